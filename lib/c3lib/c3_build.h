@@ -89,7 +89,7 @@ namespace CyberCache {
   constexpr unsigned int MAX_NUM_INTERNAL_TAG_REFS = 64;
   constexpr bool LIMITED_MEMORY_QUOTA = false; // actual limit per store is 128Tb
   constexpr unsigned int MAX_CONFIG_INCLUDE_LEVEL = 8; // base config + 7 nested
-  constexpr unsigned int MAX_NUM_CONNECTION_THREADS = 48; // worker threads
+  constexpr unsigned int MAX_NUM_CONNECTION_THREADS = 33; // worker threads
   constexpr unsigned int MAX_IPS_PER_SERVICE = 16; // IPs per sistener/replicator/etc.
 #else
   #define C3_EDITION "Community"
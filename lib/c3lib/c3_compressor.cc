@@ -25,6 +25,8 @@
 #include "c3lib/compressors/engine_lzf.h"
 #if C3_ENTERPRISE
 #include "c3lib/compressors/engine_brotli.h"
+#include "c3lib/compressors/engine_hesper.h"
+#include "c3lib/compressors/engine_asciient.h"
 #endif
 #include "c3lib/compressors/engine_lzham.h"
 
@@ -32,10 +34,58 @@ namespace CyberCache {
 
 CompressorLibrary global_compressor;
 
+CompressorDictionary* CompressorLibrary::cl_dictionaries[MAX_NUM_DICTIONARIES + 1];
+std::atomic_uint      CompressorLibrary::cl_num_dictionaries;
+
 thread_local CompressorEngine* CompressorLibrary::cl_engines[CT_NUMBER_OF_ELEMENTS];
 thread_local c3_byte_t*        CompressorLibrary::cl_buffer;
 thread_local size_t            CompressorLibrary::cl_buff_size;
 
+bool CompressorEngine::supports_dictionaries() {
+  return false;
+}
+
+c3_uint_t CompressorEngine::pack_with_dictionary(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst,
+  size_t dst_size, comp_level_t level, comp_data_t hint, const CompressorDictionary& dictionary) {
+  return 0;
+}
+
+bool CompressorEngine::unpack_with_dictionary(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst,
+  c3_uint_t dst_size, const CompressorDictionary& dictionary) {
+  return false;
+}
+
+const CompressorDictionary* CompressorLibrary::get_dictionary(c3_dictionary_t id) {
+  if (id != CDICT_NONE && id <= get_num_dictionaries()) {
+    return cl_dictionaries[id];
+  }
+  return nullptr;
+}
+
+c3_dictionary_t CompressorLibrary::add_dictionary(const c3_byte_t* data, c3_uint_t size) {
+  c3_assert(data);
+  if (size < MIN_DICTIONARY_SIZE || size > MAX_DICTIONARY_SIZE) {
+    return CDICT_NONE;
+  }
+  c3_uint_t num_dictionaries = get_num_dictionaries();
+  for (c3_uint_t i = 1; i <= num_dictionaries; i++) {
+    const CompressorDictionary* dictionary = cl_dictionaries[i];
+    if (dictionary->get_size() == size && std::memcmp(dictionary->get_data(), data, size) == 0) {
+      return dictionary->get_id();
+    }
+  }
+  if (num_dictionaries >= MAX_NUM_DICTIONARIES) {
+    return CDICT_NONE;
+  }
+  auto contents = (c3_byte_t*) global_memory.alloc(size);
+  std::memcpy(contents, data, size);
+  auto id = (c3_dictionary_t)(num_dictionaries + 1);
+  cl_dictionaries[id] = new (alloc<CompressorDictionary>()) CompressorDictionary(contents, size, id);
+  // make the dictionary visible to other threads only after it had been fully set up
+  cl_num_dictionaries.store(id, std::memory_order_release);
+  return id;
+}
+
 CompressorEngine* CompressorLibrary::get_engine(c3_compressor_t type) const {
   CompressorEngine* engine = nullptr;
   assert(type < CT_NUMBER_OF_ELEMENTS);
@@ -64,6 +114,12 @@ CompressorEngine* CompressorLibrary::get_engine(c3_compressor_t type) const {
       case CT_BROTLI:
         engine = instantiate_engine<CompressorBrotli>();
         break;
+      case CT_HESPER:
+        engine = instantiate_engine<CompressorHesper>();
+        break;
+      case CT_ASCIIENT:
+        engine = instantiate_engine<CompressorAsciient>();
+        break;
       #endif
       case CT_LZHAM:
         engine = instantiate_engine<CompressorLzham>();
@@ -100,6 +156,8 @@ void CompressorLibrary::cleanup() {
   delete_engine<CompressorLzf>(CT_LZF);
   #if C3_ENTERPRISE
   delete_engine<CompressorBrotli>(CT_BROTLI);
+  delete_engine<CompressorHesper>(CT_HESPER);
+  delete_engine<CompressorAsciient>(CT_ASCIIENT);
   #endif
   delete_engine<CompressorLzham>(CT_LZHAM);
 }
@@ -108,6 +166,14 @@ bool CompressorLibrary::is_supported(c3_compressor_t type) {
   return get_engine(type) != nullptr;
 }
 
+bool CompressorLibrary::can_use_dictionary(c3_compressor_t type, c3_uint_t size) {
+  if (size <= MAX_DICTIONARY_DATA_SIZE) {
+    CompressorEngine* engine = get_engine(type);
+    return engine != nullptr && engine->supports_dictionaries();
+  }
+  return false;
+}
+
 const char* CompressorLibrary::get_name(c3_compressor_t type) {
   switch (type) {
     case CT_NONE:
@@ -121,7 +187,7 @@ const char* CompressorLibrary::get_name(c3_compressor_t type) {
 }
 
 c3_byte_t * CompressorLibrary::pack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size,
-  c3_uint_t &dst_size, Allocator& allocator, comp_level_t level, comp_data_t hint) {
+  c3_uint_t &dst_size, Allocator& allocator, comp_level_t level, comp_data_t hint, c3_dictionary_t dictionary) {
 
   assert(src && src_size > 0 && dst_size <= src_size &&
     level < CL_NUMBER_OF_ELEMENTS && hint < CD_NUMBER_OF_ELEMENTS);
@@ -141,7 +207,15 @@ c3_byte_t * CompressorLibrary::pack(c3_compressor_t type, const c3_byte_t *src,
         cl_buff_size = guessed_size;
       }
       c3_assert(cl_buffer);
-      c3_uint_t actual_size = engine->pack(src, src_size, cl_buffer, guessed_size, level, hint);
+      c3_uint_t actual_size = 0;
+      if (dictionary != CDICT_NONE) {
+        const CompressorDictionary* dict = get_dictionary(dictionary);
+        if (dict != nullptr) {
+          actual_size = engine->pack_with_dictionary(src, src_size, cl_buffer, guessed_size, level, hint, *dict);
+        }
+      } else {
+        actual_size = engine->pack(src, src_size, cl_buffer, guessed_size, level, hint);
+      }
       if (actual_size != 0 && actual_size < dst_size) {
         result = allocator.alloc(actual_size);
         c3_assert(result);
@@ -154,22 +228,32 @@ c3_byte_t * CompressorLibrary::pack(c3_compressor_t type, const c3_byte_t *src,
 }
 
 c3_byte_t* CompressorLibrary::pack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size,
-  c3_uint_t &dst_size, Memory& memory, comp_level_t level, comp_data_t hint) {
+  c3_uint_t &dst_size, Memory& memory, comp_level_t level, comp_data_t hint, c3_dictionary_t dictionary) {
   DefaultAllocator allocator(memory);
-  return pack(type, src, src_size, dst_size, allocator, level, hint);
+  return pack(type, src, src_size, dst_size, allocator, level, hint, dictionary);
 }
 
 c3_byte_t* CompressorLibrary::unpack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size,
-  c3_uint_t dst_size, Allocator& allocator) {
+  c3_uint_t dst_size, Allocator& allocator, c3_dictionary_t dictionary) {
 
   assert(src && src_size > 0 && src_size < dst_size);
 
   c3_byte_t* result = nullptr;
   CompressorEngine* engine = get_engine(type);
+  const CompressorDictionary* dict = nullptr;
+  if (dictionary != CDICT_NONE) {
+    dict = get_dictionary(dictionary);
+    if (dict == nullptr) {
+      return nullptr;
+    }
+  }
   if (engine != nullptr) {
     result = allocator.alloc(dst_size);
     c3_assert(result);
-    if (!engine->unpack(src, src_size, result, dst_size)) {
+    bool unpacked = dict != nullptr?
+      engine->unpack_with_dictionary(src, src_size, result, dst_size, *dict):
+      engine->unpack(src, src_size, result, dst_size);
+    if (!unpacked) {
       allocator.free(result, dst_size);
       result = nullptr;
     }
@@ -178,9 +262,9 @@ c3_byte_t* CompressorLibrary::unpack(c3_compressor_t type, const c3_byte_t *src,
 }
 
 c3_byte_t* CompressorLibrary::unpack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size,
-  c3_uint_t dst_size, Memory& memory) {
+  c3_uint_t dst_size, Memory& memory, c3_dictionary_t dictionary) {
   DefaultAllocator allocator(memory);
-  return unpack(type, src, src_size, dst_size, allocator);
+  return unpack(type, src, src_size, dst_size, allocator, dictionary);
 }
 
 } // CyberCache
@@ -22,6 +22,8 @@
 #include "c3_build.h"
 #include "c3_memory.h"
 
+#include <atomic>
+
 namespace CyberCache {
 
 /// Types of compression engines
@@ -37,11 +39,19 @@ enum c3_compressor_t: c3_byte_t {
   CT_ZSTD,     // Zstd by Yann Collet (Facebook, Inc.)
   CT_ZLIB,     // Zlib (gzip) by Jean-loup Gailly and Mark Adler
   CT_LZHAM,    // Lzham by Richard Geldreich, Jr.
+  // specialized compressors for small textual records (do not support compression levels)
+  CT_HESPER,   // Hesper: 5-bit run codes for printable ASCII
+  CT_ASCIIENT, // Asciient: fixed (pre-trained) canonical Huffman codes
   CT_NUMBER_OF_ELEMENTS,
   CT_DEFAULT = CT_SNAPPY
 };
 
-static_assert(CT_NUMBER_OF_ELEMENTS == 9, "Adjust 'Recompressions_Xxx' perf counter array sizes");
+static_assert(CT_NUMBER_OF_ELEMENTS == 11, "Adjust 'Recompressions_Xxx' perf counter array sizes");
+
+/// Whether specified compressor is only available in Enterprise Edition
+inline bool is_enterprise_compressor(c3_compressor_t type) {
+  return type == CT_BROTLI || type == CT_HESPER || type == CT_ASCIIENT;
+}
 
 /// Compression levels
 enum comp_level_t {
@@ -62,6 +72,41 @@ enum comp_data_t {
   CD_DEFAULT = CD_GENERIC
 };
 
+/// Identifier of a compression dictionary (index into the dictionary table of the library)
+typedef c3_byte_t c3_dictionary_t;
+
+/// "Dictionary" identifier denoting that data were compressed without a dictionary
+constexpr c3_dictionary_t CDICT_NONE = 0;
+
+/**
+ * Signature of files with data samples for dictionary training (created by the `DUMP` server command);
+ * signature is followed by records, each being a `c3_uint_t` length (in native byte order) and data.
+ */
+constexpr char DICTIONARY_SAMPLES_SIGNATURE[] = "C3Sample";
+constexpr c3_uint_t DICTIONARY_SAMPLES_SIGNATURE_LENGTH = sizeof(DICTIONARY_SAMPLES_SIGNATURE) - 1;
+
+/**
+ * Pre-defined content (usually trained on samples of real data) that compression engines supporting
+ * dictionaries use to "prime" their history window, which greatly improves compression of small buffers
+ * that share common substrings (e.g. session records or page fragments).
+ *
+ * Once registered with the library, a dictionary is never modified or removed, so that data compressed
+ * using it remain readable even after application switched to a different dictionary.
+ */
+class CompressorDictionary {
+  const c3_byte_t* cd_data; // dictionary contents
+  c3_uint_t        cd_size; // size of the dictionary, bytes
+  c3_dictionary_t  cd_id;   // identifier of the dictionary
+
+public:
+  CompressorDictionary(const c3_byte_t* data, c3_uint_t size, c3_dictionary_t id):
+    cd_data(data), cd_size(size), cd_id(id) {}
+
+  const c3_byte_t* get_data() const { return cd_data; }
+  c3_uint_t get_size() const { return cd_size; }
+  c3_dictionary_t get_id() const { return cd_id; }
+};
+
 class CompressorEngine {
   // `CompressorLibrary` must be the only class capable of creating `CompressorEngine` instances
   friend class CompressorLibrary;
@@ -103,6 +148,25 @@ class CompressorEngine {
    */
   virtual bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) = 0;
 
+  /**
+   * Checks whether engine can use compression dictionaries; engines that can must override this method,
+   * as well as `pack_with_dictionary()` and `unpack_with_dictionary()`.
+   *
+   * @return `true` if dictionaries are supported, `false` otherwise.
+   */
+  virtual bool supports_dictionaries();
+  /**
+   * Same as `pack()`, but uses specified dictionary; default implementation always fails.
+   */
+  virtual c3_uint_t pack_with_dictionary(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst,
+    size_t dst_size, comp_level_t level, comp_data_t hint, const CompressorDictionary& dictionary);
+  /**
+   * Same as `unpack()`, but uses specified dictionary (which must be the same dictionary that was used
+   * to compress the data); default implementation always fails.
+   */
+  virtual bool unpack_with_dictionary(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst,
+    c3_uint_t dst_size, const CompressorDictionary& dictionary);
+
 protected:
   CompressorEngine() = default;
  ~CompressorEngine() = default;
@@ -116,11 +180,21 @@ public:
 };
 
 class CompressorLibrary {
+public:
+  static constexpr c3_uint_t MAX_NUM_DICTIONARIES = 15;              // max number of registered dictionaries
+  static constexpr c3_uint_t MIN_DICTIONARY_SIZE = 256;              // smallest usable dictionary, bytes
+  static constexpr c3_uint_t MAX_DICTIONARY_SIZE = 1024 * 1024;      // biggest usable dictionary, bytes
+  static constexpr c3_uint_t MAX_DICTIONARY_DATA_SIZE = 128 * 1024;  // biggest buffer packed with dictionary
+
+private:
+  static CompressorDictionary*          cl_dictionaries[MAX_NUM_DICTIONARIES + 1];
+  static std::atomic_uint               cl_num_dictionaries;
   static thread_local CompressorEngine* cl_engines[CT_NUMBER_OF_ELEMENTS];
   static thread_local c3_byte_t*        cl_buffer;
   static thread_local size_t            cl_buff_size;
 
   CompressorEngine* get_engine(c3_compressor_t type) const;
+  static const CompressorDictionary* get_dictionary(c3_dictionary_t id);
 
   template <typename T> T* instantiate_engine() const {
     T* engine = alloc<T>();
@@ -149,16 +223,32 @@ public:
   /// Every thread that might employ compression MUST call this method when it stops
   void cleanup() C3_FUNC_COLD;
 
+  /**
+   * Registers compression dictionary with the library; contents of the dictionary are copied. If a
+   * dictionary with identical contents had already been registered, its ID is returned. Must not be
+   * called by several threads concurrently (in the server, only configuration thread does that).
+   *
+   * @param data Dictionary contents
+   * @param size Size of the dictionary, bytes
+   * @return ID of the dictionary, or `CDICT_NONE` if dictionary size is out of range, or if the
+   *   dictionary table is full.
+   */
+  static c3_dictionary_t add_dictionary(const c3_byte_t* data, c3_uint_t size) C3_FUNC_COLD;
+  static c3_uint_t get_num_dictionaries() { return cl_num_dictionaries.load(std::memory_order_acquire); }
+
   bool is_supported(c3_compressor_t type) C3_FUNC_COLD;
+  bool can_use_dictionary(c3_compressor_t type, c3_uint_t size);
   const char* get_name(c3_compressor_t type) C3_FUNC_COLD;
   c3_byte_t *pack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size, c3_uint_t &dst_size,
-    Allocator& allocator, comp_level_t level = CL_DEFAULT, comp_data_t hint = CD_DEFAULT);
+    Allocator& allocator, comp_level_t level = CL_DEFAULT, comp_data_t hint = CD_DEFAULT,
+    c3_dictionary_t dictionary = CDICT_NONE);
   c3_byte_t *pack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size, c3_uint_t &dst_size,
-    Memory& memory = global_memory, comp_level_t level = CL_DEFAULT, comp_data_t hint = CD_DEFAULT);
+    Memory& memory = global_memory, comp_level_t level = CL_DEFAULT, comp_data_t hint = CD_DEFAULT,
+    c3_dictionary_t dictionary = CDICT_NONE);
   c3_byte_t* unpack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size, c3_uint_t dst_size,
-    Allocator& allocator);
+    Allocator& allocator, c3_dictionary_t dictionary = CDICT_NONE);
   c3_byte_t* unpack(c3_compressor_t type, const c3_byte_t *src, c3_uint_t src_size, c3_uint_t dst_size,
-    Memory& memory = global_memory);
+    Memory& memory = global_memory, c3_dictionary_t dictionary = CDICT_NONE);
 };
 
 extern CompressorLibrary global_compressor;
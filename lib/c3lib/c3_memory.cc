@@ -90,7 +90,8 @@ const char* Memory::get_domain_name(domain_t domain) {
 
 void Memory::report(const Memory &memory, const char *action, void *block, c3_ulong_t change) {
   c3_ulong_t used_size = memory.get_used_size();
-  size_t block_size = block? get_block_size(block): 0;
+  size_t block_size = block? (SlabAllocator::is_slab_size(change)?
+    SlabAllocator::get_block_size(change): get_block_size(block)): 0;
   domain_t domain = memory.get_domain();
   const char* domain_name;
   if (domain) {
@@ -130,6 +131,53 @@ void Memory::report(const Memory &memory, const char *action, void *block, c3_ul
 
 #endif // C3_MEMORY_DEBUG
 
+///////////////////////////////////////////////////////////////////////////////
+// PER-THREAD STATE
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Changes to used sizes of memory domains accumulated by current thread, and ID of the thread (as
+ * reported by the host; used by per-thread performance counters).
+ *
+ * Memory can be freed during destruction of other thread-local and static objects, after this object
+ * had already been destroyed; in that case, memory objects update their used sizes directly.
+ */
+class MemoryThreadState {
+  c3_long_t mts_deltas[DOMAIN_NUMBER_OF_ELEMENTS]; // accumulated changes to used sizes
+  c3_uint_t mts_thread_id;                         // ID of the thread as set by the host
+  bool      mts_disposed;                          // set when thread-local storage is being destroyed
+
+public:
+  MemoryThreadState() noexcept: mts_deltas(), mts_thread_id(0), mts_disposed(false) {}
+  MemoryThreadState(const MemoryThreadState&) = delete;
+  MemoryThreadState(MemoryThreadState&&) = delete;
+  ~MemoryThreadState();
+
+  void operator=(const MemoryThreadState&) = delete;
+  void operator=(MemoryThreadState&&) = delete;
+
+  bool is_active() const { return !mts_disposed; }
+  c3_long_t& get_delta(domain_t domain) { return mts_deltas[domain]; }
+  c3_uint_t get_thread_id() const { return mts_thread_id; }
+  void set_thread_id(c3_uint_t id) { mts_thread_id = id; }
+};
+
+static thread_local MemoryThreadState memory_thread_state;
+
+MemoryThreadState::~MemoryThreadState() {
+  mts_disposed = true;
+  for (c3_uint_t i = 0; i < DOMAIN_NUMBER_OF_ELEMENTS; i++) {
+    if (mts_deltas[i] != 0) {
+      Memory::get_memory_object((domain_t) i).flush_used_size(mts_deltas[i]);
+      mts_deltas[i] = 0;
+    }
+  }
+}
+
+void Memory::set_thread_id(c3_uint_t id) {
+  memory_thread_state.set_thread_id(id);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // QUOTA MANAGEMENT
 ///////////////////////////////////////////////////////////////////////////////
@@ -146,11 +194,30 @@ void Memory::set_quota(c3_ulong_t new_size) {
 void Memory::transfer_used_size(Memory& from, size_t size) {
   assert(size);
   if (this != &from) {
+    size = get_allocated_size(size);
     C3M_TRANSFER_FROM(from, size);
-    c3_assert_def(c3_ulong_t prev) from.m_used_size.fetch_sub(size, std::memory_order_relaxed);
-    c3_assert(prev >= size);
+    from.update_used_size(-(c3_long_t) size);
     C3M_TRANSFER_TO(*this, size);
-    m_used_size.fetch_add(size, std::memory_order_relaxed);
+    update_used_size((c3_long_t) size);
+  }
+}
+
+void Memory::flush_used_size(c3_long_t delta) {
+  m_used_size.fetch_add(delta, std::memory_order_relaxed);
+  PERF_UPDATE_VAR_DOMAIN_MAXIMUM(m_domain, Memory_Max_Used, get_used_size())
+}
+
+void Memory::update_used_size(c3_long_t delta) {
+  MemoryThreadState& state = memory_thread_state;
+  if (state.is_active()) {
+    c3_long_t& accumulated_delta = state.get_delta(m_domain);
+    accumulated_delta += delta;
+    if (accumulated_delta > MAX_USED_SIZE_DELTA || accumulated_delta < -MAX_USED_SIZE_DELTA) {
+      flush_used_size(accumulated_delta);
+      accumulated_delta = 0;
+    }
+  } else {
+    flush_used_size(delta);
   }
 }
 
@@ -158,16 +225,28 @@ void Memory::transfer_used_size(Memory& from, size_t size) {
 // HEAP MANAGEMENT
 ///////////////////////////////////////////////////////////////////////////////
 
+void* Memory::alloc_block(size_t size) {
+  return SlabAllocator::is_slab_size(size)? get_slab_allocator_object().alloc(size): std::malloc(size);
+}
+
+void Memory::free_block(void* buff, size_t size) {
+  if (SlabAllocator::is_slab_size(size)) {
+    SlabAllocator::free(buff, size);
+  } else {
+    std::free(buff);
+  }
+}
+
 void* Memory::alloc(size_t size) {
   assert(size);
   PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Alloc_Calls)
+  PERF_UPDATE_ARRAY(Memory_Thread_Alloc_Calls, memory_thread_state.get_thread_id())
   PERF_UPDATE_VAR_DOMAIN_RANGE(m_domain, Memory_Alloc_Range, size)
   for (;;) {
-    void* buff = std::malloc(size);
+    void* buff = alloc_block(size);
     if (buff != nullptr) {
       C3M_ALLOC(buff, size);
-      m_used_size.fetch_add(size, std::memory_order_relaxed);
-      PERF_UPDATE_VAR_DOMAIN_MAXIMUM(m_domain, Memory_Max_Used, m_used_size.load(std::memory_order_relaxed))
+      update_used_size(get_allocated_size(size));
       return buff;
     }
     PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Alloc_Purges)
@@ -177,30 +256,44 @@ void* Memory::alloc(size_t size) {
 
 void* Memory::calloc(size_t nelems, size_t esize) {
   assert(nelems && esize);
+  size_t size = nelems * esize;
   PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Calloc_Calls)
-  PERF_UPDATE_VAR_DOMAIN_RANGE(m_domain, Memory_Calloc_Range, nelems * esize)
+  PERF_UPDATE_ARRAY(Memory_Thread_Alloc_Calls, memory_thread_state.get_thread_id())
+  PERF_UPDATE_VAR_DOMAIN_RANGE(m_domain, Memory_Calloc_Range, size)
   for (;;) {
-    void* buff = std::calloc(nelems, esize);
+    void* buff = SlabAllocator::is_slab_size(size)?
+      get_slab_allocator_object().alloc(size): std::calloc(nelems, esize);
     if (buff != nullptr) {
+      if (SlabAllocator::is_slab_size(size)) {
+        std::memset(buff, 0, size);
+      }
       C3M_CALLOC(buff, nelems, esize);
-      m_used_size.fetch_add(nelems * esize, std::memory_order_relaxed);
-      PERF_UPDATE_VAR_DOMAIN_MAXIMUM(m_domain, Memory_Max_Used, m_used_size.load(std::memory_order_relaxed))
+      update_used_size(get_allocated_size(size));
       return buff;
     }
     PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Calloc_Purges)
-    get_interface().begin_memory_deallocation(nelems * esize);
+    get_interface().begin_memory_deallocation(size);
   }
 }
 
 void* Memory::optional_calloc(size_t nelems, size_t esize) {
   assert(nelems && esize);
+  size_t size = nelems * esize;
   PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Opt_Calloc_Calls)
-  PERF_UPDATE_VAR_DOMAIN_RANGE(m_domain, Memory_Opt_Calloc_Range, nelems * esize)
-  void* buff = std::calloc(nelems, esize);
+  PERF_UPDATE_ARRAY(Memory_Thread_Alloc_Calls, memory_thread_state.get_thread_id())
+  PERF_UPDATE_VAR_DOMAIN_RANGE(m_domain, Memory_Opt_Calloc_Range, size)
+  void* buff;
+  if (SlabAllocator::is_slab_size(size)) {
+    buff = get_slab_allocator_object().alloc(size);
+    if (buff != nullptr) {
+      std::memset(buff, 0, size);
+    }
+  } else {
+    buff = std::calloc(nelems, esize);
+  }
   if (buff != nullptr) {
     C3M_OPT_CALLOC(buff, nelems, esize);
-    m_used_size.fetch_add(nelems * esize, std::memory_order_relaxed);
-    PERF_UPDATE_VAR_DOMAIN_MAXIMUM(m_domain, Memory_Max_Used, m_used_size.load(std::memory_order_relaxed))
+    update_used_size(get_allocated_size(size));
   }
   return buff;
 }
@@ -208,20 +301,32 @@ void* Memory::optional_calloc(size_t nelems, size_t esize) {
 void* Memory::realloc(void* buff, size_t new_size, size_t old_size) {
   assert(buff && new_size && old_size && new_size != old_size);
   PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Realloc_Calls)
+  PERF_UPDATE_ARRAY(Memory_Thread_Realloc_Calls, memory_thread_state.get_thread_id())
   PERF_UPDATE_VAR_DOMAIN_RANGE(m_domain, Memory_Realloc_Range, new_size)
+  size_t new_allocated_size = get_allocated_size(new_size);
+  size_t old_allocated_size = get_allocated_size(old_size);
   for (;;) {
-    void* new_buff = std::realloc(buff, new_size);
+    void* new_buff;
+    if (SlabAllocator::is_slab_size(new_size) || SlabAllocator::is_slab_size(old_size)) {
+      if (new_allocated_size == old_allocated_size && SlabAllocator::is_slab_size(new_size)) {
+        // both sizes belong to the same size class
+        return buff;
+      }
+      new_buff = alloc_block(new_size);
+      if (new_buff != nullptr) {
+        std::memcpy(new_buff, buff, new_size < old_size? new_size: old_size);
+        free_block(buff, old_size);
+      }
+    } else {
+      new_buff = std::realloc(buff, new_size);
+    }
     if (new_buff != nullptr) {
-      if (new_size > old_size) {
-        C3M_REALLOC_GROW(new_buff, new_size - old_size);
-        m_used_size.fetch_add(new_size - old_size, std::memory_order_relaxed);
-        PERF_UPDATE_VAR_DOMAIN_MAXIMUM(m_domain, Memory_Max_Used, m_used_size.load(std::memory_order_relaxed))
+      if (new_allocated_size > old_allocated_size) {
+        C3M_REALLOC_GROW(new_buff, new_allocated_size - old_allocated_size);
       } else {
-        c3_ulong_t diff = old_size - new_size;
-        C3M_REALLOC_SHRINK(new_buff, diff);
-        c3_assert_def(c3_ulong_t prev) m_used_size.fetch_sub(diff, std::memory_order_relaxed);
-        c3_assert(prev >= diff);
+        C3M_REALLOC_SHRINK(new_buff, old_allocated_size - new_allocated_size);
       }
+      update_used_size((c3_long_t) new_allocated_size - (c3_long_t) old_allocated_size);
       return new_buff;
     }
     PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Realloc_Purges)
@@ -238,17 +343,21 @@ size_t Memory::get_block_size(void* buff) {
 }
 
 void* Memory::inplace_realloc(void* buff, size_t new_size, size_t old_size) {
-  // TODO
+  // only blocks served by slab allocators can be "re-allocated" without moving, within their size class
+  if (SlabAllocator::is_slab_size(new_size) && SlabAllocator::is_slab_size(old_size) &&
+    SlabAllocator::get_block_size(new_size) == SlabAllocator::get_block_size(old_size)) {
+    return buff;
+  }
   return nullptr;
 }
 
 void Memory::free(void* buff, size_t size) {
   assert(buff && size);
   PERF_INCREMENT_VAR_DOMAIN_COUNTER(m_domain, Memory_Free_Calls)
+  PERF_UPDATE_ARRAY(Memory_Thread_Free_Calls, memory_thread_state.get_thread_id())
   C3M_FREE(buff, size);
-  std::free(buff);
-  c3_assert_def(c3_ulong_t prev) m_used_size.fetch_sub(size, std::memory_order_relaxed);
-  c3_assert(prev >= size);
+  free_block(buff, size);
+  update_used_size(-(c3_long_t) get_allocated_size(size));
 }
 
 bool Memory::heap_check() {
@@ -20,6 +20,7 @@
 #define _C3_MEMORY_H
 
 #include "c3_types.h"
+#include "c3_slabs.h"
 #include <atomic>
 
 namespace CyberCache {
@@ -67,6 +68,17 @@ public:
  * using `global_memory` object, and then "transferred" to the proper domain using
  *   <another-domain>.transfer_used_size(global_memory, <block-size);
  *
+ * Blocks of up to `SlabAllocator::MAX_BLOCK_SIZE` bytes are served by the slab allocator of the domain,
+ * bigger blocks are allocated on the heap. Sizes of blocks served by slab allocators are rounded up to
+ * their size classes before they are added to the used size, so that the latter reflects memory that
+ * is actually consumed by the domain.
+ *
+ * Used sizes are not updated on each allocation: each thread accumulates its own per-domain changes,
+ * and adds them to shared counters only when they exceed `MAX_USED_SIZE_DELTA` bytes (in either
+ * direction), or when the thread quits. Therefore, `get_used_size()` may be off by up to that amount
+ * times number of running threads, which is negligible compared to typical memory quotas, and which
+ * eliminates contention on shared counters in connection threads.
+ *
  * We use "relaxed" memory order throughout memory manager for inter-thread synchronization; this order
  * may not achieve exact results (in that, say, `get_used_size()` may return "outdated" value if some
  * other thread just incremented the counter), but a) utmost "precision" it is not important for its
@@ -80,6 +92,8 @@ class Memory {
   // maximum allowed value for `m_max_size`
   static constexpr c3_ulong_t MAX_QUOTA = LIMITED_MEMORY_QUOTA?
     gigabytes2bytes(32): terabytes2bytes(128);
+  // maximum change of the used size that a thread can accumulate before updating `m_used_size`
+  static constexpr c3_long_t MAX_USED_SIZE_DELTA = 64 * 1024;
   // pointers to all memory objects
   static Memory* m_object_refs[DOMAIN_NUMBER_OF_ELEMENTS];
   // pointer to host interface implementation
@@ -90,8 +104,10 @@ class Memory {
 
   // how much memory was actually allocated using this object; can become
   // bigger than `m_max_size`, code watching this `Memory` object may start
-  // deallocating memory until `m_used_size` becomes lower than quota
-  std::atomic_ullong m_used_size;
+  // deallocating memory until `m_used_size` becomes lower than quota; it is
+  // signed because threads add their accumulated changes independently, so
+  // the sum can temporarily drop below zero
+  std::atomic_llong m_used_size;
 
   // domain to which this memory object belongs
   const domain_t m_domain;
@@ -106,6 +122,15 @@ class Memory {
     m_interface = host_interface;
   }
 
+  // slab allocator that serves small blocks of this domain
+  SlabAllocator& get_slab_allocator_object() const { return SlabAllocator::get_allocator(m_domain); }
+  void* alloc_block(size_t size) C3_FUNC_MALLOC;
+  void update_used_size(c3_long_t delta);
+  void flush_used_size(c3_long_t delta);
+
+  friend class MemoryThreadState;
+  static void free_block(void* buff, size_t size) C3_FUNC_NONNULL_ARGS;
+
   #if C3_MEMORY_DEBUG
   static void report(const Memory &memory, const char *action, void *block, c3_ulong_t change);
   #endif
@@ -117,6 +142,7 @@ public:
   ~Memory() = default;
 
   static void configure(MemoryInterface* host_interface) { set_interface(host_interface); }
+  static void set_thread_id(c3_uint_t id);
 
   // operators
   void operator=(Memory&) = delete;
@@ -139,7 +165,13 @@ public:
   bool is_quota_set() const { return m_max_size != DEFAULT_QUOTA; }
   c3_ulong_t get_quota() const { return m_max_size.load(std::memory_order_relaxed); }
   void set_quota(c3_ulong_t new_size) C3_FUNC_COLD;
-  c3_ulong_t get_used_size() const { return m_used_size.load(std::memory_order_relaxed); }
+  c3_ulong_t get_used_size() const {
+    c3_long_t used_size = m_used_size.load(std::memory_order_relaxed);
+    return used_size > 0? (c3_ulong_t) used_size: 0;
+  }
+  static size_t get_allocated_size(size_t size) {
+    return SlabAllocator::is_slab_size(size)? SlabAllocator::get_block_size(size): size;
+  }
   void transfer_used_size(Memory& from, size_t size);
 
   // heap management
@@ -147,10 +179,14 @@ public:
   void* calloc(size_t nelems, size_t esize) C3_FUNC_MALLOC C3_FUNC_NONNULL_RETURN;
   void* optional_calloc(size_t nelems, size_t esize) C3_FUNC_MALLOC;
   void* realloc(void* buff, size_t new_size, size_t old_size) C3_FUNC_NONNULL_ARGS C3_FUNC_NONNULL_RETURN;
-  static size_t get_block_size(void* buff);
+  static size_t get_block_size(void* buff); // only works for blocks allocated on the heap
   void* inplace_realloc(void* buff, size_t new_size, size_t old_size);
   void free(void* buff, size_t size) C3_FUNC_NONNULL_ARGS;
   static bool heap_check() C3_FUNC_COLD;
+
+  // slab statistics
+  c3_ulong_t get_slab_reserved_size() const { return get_slab_allocator_object().get_reserved_size(); }
+  c3_ulong_t get_slab_allocated_size() const { return get_slab_allocator_object().get_allocated_size(); }
 };
 
 extern Memory global_memory;
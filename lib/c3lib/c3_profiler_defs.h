@@ -174,7 +174,7 @@ namespace CyberCache {
 PERF_DEFINE_INT_ARRAY(ALL, Shared_Header_Size, 24)
 PERF_DEFINE_LONG_COUNTER(ALL, Shared_Header_Reallocations)
 
-PERF_DEFINE_INT_ARRAY(ALL, Waits_Until_No_Readers, 14);
+PERF_DEFINE_INT_ARRAY(ALL, Waits_Until_No_Readers, 31);
 
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Local_Queue_Put_Failures)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Local_Queue_Reallocations)
@@ -190,8 +190,12 @@ PERF_DEFINE_DOMAIN_INT_MAXIMUM(ALL, Queue_Max_Capacity)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Cache_Misses)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Cache_Hits)
 
-PERF_DEFINE_INT_ARRAY(GLOBAL, Recompressions_Failed, 9)
-PERF_DEFINE_INT_ARRAY(GLOBAL, Recompressions_Succeeded, 9)
+PERF_DEFINE_INT_ARRAY(GLOBAL, Recompressions_Failed, 11)
+PERF_DEFINE_INT_ARRAY(GLOBAL, Recompressions_Succeeded, 11)
+
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, IO_Payloads_Copied)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, IO_Payloads_Packed)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, IO_Payloads_Shared)
 
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, IO_Objects_Cloned)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, IO_Objects_Copied)
@@ -206,6 +210,16 @@ PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, List_Long_Reallocs)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, List_Completed_Reallocs)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, List_Added_Strings)
 
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Optimizer_LFU_Evictions)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Optimizer_LFU_Reprieves)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Optimizer_Hot_Dictionary_Buffers)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Optimizer_Recompressions_Explored)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Optimizer_Recompressions_Skipped)
+
+PERF_DEFINE_INT_MAXIMUM(FPC, Tags_Max_Deferred_Unlinks)
+PERF_DEFINE_LONG_COUNTER(FPC, Tags_Deferred_Unlink_Batches)
+PERF_DEFINE_LONG_COUNTER(FPC, Tags_Deferred_Unlinks)
+
 PERF_DEFINE_LONG_COUNTER(FPC, Store_Tag_Array_Reallocs)
 PERF_DEFINE_INT_ARRAY(FPC, Store_Tags_Per_Object, 16)
 PERF_DEFINE_DOMAIN_INT_RANGE(ALL, Store_Objects_Name_Length)
@@ -216,6 +230,11 @@ PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Store_Objects_Created)
 PERF_DEFINE_DOMAIN_INT_MAXIMUM(ALL, Replicator_Max_Deferred_Commands)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Replicator_Deferred_Commands)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Replicator_Reconnections)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Replicator_Pipelined_Commands)
+PERF_DEFINE_DOMAIN_INT_MAXIMUM(ALL, Replicator_Max_Commands_In_Flight)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Replicator_Batches)
+PERF_DEFINE_DOMAIN_INT_MAXIMUM(ALL, Replicator_Max_Batched_Commands)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Replicator_Catch_Up_Commands)
 
 PERF_DEFINE_INT_COUNTER(GLOBAL, Sockets_Accept_Error_Other)
 PERF_DEFINE_INT_COUNTER(GLOBAL, Sockets_Accept_Error_IP)
@@ -224,12 +243,16 @@ PERF_DEFINE_INT_COUNTER(GLOBAL, Sockets_Accept_Try_NoConn)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Sockets_Closed)
 PERF_DEFINE_INT_RANGE(GLOBAL, Sockets_Received_Data_Range)
 PERF_DEFINE_INT_RANGE(GLOBAL, Sockets_Sent_Data_Range)
+PERF_DEFINE_LONG_COUNTER(GLOBAL, Sockets_Vectored_Writes)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Socket_Inbound_Connections)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Socket_Outbound_Connections)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Sockets_Bound)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Sockets_Created)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Socket_Hosts_Resolved)
 
+PERF_DEFINE_LONG_COUNTER(GLOBAL, IO_Ring_Enter_Calls)
+PERF_DEFINE_LONG_COUNTER(GLOBAL, IO_Ring_File_Writes)
+
 PERF_DEFINE_DOMAIN_LONG_MAXIMUM(ALL, Memory_Max_Used)
 PERF_DEFINE_DOMAIN_INT_COUNTER(ALL, Memory_Realloc_Purges)
 PERF_DEFINE_DOMAIN_INT_COUNTER(ALL, Memory_Calloc_Purges)
@@ -243,6 +266,11 @@ PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Memory_Realloc_Calls)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Memory_Opt_Calloc_Calls)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Memory_Calloc_Calls)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Memory_Alloc_Calls)
+PERF_DEFINE_LONG_ARRAY(ALL, Memory_Thread_Free_Calls, 31);
+PERF_DEFINE_LONG_ARRAY(ALL, Memory_Thread_Realloc_Calls, 31);
+PERF_DEFINE_LONG_ARRAY(ALL, Memory_Thread_Alloc_Calls, 31);
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Memory_Slabs_Disposed)
+PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, Memory_Slabs_Created)
 
 PERF_DEFINE_DOMAIN_INT_MAXIMUM(ALL, SpinLock_Max_Waits)
 PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, SpinLock_Total_Waits)
@@ -251,6 +279,7 @@ PERF_DEFINE_DOMAIN_LONG_COUNTER(ALL, SpinLock_Acquisitions)
 PERF_DEFINE_INT_COUNTER(SESSION, Session_Aborted_Locks)
 PERF_DEFINE_INT_COUNTER(SESSION, Session_Broken_Locks)
 PERF_DEFINE_LONG_COUNTER(SESSION, Session_Lock_Waits)
+PERF_DEFINE_LONG_COUNTER(SESSION, Session_Lock_Inline_Resumes)
 PERF_DEFINE_LONG_ARRAY(GLOBAL, Hash_Object_Waits, 12)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Hash_Object_Lock_Try_Failures)
 PERF_DEFINE_LONG_COUNTER(GLOBAL, Hash_Object_Lock_Try_Successes)
@@ -0,0 +1,368 @@
+/**
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include "c3_build.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "c3_slabs.h"
+#include "c3_profiler_defs.h"
+
+namespace CyberCache {
+
+static_assert(SlabAllocator::get_block_size(SlabAllocator::MAX_BLOCK_SIZE) == SlabAllocator::MAX_BLOCK_SIZE &&
+  SlabAllocator::get_block_size(SlabAllocator::MAX_BLOCK_SIZE - 1) == SlabAllocator::MAX_BLOCK_SIZE &&
+  SlabAllocator::get_block_size(257) == 320 && SlabAllocator::get_block_size(1025) == 1280,
+  "Inconsistent slab size classes");
+
+///////////////////////////////////////////////////////////////////////////////
+// Slab
+///////////////////////////////////////////////////////////////////////////////
+
+/// Header of a slab; blocks of the slab follow it
+class Slab {
+  SlabAllocator* s_allocator;  // allocator that owns this slab
+  Slab*          s_next;       // next slab in the list of size class or the pool
+  Slab*          s_prev;       // previous slab in the list of size class
+  void*          s_free;       // list of blocks that were allocated and then freed
+  c3_byte_t*     s_unused;     // start of the area with blocks that were never allocated
+  c3_uint_t      s_num_used;   // number of allocated blocks (including those in thread caches)
+  c3_uint_t      s_num_blocks; // total number of blocks in the slab
+  c3_uint_t      s_index;      // index of the size class
+
+  friend class SlabAllocator;
+  friend class SlabPool;
+
+public:
+  static Slab* get_slab(void* block) {
+    return (Slab*)((uintptr_t) block & ~(uintptr_t)(SlabAllocator::SLAB_SIZE - 1));
+  }
+  SlabAllocator& get_allocator() const { return *s_allocator; }
+  c3_uint_t get_index() const { return s_index; }
+};
+
+static_assert(sizeof(Slab) <= SlabAllocator::SLAB_HEADER_SIZE, "Slab header is too big");
+
+///////////////////////////////////////////////////////////////////////////////
+// SlabPool
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Process-wide source of slabs. Address space is reserved in big arenas that are never returned to the
+ * OS; slabs that become empty are put back into the pool, and if the pool already has enough of them,
+ * pages of the returned slab (except the one with its header) are given back to the OS.
+ */
+class SlabPool {
+  static constexpr size_t ARENA_SIZE = 64 * SlabAllocator::SLAB_SIZE;
+  static constexpr c3_uint_t MAX_NUM_RESIDENT_SLABS = 64;
+
+  std::mutex sp_mutex;     // guards all fields
+  Slab*      sp_slabs;     // list of free slabs
+  c3_uint_t  sp_num_slabs; // number of slabs in `sp_slabs` list
+  c3_byte_t* sp_arena;     // unused part of the current arena
+  c3_byte_t* sp_arena_end; // end of the current arena
+  size_t     sp_page_size; // size of memory page
+
+  bool create_arena() C3_FUNC_COLD;
+
+public:
+  constexpr SlabPool() noexcept:
+    sp_mutex(), sp_slabs(nullptr), sp_num_slabs(0), sp_arena(nullptr), sp_arena_end(nullptr),
+    sp_page_size(0) {}
+
+  Slab* get_slab();
+  void put_slab(Slab* slab);
+};
+
+static SlabPool slab_pool;
+
+bool SlabPool::create_arena() {
+  const size_t size = ARENA_SIZE + SlabAllocator::SLAB_SIZE;
+  void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region != MAP_FAILED) {
+    auto start = (uintptr_t) region;
+    uintptr_t arena = (start + SlabAllocator::SLAB_SIZE - 1) & ~(uintptr_t)(SlabAllocator::SLAB_SIZE - 1);
+    uintptr_t arena_end = arena + ARENA_SIZE;
+    if (arena > start) {
+      munmap(region, arena - start);
+    }
+    if (start + size > arena_end) {
+      munmap((void*) arena_end, start + size - arena_end);
+    }
+    sp_arena = (c3_byte_t*) arena;
+    sp_arena_end = (c3_byte_t*) arena_end;
+    return true;
+  }
+  return false;
+}
+
+Slab* SlabPool::get_slab() {
+  std::lock_guard<std::mutex> lock(sp_mutex);
+  Slab* slab = sp_slabs;
+  if (slab != nullptr) {
+    sp_slabs = slab->s_next;
+    sp_num_slabs--;
+  } else if (sp_arena < sp_arena_end || create_arena()) {
+    slab = (Slab*) sp_arena;
+    sp_arena += SlabAllocator::SLAB_SIZE;
+  }
+  return slab;
+}
+
+void SlabPool::put_slab(Slab* slab) {
+  std::lock_guard<std::mutex> lock(sp_mutex);
+  if (sp_num_slabs >= MAX_NUM_RESIDENT_SLABS) {
+    #if !C3_CYGWIN
+    if (sp_page_size == 0) {
+      sp_page_size = (size_t) sysconf(_SC_PAGESIZE);
+    }
+    if (sp_page_size < SlabAllocator::SLAB_SIZE) {
+      madvise((c3_byte_t*) slab + sp_page_size, SlabAllocator::SLAB_SIZE - sp_page_size, MADV_DONTNEED);
+    }
+    #endif // !C3_CYGWIN
+  }
+  slab->s_next = sp_slabs;
+  sp_slabs = slab;
+  sp_num_slabs++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SlabThreadCache
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Per-thread lists of free blocks. All blocks in a list belong to the same allocator (i.e. to slabs
+ * created by that allocator) and have the same size class, so when a list overflows, or when the thread
+ * quits, blocks can be returned to their slabs with a single lock of the size class mutex.
+ */
+class SlabThreadCache {
+  struct BlockList {
+    void*     bl_head;  // first block
+    c3_uint_t bl_count; // number of blocks in the list
+  };
+
+  BlockList stc_lists[DOMAIN_NUMBER_OF_ELEMENTS][SlabAllocator::NUM_SIZE_CLASSES];
+  bool      stc_disposed; // set when thread-local storage is being destroyed
+
+public:
+  SlabThreadCache() noexcept: stc_lists(), stc_disposed(false) {}
+  SlabThreadCache(const SlabThreadCache&) = delete;
+  SlabThreadCache(SlabThreadCache&&) = delete;
+  ~SlabThreadCache();
+
+  void operator=(const SlabThreadCache&) = delete;
+  void operator=(SlabThreadCache&&) = delete;
+
+  bool is_active() const { return !stc_disposed; }
+  void* alloc(SlabAllocator& allocator, c3_uint_t index);
+  void free(SlabAllocator& allocator, c3_uint_t index, void* buff);
+};
+
+static thread_local SlabThreadCache slab_thread_cache;
+
+SlabThreadCache::~SlabThreadCache() {
+  stc_disposed = true;
+  for (c3_uint_t i = 0; i < DOMAIN_NUMBER_OF_ELEMENTS; i++) {
+    SlabAllocator& allocator = SlabAllocator::get_allocator((domain_t) i);
+    for (c3_uint_t j = 0; j < SlabAllocator::NUM_SIZE_CLASSES; j++) {
+      BlockList& list = stc_lists[i][j];
+      if (list.bl_count > 0) {
+        allocator.release_blocks(j, list.bl_head, list.bl_count);
+        list.bl_head = nullptr;
+        list.bl_count = 0;
+      }
+    }
+  }
+}
+
+void* SlabThreadCache::alloc(SlabAllocator& allocator, c3_uint_t index) {
+  BlockList& list = stc_lists[allocator.get_domain()][index];
+  if (list.bl_count == 0) {
+    c3_assert(list.bl_head == nullptr);
+    list.bl_count = allocator.fetch_blocks(index, &list.bl_head,
+      (SlabAllocator::get_cache_capacity(index) + 1) / 2);
+    if (list.bl_count == 0) {
+      return nullptr;
+    }
+  }
+  void* block = list.bl_head;
+  list.bl_head = *(void**) block;
+  list.bl_count--;
+  return block;
+}
+
+void SlabThreadCache::free(SlabAllocator& allocator, c3_uint_t index, void* buff) {
+  BlockList& list = stc_lists[allocator.get_domain()][index];
+  *(void**) buff = list.bl_head;
+  list.bl_head = buff;
+  c3_uint_t capacity = SlabAllocator::get_cache_capacity(index);
+  if (++list.bl_count > capacity) {
+    // keep most recently freed (i.e. "hot") half of the blocks, return the rest
+    c3_uint_t num_kept = capacity / 2;
+    void* last_kept = list.bl_head;
+    for (c3_uint_t i = 1; i < num_kept; i++) {
+      last_kept = *(void**) last_kept;
+    }
+    void* released = *(void**) last_kept;
+    *(void**) last_kept = nullptr;
+    allocator.release_blocks(index, released, list.bl_count - num_kept);
+    list.bl_count = num_kept;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SlabAllocator
+///////////////////////////////////////////////////////////////////////////////
+
+SlabAllocator SlabAllocator::sa_allocators[DOMAIN_NUMBER_OF_ELEMENTS];
+
+c3_uint_t SlabAllocator::get_cache_capacity(c3_uint_t index) {
+  // cache up to 8k worth of blocks per size class, but no less than 4 and no more than 64 blocks
+  c3_uint_t capacity = (c3_uint_t)(8192 / get_class_block_size(index));
+  return capacity < 4? 4: (capacity > 64? 64: capacity);
+}
+
+Slab* SlabAllocator::create_slab(c3_uint_t index) {
+  Slab* slab = slab_pool.get_slab();
+  if (slab != nullptr) {
+    size_t block_size = get_class_block_size(index);
+    slab->s_allocator = this;
+    slab->s_next = nullptr;
+    slab->s_prev = nullptr;
+    slab->s_free = nullptr;
+    slab->s_unused = (c3_byte_t*) slab + SLAB_HEADER_SIZE;
+    slab->s_num_used = 0;
+    slab->s_num_blocks = (c3_uint_t)((SLAB_SIZE - SLAB_HEADER_SIZE) / block_size);
+    slab->s_index = index;
+    sa_reserved_size.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Memory_Slabs_Created)
+  }
+  return slab;
+}
+
+void SlabAllocator::dispose_slab(Slab* slab) {
+  c3_assert(slab && slab->s_num_used == 0);
+  sa_reserved_size.fetch_sub(SLAB_SIZE, std::memory_order_relaxed);
+  PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Memory_Slabs_Disposed)
+  slab_pool.put_slab(slab);
+}
+
+c3_uint_t SlabAllocator::fetch_blocks(c3_uint_t index, void** head, c3_uint_t num) {
+  c3_assert(index < NUM_SIZE_CLASSES && head && num);
+  size_t block_size = get_class_block_size(index);
+  SizeClass& sc = sa_classes[index];
+  std::lock_guard<std::mutex> lock(sc.sc_mutex);
+  void* list = nullptr;
+  c3_uint_t count = 0;
+  while (count < num) {
+    Slab* slab = sc.sc_slabs;
+    if (slab == nullptr) {
+      slab = create_slab(index);
+      if (slab == nullptr) {
+        break;
+      }
+      sc.sc_slabs = slab;
+    }
+    do {
+      void* block = slab->s_free;
+      if (block != nullptr) {
+        slab->s_free = *(void**) block;
+      } else {
+        block = slab->s_unused;
+        slab->s_unused += block_size;
+      }
+      *(void**) block = list;
+      list = block;
+      count++;
+    } while (++slab->s_num_used < slab->s_num_blocks && count < num);
+    if (slab->s_num_used == slab->s_num_blocks) {
+      // full slabs are not kept in the list
+      sc.sc_slabs = slab->s_next;
+      if (slab->s_next != nullptr) {
+        slab->s_next->s_prev = nullptr;
+      }
+      slab->s_next = nullptr;
+    }
+  }
+  *head = list;
+  sa_allocated_size.fetch_add(count * block_size, std::memory_order_relaxed);
+  return count;
+}
+
+void SlabAllocator::release_blocks(c3_uint_t index, void* head, c3_uint_t num) {
+  c3_assert(index < NUM_SIZE_CLASSES && head && num);
+  SizeClass& sc = sa_classes[index];
+  std::lock_guard<std::mutex> lock(sc.sc_mutex);
+  void* block = head;
+  while (block != nullptr) {
+    void* next = *(void**) block;
+    Slab* slab = Slab::get_slab(block);
+    c3_assert(slab->s_allocator == this && slab->s_index == index && slab->s_num_used);
+    if (slab->s_num_used == slab->s_num_blocks) {
+      // slab was full, put it back into the list
+      slab->s_prev = nullptr;
+      slab->s_next = sc.sc_slabs;
+      if (sc.sc_slabs != nullptr) {
+        sc.sc_slabs->s_prev = slab;
+      }
+      sc.sc_slabs = slab;
+    }
+    *(void**) block = slab->s_free;
+    slab->s_free = block;
+    if (--slab->s_num_used == 0 && (slab->s_prev != nullptr || slab->s_next != nullptr)) {
+      // keep at least one slab of each class to avoid thrashing on alloc/free
+      if (slab->s_prev != nullptr) {
+        slab->s_prev->s_next = slab->s_next;
+      } else {
+        sc.sc_slabs = slab->s_next;
+      }
+      if (slab->s_next != nullptr) {
+        slab->s_next->s_prev = slab->s_prev;
+      }
+      dispose_slab(slab);
+    }
+    block = next;
+  }
+  sa_allocated_size.fetch_sub(num * get_class_block_size(index), std::memory_order_relaxed);
+}
+
+void* SlabAllocator::alloc(size_t size) {
+  c3_assert(size && is_slab_size(size));
+  c3_uint_t index = get_class_index(size);
+  SlabThreadCache& cache = slab_thread_cache;
+  if (cache.is_active()) {
+    return cache.alloc(*this, index);
+  }
+  void* block;
+  return fetch_blocks(index, &block, 1) != 0? block: nullptr;
+}
+
+void SlabAllocator::free(void* buff, size_t size) {
+  c3_assert(size && is_slab_size(size));
+  c3_uint_t index = get_class_index(size);
+  Slab* slab = Slab::get_slab(buff);
+  c3_assert(slab->get_index() == index);
+  SlabAllocator& allocator = slab->get_allocator();
+  SlabThreadCache& cache = slab_thread_cache;
+  if (cache.is_active()) {
+    cache.free(allocator, index, buff);
+  } else {
+    *(void**) buff = nullptr;
+    allocator.release_blocks(index, buff, 1);
+  }
+}
+
+} // CyberCache
@@ -0,0 +1,129 @@
+/**
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Size-class slab allocator used by memory manager for small blocks.
+ */
+#ifndef _C3_SLABS_H
+#define _C3_SLABS_H
+
+#include "c3_types.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace CyberCache {
+
+class Slab;
+
+/**
+ * Allocator of small memory blocks belonging to particular memory domain.
+ *
+ * Blocks are carved out of 64k "slabs" (aligned at 64k boundaries, so that slab header can be found
+ * using block address alone), each slab serving single size class. Size classes go in 16-byte steps up
+ * to 256 bytes, which covers headers of virtually all session and page objects (e.g. `SessionObject`
+ * with a 32-character session ID takes 152 bytes), and then in quarter-power-of-two steps up to 2k,
+ * which covers most compressed payloads of session records. Bigger blocks are served by the heap.
+ *
+ * Unlike `malloc()`, slab allocator does not store per-block headers, so it relies on the caller to
+ * always pass exact block size to `free()`; this is how `Memory` methods are used anyway.
+ *
+ * Each thread keeps a small cache of free blocks per domain and size class, so that most allocations
+ * and deallocations do not have to lock size class mutexes. Slabs that become empty are returned to a
+ * process-wide pool; if the pool grows too big, pages of extra slabs are given back to the OS.
+ *
+ * Allocator objects are constant-initialized, so they can be used by memory allocations that happen
+ * before static constructors are run.
+ */
+class SlabAllocator {
+public:
+  /// Size of each slab; must be a power of two
+  static constexpr size_t SLAB_SIZE = 64 * 1024;
+  /// Size of the slab header; first block is allocated past it
+  static constexpr size_t SLAB_HEADER_SIZE = 64;
+  /// Biggest block size served by slab allocators
+  static constexpr size_t MAX_BLOCK_SIZE = 2048;
+  /// Total number of size classes
+  static constexpr c3_uint_t NUM_SIZE_CLASSES = 28;
+
+private:
+  /// Size class descriptor
+  struct SizeClass {
+    std::mutex sc_mutex; // guards list of slabs of this class
+    Slab*      sc_slabs; // slabs that have at least one free block
+
+    constexpr SizeClass() noexcept: sc_mutex(), sc_slabs(nullptr) {}
+  };
+
+  static SlabAllocator sa_allocators[DOMAIN_NUMBER_OF_ELEMENTS]; // allocators of all domains
+
+  SizeClass          sa_classes[NUM_SIZE_CLASSES]; // size class descriptors
+  std::atomic_ullong sa_reserved_size;             // total size of all slabs of this allocator
+  std::atomic_ullong sa_allocated_size;            // total size of blocks handed out from slabs
+
+  static constexpr c3_uint_t get_class_index(size_t size) {
+    return size <= 256? (c3_uint_t)((size - 1) >> 4):
+      16 + (get_high_bit((c3_uint_t)(size - 1)) - 8) * 4 +
+      (((c3_uint_t)(size - 1) >> (get_high_bit((c3_uint_t)(size - 1)) - 2)) & 3);
+  }
+  static constexpr c3_uint_t get_high_bit(c3_uint_t n) {
+    return (c3_uint_t)(31 - __builtin_clz(n));
+  }
+  static constexpr size_t get_class_block_size(c3_uint_t index) {
+    return index < 16? (index + 1) << 4:
+      ((size_t) 1 << (8 + (index - 16) / 4)) + (((index - 16) % 4 + 1) << (6 + (index - 16) / 4));
+  }
+  static c3_uint_t get_cache_capacity(c3_uint_t index);
+
+  domain_t get_domain() const { return (domain_t)(this - sa_allocators); }
+  Slab* create_slab(c3_uint_t index) C3_FUNC_COLD;
+  void dispose_slab(Slab* slab);
+  c3_uint_t fetch_blocks(c3_uint_t index, void** head, c3_uint_t num);
+  void release_blocks(c3_uint_t index, void* head, c3_uint_t num);
+
+  friend class SlabThreadCache;
+
+public:
+  constexpr SlabAllocator() noexcept: sa_classes(), sa_reserved_size(0), sa_allocated_size(0) {}
+  SlabAllocator(const SlabAllocator&) = delete;
+  SlabAllocator(SlabAllocator&&) = delete;
+  ~SlabAllocator() = default;
+
+  void operator=(const SlabAllocator&) = delete;
+  void operator=(SlabAllocator&&) = delete;
+
+  static SlabAllocator& get_allocator(domain_t domain) {
+    c3_assert(domain < DOMAIN_NUMBER_OF_ELEMENTS);
+    return sa_allocators[domain];
+  }
+
+  // size classes
+  static constexpr bool is_slab_size(size_t size) { return size <= MAX_BLOCK_SIZE; }
+  static constexpr size_t get_block_size(size_t size) {
+    return get_class_block_size(get_class_index(size));
+  }
+
+  // statistics
+  c3_ulong_t get_reserved_size() const { return sa_reserved_size.load(std::memory_order_relaxed); }
+  c3_ulong_t get_allocated_size() const { return sa_allocated_size.load(std::memory_order_relaxed); }
+
+  // heap management; `alloc()` returns `NULL` if there is no memory for a new slab
+  void* alloc(size_t size) C3_FUNC_MALLOC;
+  static void free(void* buff, size_t size) C3_FUNC_NONNULL_ARGS;
+};
+
+} // CyberCache
+
+#endif // _C3_SLABS_H
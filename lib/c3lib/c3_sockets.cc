@@ -105,6 +105,22 @@ int c3_socket(int options) {
         return c3_set_stdlib_error_message();
       }
     }
+    if ((options & C3_SOCK_REUSE_PORT) != 0) {
+      #ifdef SO_REUSEPORT
+      /*
+       * Several sockets (served by different threads) can then listen to the same address and port, and
+       * the kernel will distribute incoming connections between them.
+       */
+      int do_share = 1;
+      if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &do_share, sizeof(do_share)) < 0) {
+        close(fd);
+        return c3_set_stdlib_error_message();
+      }
+      #else
+      close(fd);
+      return c3_set_error_message("Sharing of ports is not supported on this platform");
+      #endif
+    }
     /*
      * The only time we do not need this is creation of a listening socket (for epoll); there,
      * TCP_NODELAY does not help, but it doesn't do any harm either.
@@ -25,6 +25,7 @@ namespace CyberCache {
 
 constexpr int C3_SOCK_NON_BLOCKING = 0x01; // perform asynchronous I/O
 constexpr int C3_SOCK_REUSE_ADDR   = 0x02; // reuse address; for sockets used for c3_bind()
+constexpr int C3_SOCK_REUSE_PORT   = 0x04; // share port with other sockets; for listening sockets
 
 // minimum size of a buffer for an IPv4 address: 3 digits * 4 groups + 3 dots + 1 terminating '\0'
 constexpr size_t C3_SOCK_MIN_ADDR_LENGTH = 16;
@@ -0,0 +1,522 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include "c3_uring.h"
+#include "c3_errors.h"
+#include "c3_files.h"
+#include "c3_profiler_defs.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#if C3_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace CyberCache {
+
+///////////////////////////////////////////////////////////////////////////////
+// IoRing
+///////////////////////////////////////////////////////////////////////////////
+
+IoRing::IoRing() noexcept {
+  ir_fd = -1;
+  ir_sq_ring = nullptr;
+  ir_sq_ring_size = 0;
+  ir_cq_ring = nullptr;
+  ir_cq_ring_size = 0;
+  ir_sqes = nullptr;
+  ir_sqes_size = 0;
+  ir_sq_head = nullptr;
+  ir_sq_tail = nullptr;
+  ir_sq_array = nullptr;
+  ir_cq_head = nullptr;
+  ir_cq_tail = nullptr;
+  ir_cqes = nullptr;
+  ir_sq_mask = 0;
+  ir_cq_mask = 0;
+  ir_num_queued = 0;
+  ir_num_in_flight = 0;
+}
+
+#if C3_IO_URING
+
+static c3_uint_t* get_ring_field(void* ring, c3_uint_t offset) {
+  return (c3_uint_t*)((c3_byte_t*) ring + offset);
+}
+
+bool IoRing::initialize(c3_uint_t num_entries) {
+  c3_assert(ir_fd < 0 && num_entries > 0);
+  io_uring_params params;
+  std::memset(&params, 0, sizeof params);
+  int fd = (int) syscall(__NR_io_uring_setup, num_entries, &params);
+  if (fd < 0) {
+    c3_set_stdlib_error_message();
+    return false;
+  }
+  ir_fd = fd;
+  ir_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(c3_uint_t);
+  ir_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  #ifdef IORING_FEAT_SINGLE_MMAP
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  #else
+  bool single_mmap = false;
+  #endif
+  if (single_mmap) {
+    // kernel 5.4+ maps both rings with a single call
+    if (ir_cq_ring_size > ir_sq_ring_size) {
+      ir_sq_ring_size = ir_cq_ring_size;
+    }
+    ir_cq_ring_size = 0;
+  }
+  ir_sq_ring = mmap(nullptr, ir_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+    fd, IORING_OFF_SQ_RING);
+  if (ir_sq_ring == MAP_FAILED) {
+    ir_sq_ring = nullptr;
+    c3_set_stdlib_error_message();
+    dispose();
+    return false;
+  }
+  if (single_mmap) {
+    ir_cq_ring = ir_sq_ring;
+  } else {
+    ir_cq_ring = mmap(nullptr, ir_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      fd, IORING_OFF_CQ_RING);
+    if (ir_cq_ring == MAP_FAILED) {
+      ir_cq_ring = nullptr;
+      c3_set_stdlib_error_message();
+      dispose();
+      return false;
+    }
+  }
+  ir_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  ir_sqes = mmap(nullptr, ir_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+    fd, IORING_OFF_SQES);
+  if (ir_sqes == MAP_FAILED) {
+    ir_sqes = nullptr;
+    c3_set_stdlib_error_message();
+    dispose();
+    return false;
+  }
+  ir_sq_head = get_ring_field(ir_sq_ring, params.sq_off.head);
+  ir_sq_tail = get_ring_field(ir_sq_ring, params.sq_off.tail);
+  ir_sq_array = get_ring_field(ir_sq_ring, params.sq_off.array);
+  ir_sq_mask = *get_ring_field(ir_sq_ring, params.sq_off.ring_mask);
+  ir_cq_head = get_ring_field(ir_cq_ring, params.cq_off.head);
+  ir_cq_tail = get_ring_field(ir_cq_ring, params.cq_off.tail);
+  ir_cqes = get_ring_field(ir_cq_ring, params.cq_off.cqes);
+  ir_cq_mask = *get_ring_field(ir_cq_ring, params.cq_off.ring_mask);
+  return true;
+}
+
+bool IoRing::register_buffers(const iovec* buffers, c3_uint_t num) {
+  c3_assert(ir_fd >= 0 && buffers && num);
+  if (syscall(__NR_io_uring_register, ir_fd, IORING_REGISTER_BUFFERS, buffers, num) < 0) {
+    c3_set_stdlib_error_message();
+    return false;
+  }
+  return true;
+}
+
+void IoRing::dispose() {
+  if (ir_sqes != nullptr) {
+    munmap(ir_sqes, ir_sqes_size);
+    ir_sqes = nullptr;
+  }
+  if (ir_cq_ring != nullptr && ir_cq_ring != ir_sq_ring) {
+    munmap(ir_cq_ring, ir_cq_ring_size);
+  }
+  ir_cq_ring = nullptr;
+  if (ir_sq_ring != nullptr) {
+    munmap(ir_sq_ring, ir_sq_ring_size);
+    ir_sq_ring = nullptr;
+  }
+  if (ir_fd >= 0) {
+    // this also unregisters buffers, and cancels requests that are still in flight
+    close(ir_fd);
+    ir_fd = -1;
+  }
+  ir_num_queued = 0;
+  ir_num_in_flight = 0;
+}
+
+void* IoRing::get_sqe() {
+  c3_assert(ir_fd >= 0);
+  c3_uint_t head = __atomic_load_n(ir_sq_head, __ATOMIC_ACQUIRE);
+  c3_uint_t tail = *ir_sq_tail + ir_num_queued;
+  if (tail - head > ir_sq_mask) {
+    return nullptr; // submission queue is full
+  }
+  c3_uint_t index = tail & ir_sq_mask;
+  ir_sq_array[index] = index;
+  ir_num_queued++;
+  auto sqe = (io_uring_sqe*) ir_sqes + index;
+  std::memset(sqe, 0, sizeof(io_uring_sqe));
+  return sqe;
+}
+
+bool IoRing::queue_write(int fd, const iovec* buffer, int buffer_index, c3_ulong_t offset, c3_ulong_t data) {
+  c3_assert(fd > 0 && buffer && buffer->iov_base && buffer->iov_len);
+  auto sqe = (io_uring_sqe*) get_sqe();
+  if (sqe != nullptr) {
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->user_data = data;
+    if (buffer_index >= 0) {
+      // registered buffer: the kernel does not have to map user pages for each write
+      sqe->opcode = IORING_OP_WRITE_FIXED;
+      sqe->addr = (c3_ulong_t) buffer->iov_base;
+      sqe->len = (c3_uint_t) buffer->iov_len;
+      sqe->buf_index = (c3_ushort_t) buffer_index;
+    } else {
+      sqe->opcode = IORING_OP_WRITEV;
+      sqe->addr = (c3_ulong_t) buffer;
+      sqe->len = 1;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool IoRing::submit(c3_uint_t min_complete) {
+  c3_assert(ir_fd >= 0);
+  c3_uint_t num_queued = ir_num_queued;
+  if (num_queued > 0) {
+    // make entries visible to the kernel before the tail is updated
+    __atomic_store_n(ir_sq_tail, *ir_sq_tail + num_queued, __ATOMIC_RELEASE);
+    ir_num_queued = 0;
+    ir_num_in_flight += num_queued;
+  }
+  if (num_queued == 0 && min_complete == 0) {
+    return true;
+  }
+  c3_uint_t flags = min_complete > 0? IORING_ENTER_GETEVENTS: 0;
+  c3_uint_t num_to_submit = num_queued;
+  for (;;) {
+    long n = syscall(__NR_io_uring_enter, ir_fd, num_to_submit, min_complete, flags, nullptr, 0);
+    if (n >= 0) {
+      PERF_INCREMENT_COUNTER(IO_Ring_Enter_Calls)
+      return true;
+    }
+    if (errno != EINTR) {
+      c3_set_stdlib_error_message();
+      return false;
+    }
+    // if interrupted, entries could have been consumed anyway; kernel ignores count of missing entries
+    num_to_submit = 0;
+  }
+}
+
+bool IoRing::get_completion(c3_ulong_t& data, int& result) {
+  c3_assert(ir_fd >= 0);
+  c3_uint_t head = *ir_cq_head;
+  if (head != __atomic_load_n(ir_cq_tail, __ATOMIC_ACQUIRE)) {
+    const io_uring_cqe& cqe = ((const io_uring_cqe*) ir_cqes)[head & ir_cq_mask];
+    data = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(ir_cq_head, head + 1, __ATOMIC_RELEASE);
+    c3_assert(ir_num_in_flight);
+    ir_num_in_flight--;
+    return true;
+  }
+  return false;
+}
+
+bool IoRing::is_supported() {
+  IoRing ring;
+  return ring.initialize(1);
+}
+
+#else // !C3_IO_URING
+
+bool IoRing::initialize(c3_uint_t num_entries) {
+  c3_set_error_message("Asynchronous I/O using 'io_uring' is not supported on this platform");
+  return false;
+}
+
+bool IoRing::register_buffers(const iovec* buffers, c3_uint_t num) {
+  c3_assert_failure();
+  return false;
+}
+
+void IoRing::dispose() {
+}
+
+void* IoRing::get_sqe() {
+  c3_assert_failure();
+  return nullptr;
+}
+
+bool IoRing::queue_write(int fd, const iovec* buffer, int buffer_index, c3_ulong_t offset, c3_ulong_t data) {
+  c3_assert_failure();
+  return false;
+}
+
+bool IoRing::submit(c3_uint_t min_complete) {
+  c3_assert_failure();
+  return false;
+}
+
+bool IoRing::get_completion(c3_ulong_t& data, int& result) {
+  c3_assert_failure();
+  return false;
+}
+
+bool IoRing::is_supported() {
+  return false;
+}
+
+#endif // C3_IO_URING
+
+///////////////////////////////////////////////////////////////////////////////
+// RingFileWriter
+///////////////////////////////////////////////////////////////////////////////
+
+static thread_local RingFileWriter* ring_file_writer;
+
+RingFileWriter::RingFileWriter() noexcept {
+  for (c3_uint_t i = 0; i < NUM_BUFFERS; i++) {
+    rfw_buffers[i].iov_base = nullptr;
+    rfw_buffers[i].iov_len = 0;
+    rfw_offsets[i] = 0;
+    rfw_busy[i] = false;
+  }
+  rfw_memory = nullptr;
+  rfw_offset = 0;
+  rfw_fd = -1;
+  rfw_current = 0;
+  rfw_error = 0;
+  rfw_registered = false;
+}
+
+bool RingFileWriter::initialize(Memory& memory) {
+  c3_assert(!is_initialized() && rfw_memory == nullptr);
+  if (rfw_ring.initialize(RING_SIZE)) {
+    rfw_memory = &memory;
+    for (iovec& buffer: rfw_buffers) {
+      buffer.iov_base = memory.alloc(BUFFER_SIZE);
+      buffer.iov_len = BUFFER_SIZE;
+    }
+    // registration pins buffer pages, and can fail if "locked memory" limit is too low; that's not fatal
+    rfw_registered = rfw_ring.register_buffers(rfw_buffers, NUM_BUFFERS);
+    for (iovec& buffer: rfw_buffers) {
+      buffer.iov_len = 0;
+    }
+    return true;
+  }
+  return false;
+}
+
+void RingFileWriter::dispose() {
+  if (rfw_fd > 0) {
+    detach();
+  }
+  rfw_ring.dispose();
+  if (rfw_memory != nullptr) {
+    for (iovec& buffer: rfw_buffers) {
+      rfw_memory->free(buffer.iov_base, BUFFER_SIZE);
+      buffer.iov_base = nullptr;
+      buffer.iov_len = 0;
+    }
+    rfw_memory = nullptr;
+  }
+  rfw_registered = false;
+  if (ring_file_writer == this) {
+    ring_file_writer = nullptr;
+  }
+}
+
+bool RingFileWriter::attach(int fd) {
+  c3_assert(is_initialized() && rfw_fd < 0 && fd > 0 && !has_staged_data());
+  c3_long_t offset = c3_seek_file(fd, 0, PM_CURRENT);
+  if (offset >= 0) {
+    rfw_fd = fd;
+    rfw_offset = (c3_ulong_t) offset;
+    rfw_current = 0;
+    rfw_error = 0;
+    return true;
+  }
+  return false;
+}
+
+bool RingFileWriter::detach() {
+  c3_assert(rfw_fd > 0);
+  bool result = wait();
+  // subsequent regular writes must go after what we have written
+  if (c3_seek_file(rfw_fd, (c3_long_t) rfw_offset) < 0) {
+    result = false;
+  }
+  rfw_fd = -1;
+  return result;
+}
+
+bool RingFileWriter::complete(c3_uint_t i, int result) {
+  c3_assert(i < NUM_BUFFERS);
+  iovec& buffer = rfw_buffers[i];
+  rfw_busy[i] = false;
+  if (result < 0) {
+    if (rfw_error == 0) {
+      rfw_error = -result;
+    }
+  } else {
+    // the kernel may write less than requested (e.g. if disk is full); write the rest synchronously
+    auto bytes = (const c3_byte_t*) buffer.iov_base;
+    auto done = (size_t) result;
+    while (done < buffer.iov_len) {
+      ssize_t n = pwrite(rfw_fd, bytes + done, buffer.iov_len - done, (off_t)(rfw_offsets[i] + done));
+      if (n <= 0) {
+        if (rfw_error == 0) {
+          rfw_error = n < 0? errno: EIO;
+        }
+        break;
+      }
+      done += n;
+    }
+  }
+  buffer.iov_len = 0;
+  return rfw_error == 0;
+}
+
+bool RingFileWriter::reap(bool wait) {
+  bool reaped = false;
+  for (;;) {
+    c3_ulong_t data;
+    int result;
+    while (rfw_ring.get_completion(data, result)) {
+      c3_assert(data < NUM_BUFFERS && rfw_busy[data]);
+      complete((c3_uint_t) data, result);
+      reaped = true;
+    }
+    if (reaped || !wait || rfw_ring.get_num_in_flight() == 0) {
+      return true;
+    }
+    if (!rfw_ring.submit(1)) {
+      // we do not know what happened to the writes in flight, so we consider them failed
+      for (c3_uint_t i = 0; i < NUM_BUFFERS; i++) {
+        if (rfw_busy[i]) {
+          rfw_busy[i] = false;
+          rfw_buffers[i].iov_len = 0;
+          if (rfw_error == 0) {
+            rfw_error = errno != 0? errno: EIO;
+          }
+        }
+      }
+      return false;
+    }
+  }
+}
+
+bool RingFileWriter::submit_buffer(c3_uint_t i) {
+  c3_assert(i < NUM_BUFFERS && !rfw_busy[i] && rfw_fd > 0);
+  iovec& buffer = rfw_buffers[i];
+  c3_assert(buffer.iov_len);
+  rfw_offsets[i] = rfw_offset;
+  rfw_offset += buffer.iov_len;
+  if (rfw_ring.queue_write(rfw_fd, &buffer, rfw_registered? (int) i: -1, rfw_offsets[i], i) &&
+    rfw_ring.submit()) {
+    PERF_INCREMENT_COUNTER(IO_Ring_File_Writes)
+    rfw_busy[i] = true;
+    return true;
+  }
+  // could not submit: write the buffer synchronously
+  return complete(i, 0);
+}
+
+bool RingFileWriter::check_error() {
+  if (rfw_error != 0) {
+    // report the error once; after that, writer can be used again
+    c3_set_error_message(rfw_error);
+    rfw_error = 0;
+    return false;
+  }
+  return true;
+}
+
+io_result_t RingFileWriter::write(const c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t& nwritten) {
+  c3_assert(rfw_fd > 0 && buff && nbytes);
+  if (rfw_ring.get_num_in_flight() != 0) {
+    reap(false);
+  }
+  if (check_error()) {
+    iovec& buffer = rfw_buffers[rfw_current];
+    if (!rfw_busy[rfw_current] && buffer.iov_len == BUFFER_SIZE) {
+      submit_buffer(rfw_current);
+      rfw_current = (rfw_current + 1) % NUM_BUFFERS;
+    }
+    while (rfw_busy[rfw_current]) {
+      if (!reap(true)) {
+        break;
+      }
+    }
+    if (check_error()) {
+      iovec& current = rfw_buffers[rfw_current];
+      c3_assert(!rfw_busy[rfw_current] && current.iov_len < BUFFER_SIZE);
+      c3_uint_t n = (c3_uint_t)(BUFFER_SIZE - current.iov_len);
+      if (n > nbytes) {
+        n = nbytes;
+      }
+      std::memcpy((c3_byte_t*) current.iov_base + current.iov_len, buff, n);
+      current.iov_len += n;
+      nwritten = n;
+      return IO_RESULT_OK;
+    }
+  }
+  nwritten = 0;
+  return IO_RESULT_ERROR;
+}
+
+bool RingFileWriter::submit() {
+  c3_assert(rfw_fd > 0);
+  if (rfw_ring.get_num_in_flight() != 0) {
+    reap(false);
+  }
+  if (has_staged_data()) {
+    submit_buffer(rfw_current);
+    rfw_current = (rfw_current + 1) % NUM_BUFFERS;
+  }
+  return check_error();
+}
+
+bool RingFileWriter::wait() {
+  c3_assert(rfw_fd > 0);
+  for (;;) {
+    bool busy = false;
+    for (bool buffer_busy: rfw_busy) {
+      busy |= buffer_busy;
+    }
+    if (!busy && !has_staged_data()) {
+      return check_error();
+    }
+    if (has_staged_data()) {
+      submit_buffer(rfw_current);
+      rfw_current = (rfw_current + 1) % NUM_BUFFERS;
+    } else if (!reap(true)) {
+      return check_error();
+    }
+  }
+}
+
+RingFileWriter* RingFileWriter::get_thread_writer() {
+  return ring_file_writer;
+}
+
+void RingFileWriter::set_thread_writer(RingFileWriter* writer) {
+  ring_file_writer = writer;
+}
+
+} // CyberCache
@@ -0,0 +1,185 @@
+/**
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Support for asynchronous I/O using Linux `io_uring` interface (kernel 5.1+); system calls are made
+ * directly, so `liburing` is not required.
+ */
+#ifndef _C3_URING_H
+#define _C3_URING_H
+
+#include "c3_build.h"
+#include "c3_types.h"
+#include "c3_memory.h"
+#include "io_reader_writer.h"
+
+#include <sys/uio.h>
+
+#if !defined(C3_CYGWIN) && defined(__has_include)
+  #if __has_include(<linux/io_uring.h>)
+    #define C3_IO_URING 1
+  #endif
+#endif
+#ifndef C3_IO_URING
+  #define C3_IO_URING 0
+#endif
+
+namespace CyberCache {
+
+/// I/O backends that can be selected at startup
+enum io_backend_t: c3_byte_t {
+  IOB_INVALID = 0, // an invalid backend (placeholder)
+  IOB_EPOLL,       // readiness notifications using `epoll`, one system call per read or write
+  IOB_IO_URING,    // batched asynchronous submissions using `io_uring`
+  IOB_NUMBER_OF_ELEMENTS
+};
+
+/**
+ * Submission and completion queues of an `io_uring` instance.
+ *
+ * Objects of this class are not thread-safe: a ring is supposed to be used by the thread that created
+ * it. Requests are queued using `queue_xxx()` methods, and are not seen by the kernel until `submit()`
+ * is called, so that many requests can be passed to the kernel in a single system call.
+ */
+class IoRing {
+  int        ir_fd;            // ring descriptor, or -1 if ring is not initialized
+  void*      ir_sq_ring;       // mapped submission queue ring
+  size_t     ir_sq_ring_size;  // size of the mapped submission queue ring
+  void*      ir_cq_ring;       // mapped completion queue ring (may be the same as submission ring)
+  size_t     ir_cq_ring_size;  // size of the mapped completion queue ring
+  void*      ir_sqes;          // mapped array of submission queue entries
+  size_t     ir_sqes_size;     // size of the mapped array of submission queue entries
+  c3_uint_t* ir_sq_head;       // head of the submission queue (advanced by the kernel)
+  c3_uint_t* ir_sq_tail;       // tail of the submission queue (advanced by us)
+  c3_uint_t* ir_sq_array;      // indices of submission queue entries
+  c3_uint_t* ir_cq_head;       // head of the completion queue (advanced by us)
+  c3_uint_t* ir_cq_tail;       // tail of the completion queue (advanced by the kernel)
+  void*      ir_cqes;          // array of completion queue entries
+  c3_uint_t  ir_sq_mask;       // mask of submission queue ring indices
+  c3_uint_t  ir_cq_mask;       // mask of completion queue ring indices
+  c3_uint_t  ir_num_queued;    // number of requests queued since last submission
+  c3_uint_t  ir_num_in_flight; // number of submitted requests that have not been completed yet
+
+  void* get_sqe();
+
+public:
+  IoRing() noexcept;
+  IoRing(const IoRing&) = delete;
+  IoRing(IoRing&&) = delete;
+  ~IoRing() { dispose(); }
+
+  IoRing& operator=(const IoRing&) = delete;
+  IoRing& operator=(IoRing&&) = delete;
+
+  bool is_initialized() const { return ir_fd >= 0; }
+  c3_uint_t get_num_in_flight() const { return ir_num_in_flight; }
+
+  bool initialize(c3_uint_t num_entries) C3_FUNC_COLD;
+  bool register_buffers(const iovec* buffers, c3_uint_t num) C3_FUNC_COLD;
+  void dispose() C3_FUNC_COLD;
+
+  /**
+   * Queues writing to a file at specified offset.
+   *
+   * @param fd File descriptor
+   * @param buffer Data to write; must remain valid until request is completed
+   * @param buffer_index Index of registered buffer containing data, or -1 if buffers were not registered
+   * @param offset Offset in the file
+   * @param data User data to be returned along with request completion
+   * @return `true` on success, `false` if submission queue is full
+   */
+  bool queue_write(int fd, const iovec* buffer, int buffer_index, c3_ulong_t offset, c3_ulong_t data);
+
+  /**
+   * Submits all queued requests to the kernel, and optionally waits for completions.
+   *
+   * @param min_complete Number of completions to wait for
+   * @return `true` on success, `false` on error (error message is set)
+   */
+  bool submit(c3_uint_t min_complete = 0);
+
+  /**
+   * Retrieves next completion, if there is one available; does not wait.
+   *
+   * @param data Where to store user data passed to `queue_xxx()` method
+   * @param result Where to store request result (number of bytes, or negated error code)
+   * @return `true` if a completion had been retrieved, `false` otherwise
+   */
+  bool get_completion(c3_ulong_t& data, int& result);
+
+  static bool is_supported() C3_FUNC_COLD;
+};
+
+/**
+ * Writer that copies data into staging buffers, and writes them to a file using `io_uring` requests.
+ *
+ * Data are written at explicit offsets, so while one buffer is being written by the kernel, the other
+ * one can be filled; the writing thread only waits if it fills the second buffer before the first one is
+ * written out. When attached to a file, this writer intercepts all `FileWriter::write_bytes()` calls
+ * made by its thread for that file. When writer is detached, all pending data are written out, and file
+ * position is set to the end of written data (so that regular `write()` calls could follow).
+ *
+ * A failed write is reported by next call to `write()`, `submit()`, `wait()`, or `detach()`.
+ */
+class RingFileWriter {
+  static constexpr c3_uint_t NUM_BUFFERS = 2;           // number of staging buffers
+  static constexpr c3_uint_t BUFFER_SIZE = 256 * 1024;  // size of each staging buffer
+  static constexpr c3_uint_t RING_SIZE = 8;             // number of entries in the ring
+
+  IoRing     rfw_ring;                  // ring used to submit writes
+  iovec      rfw_buffers[NUM_BUFFERS];  // staging buffers and sizes of their contents
+  c3_ulong_t rfw_offsets[NUM_BUFFERS];  // file offsets of buffers' contents
+  bool       rfw_busy[NUM_BUFFERS];     // whether buffers are being written by the kernel
+  Memory*    rfw_memory;                // memory object that allocated buffers
+  c3_ulong_t rfw_offset;                // file offset of the next staged byte
+  int        rfw_fd;                    // file being written, or -1 if writer is detached
+  c3_uint_t  rfw_current;               // index of the buffer being filled
+  int        rfw_error;                 // code of the first failed write, or 0
+  bool       rfw_registered;            // whether buffers had been registered with the ring
+
+  bool complete(c3_uint_t i, int result);
+  bool reap(bool wait);
+  bool submit_buffer(c3_uint_t i);
+  bool check_error();
+
+public:
+  RingFileWriter() noexcept;
+  RingFileWriter(const RingFileWriter&) = delete;
+  RingFileWriter(RingFileWriter&&) = delete;
+  ~RingFileWriter() { dispose(); }
+
+  RingFileWriter& operator=(const RingFileWriter&) = delete;
+  RingFileWriter& operator=(RingFileWriter&&) = delete;
+
+  bool is_initialized() const { return rfw_ring.is_initialized(); }
+  bool is_attached(int fd) const { return rfw_fd == fd && fd > 0; }
+  bool has_staged_data() const { return !rfw_busy[rfw_current] && rfw_buffers[rfw_current].iov_len != 0; }
+
+  bool initialize(Memory& memory) C3_FUNC_COLD;
+  void dispose() C3_FUNC_COLD;
+  bool attach(int fd) C3_FUNC_COLD;
+  bool detach() C3_FUNC_COLD;
+
+  io_result_t write(const c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t& nwritten);
+  bool submit();
+  bool wait();
+
+  static RingFileWriter* get_thread_writer();
+  static void set_thread_writer(RingFileWriter* writer) C3_FUNC_COLD;
+};
+
+} // CyberCache
+
+#endif // _C3_URING_H
@@ -48,6 +48,7 @@
 #include "c3_sockets_io.h"
 #include "c3_files.h"
 #include "c3_file_base.h"
+#include "c3_uring.h"
 #include "c3_compressor.h"
 #include "c3_hasher.h"
 #include "c3_parser.h"
@@ -0,0 +1,127 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include "engine_asciient.h"
+#include "engine_asciient_table.h"
+
+namespace CyberCache {
+
+CompressorAsciient::CompressorAsciient() noexcept {
+  /*
+   * Canonical codes are assigned in the order of increasing lengths, and, within codes of the same
+   * length, in the order of byte values; this is how `asciient` utility expects them to be assigned.
+   */
+  c3_uint_t code = 0;
+  for (c3_uint_t length = 1; length <= MAX_CODE_LENGTH; length++) {
+    for (c3_uint_t value = 0; value < 256; value++) {
+      if (asciient_code_lengths[value] == length) {
+        c3_uint_t reversed = 0;
+        for (c3_uint_t i = 0; i < length; i++) {
+          reversed |= ((code >> i) & 1) << (length - 1 - i);
+        }
+        as_codes[value] = (c3_ushort_t) reversed;
+        as_lengths[value] = (c3_byte_t) length;
+        // all lookup table entries that start with this code must resolve to the same value
+        for (c3_uint_t entry = reversed; entry < LOOKUP_TABLE_SIZE; entry += 1 << length) {
+          as_lookup[entry] = (c3_ushort_t)(value | (length << 8));
+        }
+        code++;
+      }
+    }
+    if (length < MAX_CODE_LENGTH) {
+      code <<= 1;
+    }
+  }
+  // there must be neither unused codes, nor byte values without codes
+  c3_assert(code == LOOKUP_TABLE_SIZE);
+}
+
+const char* CompressorAsciient::get_name() {
+  return "Asciient";
+}
+
+size_t CompressorAsciient::get_compressed_size(c3_uint_t size) {
+  return size;
+}
+
+c3_uint_t CompressorAsciient::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+  comp_level_t level, comp_data_t hint) {
+  if (src_size <= 1 || dst_size == 0) {
+    return 0;
+  }
+  // compressed data has to be smaller than source data, otherwise compression has failed
+  c3_uint_t max_size = src_size - 1;
+  if (dst_size < max_size) {
+    max_size = (c3_uint_t) dst_size;
+  }
+  c3_byte_t* dst_pos = dst;
+  const c3_byte_t* const dst_end = dst + max_size;
+  c3_ulong_t bits = 0;
+  c3_uint_t num_bits = 0;
+  for (c3_uint_t i = 0; i < src_size; i++) {
+    c3_byte_t value = src[i];
+    bits |= (c3_ulong_t) as_codes[value] << num_bits;
+    num_bits += as_lengths[value];
+    if (num_bits >= 32) {
+      if (dst_end - dst_pos < 4) {
+        return 0;
+      }
+      dst_pos[0] = (c3_byte_t) bits;
+      dst_pos[1] = (c3_byte_t)(bits >> 8);
+      dst_pos[2] = (c3_byte_t)(bits >> 16);
+      dst_pos[3] = (c3_byte_t)(bits >> 24);
+      dst_pos += 4;
+      bits >>= 32;
+      num_bits -= 32;
+    }
+  }
+  // flush remaining bits, including the last partially filled byte
+  while (num_bits > 0) {
+    if (dst_pos == dst_end) {
+      return 0;
+    }
+    *dst_pos++ = (c3_byte_t) bits;
+    bits >>= 8;
+    num_bits = num_bits > 8? num_bits - 8: 0;
+  }
+  return (c3_uint_t)(dst_pos - dst);
+}
+
+bool CompressorAsciient::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) {
+  const c3_byte_t* src_pos = src;
+  const c3_byte_t* const src_end = src + src_size;
+  c3_ulong_t bits = 0;
+  c3_uint_t num_bits = 0;
+  for (c3_uint_t i = 0; i < dst_size; i++) {
+    if (num_bits < MAX_CODE_LENGTH) {
+      while (num_bits <= 56 && src_pos < src_end) {
+        bits |= (c3_ulong_t) *src_pos++ << num_bits;
+        num_bits += 8;
+      }
+    }
+    // missing bits past the end of compressed data are zeroes, which is caught by the length check
+    c3_ushort_t entry = as_lookup[bits & (LOOKUP_TABLE_SIZE - 1)];
+    c3_uint_t length = entry >> 8;
+    if (length > num_bits) {
+      return false;
+    }
+    dst[i] = (c3_byte_t) entry;
+    bits >>= length;
+    num_bits -= length;
+  }
+  return true;
+}
+
+} // CyberCache
@@ -0,0 +1,60 @@
+/**
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Implementation of the Asciient compression engine.
+ */
+#ifndef _ENGINE_ASCIIENT_H
+#define _ENGINE_ASCIIENT_H
+
+#include "c3lib/c3_compressor.h"
+
+namespace CyberCache {
+
+/**
+ * Asciient is a Huffman compressor with fixed codes that were built in advance (using the `asciient`
+ * utility) from samples of small Magento records, so that there is no need to store code tables along
+ * with compressed data. This makes it suitable for buffers of a few hundred bytes, which are too small
+ * for LZ-type compressors: it never gives up on a record, and always yields compression ratio that is
+ * close to what order-0 entropy of the training data would allow.
+ *
+ * Codes are canonical, their lengths are limited to `MAX_CODE_LENGTH` bits, and they are stored LSB
+ * first (bit-reversed); this allows unpacking each byte using single lookup into a table indexed with
+ * next `MAX_CODE_LENGTH` bits of compressed data. Both packing and unpacking process data using 64-bit
+ * bit buffer, and are branch-free on the per-bit level.
+ */
+class CompressorAsciient: public CompressorEngine {
+  friend class CompressorLibrary;
+
+  static constexpr c3_uint_t MAX_CODE_LENGTH = 12;
+  static constexpr c3_uint_t LOOKUP_TABLE_SIZE = 1 << MAX_CODE_LENGTH;
+
+  c3_ushort_t as_codes[256];                // bit-reversed codes of all byte values
+  c3_byte_t   as_lengths[256];              // lengths of codes of all byte values, bits
+  c3_ushort_t as_lookup[LOOKUP_TABLE_SIZE]; // byte value (low byte) and code length (high byte)
+
+  const char* get_name() override;
+  size_t get_compressed_size(c3_uint_t size) override;
+  c3_uint_t pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+    comp_level_t level, comp_data_t hint) override;
+  bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) override;
+
+public:
+  CompressorAsciient() noexcept;
+};
+
+} // CyberCache
+
+#endif // _ENGINE_ASCIIENT_H
@@ -0,0 +1,45 @@
+/**
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Code lengths of the `asciient` compressor; generated by the `asciient` utility, do not edit.
+ */
+#ifndef _ENGINE_ASCIIENT_TABLE_H
+#define _ENGINE_ASCIIENT_TABLE_H
+
+namespace CyberCache {
+
+static const c3_byte_t asciient_code_lengths[256] = {
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  7, 12, 12, 12, 12, 12, // 0x00..0x0F
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0x10..0x1F
+   4, 12,  5, 10, 11, 12, 12, 11,  8,  8,  9, 12,  8,  7,  6,  6, // 0x20..0x2F
+   6,  6,  7,  7,  8,  7,  7,  7,  7,  8,  4,  5, 11, 10, 10, 12, // 0x30..0x3F
+  12,  8, 12,  9, 11,  9, 11, 11, 11, 10, 12,  9,  9,  9,  9, 10, // 0x40..0x4F
+  10, 12,  9,  9,  9, 11, 12,  9,  9, 12, 12, 11, 12, 11, 12,  5, // 0x50..0x5F
+   8,  5,  7,  6,  5,  4,  7,  7,  6,  5, 12,  9,  5,  6,  5,  5, // 0x60..0x6F
+   6, 10,  5,  4,  4,  6,  7,  7,  7,  8,  9,  8,  8,  8, 12, 12, // 0x70..0x7F
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0x80..0x8F
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0x90..0x9F
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0xA0..0xAF
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0xB0..0xBF
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0xC0..0xCF
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0xD0..0xDF
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // 0xE0..0xEF
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12  // 0xF0..0xFF
+};
+
+} // CyberCache
+
+#endif // _ENGINE_ASCIIENT_TABLE_H
@@ -28,16 +28,17 @@ size_t CompressorBrotli::get_compressed_size(c3_uint_t size) {
   return BrotliEncoderMaxCompressedSize(size);
 }
 
+static_assert(CL_NUMBER_OF_ELEMENTS == 4, "Number of compression levels is not four");
+static const int brotli_quality[CL_NUMBER_OF_ELEMENTS] = {
+  1,  // CL_FASTEST => FAST_TWO_PASS_COMPRESSION_QUALITY
+  5,  // CL_AVERAGE => MIN_QUALITY_FOR_EXTENSIVE_REFERENCE_SEARCH, MIN_QUALITY_FOR_CONTEXT_MODELING
+  11, // CL_BEST ==> MIN_QUALITY_FOR_RECOMPUTE_DISTANCE_PREFIXES + 1
+  99  // CL_EXTREME => Brotli seems to accept any two-digit numbers, even though it doesn't matter much
+};
+
 c3_uint_t CompressorBrotli::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
   comp_level_t level, comp_data_t hint) {
   BrotliEncoderMode mode = hint == CD_TEXT? BROTLI_MODE_TEXT: BROTLI_MODE_GENERIC;
-  static_assert(CL_NUMBER_OF_ELEMENTS == 4, "Number of compression levels is not four");
-  static const int brotli_quality[CL_NUMBER_OF_ELEMENTS] = {
-    1,  // CL_FASTEST => FAST_TWO_PASS_COMPRESSION_QUALITY
-    5,  // CL_AVERAGE => MIN_QUALITY_FOR_EXTENSIVE_REFERENCE_SEARCH, MIN_QUALITY_FOR_CONTEXT_MODELING
-    11, // CL_BEST ==> MIN_QUALITY_FOR_RECOMPUTE_DISTANCE_PREFIXES + 1
-    99  // CL_EXTREME => Brotli seems to accept any two-digit numbers, even though it doesn't matter much
-  };
   size_t compressed_size = dst_size;
   BROTLI_BOOL result = BrotliEncoderCompress(brotli_quality[level], BROTLI_DEFAULT_WINDOW, mode,
     src_size, src, &compressed_size, dst);
@@ -53,4 +54,53 @@ bool CompressorBrotli::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_
   return result == BROTLI_DECODER_RESULT_SUCCESS && uncompressed_size == (size_t) dst_size;
 }
 
+bool CompressorBrotli::supports_dictionaries() {
+  return true;
+}
+
+c3_uint_t CompressorBrotli::pack_with_dictionary(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst,
+  size_t dst_size, comp_level_t level, comp_data_t hint, const CompressorDictionary& dictionary) {
+  // encoder state cannot be re-used for multiple streams, so we have to create a new one for each call
+  BrotliEncoderState* state = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+  if (state == nullptr) {
+    return 0;
+  }
+  BrotliEncoderMode mode = hint == CD_TEXT? BROTLI_MODE_TEXT: BROTLI_MODE_GENERIC;
+  BrotliEncoderSetParameter(state, BROTLI_PARAM_MODE, (uint32_t) mode);
+  BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, (uint32_t) brotli_quality[level]);
+  BrotliEncoderSetParameter(state, BROTLI_PARAM_LGWIN, BROTLI_DEFAULT_WINDOW);
+  BrotliEncoderSetCustomDictionary(state, dictionary.get_size(), dictionary.get_data());
+  size_t available_in = src_size;
+  const uint8_t* next_in = src;
+  size_t available_out = dst_size;
+  uint8_t* next_out = dst;
+  size_t compressed_size = 0;
+  BROTLI_BOOL result = BrotliEncoderCompressStream(state, BROTLI_OPERATION_FINISH,
+    &available_in, &next_in, &available_out, &next_out, &compressed_size);
+  bool finished = result == BROTLI_TRUE && BrotliEncoderIsFinished(state) == BROTLI_TRUE;
+  BrotliEncoderDestroyInstance(state);
+  if (finished && compressed_size > 0 && compressed_size < (size_t) src_size) {
+    return (c3_uint_t) compressed_size;
+  }
+  return 0;
+}
+
+bool CompressorBrotli::unpack_with_dictionary(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst,
+  c3_uint_t dst_size, const CompressorDictionary& dictionary) {
+  BrotliDecoderState* state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+  if (state == nullptr) {
+    return false;
+  }
+  BrotliDecoderSetCustomDictionary(state, dictionary.get_size(), dictionary.get_data());
+  size_t available_in = src_size;
+  const uint8_t* next_in = src;
+  size_t available_out = dst_size;
+  uint8_t* next_out = dst;
+  size_t uncompressed_size = 0;
+  BrotliDecoderResult result = BrotliDecoderDecompressStream(state,
+    &available_in, &next_in, &available_out, &next_out, &uncompressed_size);
+  BrotliDecoderDestroyInstance(state);
+  return result == BROTLI_DECODER_RESULT_SUCCESS && uncompressed_size == (size_t) dst_size;
+}
+
 } // CyberCache
@@ -38,6 +38,11 @@ class CompressorBrotli: public CompressorEngine {
   c3_uint_t pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
     comp_level_t level, comp_data_t hint) override;
   bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) override;
+  bool supports_dictionaries() override;
+  c3_uint_t pack_with_dictionary(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+    comp_level_t level, comp_data_t hint, const CompressorDictionary& dictionary) override;
+  bool unpack_with_dictionary(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size,
+    const CompressorDictionary& dictionary) override;
 };
 
 } // CyberCache
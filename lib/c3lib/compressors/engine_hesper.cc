@@ -0,0 +1,174 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include "engine_hesper.h"
+
+#include <cstring>
+
+namespace CyberCache {
+
+/// Control codes (with zero length bits) of all run types
+static const c3_byte_t hesper_control_codes[] = {
+  0x00, // RT_INVALID (never used)
+  0x10, // RT_DIGITS: 10xxx
+  0x00, // RT_CAPITALS: 0xxxx
+  0x18  // RT_LETTERS: 11xxx
+};
+
+/// Code of the newline character within `RT_LETTERS` runs (it takes place of the unprintable 0x7F)
+static constexpr c3_byte_t HESPER_NEWLINE_CODE = 0x7F - 0x60;
+
+CompressorHesper::CompressorHesper() noexcept {
+  std::memset(hs_types, RT_INVALID, sizeof hs_types);
+  std::memset(hs_codes, 0, sizeof hs_codes);
+  std::memset(hs_values, 0, sizeof hs_values);
+  for (c3_uint_t code = 0; code < 32; code++) {
+    hs_types[0x20 + code] = RT_DIGITS;
+    hs_codes[0x20 + code] = (c3_byte_t) code;
+    hs_values[RT_DIGITS][code] = (c3_byte_t)(0x20 + code);
+    hs_types[0x40 + code] = RT_CAPITALS;
+    hs_codes[0x40 + code] = (c3_byte_t) code;
+    hs_values[RT_CAPITALS][code] = (c3_byte_t)(0x40 + code);
+    if (code != HESPER_NEWLINE_CODE) {
+      hs_types[0x60 + code] = RT_LETTERS;
+      hs_codes[0x60 + code] = (c3_byte_t) code;
+      hs_values[RT_LETTERS][code] = (c3_byte_t)(0x60 + code);
+    }
+  }
+  hs_types['\n'] = RT_LETTERS;
+  hs_codes['\n'] = HESPER_NEWLINE_CODE;
+  hs_values[RT_LETTERS][HESPER_NEWLINE_CODE] = '\n';
+}
+
+const char* CompressorHesper::get_name() {
+  return "Hesper";
+}
+
+size_t CompressorHesper::get_compressed_size(c3_uint_t size) {
+  return size;
+}
+
+c3_uint_t CompressorHesper::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+  comp_level_t level, comp_data_t hint) {
+  if (src_size <= 1 || dst_size == 0) {
+    return 0;
+  }
+  // compressed data has to be smaller than source data, otherwise compression has failed
+  c3_uint_t max_size = src_size - 1;
+  if (dst_size < max_size) {
+    max_size = (c3_uint_t) dst_size;
+  }
+  c3_byte_t* dst_pos = dst;
+  const c3_byte_t* const dst_end = dst + max_size;
+  const c3_byte_t* src_pos = src;
+  const c3_byte_t* const src_end = src + src_size;
+  c3_ulong_t bits = 0;
+  c3_uint_t num_bits = 0;
+  while (src_pos < src_end) {
+    // find out type and length of the run
+    c3_byte_t type = hs_types[*src_pos];
+    if (type == RT_INVALID) {
+      return 0;
+    }
+    c3_uint_t max_length = type == RT_CAPITALS? 16: 8;
+    const c3_byte_t* run_end = (c3_uint_t)(src_end - src_pos) > max_length? src_pos + max_length: src_end;
+    const c3_byte_t* run = src_pos + 1;
+    while (run < run_end && hs_types[*run] == type) {
+      run++;
+    }
+    // put control code and codes of all the characters of the run into the bit buffer
+    bits |= (c3_ulong_t)(hesper_control_codes[type] | (c3_uint_t)(run - src_pos - 1)) << num_bits;
+    num_bits += 5;
+    do {
+      bits |= (c3_ulong_t) hs_codes[*src_pos] << num_bits;
+      num_bits += 5;
+      if (num_bits >= 32) {
+        if (dst_end - dst_pos < 4) {
+          return 0;
+        }
+        dst_pos[0] = (c3_byte_t) bits;
+        dst_pos[1] = (c3_byte_t)(bits >> 8);
+        dst_pos[2] = (c3_byte_t)(bits >> 16);
+        dst_pos[3] = (c3_byte_t)(bits >> 24);
+        dst_pos += 4;
+        bits >>= 32;
+        num_bits -= 32;
+      }
+    } while (++src_pos < run);
+  }
+  // flush remaining bits, including the last partially filled byte
+  while (num_bits > 0) {
+    if (dst_pos == dst_end) {
+      return 0;
+    }
+    *dst_pos++ = (c3_byte_t) bits;
+    bits >>= 8;
+    num_bits = num_bits > 8? num_bits - 8: 0;
+  }
+  return (c3_uint_t)(dst_pos - dst);
+}
+
+bool CompressorHesper::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) {
+  if (src_size == 0) {
+    return false;
+  }
+  const c3_byte_t* src_pos = src;
+  const c3_byte_t* const src_end = src + src_size;
+  c3_byte_t* dst_pos = dst;
+  const c3_byte_t* const dst_end = dst + dst_size;
+  c3_ulong_t bits = 0;
+  c3_uint_t num_bits = 0;
+  while (dst_pos < dst_end) {
+    while (num_bits <= 56 && src_pos < src_end) {
+      bits |= (c3_ulong_t) *src_pos++ << num_bits;
+      num_bits += 8;
+    }
+    if (num_bits < 5) {
+      return false;
+    }
+    auto control = (c3_uint_t)(bits & 0x1F);
+    bits >>= 5;
+    num_bits -= 5;
+    c3_uint_t length;
+    const c3_byte_t* values;
+    if ((control & 0x10) != 0) {
+      length = (control & 0x07) + 1;
+      values = hs_values[(control & 0x08) != 0? RT_LETTERS: RT_DIGITS];
+    } else {
+      length = (control & 0x0F) + 1;
+      values = hs_values[RT_CAPITALS];
+    }
+    if ((c3_uint_t)(dst_end - dst_pos) < length) {
+      return false;
+    }
+    do {
+      if (num_bits < 5) {
+        while (num_bits <= 56 && src_pos < src_end) {
+          bits |= (c3_ulong_t) *src_pos++ << num_bits;
+          num_bits += 8;
+        }
+        if (num_bits < 5) {
+          return false;
+        }
+      }
+      *dst_pos++ = values[bits & 0x1F];
+      bits >>= 5;
+      num_bits -= 5;
+    } while (--length > 0);
+  }
+  return true;
+}
+
+} // CyberCache
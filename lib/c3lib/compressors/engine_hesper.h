@@ -0,0 +1,67 @@
+/**
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Implementation of the Hesper compression engine.
+ */
+#ifndef _ENGINE_HESPER_H
+#define _ENGINE_HESPER_H
+
+#include "c3lib/c3_compressor.h"
+
+namespace CyberCache {
+
+/**
+ * Hesper is a simple compressor of printable ASCII text meant for buffers that are too short for
+ * dictionary-based compressors to find repeating sequences in them. It can only handle printable ASCII
+ * characters and newlines, and gives up as soon as it stumbles upon anything else.
+ *
+ * Input bytes are compressed into "runs" of 5-bit codes (stored LSB first), first code in each run being
+ * type/length control code (`0xxxx` for up to 16 capitals, `10xxx` for up to 8 digits/punctuation, and
+ * `11xxx` for up to 8 small letters), and remaining codes being characters' offsets within the part of
+ * ASCII table that corresponds to the run type. Both packing and unpacking are table-driven, and process
+ * codes using a 64-bit bit buffer, so that there are no per-bit loops or per-character branches.
+ *
+ * The algorithm is named after Hesperonychus, the smallest known carnivorous dinosaur.
+ */
+class CompressorHesper: public CompressorEngine {
+  friend class CompressorLibrary;
+
+  /// Run types; those are also indices into `hs_values`
+  enum run_type_t: c3_byte_t {
+    RT_INVALID = 0, // unsupported character
+    RT_DIGITS,      // space, digits, and most punctuation marks
+    RT_CAPITALS,    // capital letters, underscore, and some punctuation characters
+    RT_LETTERS,     // small letters, some punctuation, and '\n'
+    RT_NUMBER_OF_ELEMENTS
+  };
+
+  c3_byte_t hs_types[256];                        // run types of all byte values
+  c3_byte_t hs_codes[256];                        // 5-bit codes of all byte values
+  c3_byte_t hs_values[RT_NUMBER_OF_ELEMENTS][32]; // byte values of all codes of each run type
+
+  const char* get_name() override;
+  size_t get_compressed_size(c3_uint_t size) override;
+  c3_uint_t pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+    comp_level_t level, comp_data_t hint) override;
+  bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) override;
+
+public:
+  CompressorHesper() noexcept;
+};
+
+} // CyberCache
+
+#endif // _ENGINE_HESPER_H
@@ -18,25 +18,13 @@
 
 namespace CyberCache {
 
-const char* CompressorLzham::get_name() {
-  return "Lzham";
-}
-
-size_t CompressorLzham::get_compressed_size(c3_uint_t size) {
-  return size;
-}
-
-c3_uint_t CompressorLzham::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
-  comp_level_t level, comp_data_t hint) {
-
-  static_assert(CL_NUMBER_OF_ELEMENTS == 4, "Number of compression levels is not four");
-  /*
-   * From README.md: "the m_table_update_rate decompression parameter MUST match the setting used during
-   * compression (same for the dictionary size)". Since we do not store compression settings anywhere,
-   * the `m_table_update_rate` and `m_dict_size_log2` must be set to some reasonable permanent values
-   * that do not depend on compression level.
-   */
-  lzham_compress_params params;
+/*
+ * From README.md: "the m_table_update_rate decompression parameter MUST match the setting used during
+ * compression (same for the dictionary size)". Since we do not store compression settings anywhere,
+ * the `m_table_update_rate` and `m_dict_size_log2` must be set to some reasonable permanent values
+ * that do not depend on compression level.
+ */
+static void init_compress_params(lzham_compress_params& params, comp_level_t level) {
   params.m_struct_size = sizeof(params);
   params.m_dict_size_log2 = 20; // 1Mb, *must* match decompressor setting
   params.m_level = LZHAM_COMP_LEVEL_FASTEST;
@@ -64,18 +52,9 @@ c3_uint_t CompressorLzham::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byt
     default:
       c3_assert_failure();
   }
-  size_t compressed_size = dst_size;
-  lzham_compress_status_t result = lzham_compress_memory(&params, dst, &compressed_size,
-    src, src_size, nullptr /* Adler32 checksum */);
-  if (result == LZHAM_COMP_STATUS_SUCCESS && compressed_size < (size_t) src_size) {
-    return (c3_uint_t) compressed_size;
-  }
-  return 0;
 }
 
-bool CompressorLzham::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) {
-
-  lzham_decompress_params params;
+static void init_decompress_params(lzham_decompress_params& params) {
   params.m_struct_size = sizeof(params);
   params.m_dict_size_log2 = 20; // 1Mb, *must* match compressor setting
   params.m_table_update_rate = LZHAM_DEFAULT_TABLE_UPDATE_RATE; // *must* match compressor setting
@@ -84,10 +63,101 @@ bool CompressorLzham::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t
   params.m_pSeed_bytes = nullptr;
   params.m_table_max_update_interval = 0; // == "don't care"
   params.m_table_update_interval_slow_rate = 0; // == "don't care"
+}
+
+CompressorLzham::CompressorLzham() noexcept {
+  for (c3_uint_t i = 0; i < CL_NUMBER_OF_ELEMENTS; i++) {
+    lh_compressors[i] = nullptr;
+  }
+  lh_decompressor = nullptr;
+}
+
+CompressorLzham::~CompressorLzham() {
+  for (c3_uint_t i = 0; i < CL_NUMBER_OF_ELEMENTS; i++) {
+    if (lh_compressors[i] != nullptr) {
+      lzham_compress_deinit(lh_compressors[i]);
+    }
+  }
+  if (lh_decompressor != nullptr) {
+    lzham_decompress_deinit(lh_decompressor);
+  }
+}
+
+const char* CompressorLzham::get_name() {
+  return "Lzham";
+}
+
+size_t CompressorLzham::get_compressed_size(c3_uint_t size) {
+  return size;
+}
+
+c3_uint_t CompressorLzham::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+  comp_level_t level, comp_data_t hint) {
+
+  static_assert(CL_NUMBER_OF_ELEMENTS == 4, "Number of compression levels is not four");
+  lzham_compress_state_ptr state = lh_compressors[level];
+  if (state == nullptr) {
+    lzham_compress_params params;
+    init_compress_params(params, level);
+    state = lzham_compress_init(&params);
+    if (state == nullptr) {
+      return 0;
+    }
+    lh_compressors[level] = state;
+  }
+  const c3_byte_t* in = src;
+  size_t in_remaining = src_size;
+  c3_byte_t* out = dst;
+  size_t out_remaining = dst_size;
+  lzham_compress_status_t result;
+  for (;;) {
+    size_t in_size = in_remaining;
+    size_t out_size = out_remaining;
+    result = lzham_compress(state, in, &in_size, out, &out_size, true);
+    in += in_size;
+    in_remaining -= in_size;
+    out += out_size;
+    out_remaining -= out_size;
+    if (result >= LZHAM_COMP_STATUS_FIRST_SUCCESS_OR_FAILURE_CODE) {
+      break;
+    }
+    if (out_remaining == 0) {
+      // compressed data would not be smaller than source data
+      result = LZHAM_COMP_STATUS_OUTPUT_BUF_TOO_SMALL;
+      break;
+    }
+  }
+  // get the state ready for the next call; the state is re-created if that fails
+  if (lzham_compress_reinit(state) == nullptr) {
+    lzham_compress_deinit(state);
+    lh_compressors[level] = nullptr;
+  }
+  size_t compressed_size = dst_size - out_remaining;
+  if (result == LZHAM_COMP_STATUS_SUCCESS && compressed_size < (size_t) src_size) {
+    return (c3_uint_t) compressed_size;
+  }
+  return 0;
+}
+
+bool CompressorLzham::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) {
+
+  lzham_decompress_params params;
+  init_decompress_params(params);
+  // if the state does not exist yet, `lzham_decompress_reinit()` creates it
+  lzham_decompress_state_ptr state = lzham_decompress_reinit(lh_decompressor, &params);
+  if (state == nullptr) {
+    if (lh_decompressor != nullptr) {
+      lzham_decompress_deinit(lh_decompressor);
+      lh_decompressor = nullptr;
+    }
+    return false;
+  }
+  lh_decompressor = state;
 
+  size_t compressed_size = src_size;
   size_t uncompressed_size = dst_size;
-  lzham_decompress_status_t result = lzham_decompress_memory(&params, dst, &uncompressed_size,
-    src, src_size, nullptr /* Adler32 checksum */);
+  lzham_decompress_status_t result = lzham_decompress(state, src, &compressed_size,
+    dst, &uncompressed_size, true);
   return result == LZHAM_DECOMP_STATUS_SUCCESS && uncompressed_size == (size_t) dst_size;
 }
 
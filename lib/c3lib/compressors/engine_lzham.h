@@ -25,15 +25,26 @@ namespace CyberCache {
 
 /**
  * Wrapper around Lzham compressor by Richard Geldreich, Jr.
+ *
+ * Compressor states (one per compression level) and decompressor state are created when they are
+ * needed for the first time, and are then re-initialized and re-used by all subsequent calls made by
+ * the same thread.
  */
 class CompressorLzham: public CompressorEngine {
   friend class CompressorLibrary;
 
+  void* lh_compressors[CL_NUMBER_OF_ELEMENTS]; // compressor states (`lzham_compress_state_ptr`), per level
+  void* lh_decompressor;                       // decompressor state (`lzham_decompress_state_ptr`)
+
   const char* get_name() override;
   size_t get_compressed_size(c3_uint_t size) override ;
   c3_uint_t pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
     comp_level_t level, comp_data_t hint) override;
   bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) override;
+
+public:
+  CompressorLzham() noexcept;
+  ~CompressorLzham();
 };
 
 } // CyberCache
@@ -16,8 +16,31 @@
 #include "engine_zlib.h"
 #include "compression/zlib/zlib.h"
 
+#include <cstring>
+
 namespace CyberCache {
 
+CompressorZlib::CompressorZlib() noexcept {
+  for (c3_uint_t i = 0; i < CL_NUMBER_OF_ELEMENTS; i++) {
+    zl_deflaters[i] = nullptr;
+  }
+  zl_inflater = nullptr;
+}
+
+CompressorZlib::~CompressorZlib() {
+  for (c3_uint_t i = 0; i < CL_NUMBER_OF_ELEMENTS; i++) {
+    z_stream* stream = zl_deflaters[i];
+    if (stream != nullptr) {
+      deflateEnd(stream);
+      dealloc<z_stream>(stream);
+    }
+  }
+  if (zl_inflater != nullptr) {
+    inflateEnd(zl_inflater);
+    dealloc<z_stream>(zl_inflater);
+  }
+}
+
 const char* CompressorZlib::get_name() {
   return "Zlib";
 }
@@ -35,18 +58,45 @@ c3_uint_t CompressorZlib::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte
     9,                     // CL_BEST
     9                      // CL_EXTREME
   };
-  uLongf compressed_size = dst_size;
-  int result = compress2(dst, &compressed_size, src, src_size, compression_levels[level]);
-  if (result == Z_OK && compressed_size < (size_t) src_size) {
-    return (c3_uint_t) compressed_size;
+  z_stream* stream = zl_deflaters[level];
+  if (stream == nullptr) {
+    stream = (z_stream*) std::memset(alloc<z_stream>(), 0, sizeof(z_stream));
+    if (deflateInit(stream, compression_levels[level]) != Z_OK) {
+      dealloc<z_stream>(stream);
+      return 0;
+    }
+    zl_deflaters[level] = stream;
+  } else if (deflateReset(stream) != Z_OK) {
+    return 0;
+  }
+  stream->next_in = const_cast<Bytef*>(src);
+  stream->avail_in = src_size;
+  stream->next_out = dst;
+  stream->avail_out = (uInt) dst_size;
+  // whole output fits into destination buffer (see `get_compressed_size()`), so a single call will do
+  if (deflate(stream, Z_FINISH) == Z_STREAM_END && stream->total_out < (uLong) src_size) {
+    return (c3_uint_t) stream->total_out;
   }
   return 0;
 }
 
 bool CompressorZlib::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) {
-  uLongf uncompressed_size = dst_size;
-  int result = uncompress(dst, &uncompressed_size, src, src_size);
-  return result == Z_OK && uncompressed_size == (size_t) dst_size;
+  z_stream* stream = zl_inflater;
+  if (stream == nullptr) {
+    stream = (z_stream*) std::memset(alloc<z_stream>(), 0, sizeof(z_stream));
+    if (inflateInit(stream) != Z_OK) {
+      dealloc<z_stream>(stream);
+      return false;
+    }
+    zl_inflater = stream;
+  } else if (inflateReset(stream) != Z_OK) {
+    return false;
+  }
+  stream->next_in = const_cast<Bytef*>(src);
+  stream->avail_in = src_size;
+  stream->next_out = dst;
+  stream->avail_out = dst_size;
+  return inflate(stream, Z_FINISH) == Z_STREAM_END && stream->total_out == (uLong) dst_size;
 }
 
 } // CyberCache
@@ -21,19 +21,31 @@
 
 #include "c3lib/c3_compressor.h"
 
+struct z_stream_s;
+
 namespace CyberCache {
 
 /**
  * Wrapper around Zlib/Gzip compressor.
+ *
+ * Deflate streams (one per compression level) and inflate stream are initialized when they are needed
+ * for the first time, and are then reset and re-used by all subsequent calls made by the same thread.
  */
 class CompressorZlib: public CompressorEngine {
   friend class CompressorLibrary;
 
+  z_stream_s* zl_deflaters[CL_NUMBER_OF_ELEMENTS]; // compression streams, one per level
+  z_stream_s* zl_inflater;                         // decompression stream
+
   const char* get_name() override;
   size_t get_compressed_size(c3_uint_t size) override;
   c3_uint_t pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
     comp_level_t level, comp_data_t hint) override;
   bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) override;
+
+public:
+  CompressorZlib() noexcept;
+  ~CompressorZlib();
 };
 
 } // CyberCache
@@ -14,10 +14,57 @@
  * GNU General Public License for more details.
  */
 #include "engine_zstd.h"
+#define ZSTD_STATIC_LINKING_ONLY
 #include "compression/zstd/zstd.h"
 
 namespace CyberCache {
 
+/*
+ * Contexts and digested dictionaries are allocated from global memory (just like library's own buffers),
+ * so that they are accounted for, and are subject to memory quota. Zstd does not pass block size to its
+ * `free` function, so each block is prefixed with its full size; prefix size preserves alignment.
+ */
+static constexpr size_t ZSTD_BLOCK_PREFIX_SIZE = 16;
+
+static void* zstd_alloc(void* opaque, size_t size) {
+  size_t full_size = size + ZSTD_BLOCK_PREFIX_SIZE;
+  auto block = (size_t*) global_memory.alloc(full_size);
+  *block = full_size;
+  return (c3_byte_t*) block + ZSTD_BLOCK_PREFIX_SIZE;
+}
+
+static void zstd_free(void* opaque, void* address) {
+  if (address != nullptr) {
+    auto block = (size_t*)((c3_byte_t*) address - ZSTD_BLOCK_PREFIX_SIZE);
+    global_memory.free(block, *block);
+  }
+}
+
+static const ZSTD_customMem zstd_allocator = { zstd_alloc, zstd_free, nullptr };
+
+CompressorZstd::CompressorZstd() noexcept {
+  for (c3_uint_t i = 0; i < CL_NUMBER_OF_ELEMENTS; i++) {
+    zs_cctxs[i] = nullptr;
+    zs_cdicts[i] = nullptr;
+    zs_cdict_ids[i] = CDICT_NONE;
+  }
+  zs_dctx = nullptr;
+}
+
+CompressorZstd::~CompressorZstd() {
+  for (c3_uint_t i = 0; i < CL_NUMBER_OF_ELEMENTS; i++) {
+    if (zs_cctxs[i] != nullptr) {
+      ZSTD_freeCCtx(zs_cctxs[i]);
+    }
+    if (zs_cdicts[i] != nullptr) {
+      ZSTD_freeCDict(zs_cdicts[i]);
+    }
+  }
+  if (zs_dctx != nullptr) {
+    ZSTD_freeDCtx(zs_dctx);
+  }
+}
+
 const char* CompressorZstd::get_name() {
   return "Zstd";
 }
@@ -26,17 +73,42 @@ size_t CompressorZstd::get_compressed_size(c3_uint_t size) {
   return ZSTD_compressBound(size);
 }
 
+static_assert(CL_NUMBER_OF_ELEMENTS == 4, "Number of compression levels is not four");
+// see `ZSTD_compressionParameters` in `zstd_compress.c`
+static const int zstd_compression_levels[CL_NUMBER_OF_ELEMENTS] = {
+  1,  // CL_FASTEST
+  12, // CL_AVERAGE
+  20, // CL_BEST
+  22  // CL_EXTREME
+};
+
+ZSTD_CCtx* CompressorZstd::get_cctx(comp_level_t level) {
+  /*
+   * Contexts are keyed by level so that switching between levels would not make Zstd re-allocate its
+   * working memory; a context is reset by `ZSTD_compressCCtx()` itself.
+   */
+  ZSTD_CCtx* cctx = zs_cctxs[level];
+  if (cctx == nullptr) {
+    cctx = ZSTD_createCCtx_advanced(zstd_allocator);
+    zs_cctxs[level] = cctx;
+  }
+  return cctx;
+}
+
+ZSTD_DCtx* CompressorZstd::get_dctx() {
+  if (zs_dctx == nullptr) {
+    zs_dctx = ZSTD_createDCtx_advanced(zstd_allocator);
+  }
+  return zs_dctx;
+}
+
 c3_uint_t CompressorZstd::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
   comp_level_t level, comp_data_t hint) {
-  static_assert(CL_NUMBER_OF_ELEMENTS == 4, "Number of compression levels is not four");
-  // see `ZSTD_compressionParameters` in `zstd_compress.c`
-  static const int compression_levels[CL_NUMBER_OF_ELEMENTS] = {
-    1,  // CL_FASTEST
-    12, // CL_AVERAGE
-    20, // CL_BEST
-    22  // CL_EXTREME
-  };
-  size_t result = ZSTD_compress(dst, dst_size, src, src_size, compression_levels[level]);
+  ZSTD_CCtx* cctx = get_cctx(level);
+  if (cctx == nullptr) {
+    return 0;
+  }
+  size_t result = ZSTD_compressCCtx(cctx, dst, dst_size, src, src_size, zstd_compression_levels[level]);
   if (result < (size_t) src_size) {
     return (c3_uint_t) result;
   }
@@ -44,7 +116,61 @@ c3_uint_t CompressorZstd::pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte
 }
 
 bool CompressorZstd::unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) {
-  size_t result = ZSTD_decompress(dst, dst_size, src, src_size);
+  ZSTD_DCtx* dctx = get_dctx();
+  if (dctx == nullptr) {
+    return false;
+  }
+  size_t result = ZSTD_decompressDCtx(dctx, dst, dst_size, src, src_size);
+  return result == (size_t) dst_size;
+}
+
+bool CompressorZstd::supports_dictionaries() {
+  return true;
+}
+
+c3_uint_t CompressorZstd::pack_with_dictionary(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst,
+  size_t dst_size, comp_level_t level, comp_data_t hint, const CompressorDictionary& dictionary) {
+  ZSTD_CCtx* cctx = get_cctx(level);
+  if (cctx == nullptr) {
+    return 0;
+  }
+  ZSTD_CDict* cdict = zs_cdicts[level];
+  if (cdict == nullptr || zs_cdict_ids[level] != dictionary.get_id()) {
+    if (cdict != nullptr) {
+      ZSTD_freeCDict(cdict);
+      zs_cdicts[level] = nullptr;
+    }
+    /*
+     * Digesting a dictionary with parameters chosen for unknown source size would make Zstd allocate
+     * huge tables at higher levels; since only small buffers are packed with dictionaries, we tune
+     * parameters for the biggest of them.
+     */
+    ZSTD_parameters params = ZSTD_getParams(zstd_compression_levels[level],
+      CompressorLibrary::MAX_DICTIONARY_DATA_SIZE, dictionary.get_size());
+    params.fParams.contentSizeFlag = 1;
+    cdict = ZSTD_createCDict_advanced(dictionary.get_data(), dictionary.get_size(), params, zstd_allocator);
+    if (cdict == nullptr) {
+      return 0;
+    }
+    zs_cdicts[level] = cdict;
+    zs_cdict_ids[level] = dictionary.get_id();
+  }
+  size_t result = ZSTD_compress_usingCDict(cctx, dst, dst_size, src, src_size, cdict);
+  if (result < (size_t) src_size) {
+    return (c3_uint_t) result;
+  }
+  return 0;
+}
+
+bool CompressorZstd::unpack_with_dictionary(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst,
+  c3_uint_t dst_size, const CompressorDictionary& dictionary) {
+  ZSTD_DCtx* dctx = get_dctx();
+  if (dctx == nullptr) {
+    return false;
+  }
+  // dictionaries are "raw content" ones, so they do not need to be digested by the decoder
+  size_t result = ZSTD_decompress_usingDict(dctx, dst, dst_size, src, src_size,
+    dictionary.get_data(), dictionary.get_size());
   return result == (size_t) dst_size;
 }
 
@@ -21,19 +21,46 @@
 
 #include "c3lib/c3_compressor.h"
 
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+
 namespace CyberCache {
 
 /**
  * Wrapper around Zstd compressor by Yann Collet (Facebook, Inc.)
+ *
+ * Compression contexts (one per compression level) and decompression context are created when they are
+ * needed for the first time, and are then re-used by all subsequent calls made by the same thread. Same
+ * applies to "digested" dictionaries: they are cached per compression level, and are re-created only when
+ * the thread starts using a different dictionary. All memory used by Zstd is allocated from (and accounted
+ * for by) global memory object.
  */
 class CompressorZstd: public CompressorEngine {
   friend class CompressorLibrary;
 
+  ZSTD_CCtx_s*    zs_cctxs[CL_NUMBER_OF_ELEMENTS];     // compression contexts, one per level
+  ZSTD_DCtx_s*    zs_dctx;                             // decompression context
+  ZSTD_CDict_s*   zs_cdicts[CL_NUMBER_OF_ELEMENTS];    // digested dictionaries, one per level
+  c3_dictionary_t zs_cdict_ids[CL_NUMBER_OF_ELEMENTS]; // IDs of the dictionaries in `zs_cdicts`
+
+  ZSTD_CCtx_s* get_cctx(comp_level_t level);
+  ZSTD_DCtx_s* get_dctx();
+
   const char* get_name() override;
   size_t get_compressed_size(c3_uint_t size) override;
   c3_uint_t pack(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
     comp_level_t level, comp_data_t hint) override;
   bool unpack(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size) override;
+  bool supports_dictionaries() override;
+  c3_uint_t pack_with_dictionary(const c3_byte_t* src, c3_uint_t src_size, c3_byte_t* dst, size_t dst_size,
+    comp_level_t level, comp_data_t hint, const CompressorDictionary& dictionary) override;
+  bool unpack_with_dictionary(const c3_byte_t *src, c3_uint_t src_size, c3_byte_t *dst, c3_uint_t dst_size,
+    const CompressorDictionary& dictionary) override;
+
+public:
+  CompressorZstd() noexcept;
+  ~CompressorZstd();
 };
 
 } // CyberCache
@@ -200,10 +200,8 @@ PayloadListChunkBuilder::PayloadListChunkBuilder(ReaderWriter& container,
   lcb_allocated_size = size;
 }
 
-bool PayloadListChunkBuilder::add(c3_uint_t size, const char* str) {
-  assert(str);
+bool PayloadListChunkBuilder::reserve(c3_uint_t full_length) {
   c3_assert(lcb_buffer);
-  c3_uint_t full_length = measure_string(size);
   c3_ulong_t minimum_new_size = (c3_ulong_t) lcb_used_size + full_length;
   if (minimum_new_size > lcb_allocated_size) {
     /*
@@ -242,17 +240,39 @@ bool PayloadListChunkBuilder::add(c3_uint_t size, const char* str) {
     lcb_buffer = (c3_byte_t*) get_memory_object().realloc(lcb_buffer, new_size, lcb_allocated_size);
     lcb_allocated_size = new_size;
   }
-  PERF_INCREMENT_VAR_DOMAIN_COUNTER(lcb_domain, List_Added_Strings)
-  put_string(size, str);
-  lcb_count++;
   return true;
 }
 
+bool PayloadListChunkBuilder::add(c3_uint_t size, const char* str) {
+  assert(str);
+  if (reserve(measure_string(size))) {
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(lcb_domain, List_Added_Strings)
+    put_string(size, str);
+    lcb_count++;
+    return true;
+  }
+  return false;
+}
+
 bool PayloadListChunkBuilder::add(const char* str) {
   assert(str);
   return add((c3_uint_t) std::strlen(str), str);
 }
 
+bool PayloadListChunkBuilder::add(const PayloadListChunkBuilder& list) {
+  c3_assert(list.is_valid());
+  c3_uint_t size = list.get_size();
+  if (size > 0) {
+    if (!reserve(size)) {
+      return false;
+    }
+    std::memcpy(lcb_buffer + lcb_used_size, list.get_buffer(), size);
+    lcb_used_size += size;
+    lcb_count += list.get_count();
+  }
+  return true;
+}
+
 bool PayloadListChunkBuilder::addf(const char* format, ...) {
   char buffer[MAX_FORMATED_STRING_LENGTH];
   va_list args;
@@ -301,6 +321,7 @@ void PayloadChunkBuilder::add(const c3_byte_t* buffer, c3_uint_t usize, comp_dat
       if (result != nullptr) {
         pcb_usize = usize;
         c3_assert(size && size < usize && size == cb_container.get_payload_size());
+        PERF_INCREMENT_VAR_DOMAIN_COUNTER(cb_container.get_domain(), IO_Payloads_Packed)
         return;
       }
     }
@@ -310,6 +331,7 @@ void PayloadChunkBuilder::add(const c3_byte_t* buffer, c3_uint_t usize, comp_dat
     pcb_usize = usize;
     pcb_compressor = CT_NONE;
     std::memcpy(result, buffer, usize);
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(cb_container.get_domain(), IO_Payloads_Copied)
   } else {
     pcb_usize = 0;
     pcb_compressor = CT_NONE;
@@ -323,9 +345,16 @@ void PayloadChunkBuilder::add(const PayloadListChunkBuilder &list) {
 void PayloadChunkBuilder::add(Payload* payload) {
   assert(payload);
   c3_assert(cb_container.get_payload_size() == 0);
+  /*
+   * Stored buffer is attached as is, in whatever format the object's compressor (possibly changed by the
+   * optimizer) left it; clients can unpack data compressed with any of the supported compressors, as long
+   * as no dictionary was used. Buffers packed with server's dictionaries must not be passed here: callers
+   * add them unpacked instead (and then they may get re-packed without dictionary).
+   */
   cb_container.response_writer_attach_payload(payload);
   pcb_usize = cb_container.get_payload_usize();
   pcb_compressor = cb_container.get_payload_compressor();
+  PERF_INCREMENT_VAR_DOMAIN_COUNTER(cb_container.get_domain(), IO_Payloads_Shared)
 }
 
 void PayloadChunkBuilder::add() {
@@ -337,6 +366,7 @@ void PayloadChunkBuilder::add() {
    */
   pcb_usize = cb_container.get_payload_usize();
   pcb_compressor = cb_container.get_payload_compressor();
+  PERF_INCREMENT_VAR_DOMAIN_COUNTER(cb_container.get_domain(), IO_Payloads_Shared)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
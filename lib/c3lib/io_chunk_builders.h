@@ -144,6 +144,8 @@ public:
 class PayloadListChunkBuilder: public ListChunkBuilder {
   static const size_t MAX_FORMATED_STRING_LENGTH = 1024;
 
+  bool reserve(c3_uint_t full_length);
+
 public:
   PayloadListChunkBuilder(ReaderWriter& container, const NetworkConfiguration& net_config,
       c3_uint_t min_guess, c3_uint_t max_guess, c3_uint_t average_length);
@@ -151,6 +153,7 @@ public:
   bool is_valid() const { return lcb_allocated_size > 0; }
   bool add(c3_uint_t size, const char* str);
   bool add(const char* str);
+  bool add(const PayloadListChunkBuilder& list);
   bool addf(const char* format, ...) C3_FUNC_PRINTF(2);
 };
 
@@ -368,51 +368,20 @@ io_result_t CommandWriter::write(c3_ulong_t& ntotal) {
         rw_pos = 0;
         rw_remains = get_command_header_size();
         rw_state = IO_STATE_COMMAND_WRITE_HEADER;
-        if ((rw_flags & IO_FLAG_NETWORK) != 0) { // not a (file) binlog writer?
-          c3_begin_data_block(get_fd());
-        }
         // fall through
 
       case IO_STATE_COMMAND_WRITE_HEADER:
-        result = write_bytes(get_fd(), get_header_bytes(rw_pos, rw_remains), rw_remains, nwritten);
-        switch (result) {
-          case IO_RESULT_OK:
-            ntotal += nwritten;
-            if (nwritten == rw_remains) {
-              rw_remains = get_payload_size();
-              if (rw_remains > 0) {
-                rw_pos = 0;
-                rw_state = IO_STATE_COMMAND_WRITE_PAYLOAD;
-              } else {
-                rw_state = IO_STATE_COMMAND_WRITE_MARKER_BYTE;
-              }
-              continue; // continue with the next state
-            } else {
-              rw_pos += nwritten;
-              rw_remains -= nwritten;
-              continue; // try again unless we are explicitly told to retry
-            }
-          case IO_RESULT_ERROR:
-          case IO_RESULT_EOF:
-            rw_state = IO_STATE_ERROR;
-            // fall through
-          default: // IO_RESULT_RETRY
-            return result;
-        }
-
       case IO_STATE_COMMAND_WRITE_PAYLOAD:
-        result = write_bytes(get_fd(), get_payload_bytes(rw_pos, rw_remains), rw_remains, nwritten);
+      case IO_STATE_COMMAND_WRITE_MARKER_BYTE:
+        // header, payload, and marker are gathered into a single system call
+        result = write_parts(IO_STATE_COMMAND_WRITE_HEADER, command_marker_is_present(), nwritten);
         switch (result) {
           case IO_RESULT_OK:
             ntotal += nwritten;
-            if (nwritten == rw_remains) {
-              rw_state = IO_STATE_COMMAND_WRITE_MARKER_BYTE;
-              continue; // continue with the next state
-            } else {
-              rw_pos += nwritten;
-              rw_remains -= nwritten;
-              continue; // try again unless we are explicitly told to retry
+            if (rw_state == IO_STATE_COMMAND_WRITE_DONE) {
+              return IO_RESULT_OK; // done!
             }
+            continue; // try again unless we are explicitly told to retry
           case IO_RESULT_ERROR:
           case IO_RESULT_EOF:
             rw_state = IO_STATE_ERROR;
@@ -421,31 +390,6 @@ io_result_t CommandWriter::write(c3_ulong_t& ntotal) {
             return result;
         }
 
-      case IO_STATE_COMMAND_WRITE_MARKER_BYTE:
-        if (command_marker_is_present()) {
-          c3_byte_t marker = C3_INTEGRITY_MARKER;
-          result = write_bytes(get_fd(), &marker, 1, nwritten);
-          switch (result) {
-            case IO_RESULT_OK:
-              ntotal++;
-              break; // done!
-
-            case IO_RESULT_ERROR:
-            case IO_RESULT_EOF:
-              rw_state = IO_STATE_ERROR;
-              // fall through
-            default: // IO_RESULT_RETRY
-              return result;
-          }
-        }
-        rw_state = IO_STATE_COMMAND_WRITE_DONE;
-        rw_pos = UINT_MAX_VAL;
-        rw_remains = 0;
-        if ((rw_flags & IO_FLAG_NETWORK) != 0) { // not a (file) binlog writer?
-          c3_end_data_block(get_fd());
-        }
-        return IO_RESULT_OK; // done!
-
       default:
         c3_assert_failure();
         return set_error_state();
@@ -464,6 +408,24 @@ void CommandWriter::io_rewind(int fd, c3_ipv4_t ipv4) {
   rw_state = IO_STATE_COMMAND_WRITE_READY;
 }
 
+c3_uint_t CommandWriter::get_command_size() const {
+  c3_uint_t size = get_command_header_size() + get_payload_size();
+  return command_marker_is_present()? size + 1: size;
+}
+
+void CommandWriter::copy_command(c3_byte_t* buffer) const {
+  c3_assert(buffer);
+  c3_uint_t header_size = get_command_header_size();
+  std::memcpy(buffer, get_const_header_bytes(0, header_size), header_size);
+  c3_uint_t payload_size = get_payload_size();
+  if (payload_size > 0) {
+    std::memcpy(buffer + header_size, get_payload_bytes(0, payload_size), payload_size);
+  }
+  if (command_marker_is_present()) {
+    buffer[header_size + payload_size] = C3_INTEGRITY_MARKER;
+  }
+}
+
 #if INCLUDE_COMMANDWRITER_GET_COMMAND_ID
 command_t CommandWriter::get_command_id() const {
   c3_assert(rw_state >= IO_STATE_COMMAND_WRITE_READY && rw_state <= IO_STATE_COMMAND_WRITE_DONE);
@@ -181,6 +181,10 @@ public:
   bool io_completed() const override;
   void io_rewind(int fd, c3_ipv4_t ipv4) override;
 
+  // support for batching: full size of the command as it's sent over the wire, and its serialization
+  c3_uint_t get_command_size() const;
+  void copy_command(c3_byte_t* buffer) const;
+
   #if INCLUDE_COMMANDWRITER_GET_COMMAND_ID
   command_t get_command_id() const;
   #endif // INCLUDE_COMMANDWRITER_GET_COMMAND_ID
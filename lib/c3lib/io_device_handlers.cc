@@ -16,11 +16,14 @@
 #include "io_device_handlers.h"
 #include "io_net_config.h"
 #include "c3_sockets.h"
+#include "c3_uring.h"
 #include "c3_profiler_defs.h"
 
 #include <cerrno>
+#include <cstring>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 namespace CyberCache {
 
@@ -78,6 +81,33 @@ io_result_t SocketWriter::write_bytes(int fd, const c3_byte_t* buff, c3_uint_t n
   return IO_RESULT_OK;
 }
 
+io_result_t SocketWriter::write_vector(int fd, const iovec* parts, c3_uint_t num, c3_uint_t &nwritten) const {
+  c3_assert(fd > 0 && parts && num);
+  msghdr message;
+  std::memset(&message, 0, sizeof message);
+  message.msg_iov = (iovec*) parts;
+  message.msg_iovlen = num;
+  ssize_t n = sendmsg(fd, &message, (NetworkConfiguration::get_sync_io()? 0: MSG_DONTWAIT) | MSG_NOSIGNAL);
+  if (n < 0) {
+    nwritten = 0;
+    int error_code = errno;
+    // not using switch() here because EAGAIN and EWOULDBLOCK are the same on most systems
+    if (error_code == EAGAIN || error_code == EWOULDBLOCK) {
+      return IO_RESULT_RETRY;
+    } else if (error_code == ECONNRESET || error_code == EPIPE){
+      return IO_RESULT_EOF;
+    } else {
+      return IO_RESULT_ERROR;
+    }
+  }
+  // if data could not be sent, we should have received -1 and `EAGAIN`
+  c3_assert(n > 0);
+  nwritten = (c3_uint_t) n;
+  PERF_UPDATE_RANGE(Sockets_Sent_Data_Range, (c3_uint_t) n)
+  PERF_INCREMENT_COUNTER(Sockets_Vectored_Writes)
+  return IO_RESULT_OK;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // FileReader
 ///////////////////////////////////////////////////////////////////////////////
@@ -105,6 +135,11 @@ io_result_t FileReader::read_bytes(int fd, c3_byte_t* buff, c3_uint_t nbytes, c3
 
 io_result_t FileWriter::write_bytes(int fd, const c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nwritten) const {
   c3_assert(fd > 0 && buff && nbytes);
+  RingFileWriter* writer = RingFileWriter::get_thread_writer();
+  if (writer != nullptr && writer->is_attached(fd)) {
+    // binlog writer thread that uses `io_uring`: data will be written out in big asynchronous chunks
+    return writer->write(buff, nbytes, nwritten);
+  }
   ssize_t result = write(fd, buff, nbytes);
   switch (result) {
     case -1:
@@ -118,4 +153,38 @@ io_result_t FileWriter::write_bytes(int fd, const c3_byte_t* buff, c3_uint_t nby
   }
 }
 
+io_result_t FileWriter::write_vector(int fd, const iovec* parts, c3_uint_t num, c3_uint_t &nwritten) const {
+  c3_assert(fd > 0 && parts && num);
+  RingFileWriter* writer = RingFileWriter::get_thread_writer();
+  if (writer != nullptr && writer->is_attached(fd)) {
+    // data are only copied to a staging buffer, so there is no point in gathering them
+    return DeviceReaderWriter::write_vector(fd, parts, num, nwritten);
+  }
+  ssize_t result = writev(fd, parts, (int) num);
+  if (result <= 0) {
+    // writev() is not supposed to return 0 for non-empty parts, but just in case...
+    nwritten = 0;
+    return IO_RESULT_ERROR;
+  }
+  nwritten = (c3_uint_t) result;
+  return IO_RESULT_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BufferReader
+///////////////////////////////////////////////////////////////////////////////
+
+io_result_t BufferReader::read_bytes(int fd, c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nread) const {
+  c3_assert(buff && nbytes);
+  if (br_remains == 0) {
+    nread = 0;
+    return IO_RESULT_EOF;
+  }
+  nread = nbytes <= br_remains? nbytes: br_remains;
+  std::memcpy(buff, br_buffer, nread);
+  br_buffer += nread;
+  br_remains -= nread;
+  return IO_RESULT_OK;
+}
+
 }
@@ -35,6 +35,7 @@ public:
 /// Class implementing low-level writing to a TCP/IP socket
 class SocketWriter: virtual public DeviceReaderWriter {
   io_result_t write_bytes(int fd, const c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nwritten) const override;
+  io_result_t write_vector(int fd, const iovec* parts, c3_uint_t num, c3_uint_t &nwritten) const override;
 };
 
 /// Class implementing low-level reading from a file (e.g. during restoration from binlog)
@@ -46,6 +47,25 @@ public:
 /// Class implementing low-level writing to a file (e.g. to a binlog)
 class FileWriter: virtual public DeviceReaderWriter {
   io_result_t write_bytes(int fd, const c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nwritten) const override;
+  io_result_t write_vector(int fd, const iovec* parts, c3_uint_t num, c3_uint_t &nwritten) const override;
+};
+
+/**
+ * Class implementing low-level reading from a memory buffer (e.g. while unpacking batched commands); the
+ * descriptor passed to `read_bytes()` is ignored. The buffer is not owned by this object.
+ */
+class BufferReader: virtual public DeviceReaderWriter {
+  mutable const c3_byte_t* br_buffer;  // data that have not been read yet
+  mutable c3_uint_t        br_remains; // number of bytes that have not been read yet
+
+protected:
+  BufferReader(const c3_byte_t* buffer, c3_uint_t size) {
+    br_buffer = buffer;
+    br_remains = size;
+  }
+
+public:
+  io_result_t read_bytes(int fd, c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nread) const override;
 };
 
 } // CyberCache
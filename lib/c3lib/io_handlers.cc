@@ -155,4 +155,17 @@ c3_uint_t FileCommandWriter::get_object_size() const {
   return sizeof(FileCommandWriter);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// BufferCommandReader
+///////////////////////////////////////////////////////////////////////////////
+
+BufferCommandReader::BufferCommandReader(Memory& memory, int fd, const c3_byte_t* buffer, c3_uint_t size,
+  SharedBuffers* sb):
+  CommandReader(memory, IO_FLAG_IS_READER, fd, INVALID_IPV4_ADDRESS, sb), BufferReader(buffer, size) {
+}
+
+c3_uint_t BufferCommandReader::get_object_size() const {
+  return sizeof(BufferCommandReader);
+}
+
 } // CyberCache
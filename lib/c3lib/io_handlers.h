@@ -136,6 +136,18 @@ public:
   c3_uint_t get_object_size() const override;
 };
 
+/**
+ * Class implementing reading commands from a memory buffer (payload of a `BATCH` command). Just like commands
+ * loaded from binlog, these do not have "network" flag set, so responses to them are never sent; descriptor
+ * is only needed for the object to be "active", and is not used for reading.
+ */
+class BufferCommandReader: public CommandReader, public BufferReader {
+public:
+  BufferCommandReader(Memory& memory, int fd, const c3_byte_t* buffer, c3_uint_t size, SharedBuffers* sb);
+
+  c3_uint_t get_object_size() const override;
+};
+
 } // CyberCache
 
 #endif // _IO_HANDLERS_H
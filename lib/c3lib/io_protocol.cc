@@ -25,6 +25,8 @@ const char* c3_get_command_name(command_t cmd) {
       return "PING";
     case CMD_CHECK:
       return "CHECK";
+    case CMD_SEQUENCE:
+      return "SEQUENCE";
     case CMD_INFO:
       return "INFO";
     case CMD_STATS:
@@ -37,6 +39,8 @@ const char* c3_get_command_name(command_t cmd) {
       return "RESTORE";
     case CMD_STORE:
       return "STORE";
+    case CMD_DUMP:
+      return "DUMP";
     case CMD_GET:
       return "GET";
     case CMD_SET:
@@ -45,6 +49,8 @@ const char* c3_get_command_name(command_t cmd) {
       return "LOG";
     case CMD_ROTATE:
       return "ROTATE";
+    case CMD_CATCHUP:
+      return "CATCHUP";
     case CMD_READ:
       return "READ";
     case CMD_WRITE:
@@ -53,6 +59,8 @@ const char* c3_get_command_name(command_t cmd) {
       return "DESTROY";
     case CMD_GC:
       return "GC";
+    case CMD_BATCH:
+      return "BATCH";
     case CMD_LOAD:
       return "LOAD";
     case CMD_TEST:
@@ -63,6 +71,14 @@ const char* c3_get_command_name(command_t cmd) {
       return "REMOVE";
     case CMD_CLEAN:
       return "CLEAN";
+    case CMD_MLOAD:
+      return "MLOAD";
+    case CMD_MTEST:
+      return "MTEST";
+    case CMD_MSAVE:
+      return "MSAVE";
+    case CMD_MREMOVE:
+      return "MREMOVE";
     case CMD_GETIDS:
       return "GETIDS";
     case CMD_GETTAGS:
@@ -39,6 +39,10 @@ enum command_t: c3_byte_t {
   /// DESCRIPTOR 0x02 [ PASSWORD ] [ MARKER ]
   CMD_CHECK = 0x02,
 
+  /// DESCRIPTOR HEADER { 0x03 [ PASSWORD ] CHUNK(NUMBER) CHUNK(NUMBER) } [ MARKER ]
+  /// (only found in binlogs; sets sequence number of the command that follows it)
+  CMD_SEQUENCE = 0x03,
+
   /// DESCRIPTOR HEADER { 0x10 [ PASSWORD ] CHUNK(NUMBER) } [ MARKER ]
   CMD_INFO = 0x10,
 
@@ -57,6 +61,9 @@ enum command_t: c3_byte_t {
   /// DESCRIPTOR HEADER { 0xF3 [ PASSWORD ] CHUNK(NUMBER) CHUNK(STRING) CHUNK(NUMBER) CHUNK(NUMBER) } [ MARKER ]
   CMD_STORE = 0xF3,
 
+  /// DESCRIPTOR HEADER { 0xF4 [ PASSWORD ] CHUNK(NUMBER) CHUNK(STRING) CHUNK(NUMBER) } [ MARKER ]
+  CMD_DUMP = 0xF4,
+
   /// DESCRIPTOR HEADER { 0xF5 [ PASSWORD ] CHUNK(LIST) } [ MARKER ]
   CMD_GET = 0xF5,
 
@@ -69,6 +76,9 @@ enum command_t: c3_byte_t {
   /// DESCRIPTOR HEADER { 0xFB [ PASSWORD ] CHUNK(NUMBER) } [ MARKER ]
   CMD_ROTATE = 0xFB,
 
+  /// DESCRIPTOR HEADER { 0xFC [ PASSWORD ] CHUNK(NUMBER) [ CHUNK(NUMBER) CHUNK(NUMBER) ] } [ MARKER ]
+  CMD_CATCHUP = 0xFC,
+
   /// DESCRIPTOR HEADER { 0x21 [ PASSWORD ] CHUNK(STRING) CHUNK(NUMBER) [ CHUNK(NUMBER) ] } [ MARKER ]
   CMD_READ = 0x21,
 
@@ -82,6 +92,10 @@ enum command_t: c3_byte_t {
   /// DESCRIPTOR HEADER { 0x24 [ PASSWORD ] CHUNK(NUMBER) } [ MARKER ]
   CMD_GC = 0x24,
 
+  /// DESCRIPTOR HEADER { 0x25 [ PASSWORD ] PAYLOAD_INFO CHUNK(NUMBER) } PAYLOAD [ MARKER ]
+  /// (sent by session replicators; payload is a sequence of complete commands, number is their count)
+  CMD_BATCH = 0x25,
+
   /// DESCRIPTOR HEADER { 0x41 [ PASSWORD ] CHUNK(STRING) CHUNK(NUMBER) } [ MARKER ]
   CMD_LOAD = 0x41,
 
@@ -99,6 +113,19 @@ enum command_t: c3_byte_t {
   /// DESCRIPTOR HEADER { 0x45 [ PASSWORD ] CHUNK(NUMBER) [ CHUNK(LIST) ] } [ MARKER ]
   CMD_CLEAN = 0x45,
 
+  /// DESCRIPTOR HEADER { 0x46 [ PASSWORD ] CHUNK(LIST) CHUNK(NUMBER) } [ MARKER ]
+  CMD_MLOAD = 0x46,
+
+  /// DESCRIPTOR HEADER { 0x47 [ PASSWORD ] CHUNK(LIST) CHUNK(NUMBER) } [ MARKER ]
+  CMD_MTEST = 0x47,
+
+  /// DESCRIPTOR HEADER { 0x48 [ PASSWORD ] PAYLOAD_INFO CHUNK(NUMBER) } PAYLOAD [ MARKER ]
+  /// (payload is a sequence of complete `SAVE` commands, number is their count)
+  CMD_MSAVE = 0x48,
+
+  /// DESCRIPTOR HEADER { 0x49 [ PASSWORD ] CHUNK(LIST) } [ MARKER ]
+  CMD_MREMOVE = 0x49,
+
   /// DESCRIPTOR 0x61 [ PASSWORD ] [ MARKER ]
   CMD_GETIDS = 0x61,
 
@@ -35,6 +35,12 @@ io_result_t DeviceReaderWriter::write_bytes(int fd, const c3_byte_t* buff, c3_ui
   return IO_RESULT_ERROR;
 }
 
+io_result_t DeviceReaderWriter::write_vector(int fd, const iovec* parts, c3_uint_t num,
+  c3_uint_t& nwritten) const {
+  c3_assert(parts && num);
+  return write_bytes(fd, (const c3_byte_t*) parts[0].iov_base, (c3_uint_t) parts[0].iov_len, nwritten);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // ReaderWriter
 ///////////////////////////////////////////////////////////////////////////////
@@ -104,6 +110,76 @@ io_result_t ReaderWriter::set_error_state() {
   return IO_RESULT_ERROR;
 }
 
+io_result_t ReaderWriter::write_parts(io_state_t header_state, bool marker, c3_uint_t& nwritten) {
+  static_assert(IO_STATE_RESPONSE_WRITE_PAYLOAD == IO_STATE_RESPONSE_WRITE_HEADER + 1 &&
+    IO_STATE_RESPONSE_WRITE_MARKER_BYTE == IO_STATE_RESPONSE_WRITE_HEADER + 2 &&
+    IO_STATE_RESPONSE_WRITE_DONE == IO_STATE_RESPONSE_WRITE_HEADER + 3, "Response writing states reordered");
+  static_assert(IO_STATE_COMMAND_WRITE_PAYLOAD == IO_STATE_COMMAND_WRITE_HEADER + 1 &&
+    IO_STATE_COMMAND_WRITE_MARKER_BYTE == IO_STATE_COMMAND_WRITE_HEADER + 2 &&
+    IO_STATE_COMMAND_WRITE_DONE == IO_STATE_COMMAND_WRITE_HEADER + 3, "Command writing states reordered");
+  static const c3_byte_t integrity_marker = C3_INTEGRITY_MARKER;
+  const auto payload_state = (io_state_t)(header_state + 1);
+  const auto marker_state = (io_state_t)(header_state + 2);
+  const auto done_state = (io_state_t)(header_state + 3);
+  c3_assert(rw_state == header_state || rw_state == payload_state || (rw_state == marker_state && marker));
+
+  iovec parts[3];
+  c3_uint_t num = 0;
+  c3_uint_t payload_size = 0;
+  if (rw_state == header_state) {
+    parts[num].iov_base = get_header_bytes(rw_pos, rw_remains);
+    parts[num++].iov_len = rw_remains;
+    payload_size = get_payload_size();
+    if (payload_size > 0) {
+      parts[num].iov_base = get_payload_bytes(0, payload_size);
+      parts[num++].iov_len = payload_size;
+    }
+  } else if (rw_state == payload_state && rw_remains > 0) {
+    parts[num].iov_base = get_payload_bytes(rw_pos, rw_remains);
+    parts[num++].iov_len = rw_remains;
+  }
+  if (marker) {
+    parts[num].iov_base = (void*) &integrity_marker;
+    parts[num++].iov_len = 1;
+  }
+  c3_assert(num > 0);
+
+  io_result_t result = write_vector(get_fd(), parts, num, nwritten);
+  if (result == IO_RESULT_OK) {
+    // figure out which part the write stopped in
+    c3_uint_t n = nwritten;
+    if (rw_state == header_state) {
+      if (n < rw_remains) {
+        rw_pos += n;
+        rw_remains -= n;
+        return result;
+      }
+      n -= rw_remains;
+      rw_pos = 0;
+      rw_remains = payload_size;
+      rw_state = payload_state;
+    }
+    if (rw_state == payload_state) {
+      if (n < rw_remains) {
+        rw_pos += n;
+        rw_remains -= n;
+        return result;
+      }
+      n -= rw_remains;
+      rw_pos = 0;
+      rw_remains = marker? 1: 0;
+      rw_state = marker_state;
+    }
+    c3_assert(rw_state == marker_state && n <= rw_remains);
+    if (n == rw_remains) {
+      rw_pos = UINT_MAX_VAL;
+      rw_remains = 0;
+      rw_state = done_state;
+    }
+  }
+  return result;
+}
+
 Memory& ReaderWriter::get_memory_object() const {
   return Memory::get_memory_object(rw_domain);
 }
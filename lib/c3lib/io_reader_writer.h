@@ -23,6 +23,8 @@
 #include "io_protocol.h"
 #include "io_shared_buffers.h"
 
+#include <sys/uio.h>
+
 namespace CyberCache {
 
 /// Return codes for various I/O methods of public interfaces
@@ -148,6 +150,8 @@ public:
   // these methods should *only* return `OK` result if they successfully read at least one byte
   virtual io_result_t read_bytes(int fd, c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nread) const;
   virtual io_result_t write_bytes(int fd, const c3_byte_t* buff, c3_uint_t nbytes, c3_uint_t &nwritten) const;
+  // default implementation only writes (some of) the first part; devices that can do better override it
+  virtual io_result_t write_vector(int fd, const iovec* parts, c3_uint_t num, c3_uint_t &nwritten) const;
 };
 
 /// Base class for all command/response readers, writers, and processors
@@ -175,6 +179,18 @@ protected:
 
   io_result_t set_error_state();
 
+  /**
+   * Writes what remains of the header, payload, and integrity check marker using a single vectored write,
+   * and then advances writing state to where the write stopped. States of writing header, payload, and
+   * marker byte, and the "done" state, must follow each other in `io_state_t`.
+   *
+   * @param header_state State in which header is being written
+   * @param marker `true` if integrity check marker has to be written after the payload
+   * @param nwritten Number of bytes written
+   * @return `IO_RESULT_OK` if at least one byte had been written, other `IO_RESULT_xxx` code otherwise
+   */
+  io_result_t write_parts(io_state_t header_state, bool marker, c3_uint_t& nwritten);
+
   void configure_descriptor(int fd, c3_ipv4_t ipv4 = INVALID_IPV4_ADDRESS) {
     // if we're in "error" state, that's OK, that's recoverable
     c3_assert(is_valid() && fd > 0);
@@ -330,6 +346,13 @@ public:
     #endif
   }
 
+  /////////////////////////////////////////////////////////////////////////////
+  // ACCESSORS (WRAPPERS): SEQUENCE NUMBER
+  /////////////////////////////////////////////////////////////////////////////
+
+  c3_ulong_t get_sequence() const { return rw_sb->get_sequence(); }
+  void set_sequence(c3_ulong_t sequence) const { rw_sb->set_sequence(sequence); }
+
   /////////////////////////////////////////////////////////////////////////////
   // ACCESSORS (WRAPPERS): PAYLOAD BUFFER
   /////////////////////////////////////////////////////////////////////////////
@@ -351,49 +351,20 @@ io_result_t ResponseWriter::write(c3_ulong_t& ntotal) {
         rw_pos = 0;
         rw_remains = get_response_header_size();
         rw_state = IO_STATE_RESPONSE_WRITE_HEADER;
-        c3_begin_data_block(get_fd());
         // fall through
 
       case IO_STATE_RESPONSE_WRITE_HEADER:
-        result = write_bytes(get_fd(), get_header_bytes(rw_pos, rw_remains), rw_remains, nwritten);
-        switch (result) {
-          case IO_RESULT_OK:
-            ntotal += nwritten;
-            if (nwritten == rw_remains) {
-              rw_remains = get_payload_size();
-              if (rw_remains > 0) {
-                rw_pos = 0;
-                rw_state = IO_STATE_RESPONSE_WRITE_PAYLOAD;
-              } else {
-                rw_state = IO_STATE_RESPONSE_WRITE_MARKER_BYTE;
-              }
-              continue; // continue with the next state
-            } else {
-              rw_pos += nwritten;
-              rw_remains -= nwritten;
-              continue; // try again unless we are explicitly told to retry
-            }
-          case IO_RESULT_ERROR:
-          case IO_RESULT_EOF:
-            rw_state = IO_STATE_ERROR;
-            // fall through
-          default: // IO_RESULT_RETRY
-            return result;
-        }
-
       case IO_STATE_RESPONSE_WRITE_PAYLOAD:
-        result = write_bytes(get_fd(), get_payload_bytes(rw_pos, rw_remains), rw_remains, nwritten);
+      case IO_STATE_RESPONSE_WRITE_MARKER_BYTE:
+        // header, payload, and marker are gathered into a single system call
+        result = write_parts(IO_STATE_RESPONSE_WRITE_HEADER, response_marker_is_present(), nwritten);
         switch (result) {
           case IO_RESULT_OK:
             ntotal += nwritten;
-            if (nwritten == rw_remains) {
-              rw_state = IO_STATE_RESPONSE_WRITE_MARKER_BYTE;
-              continue; // continue with the next state
-            } else {
-              rw_pos += nwritten;
-              rw_remains -= nwritten;
-              continue; // try again unless we are explicitly told to retry
+            if (rw_state == IO_STATE_RESPONSE_WRITE_DONE) {
+              return IO_RESULT_OK; // done!
             }
+            continue; // try again unless we are explicitly told to retry
           case IO_RESULT_ERROR:
           case IO_RESULT_EOF:
             rw_state = IO_STATE_ERROR;
@@ -402,29 +373,6 @@ io_result_t ResponseWriter::write(c3_ulong_t& ntotal) {
             return result;
         }
 
-      case IO_STATE_RESPONSE_WRITE_MARKER_BYTE:
-        if (response_marker_is_present()) {
-          c3_byte_t marker = C3_INTEGRITY_MARKER;
-          result = write_bytes(get_fd(), &marker, 1, nwritten);
-          switch (result) {
-            case IO_RESULT_OK:
-              ntotal++;
-              break; // done!
-
-            case IO_RESULT_ERROR:
-            case IO_RESULT_EOF:
-              rw_state = IO_STATE_ERROR;
-              // fall through
-            default: // IO_RESULT_RETRY
-              return result;
-          }
-        }
-        rw_state = IO_STATE_RESPONSE_WRITE_DONE;
-        rw_pos = UINT_MAX_VAL;
-        rw_remains = 0;
-        c3_end_data_block(get_fd());
-        return IO_RESULT_OK; // done!
-
       case IO_STATE_ERROR:
         // so that to be able to pass separate check before every write() attempt
         return IO_RESULT_ERROR;
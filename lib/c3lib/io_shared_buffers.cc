@@ -52,6 +52,7 @@ void SharedBuffers::clone_payload(SharedBuffers* cloned_sb) const {
 
 SharedBuffers* SharedBuffers::clone(bool full) const {
   SharedBuffers* sb = create(sb_memory);
+  sb->sb_sequence = sb_sequence;
   c3_uint_t size = sb_data.get_size();
   if (size > 0) {
     c3_assert(size > AUX_DATA_SIZE);
@@ -45,6 +45,7 @@ protected:
   Memory&             sb_memory;             // memory object for `sb_data` and `sb_payload`
   DataBuffer          sb_data;               // command header or response data
   DataBuffer          sb_payload;            // payload buffer
+  c3_ulong_t          sb_sequence;           // replication sequence number of the command, or zero
   c3_byte_t           sb_aux[AUX_DATA_SIZE]; // "alternative" storage for small headers or responses
   std::atomic_uint    sb_nrefs;              // reference count: current number of users of this buffer
 
@@ -54,6 +55,7 @@ protected:
   c3_uint_t decrement_num_refs() { return sb_nrefs.fetch_sub(1, std::memory_order_acq_rel); }
 
   explicit SharedBuffers(Memory& memory): sb_memory(memory) {
+    sb_sequence = 0;
     set_num_refs(0);
   }
   virtual ~SharedBuffers();
@@ -131,6 +133,17 @@ public:
     }
   }
 
+  /////////////////////////////////////////////////////////////////////////////
+  // ACCESSORS: SEQUENCE NUMBER
+  /////////////////////////////////////////////////////////////////////////////
+
+  /*
+   * Sequence numbers are assigned to replicated commands before they are passed on to replicators and
+   * binlog writers; since all copies of a command share the same buffers, they all see the same number.
+   */
+  c3_ulong_t get_sequence() const { return sb_sequence; }
+  void set_sequence(c3_ulong_t sequence) { sb_sequence = sequence; }
+
   /////////////////////////////////////////////////////////////////////////////
   // ACCESSORS: PAYLOAD
   /////////////////////////////////////////////////////////////////////////////
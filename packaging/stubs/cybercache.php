@@ -200,6 +200,32 @@ function c3_test($resource, string $id) {}
  */
 function c3_save($resource, string $id, int $lifetime, array $tags, string $data) {}
 
+/**
+ * Loads several FPC records using single request.
+ *
+ * See man entry cybercache(1) for more information.
+ *
+ * @param resource $resource CyberCache resource handle returned by `c3_session()` or `c3_fpc()` call.
+ * @param array $ids List of cache record IDs specified as a regular array.
+ *
+ * @return array Associative array with record IDs as keys, and FPC record data (or `false` if record does not exist or could not be loaded) as values; `false` if IDs are not strings.
+ */
+function c3_mload($resource, array $ids) {}
+
+/**
+ * Saves several FPC records with the same lifetime and tags, sending all requests before waiting for responses.
+ *
+ * See man entry cybercache(1) for more information.
+ *
+ * @param resource $resource CyberCache resource handle returned by `c3_session()` or `c3_fpc()` call.
+ * @param array $records Associative array with record IDs as keys, and data to be stored in cache records as values.
+ * @param integer $lifetime Record lifetime, seconds; 0 mean infinite, -1 means use value specified in configuration file. Optional; default value is -1.
+ * @param array $tags List of tags specified as a regular array. Optional; default value is NULL.
+ *
+ * @return array Associative array with record IDs as keys, and booleans (`true` on success, `false` on error) as values; `false` on errors.
+ */
+function c3_msave($resource, array $records, int $lifetime = -1, array $tags = NULL) {}
+
 /**
  * Deletes specified FPC record.
  *
@@ -62,6 +62,18 @@ ZEND_BEGIN_ARG_INFO(arginfo_rc_seconds, 0)
     ZEND_ARG_INFO(0, seconds)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO(arginfo_rc_ids, 0)
+    ZEND_ARG_INFO(0, resource)
+    ZEND_ARG_ARRAY_INFO(0, ids, 0) // can *NOT* be NULL
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_rc_records_lifetime_tags, 0, 0, 2)
+    ZEND_ARG_INFO(0, resource)
+    ZEND_ARG_ARRAY_INFO(0, records, 0) // can *NOT* be NULL
+    ZEND_ARG_INFO(0, lifetime)
+    ZEND_ARG_ARRAY_INFO(0, tags, 1) // can be NULL
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO(arginfo_rc_id_lifetime_tags_data, 0)
     ZEND_ARG_INFO(0, resource)
     ZEND_ARG_INFO(0, id)
@@ -225,6 +237,17 @@ static PHP_FUNCTION(c3_fpc) {
   }
 }
 
+static zend_long get_lifetime(const zval* lifetime) {
+  switch (Z_TYPE_P(lifetime)) {
+    case IS_LONG:
+      return Z_LVAL_P(lifetime);
+    case IS_FALSE: // "do not set specific lifetime" ==> default lifetime
+      return -1;
+    default: // must be `IS_NULL` ==> infinite lifetime
+      return 0;
+  }
+}
+
 static PHP_FUNCTION(c3_load) {
   const zval* rc;
   c3_arg_t id;
@@ -266,16 +289,7 @@ static PHP_FUNCTION(c3_save) {
     args[TAGS].a_list = Z_ARRVAL(temp_array);
     array_initialized = true;
   }
-  switch (Z_TYPE_P(lifetime)) {
-    case IS_LONG:
-      args[LIFETIME].a_number = Z_LVAL_P(lifetime);
-      break;
-    case IS_FALSE: // "do not set specific lifetime" ==> default lifetime
-      args[LIFETIME].a_number = -1;
-      break;
-    default: // must be `IS_NULL` ==> infinite lifetime
-      args[LIFETIME].a_number = 0;
-  }
+  args[LIFETIME].a_number = get_lifetime(lifetime);
   call_c3(rc, return_value, OSR_TRUE_FROM_OK, ESR_FALSE_FROM_ERROR,
     CMD_SAVE, AUT_USER, "SANLP", args);
   if (array_initialized) {
@@ -283,6 +297,108 @@ static PHP_FUNCTION(c3_save) {
   }
 }
 
+static PHP_FUNCTION(c3_mload) {
+  const zval* rc;
+  HashTable* ids;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "rh", &rc, &ids) == FAILURE) {
+    return;
+  }
+  HashPosition ht_pos;
+  zend_hash_internal_pointer_reset_ex(ids, &ht_pos);
+  const zval* id;
+  while ((id = zend_hash_get_current_data_ex(ids, &ht_pos)) != nullptr) {
+    if (Z_TYPE_P(id) != IS_STRING) {
+      report_error("Record IDs must be strings");
+      RETURN_FALSE;
+    }
+    zend_hash_move_forward_ex(ids, &ht_pos);
+  }
+  array_init(return_value);
+  if (zend_hash_num_elements(ids) == 0) {
+    return;
+  }
+  // the server only returns records that it found: [<id> => <data>, ...]
+  zval found;
+  ZVAL_UNDEF(&found);
+  c3_arg_t arg;
+  arg.a_list = ids;
+  call_c3(rc, &found, OSR_MAP_FROM_LIST_PAYLOAD, ESR_EMPTY_ARRAY_FROM_ERROR,
+    CMD_MLOAD, AUT_USER, "LA", &arg);
+  // returns array [<id> => <data-or-false>, ...] in the order in which IDs were passed
+  zend_hash_internal_pointer_reset_ex(ids, &ht_pos);
+  while ((id = zend_hash_get_current_data_ex(ids, &ht_pos)) != nullptr) {
+    zval* data = Z_TYPE(found) == IS_ARRAY?
+      zend_symtable_str_find(Z_ARRVAL(found), Z_STRVAL_P(id), Z_STRLEN_P(id)): nullptr;
+    zval value;
+    if (data != nullptr) {
+      ZVAL_COPY(&value, data);
+    } else {
+      ZVAL_FALSE(&value);
+    }
+    zend_symtable_str_update(Z_ARRVAL_P(return_value), Z_STRVAL_P(id), Z_STRLEN_P(id), &value);
+    zend_hash_move_forward_ex(ids, &ht_pos);
+  }
+  zval_ptr_dtor(&found);
+}
+
+static PHP_FUNCTION(c3_msave) {
+  const zval* rc;
+  HashTable* records;
+  zval* lifetime = nullptr;
+  HashTable* tags = nullptr;
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "rh|zh!", &rc, &records, &lifetime, &tags) == FAILURE) {
+    return;
+  }
+  c3_uint_t num_records = zend_hash_num_elements(records);
+  if (num_records == 0) {
+    array_init(return_value);
+    return;
+  }
+  enum { ID = 0, LIFETIME, TAGS, DATA, NUM_OF_ARGUMENTS };
+  auto args = (c3_arg_t*) emalloc(sizeof(c3_arg_t) * NUM_OF_ARGUMENTS * num_records);
+  zend_long record_lifetime = lifetime != nullptr? get_lifetime(lifetime): -1;
+  // PHP converts numeric string keys to integers, so we have to convert them back
+  zval numeric_ids;
+  array_init(&numeric_ids);
+  bool ok = true;
+  HashPosition ht_pos;
+  zend_hash_internal_pointer_reset_ex(records, &ht_pos);
+  for (c3_uint_t i = 0; i < num_records; i++) {
+    c3_arg_t* record_args = args + i * NUM_OF_ARGUMENTS;
+    const zval* data = zend_hash_get_current_data_ex(records, &ht_pos);
+    if (Z_TYPE_P(data) != IS_STRING) {
+      report_error("Record data must be strings");
+      ok = false;
+      break;
+    }
+    zend_string* key;
+    zend_ulong index;
+    if (zend_hash_get_current_key_ex(records, &key, &index, &ht_pos) == HASH_KEY_IS_STRING) {
+      record_args[ID].a_string = ZSTR_VAL(key);
+      record_args[ID].a_size = ZSTR_LEN(key);
+    } else {
+      zend_string* id = zend_long_to_str((zend_long) index);
+      add_next_index_str(&numeric_ids, id);
+      record_args[ID].a_string = ZSTR_VAL(id);
+      record_args[ID].a_size = ZSTR_LEN(id);
+    }
+    record_args[LIFETIME].a_number = record_lifetime;
+    record_args[TAGS].a_list = tags;
+    record_args[DATA].a_buffer = (const c3_byte_t*) Z_STRVAL_P(data);
+    record_args[DATA].a_size = Z_STRLEN_P(data);
+    zend_hash_move_forward_ex(records, &ht_pos);
+  }
+  if (ok) {
+    // returns array [<id> => <true-or-false>, ...]
+    call_c3_multi(rc, return_value, OSR_TRUE_FROM_OK, ESR_FALSE_FROM_ERROR,
+      CMD_SAVE, AUT_USER, "SANLP", num_records, args);
+  } else {
+    RETVAL_FALSE;
+  }
+  zval_dtor(&numeric_ids);
+  efree(args);
+}
+
 static PHP_FUNCTION(c3_remove) {
   const zval* rc;
   c3_arg_t id;
@@ -686,6 +802,8 @@ const zend_function_entry cybercache_functions[] = {
   PHP_FE(c3_load, arginfo_rc_id)
   PHP_FE(c3_test, arginfo_rc_id)
   PHP_FE(c3_save, arginfo_rc_id_lifetime_tags_data)
+  PHP_FE(c3_mload, arginfo_rc_ids)
+  PHP_FE(c3_msave, arginfo_rc_records_lifetime_tags)
   PHP_FE(c3_remove, arginfo_rc_id)
   PHP_FE(c3_clean, arginfo_rc_mode_tags)
   PHP_FE(c3_get_ids, arginfo_rc)
@@ -73,16 +73,18 @@ c3_compressor_t get_compressor_option(const zend_string* zstr) {
     "brotli",
     "zstd",
     "zlib",
-    "lzham"
+    "lzham",
+    "hesper",
+    "asciient"
   };
-  static_assert(CT_NUMBER_OF_ELEMENTS == 9, "Number of compressors has changed");
+  static_assert(CT_NUMBER_OF_ELEMENTS == 11, "Number of compressors has changed");
   const char* compressor = ZSTR_VAL(zstr);
   unsigned int i = 1; do {
     if (std::strcmp(compressor, compressors[i]) == 0) {
       auto comp_type = (c3_compressor_t) i;
       #if !C3_ENTERPRISE
-      if (comp_type == CT_BROTLI) {
-        report_error("The 'brotli' compressor is only supported in Enterprise edition");
+      if (is_enterprise_compressor(comp_type)) {
+        report_error("The '%s' compressor is only supported in Enterprise edition", compressor);
         return CT_NONE;
       }
       #endif
@@ -367,70 +367,74 @@ static void fetch_array_from_list_payload(const SocketResponseReader& reader,
   set_internal_error(error_return, return_value, "received malformed LIST response");
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// INTERFACE
-///////////////////////////////////////////////////////////////////////////////
-
-void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_error_return_t error_return,
-  command_t cmd, c3_auth_type_t auth, const char* format, c3_arg_t* args) {
-
-  c3_assert(rc && return_value && cmd && format && (format[0] == 0 || args));
-
-  // 1) Get and validate resource handle
-  // -----------------------------------
+static void fetch_map_from_list_payload(const SocketResponseReader& reader,
+  c3_error_return_t error_return, zval* return_value) {
+  ResponseHeaderIterator header(reader);
+  NumberChunk number = header.get_number();
+  if (number.is_valid_uint() && (number.get_uint() & 1) == 0 && !header.has_more_chunks()) {
+    c3_uint_t count = number.get_uint();
+    // see comments in `fetch_array_from_list_payload()`
+    array_init(return_value);
+    bool errors = false;
+    if (count > 0) {
+      ResponsePayloadIterator payload(reader);
+      ListChunk list(payload, count);
+      if (list.is_valid()) {
+        for (c3_uint_t i = 0; i < count; i += 2) {
+          StringChunk key = list.get_string();
+          StringChunk value = list.get_string();
+          if (key.is_valid() && value.is_valid()) {
+            zval zvalue;
+            ZVAL_STRINGL(&zvalue, value.get_chars(), value.get_length());
+            zend_symtable_str_update(Z_ARRVAL_P(return_value), key.get_chars(), key.get_length(), &zvalue);
+          } else {
+            errors = true;
+          }
+        }
+      } else {
+        errors = true;
+      }
+    }
+    if (errors) {
+      report_internal_error("received LIST response with malformed key/value pair(s)");
+    }
+    return;
+  }
+  set_internal_error(error_return, return_value, "received malformed LIST response");
+}
 
+static C3Resource* fetch_resource(const zval* rc, c3_error_return_t error_return, zval* return_value) {
   auto res = (C3Resource*) zend_fetch_resource(Z_RES_P(rc), C3_RESOURCE_NAME, le_cybercache_res);
-  if (res == nullptr) {
+  if (res != nullptr) {
+    res->reset_error_message();
+  } else {
     set_error(error_return, return_value, "Invalid or incompatible resource");
-    return;
   }
-  res->reset_error_message();
-
-  // 2) Figure out whether the command should be submitted with admin- or user-level authentication
-  // ----------------------------------------------------------------------------------------------
+  return res;
+}
 
-  bool execute_as_admin;
+static bool execute_as_admin(c3_auth_type_t auth) {
   switch (auth) {
     default:
       c3_assert_failure();
       // either does not return, or does nothing
     case AUT_USER:
-      execute_as_admin = false;
-      break;
+      return false;
     case AUT_ADMIN:
-      execute_as_admin = true;
-      break;
+      return true;
     case AUT_INFO:
-      execute_as_admin = C3GLOBAL(mg_info_password) == IPD_ADMIN;
-      break;
+      return C3GLOBAL(mg_info_password) == IPD_ADMIN;
   }
+}
 
-  // 3) Create network configuration object
-  // --------------------------------------
-
-  NetworkConfiguration net_config(res->get_user_password(), res->get_admin_password(),
-    res->get_compressor(), res->get_threshold(), res->get_marker());
-
-  // 4) Establish connection to the server
-  // -------------------------------------
-
-  char ip_address[C3_SOCK_MIN_ADDR_LENGTH];
-  if (!c3_request_socket.connect(res->get_address(), res->get_port(), res->is_persistent())) {
-    set_error(error_return, return_value, "Could not connect to '%s:%hu'",
-      c3_ip2address(res->get_address(), ip_address), res->get_port());
-    return;
-  }
-  SocketGuard guard(c3_request_socket);
-
-  // 5) Create I/O objects
-  // ---------------------
+static bool build_command(SocketCommandWriter& command, const C3Resource* res,
+  const NetworkConfiguration& net_config, command_t cmd, bool admin, const char* format, const c3_arg_t* args,
+  c3_error_return_t error_return, zval* return_value) {
 
-  SharedBuffers* cmd_sb = SharedBuffers::create(global_memory);
-  SocketCommandWriter command(global_memory, c3_request_socket.get_fd(), res->get_address(), cmd_sb);
-  CommandHeaderChunkBuilder header(command, net_config, cmd, execute_as_admin);
+  CommandHeaderChunkBuilder header(command, net_config, cmd, admin);
   HeaderListChunkBuilder list(command, net_config); // just in case...
 
-  // 3) Estimate header size and fetch payload (if any)
+  // 1) Estimate header size and fetch payload (if any)
   // --------------------------------------------------
 
   const c3_arg_t* payload = nullptr;
@@ -450,7 +454,7 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
         if (num < INT_MIN_VAL || num > UINT_MAX_VAL) {
           set_error(error_return, return_value, "Number not in [%d..%u] range: %lld",
             INT_MIN_VAL, UINT_MAX_VAL, num);
-          return;
+          return false;
         }
         c3_uint_t chunk_size = header.estimate_number(num);
         header_size += chunk_size;
@@ -464,7 +468,7 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
         if (length > UINT_MAX_VAL) {
           set_error(error_return, return_value, "String longer than %u bytes (%lu bytes): '%.*s ...'",
             UINT_MAX_VAL, length, STRING_PRINTABLE_PREFIX_LENGTH, args[index].a_string);
-          return;
+          return false;
         }
         c3_uint_t chunk_size = header.estimate_string((c3_uint_t) length);
         header_size += chunk_size;
@@ -481,7 +485,7 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
           break;
         } else {
           // error message had already been printed, and return value set
-          return;
+          return false;
         }
       case 'A': {
         c3_assert(res->get_user_agent() < UA_NUMBER_OF_ELEMENTS);
@@ -496,7 +500,7 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
         if (payload->a_size > UINT_MAX_VAL) {
           set_error(error_return, return_value, "Data buffer bigger than %u bytes: %lu bytes",
             UINT_MAX_VAL, payload->a_size);
-          return;
+          return false;
         }
         index++;
         break;
@@ -506,11 +510,11 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
     if (header_size > UINT_MAX_VAL) {
       set_error(error_return, return_value, "Command header bigger than %u bytes: %llu bytes",
         UINT_MAX_VAL, header_size);
-      return;
+      return false;
     }
   }
 
-  // 4) Configure payload
+  // 2) Configure payload
   // --------------------
 
   if (payload != nullptr) {
@@ -521,7 +525,7 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
     header.configure(nullptr);
   }
 
-  // 5) Add data chunks to the header
+  // 3) Add data chunks to the header
   // --------------------------------
 
   index = 0;
@@ -552,64 +556,33 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
     }
   }
 
-  // 6) Validate header
+  // 4) Validate header
   // ------------------
 
   header.check();
+  return true;
+}
 
-  // 7) Send command to the server
-  // -----------------------------
-
+static io_result_t send_command(SocketCommandWriter& command) {
   io_result_t result;
-  bool first_time = true;
-  for(;;) {
+  do {
     c3_ulong_t written_bytes;
     result = command.write(written_bytes);
-    switch (result) {
-      case IO_RESULT_OK:
-        break;
-      case IO_RESULT_EOF:
-      case IO_RESULT_ERROR:
-        if (first_time && res->is_persistent() && c3_request_socket.reconnect()) {
-          /*
-           * we get here if PHP extension was put into "persistent connections" mode, while
-           * the server works in "per-command connections" mode, so it apparently hung up after last
-           * submitted command, and we should retry (but only once)
-           */
-          command.io_rewind(c3_request_socket.get_fd(), res->get_address());
-        } else {
-          set_error(error_return, return_value, "Could not send command to %s:%hu (result=%u)",
-            c3_ip2address(res->get_address(), ip_address), res->get_port(), result);
-          return;
-        }
-        // fall through
-      case IO_RESULT_RETRY:
-        first_time = false;
-        continue;
-    }
-    break;
-  }
-
-  // 8) Receive response from the server
-  // -----------------------------------
-
-  SharedBuffers* resp_sb = SharedBuffers::create(global_memory);
-  // `reconnect()` could have changed socket handle, so we could not initialize response earlier
-  SocketResponseReader response(global_memory, c3_request_socket.get_fd(), res->get_address(), resp_sb);
+  } while (result == IO_RESULT_RETRY);
+  return result;
+}
 
+static io_result_t receive_response(SocketResponseReader& response) {
+  io_result_t result;
   do {
     c3_ulong_t read_bytes;
     result = response.read(read_bytes);
   } while (result == IO_RESULT_RETRY);
+  return result;
+}
 
-  if (result != IO_RESULT_OK) {
-    set_error(error_return, return_value, "Could not receive response from %s:%hu (result=%u)",
-      c3_ip2address(res->get_address(), ip_address), res->get_port(), result);
-    return;
-  }
-
-  // 9) Process server response
-  // --------------------------
+static void process_response(const SocketResponseReader& response, C3Resource* res, command_t cmd,
+  c3_ok_return_t ok_return, c3_error_return_t error_return, zval* return_value) {
 
   response_type_t type = response.get_type();
   switch (type) {
@@ -648,9 +621,15 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
       }
       break;
     case RESPONSE_LIST:
-      if (ok_return == OSR_ARRAY_FROM_LIST_PAYLOAD) {
-        fetch_array_from_list_payload(response, error_return, return_value);
-        return;
+      switch (ok_return) {
+        case OSR_ARRAY_FROM_LIST_PAYLOAD:
+          fetch_array_from_list_payload(response, error_return, return_value);
+          return;
+        case OSR_MAP_FROM_LIST_PAYLOAD:
+          fetch_map_from_list_payload(response, error_return, return_value);
+          return;
+        default:
+          break;
       }
       break;
     case RESPONSE_ERROR:
@@ -660,9 +639,280 @@ void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_er
       c3_assert_failure();
   }
 
-  // 10) Process unexpected responses
-  // --------------------------------
-
+  // process unexpected responses
   set_internal_error(error_return, return_value, "unexpected server response [C%02X:R%u:E%u]",
     cmd, type, ok_return);
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// PIPELINING
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Maximum number of commands that `call_c3_multi()` sends before it starts reading responses.
+ *
+ * The server processes commands received over a connection strictly one by one, so responses come back
+ * in the order in which commands were sent, and position of a response in the batch identifies the
+ * command it belongs to.
+ */
+static constexpr c3_uint_t PIPELINE_MAX_BATCH_COMMANDS = 16;
+
+/**
+ * Maximum total size of commands in a batch (a single command can be bigger). The server does not read
+ * next command until it sends response to the current one, so if a batch did not fit into socket
+ * buffers, we would block sending the rest of it while the server would block sending a response we do
+ * not read yet.
+ */
+static constexpr c3_uint_t PIPELINE_MAX_BATCH_BYTES = 32 * 1024;
+
+/// A command that is sent as part of a batch
+struct pipelined_command_t {
+  SocketCommandWriter* pc_command; // command object
+  c3_uint_t            pc_index;   // index of command's arguments (and result)
+};
+
+static SocketCommandWriter* create_command(const C3Resource* res, const NetworkConfiguration& net_config,
+  command_t cmd, bool admin, const char* format, const c3_arg_t* args,
+  c3_error_return_t error_return, zval* return_value) {
+  SharedBuffers* sb = SharedBuffers::create(global_memory);
+  auto command = alloc<SocketCommandWriter>(global_memory);
+  // actual connection handle will be set by `io_rewind()` right before sending the command
+  new (command) SocketCommandWriter(global_memory, 0, res->get_address(), sb);
+  if (build_command(*command, res, net_config, cmd, admin, format, args, error_return, return_value)) {
+    return command;
+  }
+  ReaderWriter::dispose(command);
+  return nullptr;
+}
+
+static void set_multi_result(zval* return_value, const c3_arg_t& id, zval* value) {
+  zend_symtable_str_update(Z_ARRVAL_P(return_value), id.a_string, id.a_size, value);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INTERFACE
+///////////////////////////////////////////////////////////////////////////////
+
+void call_c3(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_error_return_t error_return,
+  command_t cmd, c3_auth_type_t auth, const char* format, c3_arg_t* args) {
+
+  c3_assert(rc && return_value && cmd && format && (format[0] == 0 || args));
+
+  // 1) Get and validate resource handle
+  // -----------------------------------
+
+  C3Resource* res = fetch_resource(rc, error_return, return_value);
+  if (res == nullptr) {
+    return;
+  }
+
+  // 2) Create network configuration object
+  // --------------------------------------
+
+  NetworkConfiguration net_config(res->get_user_password(), res->get_admin_password(),
+    res->get_compressor(), res->get_threshold(), res->get_marker());
+
+  // 3) Establish connection to the server
+  // -------------------------------------
+
+  char ip_address[C3_SOCK_MIN_ADDR_LENGTH];
+  if (!c3_request_socket.connect(res->get_address(), res->get_port(), res->is_persistent())) {
+    set_error(error_return, return_value, "Could not connect to '%s:%hu'",
+      c3_ip2address(res->get_address(), ip_address), res->get_port());
+    return;
+  }
+  SocketGuard guard(c3_request_socket);
+
+  // 4) Create and configure command object
+  // --------------------------------------
+
+  SharedBuffers* cmd_sb = SharedBuffers::create(global_memory);
+  SocketCommandWriter command(global_memory, c3_request_socket.get_fd(), res->get_address(), cmd_sb);
+  if (!build_command(command, res, net_config, cmd, execute_as_admin(auth), format, args,
+    error_return, return_value)) {
+    // error message had already been printed, and return value set
+    return;
+  }
+
+  // 5) Send command to the server
+  // -----------------------------
+
+  io_result_t result = send_command(command);
+  if (result != IO_RESULT_OK) {
+    if (res->is_persistent() && c3_request_socket.reconnect()) {
+      /*
+       * we get here if PHP extension was put into "persistent connections" mode, while
+       * the server works in "per-command connections" mode, so it apparently hung up after last
+       * submitted command, and we should retry (but only once)
+       */
+      command.io_rewind(c3_request_socket.get_fd(), res->get_address());
+      result = send_command(command);
+    }
+    if (result != IO_RESULT_OK) {
+      set_error(error_return, return_value, "Could not send command to %s:%hu (result=%u)",
+        c3_ip2address(res->get_address(), ip_address), res->get_port(), result);
+      return;
+    }
+  }
+
+  // 6) Receive response from the server
+  // -----------------------------------
+
+  SharedBuffers* resp_sb = SharedBuffers::create(global_memory);
+  // `reconnect()` could have changed socket handle, so we could not initialize response earlier
+  SocketResponseReader response(global_memory, c3_request_socket.get_fd(), res->get_address(), resp_sb);
+  result = receive_response(response);
+  if (result != IO_RESULT_OK) {
+    set_error(error_return, return_value, "Could not receive response from %s:%hu (result=%u)",
+      c3_ip2address(res->get_address(), ip_address), res->get_port(), result);
+    return;
+  }
+
+  // 7) Process server response
+  // --------------------------
+
+  process_response(response, res, cmd, ok_return, error_return, return_value);
+}
+
+void call_c3_multi(const zval* rc, zval* return_value, c3_ok_return_t ok_return, c3_error_return_t error_return,
+  command_t cmd, c3_auth_type_t auth, const char* format, c3_uint_t num_commands, c3_arg_t* args) {
+
+  c3_assert(rc && return_value && cmd && format && format[0] == 'S' && args);
+
+  // 1) Get and validate resource handle
+  // -----------------------------------
+
+  C3Resource* res = fetch_resource(rc, ESR_FALSE_FROM_ERROR, return_value);
+  if (res == nullptr) {
+    return;
+  }
+  NetworkConfiguration net_config(res->get_user_password(), res->get_admin_password(),
+    res->get_compressor(), res->get_threshold(), res->get_marker());
+  bool admin = execute_as_admin(auth);
+
+  // 2) Pre-populate result array with error returns
+  // -----------------------------------------------
+
+  /*
+   * This way, the array will have all requested keys (in the order in which they were requested) even if
+   * we lose connection to the server halfway through, and we will only have to replace values of the
+   * elements for which we receive responses.
+   */
+  c3_uint_t num_args = 0;
+  for (const char* specifier = format; *specifier != '\0'; specifier++) {
+    if (*specifier != 'A') {
+      num_args++;
+    }
+  }
+  array_init_size(return_value, num_commands);
+  for (c3_uint_t i = 0; i < num_commands; i++) {
+    zval value;
+    set_error(error_return, &value);
+    set_multi_result(return_value, args[i * num_args], &value);
+  }
+
+  // 3) Send commands in batches, reading responses to each batch after sending all its commands
+  // -------------------------------------------------------------------------------------------
+
+  char ip_address[C3_SOCK_MIN_ADDR_LENGTH];
+  const c3_uint_t max_batch_commands = res->is_persistent()? PIPELINE_MAX_BATCH_COMMANDS: 1;
+  pipelined_command_t batch[PIPELINE_MAX_BATCH_COMMANDS];
+  pipelined_command_t postponed = { nullptr, 0 };
+  c3_uint_t next_index = 0;
+  while (next_index < num_commands || postponed.pc_command != nullptr) {
+
+    // a) Create command objects
+    // -------------------------
+
+    c3_uint_t num_batch_commands = 0;
+    c3_ulong_t batch_size = 0;
+    if (postponed.pc_command != nullptr) {
+      batch[num_batch_commands++] = postponed;
+      batch_size = postponed.pc_command->get_command_size();
+      postponed.pc_command = nullptr;
+    }
+    while (num_batch_commands < max_batch_commands && next_index < num_commands) {
+      const c3_arg_t* command_args = args + next_index * num_args;
+      zval value;
+      SocketCommandWriter* command = create_command(res, net_config, cmd, admin, format, command_args,
+        error_return, &value);
+      if (command != nullptr) {
+        c3_uint_t command_size = command->get_command_size();
+        if (num_batch_commands > 0 && batch_size + command_size > PIPELINE_MAX_BATCH_BYTES) {
+          postponed.pc_command = command;
+          postponed.pc_index = next_index++;
+          break;
+        }
+        batch[num_batch_commands].pc_command = command;
+        batch[num_batch_commands++].pc_index = next_index;
+        batch_size += command_size;
+      } else {
+        // error message had already been printed
+        set_multi_result(return_value, command_args[0], &value);
+      }
+      next_index++;
+    }
+
+    // b) Send commands and receive responses
+    // --------------------------------------
+
+    /*
+     * If the server closes the connection on us (e.g. because it does not use persistent connections),
+     * we re-connect and re-send all the commands for which we have not received responses yet, but only
+     * if we have received at least one response since the previous re-connection (or if it's the first
+     * failure).
+     */
+    c3_uint_t num_responses = 0;
+    bool reconnected = false;
+    bool failed = !c3_request_socket.connect(res->get_address(), res->get_port(), res->is_persistent());
+    if (failed) {
+      report_error("Could not connect to '%s:%hu'",
+        c3_ip2address(res->get_address(), ip_address), res->get_port());
+    }
+    while (!failed && num_responses < num_batch_commands) {
+      io_result_t result = IO_RESULT_OK;
+      for (c3_uint_t i = num_responses; i < num_batch_commands && result == IO_RESULT_OK; i++) {
+        SocketCommandWriter* command = batch[i].pc_command;
+        command->io_rewind(c3_request_socket.get_fd(), res->get_address());
+        result = send_command(*command);
+      }
+      while (result == IO_RESULT_OK && num_responses < num_batch_commands) {
+        SharedBuffers* resp_sb = SharedBuffers::create(global_memory);
+        SocketResponseReader response(global_memory, c3_request_socket.get_fd(), res->get_address(), resp_sb);
+        result = receive_response(response);
+        if (result == IO_RESULT_OK) {
+          const pipelined_command_t& pc = batch[num_responses++];
+          const c3_arg_t* command_args = args + pc.pc_index * num_args;
+          zval value;
+          process_response(response, res, cmd, ok_return, error_return, &value);
+          set_multi_result(return_value, command_args[0], &value);
+          reconnected = false;
+        }
+      }
+      if (result != IO_RESULT_OK) {
+        if (res->is_persistent() && !reconnected && c3_request_socket.reconnect()) {
+          reconnected = true;
+        } else {
+          report_error("Could not exchange data with %s:%hu (result=%u)",
+            c3_ip2address(res->get_address(), ip_address), res->get_port(), result);
+          failed = true;
+        }
+      }
+    }
+    c3_request_socket.disconnect(failed);
+    for (c3_uint_t i = 0; i < num_batch_commands; i++) {
+      ReaderWriter::dispose(batch[i].pc_command);
+    }
+
+    // c) Stop at first connection failure
+    // -----------------------------------
+
+    if (failed) {
+      // keep error returns for the commands that we could not send (they had been pre-populated)
+      if (postponed.pc_command != nullptr) {
+        ReaderWriter::dispose(postponed.pc_command);
+      }
+      return;
+    }
+  }
+}
@@ -34,7 +34,8 @@ enum c3_ok_return_t {
   OSR_NUM3_ARRAY_FROM_DATA_HEADER, // return array of 3 numbers if server response is 'data' (special case)
   OSR_METADATA_FROM_DATA_HEADER,   // return data formatted for GETMETADATAS command (special case)
   OSR_STRING_FROM_DATA_PAYLOAD,    // return string if server response is 'data' with valid payload
-  OSR_ARRAY_FROM_LIST_PAYLOAD      // return array if server response is 'list' with valid payload
+  OSR_ARRAY_FROM_LIST_PAYLOAD,     // return array if server response is 'list' with valid payload
+  OSR_MAP_FROM_LIST_PAYLOAD        // return associative array if server response is 'list' with key/value pairs
 };
 
 /**
@@ -105,4 +106,27 @@ void call_c3(const zval* rc,
   zval* return_value, c3_ok_return_t ok_return, c3_error_return_t error_return,
   command_t cmd, c3_auth_type_t auth, const char* format, c3_arg_t* args = nullptr);
 
+/**
+ * Issues the same command with different sets of arguments to CyberCache Cluster, and returns results
+ * to PHP code as an associative array keyed by cache record IDs.
+ *
+ * If the resource uses persistent connections, commands are sent in batches over single connection, and
+ * responses to all commands of a batch are read after the whole batch has been sent; otherwise, each
+ * command is sent over its own connection.
+ *
+ * @param rc Pointer to PHP variable that holds an instance of C3Resource class.
+ * @param return_value Pointer to PHP variable to which array of results should be stored; it will be
+ *   set to `false` if the resource is invalid.
+ * @param ok_return What is considered a "success" value of each array element.
+ * @param error_return What should be stored into an array element upon "failure".
+ * @param cmd ID of the command that should be sent to the server.
+ * @param auth Authentication level required by the command.
+ * @param format Same as for `call_c3()`; first specifier must be 'S' (cache record ID).
+ * @param num_commands Number of commands to send.
+ * @param args Array of `num_commands` argument sets, one after another.
+ */
+void call_c3_multi(const zval* rc,
+  zval* return_value, c3_ok_return_t ok_return, c3_error_return_t error_return,
+  command_t cmd, c3_auth_type_t auth, const char* format, c3_uint_t num_commands, c3_arg_t* args);
+
 #endif // _SERVER_THUNK_H
@@ -31,13 +31,13 @@ void get_help(Parser& parser) {
     ping, check, info, stats.
   ADMINISTRATIVE commands (sent to server):
     shutdown, localconfig, remoteconfig, restore, store,
-    get, set, log, rotate.
+    get, set, log, rotate, catchup, dump.
   SESSION store commands (sent to server):
     read, write, destroy, gc.
   FPC commands (sent to server):
-    load, test, save, remove, clean, getids, gettags,
-    getidsmatchingtags, getidsnotmatchingtags, getidsmatchinganytags,
-    getfillingpercentage, getmetadatas, touch.
+    load, test, save, remove, mload, mtest, msave, mremove, clean,
+    getids, gettags, getidsmatchingtags, getidsnotmatchingtags,
+    getidsmatchinganytags, getfillingpercentage, getmetadatas, touch.
 Use 'HELP <command>' to print out that command's format and description (note
 that command names are case-INsensitive). Enter <mask-containing-asterisks>
 (as a command, not as an argument to 'HELP') to get list of commands matching
@@ -268,9 +268,10 @@ Description:
   without arguments, prints out current setting.
 Compressor types:
   Compressor can be specified using one of the following reserved words:
-  'lzf', 'snappy', 'lz4', 'lzss3', 'brotli', 'zstd', 'zlib' (gzip), 'lzham';
-  default is 'snappy'. The 'brotli' compressor is only available in Enterprise
-  Edition of the suite. See documentation for details.$
+  'lzf', 'snappy', 'lz4', 'lzss3', 'brotli', 'zstd', 'zlib' (gzip), 'lzham',
+  'hesper', 'asciient'; default is 'snappy'. The 'brotli', 'hesper', and
+  'asciient' compressors are only available in Enterprise Edition of the
+  suite. See documentation for details.$
 THRESHOLD
 Format:
   threshold [ <positive-number> ]
@@ -597,6 +598,33 @@ Description:
   configuration option).
 Server response:
   'OK', or an error message.$
+CATCHUP
+Format:
+  catchup session | fpc | all [ <sequence-number> ]
+Description:
+  Makes session and/or FPC replicator re-send, from binlog files, commands
+  that it failed to deliver to replication servers. If <sequence-number> is
+  specified, all commands numbered above it are re-sent; otherwise, re-sending
+  starts with the first command that the replicator failed to deliver (see
+  'INFO' output). Respective binlog must be active; only binlog files rotated
+  since server start (and current binlog) are searched; passing 0 as
+  <sequence-number> re-sends everything they contain. May require
+  administrative authentication (depends upon 'admin_password' server
+  configuration option).
+Server response:
+  'OK', or an error message.$
+DUMP
+Format:
+  dump session | fpc <samples-file-path> [ <max-samples> ]
+Description:
+  Saves uncompressed data of up to <max-samples> (10000 by default) records
+  of specified domain to a samples file, to be used by the 'c3dict' utility
+  for training a compression dictionary. Records are picked evenly across the
+  whole store. Note that existing file will be overwritten. May require
+  administrative authentication (depends upon 'admin_password' server
+  configuration option).
+Server response:
+  'OK', or an error message.$
 READ
 Format:
   read <session-entry-id>
@@ -692,6 +720,47 @@ Description:
   authentication (depends upon 'user_password' server configuration option).
 Server response:
   'OK', or an error message.$
+MLOAD
+Format:
+  mload <fpc-entry-id> [ <fpc-entry-id> [...]]
+Description:
+  Fetches several FPC records from the server in one request. Passes currently
+  active 'USERAGENT' to the server. May require user-level authentication
+  (depends upon 'user_password' server configuration option).
+Server response:
+  List of strings: ID and data of each found record (records that did not
+  exist are omitted), or an error message.$
+MTEST
+Format:
+  mtest <fpc-entry-id> [ <fpc-entry-id> [...]]
+Description:
+  Checks if FPC records with given IDs exist in the store. Passes currently
+  active 'USERAGENT' to the server. May require user-level authentication
+  (depends upon 'user_password' server configuration option).
+Server response:
+  List of strings: ID and last modification timestamp of each found record
+  (records that did not exist are omitted), or an error message.$
+MSAVE
+Format:
+  msave <fpc-entry-id> [@]<fpc-entry-data> [ <id> [@]<data> [...]]
+Description:
+  Sends several FPC records to the server in one request. Each record is
+  prepared exactly as it would be by the 'SAVE' command (with currently active
+  'USERAGENT', 'LIFETIME', and set of tags), and then all of them are sent as a
+  single batch that the server stores at once. May require user-level
+  authentication (if 'user_password' server configuration option is
+  non-empty).
+Server response:
+  'OK', or an error message.$
+MREMOVE
+Format:
+  mremove <fpc-entry-id> [ <fpc-entry-id> [...]]
+Description:
+  Deletes FPC records with specified IDs from the server in one request. May
+  require user-level authentication (depends upon 'user_password' server
+  configuration option).
+Server response:
+  'OK', or an error message.$
 CLEAN
 Format:
   clean { all | old | matchall | matchnot | matchany } [ <tag> [ <tag> [...]]]
@@ -622,7 +622,7 @@ static bool PARSER_SET_PROC(marker)(Parser& parser, parser_token_t* args, c3_uin
 }
 
 static bool PARSER_SET_PROC(compressor)(Parser& parser, parser_token_t* args, c3_uint_t num) {
-  static_assert(CT_NUMBER_OF_ELEMENTS == 9, "Number of compressors is not nine");
+  static_assert(CT_NUMBER_OF_ELEMENTS == 11, "Number of compressors is not eleven");
   static const char* compressors[CT_NUMBER_OF_ELEMENTS] = {
     "none", // never matched against user input
     "lzf",
@@ -632,9 +632,11 @@ static bool PARSER_SET_PROC(compressor)(Parser& parser, parser_token_t* args, c3
     "brotli",
     "zstd",
     "zlib",
-    "lzham"
+    "lzham",
+    "hesper",
+    "asciient"
   };
-  static_assert(CT_NUMBER_OF_ELEMENTS == 9, "Number of compressors has changed");
+  static_assert(CT_NUMBER_OF_ELEMENTS == 11, "Number of compressors has changed");
   switch (num) {
     case 0:
       parser.log(LL_EXPLICIT, "Currently active compressor is '%s'.",
@@ -645,8 +647,8 @@ static bool PARSER_SET_PROC(compressor)(Parser& parser, parser_token_t* args, c3
         const char* compressor = compressors[comp];
         if (args[0].is(compressor)) {
           #if !C3_ENTERPRISE
-          if (comp == CT_BROTLI) {
-            parser.log(LL_ERROR, "The 'brotli' compressor is only supported in Enterprise Edition");
+          if (is_enterprise_compressor((c3_compressor_t) comp)) {
+            parser.log(LL_ERROR, "The '%s' compressor is only supported in Enterprise Edition", compressor);
             return false;
           }
           #endif
@@ -1402,6 +1404,61 @@ static bool PARSER_SET_PROC(rotate)(Parser& parser, parser_token_t* args, c3_uin
   return true;
 }
 
+static bool PARSER_SET_PROC(catchup)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  if (num == 1 || num == 2) {
+    c3_uint_t mode;
+    parser_token_t& arg = args[0];
+    if (arg.is("session")) {
+      mode = DM_SESSION;
+    } else if (arg.is("fpc")) {
+      mode = DM_FPC;
+    } else if (arg.is("all")) {
+      mode = DM_SESSION | DM_FPC;
+    } else {
+      parser.log_error("Invalid catch-up domain: '%s'", arg.get_string());
+      return false;
+    }
+    if (num == 2) {
+      c3_ulong_t sequence;
+      if (!args[1].get_ulong(sequence)) {
+        parser.log_error("Invalid sequence number: '%s'", args[1].get_string());
+        return false;
+      }
+      // protocol numbers are 32-bit, so sequence number is sent as two halves, higher one first
+      cc_result = cc_server.execute(CMD_CATCHUP, "UUU", mode,
+        (c3_uint_t)(sequence >> 32), (c3_uint_t)(sequence & UINT_MAX_VAL));
+    } else {
+      cc_result = cc_server.execute(CMD_CATCHUP, "U", mode);
+    }
+    return true;
+  }
+  parser.log_error("Command '%s' requires one or two arguments.", parser.get_command_name());
+  return false;
+}
+
+static bool PARSER_SET_PROC(dump)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  if (num == 2 || num == 3) {
+    c3_uint_t domain;
+    parser_token_t& arg = args[0];
+    if (arg.is("session")) {
+      domain = DM_SESSION;
+    } else if (arg.is("fpc")) {
+      domain = DM_FPC;
+    } else {
+      parser.log_error("DUMP: unrecognized domain: '%s'.", arg.get_string());
+      return false;
+    }
+    c3_uint_t max_samples = 10000;
+    if (num == 3 && !get_positive_number(parser, args[2], max_samples, "max-samples")) {
+      return false;
+    }
+    cc_result = cc_server.execute(CMD_DUMP, "USU", domain, args[1].get_string(), max_samples);
+    return true;
+  }
+  parser.log_error("Command '%s' requires two or three arguments.", parser.get_command_name());
+  return false;
+}
+
 static bool PARSER_SET_PROC(read)(Parser& parser, parser_token_t* args, c3_uint_t num) {
   if (has_one_arg(parser, num)) {
     cc_result = cc_server.execute(CMD_READ, "SU", args[0].get_string(), cc_server.get_user_agent());
@@ -1476,31 +1533,37 @@ static bool PARSER_SET_PROC(test)(Parser& parser, parser_token_t* args, c3_uint_
   return false;
 }
 
+static bool get_fpc_data(Parser& parser, StringFile& file, const char*& data, c3_uint_t& length) {
+  if (data[0] == '@') {
+    const char* path = data + 1;
+    if (file.load(path)) {
+      data = file.get_string();
+      size_t size = file.get_length();
+      if (size > UINT_MAX_VAL) {
+        parser.log_error("FPC data file too big: '%s'", path);
+        return false;
+      }
+      length = (c3_uint_t) size;
+    } else {
+      parser.log_error("Could not load FPC data from '%s'.", path);
+      return false;
+    }
+  } else {
+    length = (c3_uint_t) std::strlen(data);
+  }
+  return true;
+}
+
 static bool PARSER_SET_PROC(save)(Parser& parser, parser_token_t* args, c3_uint_t num) {
   if (has_required_args(parser, num, 2)) {
     StringFile file;
     const char* data = args[1].get_string();
     c3_uint_t length;
-    if (data[0] == '@') {
-      const char* path = data + 1;
-      if (file.load(path)) {
-        data = file.get_string();
-        size_t size = file.get_length();
-        if (size > UINT_MAX_VAL) {
-          parser.log_error("FPC data file too big: '%s'", path);
-          return false;
-        }
-        length = (c3_uint_t) size;
-      } else {
-        parser.log_error("Could not load FPC data from '%s'.", path);
-        return false;
-      }
-    } else {
-      length = (c3_uint_t) std::strlen(data);
+    if (get_fpc_data(parser, file, data, length)) {
+      cc_result = cc_server.execute(CMD_SAVE, length, data, "SUNL",
+        args[0].get_string(), cc_server.get_user_agent(), cc_server.get_lifetime(), cc_server.get_tags());
+      return true;
     }
-    cc_result = cc_server.execute(CMD_SAVE, length, data, "SUNL",
-      args[0].get_string(), cc_server.get_user_agent(), cc_server.get_lifetime(), cc_server.get_tags());
-    return true;
   }
   return false;
 }
@@ -1513,6 +1576,72 @@ static bool PARSER_SET_PROC(remove)(Parser& parser, parser_token_t* args, c3_uin
   return false;
 }
 
+static bool PARSER_SET_PROC(mload)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  if (has_args(parser, num)) {
+    StringList list(num);
+    for (c3_uint_t i = 0; i < num; ++i) {
+      list.add_unique(args[i].get_string());
+    }
+    cc_result = cc_server.execute(CMD_MLOAD, "LU", &list, cc_server.get_user_agent());
+    return true;
+  }
+  return false;
+}
+
+static bool PARSER_SET_PROC(mtest)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  if (has_args(parser, num)) {
+    StringList list(num);
+    for (c3_uint_t i = 0; i < num; ++i) {
+      list.add_unique(args[i].get_string());
+    }
+    cc_result = cc_server.execute(CMD_MTEST, "LU", &list, cc_server.get_user_agent());
+    return true;
+  }
+  return false;
+}
+
+static bool PARSER_SET_PROC(msave)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  if (has_args(parser, num)) {
+    if (num % 2 != 0) {
+      parser.log_error("Command '%s' requires pairs of record IDs and data.", parser.get_command_name());
+      return false;
+    }
+    c3_byte_t* buffer = nullptr;
+    c3_uint_t size = 0;
+    bool ok = true;
+    for (c3_uint_t i = 0; i < num && ok; i += 2) {
+      StringFile file;
+      const char* data = args[i + 1].get_string();
+      c3_uint_t length;
+      ok = get_fpc_data(parser, file, data, length);
+      if (ok && !cc_server.append_save_command(buffer, size, args[i].get_string(), data, length)) {
+        parser.log_error("Could not create SAVE command for '%s'.", args[i].get_string());
+        ok = false;
+      }
+    }
+    if (ok) {
+      cc_result = cc_server.execute(CMD_MSAVE, size, buffer, "U", num / 2);
+    }
+    if (buffer != nullptr) {
+      global_memory.free(buffer, size);
+    }
+    return ok;
+  }
+  return false;
+}
+
+static bool PARSER_SET_PROC(mremove)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  if (has_args(parser, num)) {
+    StringList list(num);
+    for (c3_uint_t i = 0; i < num; ++i) {
+      list.add_unique(args[i].get_string());
+    }
+    cc_result = cc_server.execute(CMD_MREMOVE, "L", &list);
+    return true;
+  }
+  return false;
+}
+
 static bool PARSER_SET_PROC(clean)(Parser& parser, parser_token_t* args, c3_uint_t num) {
   if (has_args(parser, num)) {
     clean_mode_t mode;
@@ -1678,6 +1807,8 @@ static parser_command_t console_commands[] = {
   PARSER_SET_ENTRY(set),
   PARSER_SET_ENTRY(log),
   PARSER_SET_ENTRY(rotate),
+  PARSER_SET_ENTRY(catchup),
+  PARSER_SET_ENTRY(dump),
   PARSER_SET_ENTRY(read),
   PARSER_SET_ENTRY(write),
   PARSER_SET_ENTRY(destroy),
@@ -1686,6 +1817,10 @@ static parser_command_t console_commands[] = {
   PARSER_SET_ENTRY(test),
   PARSER_SET_ENTRY(save),
   PARSER_SET_ENTRY(remove),
+  PARSER_SET_ENTRY(mload),
+  PARSER_SET_ENTRY(mtest),
+  PARSER_SET_ENTRY(msave),
+  PARSER_SET_ENTRY(mremove),
   PARSER_SET_ENTRY(clean),
   PARSER_SET_ENTRY(getids),
   PARSER_SET_ENTRY(gettags),
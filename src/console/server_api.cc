@@ -707,16 +707,24 @@ bool CommandInfo::is_admin_command() const {
         case CMD_SET:
         case CMD_LOG:
         case CMD_ROTATE:
+        case CMD_CATCHUP:
+        case CMD_DUMP:
           return true;
+        case CMD_SEQUENCE:
         case CMD_READ:
         case CMD_WRITE:
         case CMD_DESTROY:
         case CMD_GC:
+        case CMD_BATCH:
         case CMD_LOAD:
         case CMD_TEST:
         case CMD_SAVE:
         case CMD_REMOVE:
         case CMD_CLEAN:
+        case CMD_MLOAD:
+        case CMD_MTEST:
+        case CMD_MSAVE:
+        case CMD_MREMOVE:
         case CMD_GETIDS:
         case CMD_GETTAGS:
         case CMD_GETIDSMATCHINGTAGS:
@@ -788,6 +796,36 @@ void CyberCache::populate_list(HeaderListChunkBuilder& header_list, const String
   header_list.check();
 }
 
+bool CyberCache::append_save_command(c3_byte_t*& buffer, c3_uint_t& size, const char* id,
+  const char* data, c3_uint_t length) const {
+  SharedBuffers* cmd_sb = SharedBuffers::create(global_memory);
+  // the command is never sent on its own, so it does not need a connection handle
+  SocketCommandWriter command(global_memory, 0, cc_ip, cmd_sb);
+  CommandHeaderChunkBuilder header(command, console_net_config, CMD_SAVE, false);
+  HeaderListChunkBuilder list(command, console_net_config);
+  populate_list(list, &cc_tags);
+  if (header.estimate_cstring(id) != 0 &&
+    header.estimate_number(cc_user_agent) != 0 &&
+    header.estimate_number(cc_lifetime) != 0 &&
+    header.estimate_list(list) != 0) {
+    PayloadChunkBuilder payload(command, console_net_config);
+    payload.add((const c3_byte_t*) data, length);
+    header.configure(&payload);
+    header.add_cstring(id);
+    header.add_number(cc_user_agent);
+    header.add_number(cc_lifetime);
+    header.add_list(list);
+    header.check();
+    c3_uint_t command_size = command.get_command_size();
+    buffer = (c3_byte_t*) (buffer != nullptr?
+      global_memory.realloc(buffer, size + command_size, size): global_memory.alloc(command_size));
+    command.copy_command(buffer + size);
+    size += command_size;
+    return true;
+  }
+  return false;
+}
+
 Result CyberCache::run(command_t cmd, const void* buffer, c3_uint_t length,
   const char* format, va_list args) {
 
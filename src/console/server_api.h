@@ -338,6 +338,13 @@ public:
   bool is_persistent() const { return cc_persistent; }
   void set_persistent(bool persistent) { cc_persistent = persistent; }
 
+  /**
+   * Serializes `SAVE` command with currently active user agent, lifetime, and tags, and appends it to
+   * the buffer (which is allocated or grown using global memory object); used to build payloads of
+   * `MSAVE` commands. Returns `false` if the command could not be built.
+   */
+  bool append_save_command(c3_byte_t*& buffer, c3_uint_t& size, const char* id,
+    const char* data, c3_uint_t length) const;
   Result emulate(const CommandInfo& info, const void* buffer, c3_uint_t length, const char* format,
     const CommandArgument* arguments);
   Result execute(command_t cmd, c3_uint_t size, const void* buffer, const char* format, ...);
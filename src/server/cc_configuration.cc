@@ -27,8 +27,10 @@ static const char* config_log_levels[LL_NUMBER_OF_ELEMENTS];
 static const char* config_eviction_modes[EM_NUMBER_OF_ELEMENTS];
 static const char* config_compressors[CT_NUMBER_OF_ELEMENTS];
 static const char* config_hashers[HM_NUMBER_OF_ELEMENTS];
+static const char* config_table_engines[TE_NUMBER_OF_ELEMENTS];
 static const char* config_sync_modes[SM_NUMBER_OF_ELEMENTS];
 static const char* config_user_agents[UA_NUMBER_OF_ELEMENTS];
+static const char* config_io_backends[IOB_NUMBER_OF_ELEMENTS];
 
 ///////////////////////////////////////////////////////////////////////////////
 // HELPERS TO BE USED BY OPTIONS' GETTERS/SETTERS
@@ -347,6 +349,15 @@ bool Configuration::get_recompression_threshold(Parser &parser, parser_token_t*
   return false;
 }
 
+bool Configuration::get_exploration_rate(Parser &parser, parser_token_t* args, c3_uint_t num,
+  Optimizer &optimizer) {
+  c3_uint_t rate;
+  if (get_number(parser, args, num, rate, 0, 100)) {
+    return optimizer.post_config_exploration_rate_message(rate);
+  }
+  return false;
+}
+
 void Configuration::log_keyword_error(Parser& parser, const char** options, c3_uint_t num_options) {
   const size_t BUFFER_SIZE = 1024;
   char buffer[BUFFER_SIZE];
@@ -433,8 +444,9 @@ ssize_t Configuration::print_compressors(char* buff, size_t length, Optimizer& o
 int Configuration::get_compressor_index(Parser& parser, parser_token_t& arg) {
   int compressor = get_keyword_index(parser, arg, config_compressors, CT_NUMBER_OF_ELEMENTS);
   #if !C3_ENTERPRISE
-  if (compressor == CT_BROTLI) {
-    parser.log(LL_ERROR, "The 'brotli' compressor is available in Enterprise Edition only");
+  if (compressor >= 0 && is_enterprise_compressor((c3_compressor_t) compressor)) {
+    parser.log(LL_ERROR, "The '%s' compressor is available in Enterprise Edition only",
+      config_compressors[compressor]);
     compressor = -1;
   }
   #endif
@@ -444,8 +456,9 @@ int Configuration::get_compressor_index(Parser& parser, parser_token_t& arg) {
 int Configuration::get_single_compressor_index(Parser& parser, parser_token_t* args, c3_uint_t num) {
   int compressor = get_single_keyword_index(parser, args, num, config_compressors, CT_NUMBER_OF_ELEMENTS);
   #if !C3_ENTERPRISE
-  if (compressor == CT_BROTLI) {
-    parser.log(LL_ERROR, "The 'brotli' compressor is available in Enterprise Edition only");
+  if (compressor >= 0 && is_enterprise_compressor((c3_compressor_t) compressor)) {
+    parser.log(LL_ERROR, "The '%s' compressor is available in Enterprise Edition only",
+      config_compressors[compressor]);
     compressor = -1;
   }
   #endif
@@ -503,9 +516,8 @@ ssize_t Configuration::get_max_file_size(Parser& parser, char* buff, size_t leng
   return Parser::print_size(buff, length, file.get_max_size());
 }
 
-bool Configuration::set_ips(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline) {
+bool Configuration::get_ips(Parser &parser, parser_token_t* args, c3_uint_t num, c3_ipv4_t* ips) {
   if (require_arguments(parser, num, "address", 1, MAX_IPS_PER_SERVICE)) {
-    c3_ipv4_t ips[MAX_IPS_PER_SERVICE];
     c3_uint_t i = 0;
     do {
       const char* address = args[i].get_string();
@@ -516,11 +528,22 @@ bool Configuration::set_ips(Parser &parser, parser_token_t* args, c3_uint_t num,
       }
       ips[i] = ip;
     } while (++i < num);
-    return pipeline.send_ip_set_change_command(ips, num);
+    return true;
   }
   return false;
 }
 
+bool Configuration::set_ips(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline) {
+  c3_ipv4_t ips[MAX_IPS_PER_SERVICE];
+  return get_ips(parser, args, num, ips) && pipeline.send_ip_set_change_command(ips, num);
+}
+
+bool Configuration::set_ips(Parser &parser, parser_token_t* args, c3_uint_t num,
+  ShardedSocketInputPipeline &pipeline) {
+  c3_ipv4_t ips[MAX_IPS_PER_SERVICE];
+  return get_ips(parser, args, num, ips) && pipeline.send_ip_set_change_command(ips, num);
+}
+
 bool Configuration::set_port(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline) {
   c3_uint_t port;
   if (get_number(parser, args, num, port, 1024, 65535)) {
@@ -529,6 +552,15 @@ bool Configuration::set_port(Parser &parser, parser_token_t* args, c3_uint_t num
   return false;
 }
 
+bool Configuration::set_port(Parser &parser, parser_token_t* args, c3_uint_t num,
+  ShardedSocketInputPipeline &pipeline) {
+  c3_uint_t port;
+  if (get_number(parser, args, num, port, 1024, 65535)) {
+    return pipeline.send_port_change_command((c3_ushort_t) port);
+  }
+  return false;
+}
+
 bool Configuration::set_persistence(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline) {
   bool enabled;
   if (Configuration::get_boolean(parser, args, num, enabled)) {
@@ -537,6 +569,15 @@ bool Configuration::set_persistence(Parser &parser, parser_token_t* args, c3_uin
   return false;
 }
 
+bool Configuration::set_persistence(Parser &parser, parser_token_t* args, c3_uint_t num,
+  ShardedSocketInputPipeline &pipeline) {
+  bool enabled;
+  if (Configuration::get_boolean(parser, args, num, enabled)) {
+    return pipeline.send_set_persistent_connections_command(enabled);
+  }
+  return false;
+}
+
 ssize_t Configuration::print_fill_factor(char* buff, size_t length, Store& store) {
   return std::snprintf(buff, length, "%f", store.get_fill_factor());
 }
@@ -578,6 +619,22 @@ bool Configuration::set_init_capacity(Parser &parser, parser_token_t* args, c3_u
   return false;
 }
 
+ssize_t Configuration::print_table_engine(char* buff, size_t length, ObjectStore& store) {
+  return print_keyword(buff, length, store.get_table_engine(), config_table_engines, TE_NUMBER_OF_ELEMENTS);
+}
+
+bool Configuration::set_table_engine(Parser &parser, parser_token_t* args, c3_uint_t num, ObjectStore &store) {
+  int option = get_single_keyword_index(parser, args, num, config_table_engines, TE_NUMBER_OF_ELEMENTS);
+  if (option >= 0) {
+    // if server is not in CONFIG state, we fail silently
+    if (server.get_state() <= SS_CONFIG) {
+      store.set_table_engine((table_engine_t) option);
+    }
+    return true;
+  }
+  return false;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // OPTION HANDLERS
 ///////////////////////////////////////////////////////////////////////////////
@@ -668,6 +725,42 @@ static bool CONFIG_SET_PROC(fpc_replicator_persistent)(Parser& parser, parser_to
   return Configuration::set_persistence(parser, args, num, fpc_replicator);
 }
 
+static ssize_t CONFIG_GET_PROC(session_replicator_window)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, session_replicator.get_window());
+}
+
+static bool CONFIG_SET_PROC(session_replicator_window)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t window;
+  if (Configuration::get_number(parser, args, num, window, 1, SocketOutputPipeline::get_max_window())) {
+    return session_replicator.send_window_change_command(window);
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(fpc_replicator_window)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, fpc_replicator.get_window());
+}
+
+static bool CONFIG_SET_PROC(fpc_replicator_window)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t window;
+  if (Configuration::get_number(parser, args, num, window, 1, SocketOutputPipeline::get_max_window())) {
+    return fpc_replicator.send_window_change_command(window);
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(session_replicator_batch_size)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, session_replicator.get_batch_size());
+}
+
+static bool CONFIG_SET_PROC(session_replicator_batch_size)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_ulong_t size;
+  if (Configuration::get_size(parser, args, num, size, 0, SocketOutputPipeline::get_max_batch_size())) {
+    return session_replicator.send_batch_size_change_command((c3_uint_t) size);
+  }
+  return false;
+}
+
 static bool CONFIG_SET_PROC(user_password)(Parser& parser, parser_token_t* args, c3_uint_t num) {
   if (Configuration::check_password(parser, args, num)) {
     if (!parser.is_interactive()) {
@@ -770,6 +863,56 @@ static bool CONFIG_SET_PROC(num_connection_threads)(Parser& parser, parser_token
   return false;
 }
 
+static ssize_t CONFIG_GET_PROC(num_recompression_threads)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, recompressor.get_num_threads());
+}
+
+static bool CONFIG_SET_PROC(num_recompression_threads)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t num_threads;
+  if (Configuration::get_number(parser, args, num, num_threads, 0, MAX_NUM_RECOMPRESSION_THREADS)) {
+    return server.set_num_recompression_threads(num_threads);
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(num_listener_threads)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, server_listener.get_num_shards());
+}
+
+static bool CONFIG_SET_PROC(num_listener_threads)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t num_threads;
+  if (Configuration::get_number(parser, args, num, num_threads, 1, MAX_NUM_LISTENER_THREADS)) {
+    return server.set_num_listener_threads(num_threads);
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(io_backend)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_keyword(buff, length, FileOutputPipeline::get_io_backend(),
+    config_io_backends, IOB_NUMBER_OF_ELEMENTS);
+}
+
+static bool CONFIG_SET_PROC(io_backend)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  int option = Configuration::get_single_keyword_index(parser, args, num,
+    config_io_backends, IOB_NUMBER_OF_ELEMENTS);
+  if (option > 0) {
+    return server.set_io_backend((io_backend_t) option);
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(num_tag_manager_threads)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, tag_manager.get_num_shards());
+}
+
+static bool CONFIG_SET_PROC(num_tag_manager_threads)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t num_threads;
+  if (Configuration::get_number(parser, args, num, num_threads, 1, MAX_NUM_TAG_MANAGER_THREADS)) {
+    return server.set_num_tag_manager_threads(num_threads);
+  }
+  return false;
+}
+
 static ssize_t CONFIG_GET_PROC(session_lock_wait_time)(Parser& parser, char* buff, size_t length) {
   return Configuration::print_number(buff, length, SessionObject::get_lock_wait_time());
 }
@@ -946,6 +1089,25 @@ static bool CONFIG_SET_PROC(fpc_optimization_compressors)(Parser& parser, parser
   return Configuration::get_compressors(parser, args, num, fpc_optimizer);
 }
 
+static ssize_t CONFIG_GET_PROC(session_optimization_exploration)(Parser& parser, char* buff,
+  size_t length) {
+  return Configuration::print_number(buff, length, session_optimizer.get_exploration_rate());
+}
+
+static bool CONFIG_SET_PROC(session_optimization_exploration)(Parser& parser, parser_token_t* args,
+  c3_uint_t num) {
+  return Configuration::get_exploration_rate(parser, args, num, session_optimizer);
+}
+
+static ssize_t CONFIG_GET_PROC(fpc_optimization_exploration)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, fpc_optimizer.get_exploration_rate());
+}
+
+static bool CONFIG_SET_PROC(fpc_optimization_exploration)(Parser& parser, parser_token_t* args,
+  c3_uint_t num) {
+  return Configuration::get_exploration_rate(parser, args, num, fpc_optimizer);
+}
+
 static ssize_t CONFIG_GET_PROC(session_recompression_threshold)(Parser& parser, char* buff,
   size_t length) {
   return Configuration::print_number(buff, length, session_optimizer.get_recompression_threshold());
@@ -993,11 +1155,13 @@ static bool CONFIG_SET_PROC(fpc_tables_per_store)(Parser& parser, parser_token_t
 }
 
 static ssize_t CONFIG_GET_PROC(tags_tables_per_store)(Parser& parser, char* buff, size_t length) {
-  return Configuration::print_number(buff, length, tag_manager.get_num_tables());
+  return Configuration::print_number(buff, length, tag_manager.get_shard(0).get_num_tables());
 }
 
 static bool CONFIG_SET_PROC(tags_tables_per_store)(Parser& parser, parser_token_t* args, c3_uint_t num) {
-  return Configuration::set_num_tables(parser, args, num, tag_manager);
+  return tag_manager.configure_shards([&](ObjectStore& store) {
+    return Configuration::set_num_tables(parser, args, num, store);
+  });
 }
 
 static ssize_t CONFIG_GET_PROC(health_check_interval)(Parser& parser, char* buff, size_t length) {
@@ -1292,6 +1456,50 @@ static bool CONFIG_SET_PROC(fpc_db_file)(Parser& parser, parser_token_t* args, c
   return false;
 }
 
+#if C3_ENTERPRISE
+static ssize_t CONFIG_GET_PROC(session_compressor_dictionary)(Parser& parser, char* buff, size_t length) {
+  return std::snprintf(buff, length, "%s", server.get_session_dictionary_path());
+}
+
+static bool CONFIG_SET_PROC(session_compressor_dictionary)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  return Configuration::check_path(parser, args, num) && server.set_session_dictionary_path(args[0].get_string());
+}
+
+static ssize_t CONFIG_GET_PROC(fpc_compressor_dictionary)(Parser& parser, char* buff, size_t length) {
+  return std::snprintf(buff, length, "%s", server.get_fpc_dictionary_path());
+}
+
+static bool CONFIG_SET_PROC(fpc_compressor_dictionary)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  return Configuration::check_path(parser, args, num) && server.set_fpc_dictionary_path(args[0].get_string());
+}
+#endif // C3_ENTERPRISE
+
+static ssize_t CONFIG_GET_PROC(session_db_segments)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, server.get_session_db_segments());
+}
+
+static bool CONFIG_SET_PROC(session_db_segments)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t num_segments;
+  if (Configuration::get_number(parser, args, num, num_segments, 1, Server::get_max_db_segments())) {
+    server.set_session_db_segments(num_segments);
+    return true;
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(fpc_db_segments)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, server.get_fpc_db_segments());
+}
+
+static bool CONFIG_SET_PROC(fpc_db_segments)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t num_segments;
+  if (Configuration::get_number(parser, args, num, num_segments, 1, Server::get_max_db_segments())) {
+    server.set_fpc_db_segments(num_segments);
+    return true;
+  }
+  return false;
+}
+
 static ssize_t CONFIG_GET_PROC(session_auto_save_interval)(Parser& parser, char* buff, size_t length) {
   return Parser::print_duration(buff, length, server.get_session_autosave_interval());
 }
@@ -1572,11 +1780,13 @@ static bool CONFIG_SET_PROC(perf_fpc_table_fill_factor)(Parser& parser, parser_t
 }
 
 static ssize_t CONFIG_GET_PROC(perf_tags_table_fill_factor)(Parser& parser, char* buff, size_t length) {
-  return Configuration::print_fill_factor(buff, length, tag_manager);
+  return Configuration::print_fill_factor(buff, length, tag_manager.get_shard(0));
 }
 
 static bool CONFIG_SET_PROC(perf_tags_table_fill_factor)(Parser& parser, parser_token_t* args, c3_uint_t num) {
-  return Configuration::set_fill_factor(parser, args, num, tag_manager);
+  return tag_manager.configure_shards([&](ObjectStore& store) {
+    return Configuration::set_fill_factor(parser, args, num, store);
+  });
 }
 
 static bool CONFIG_SET_PROC(perf_session_init_table_capacity)(Parser& parser, parser_token_t* args, c3_uint_t num) {
@@ -1588,7 +1798,35 @@ static bool CONFIG_SET_PROC(perf_fpc_init_table_capacity)(Parser& parser, parser
 }
 
 static bool CONFIG_SET_PROC(perf_tags_init_table_capacity)(Parser& parser, parser_token_t* args, c3_uint_t num) {
-  return Configuration::set_init_capacity(parser, args, num, tag_manager);
+  return tag_manager.configure_shards([&](ObjectStore& store) {
+    return Configuration::set_init_capacity(parser, args, num, store);
+  });
+}
+
+static ssize_t CONFIG_GET_PROC(perf_session_table_engine)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_table_engine(buff, length, session_store);
+}
+
+static bool CONFIG_SET_PROC(perf_session_table_engine)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  return Configuration::set_table_engine(parser, args, num, session_store);
+}
+
+static ssize_t CONFIG_GET_PROC(perf_fpc_table_engine)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_table_engine(buff, length, fpc_store);
+}
+
+static bool CONFIG_SET_PROC(perf_fpc_table_engine)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  return Configuration::set_table_engine(parser, args, num, fpc_store);
+}
+
+static ssize_t CONFIG_GET_PROC(perf_tags_table_engine)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_table_engine(buff, length, tag_manager.get_shard(0));
+}
+
+static bool CONFIG_SET_PROC(perf_tags_table_engine)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  return tag_manager.configure_shards([&](ObjectStore& store) {
+    return Configuration::set_table_engine(parser, args, num, store);
+  });
 }
 
 static ssize_t CONFIG_GET_PROC(perf_session_opt_queue_capacity)(Parser& parser, char* buff, size_t length) {
@@ -1676,6 +1914,30 @@ static bool CONFIG_SET_PROC(perf_fpc_store_max_queue_capacity)(Parser& parser, p
   return false;
 }
 
+static ssize_t CONFIG_GET_PROC(perf_tags_bitmap_index)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_boolean(buff, length, tag_manager.is_using_tag_index());
+}
+
+static bool CONFIG_SET_PROC(perf_tags_bitmap_index)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  bool value;
+  if (Configuration::get_boolean(parser, args, num, value)) {
+    return tag_manager.post_index_change_message(value);
+  }
+  return false;
+}
+
+static ssize_t CONFIG_GET_PROC(perf_tags_clean_batch_size)(Parser& parser, char* buff, size_t length) {
+  return Configuration::print_number(buff, length, tag_manager.get_clean_batch_size());
+}
+
+static bool CONFIG_SET_PROC(perf_tags_clean_batch_size)(Parser& parser, parser_token_t* args, c3_uint_t num) {
+  c3_uint_t batch_size;
+  if (Configuration::get_number(parser, args, num, batch_size)) {
+    return tag_manager.post_clean_batch_change_message(batch_size);
+  }
+  return false;
+}
+
 static ssize_t CONFIG_GET_PROC(perf_tag_manager_queue_capacity)(Parser& parser, char* buff, size_t length) {
   return Configuration::print_number(buff, length, tag_manager.get_queue_capacity());
 }
@@ -1995,6 +2257,9 @@ static parser_command_t server_options[] = {
   PARSER_ENTRY(listener_persistent),
   PARSER_ENTRY(session_replicator_persistent),
   PARSER_ENTRY(fpc_replicator_persistent),
+  PARSER_ENTRY(session_replicator_window),
+  PARSER_ENTRY(fpc_replicator_window),
+  PARSER_ENTRY(session_replicator_batch_size),
   PARSER_SET_ENTRY(user_password),
   PARSER_SET_ENTRY(admin_password),
   PARSER_SET_ENTRY(bulk_password),
@@ -2004,6 +2269,10 @@ static parser_command_t server_options[] = {
   PARSER_ENTRY(log_rotation_threshold),
   PARSER_SET_ENTRY(log_rotation_path),
   PARSER_ENTRY(num_connection_threads),
+  PARSER_ENTRY(num_recompression_threads),
+  PARSER_ENTRY(num_listener_threads),
+  PARSER_ENTRY(num_tag_manager_threads),
+  PARSER_ENTRY(io_backend),
   PARSER_ENTRY(session_lock_wait_time),
   PARSER_ENTRY(session_first_write_lifetimes),
   PARSER_ENTRY(session_first_write_nums),
@@ -2018,8 +2287,14 @@ static parser_command_t server_options[] = {
   PARSER_ENTRY(fpc_optimization_interval),
   PARSER_ENTRY(session_optimization_compressors),
   PARSER_ENTRY(fpc_optimization_compressors),
+  PARSER_ENTRY(session_optimization_exploration),
+  PARSER_ENTRY(fpc_optimization_exploration),
   PARSER_ENTRY(session_recompression_threshold),
   PARSER_ENTRY(fpc_recompression_threshold),
+#if C3_ENTERPRISE
+  PARSER_ENTRY(session_compressor_dictionary),
+  PARSER_ENTRY(fpc_compressor_dictionary),
+#endif // C3_ENTERPRISE
   PARSER_ENTRY(response_compression_threshold),
   PARSER_ENTRY(session_tables_per_store),
   PARSER_ENTRY(fpc_tables_per_store),
@@ -2047,6 +2322,8 @@ static parser_command_t server_options[] = {
   PARSER_ENTRY(fpc_db_include),
   PARSER_ENTRY(session_db_file),
   PARSER_ENTRY(fpc_db_file),
+  PARSER_ENTRY(session_db_segments),
+  PARSER_ENTRY(fpc_db_segments),
   PARSER_ENTRY(session_auto_save_interval),
   PARSER_ENTRY(fpc_auto_save_interval),
   PARSER_ENTRY(table_hash_method),
@@ -2075,6 +2352,11 @@ static parser_command_t server_options[] = {
   PARSER_SET_ENTRY(perf_session_init_table_capacity),
   PARSER_SET_ENTRY(perf_fpc_init_table_capacity),
   PARSER_SET_ENTRY(perf_tags_init_table_capacity),
+  PARSER_ENTRY(perf_session_table_engine),
+  PARSER_ENTRY(perf_fpc_table_engine),
+  PARSER_ENTRY(perf_tags_table_engine),
+  PARSER_ENTRY(perf_tags_bitmap_index),
+  PARSER_ENTRY(perf_tags_clean_batch_size),
   PARSER_ENTRY(perf_session_opt_queue_capacity),
   PARSER_ENTRY(perf_fpc_opt_queue_capacity),
   PARSER_ENTRY(perf_session_opt_max_queue_capacity),
@@ -2142,14 +2424,15 @@ Configuration::Configuration() noexcept: c_parser(0) {
   config_log_levels[LL_VERBOSE] = "verbose";
   config_log_levels[LL_DEBUG] = "debug";
 
-  static_assert(EM_NUMBER_OF_ELEMENTS == 5, "Number of eviction modes has changed");
+  static_assert(EM_NUMBER_OF_ELEMENTS == 6, "Number of eviction modes has changed");
   config_eviction_modes[EM_INVALID] = nullptr;
   config_eviction_modes[EM_STRICT_EXPIRATION_LRU] = "strict-expiration-lru";
   config_eviction_modes[EM_EXPIRATION_LRU] = "expiration-lru";
   config_eviction_modes[EM_LRU] = "lru";
   config_eviction_modes[EM_STRICT_LRU] = "strict-lru";
+  config_eviction_modes[EM_TINY_LFU] = "tiny-lfu";
 
-  static_assert(CT_NUMBER_OF_ELEMENTS == 9, "Number of compression types has changed");
+  static_assert(CT_NUMBER_OF_ELEMENTS == 11, "Number of compression types has changed");
   config_compressors[CT_NONE] = nullptr;
   config_compressors[CT_LZF] = "lzf";
   config_compressors[CT_SNAPPY] = "snappy";
@@ -2159,6 +2442,8 @@ Configuration::Configuration() noexcept: c_parser(0) {
   config_compressors[CT_ZSTD] = "zstd";
   config_compressors[CT_ZLIB] = "zlib";
   config_compressors[CT_LZHAM] = "lzham";
+  config_compressors[CT_HESPER] = "hesper";
+  config_compressors[CT_ASCIIENT] = "asciient";
 
   static_assert(HM_NUMBER_OF_ELEMENTS == 6, "Number of hash methods has changed");
   config_hashers[HM_INVALID] = nullptr;
@@ -2168,6 +2453,11 @@ Configuration::Configuration() noexcept: c_parser(0) {
   config_hashers[HM_MURMURHASH2] = "murmurhash2";
   config_hashers[HM_MURMURHASH3] = "murmurhash3";
 
+  static_assert(TE_NUMBER_OF_ELEMENTS == 3, "Number of table engines has changed");
+  config_table_engines[TE_INVALID] = nullptr;
+  config_table_engines[TE_CHAINED] = "chained";
+  config_table_engines[TE_SWISS] = "swiss";
+
   static_assert(SM_NUMBER_OF_ELEMENTS == 3, "Number of synchronization modes has changed");
   config_sync_modes[SM_NONE] = "none";
   config_sync_modes[SM_DATA_ONLY] = "data-only";
@@ -2178,6 +2468,11 @@ Configuration::Configuration() noexcept: c_parser(0) {
   config_user_agents[UA_BOT] = "bot";
   config_user_agents[UA_WARMER] = "warmer";
   config_user_agents[UA_USER] = "user";
+
+  static_assert(IOB_NUMBER_OF_ELEMENTS == 3, "Number of I/O backends has changed");
+  config_io_backends[IOB_INVALID] = nullptr;
+  config_io_backends[IOB_EPOLL] = "epoll";
+  config_io_backends[IOB_IO_URING] = "io-uring";
   /*
    * We initialize option array only once; if we later create a new instance of the server configuration
    * parser using the same set of options, sorting option array won't be necessary.
@@ -87,6 +87,8 @@ public:
     c3_ulong_t min_value, c3_ulong_t max_value) C3_FUNC_COLD;
   static bool get_recompression_threshold(Parser &parser, parser_token_t* args, c3_uint_t num,
     Optimizer &optimizer) C3_FUNC_COLD;
+  static bool get_exploration_rate(Parser &parser, parser_token_t* args, c3_uint_t num,
+    Optimizer &optimizer) C3_FUNC_COLD;
 
   // output/fetch keyword arguments
   static void log_keyword_error(Parser& parser, const char** options, c3_uint_t num_options) C3_FUNC_COLD;
@@ -112,10 +114,17 @@ public:
   static ssize_t get_max_file_size(Parser& parser, char* buff, size_t length, FileBase& file) C3_FUNC_COLD;
 
   // helpers for socket pipelines
+  static bool get_ips(Parser &parser, parser_token_t* args, c3_uint_t num, c3_ipv4_t* ips) C3_FUNC_COLD;
   static bool set_ips(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline) C3_FUNC_COLD;
+  static bool set_ips(Parser &parser, parser_token_t* args, c3_uint_t num, ShardedSocketInputPipeline &pipeline)
+    C3_FUNC_COLD;
   static bool set_port(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline) C3_FUNC_COLD;
+  static bool set_port(Parser &parser, parser_token_t* args, c3_uint_t num, ShardedSocketInputPipeline &pipeline)
+    C3_FUNC_COLD;
   static bool set_persistence(Parser &parser, parser_token_t* args, c3_uint_t num, SocketPipeline &pipeline)
     C3_FUNC_COLD;
+  static bool set_persistence(Parser &parser, parser_token_t* args, c3_uint_t num,
+    ShardedSocketInputPipeline &pipeline) C3_FUNC_COLD;
 
   // helpers for output/fetching fill factors of object stores
   static ssize_t print_fill_factor(char* buff, size_t length, Store& store) C3_FUNC_COLD;
@@ -124,6 +133,8 @@ public:
   // helpers for configuring hash tables in object stores
   static bool set_num_tables(Parser &parser, parser_token_t* args, c3_uint_t num, ObjectStore &store) C3_FUNC_COLD;
   static bool set_init_capacity(Parser &parser, parser_token_t* args, c3_uint_t num, ObjectStore &store) C3_FUNC_COLD;
+  static ssize_t print_table_engine(char* buff, size_t length, ObjectStore& store) C3_FUNC_COLD;
+  static bool set_table_engine(Parser &parser, parser_token_t* args, c3_uint_t num, ObjectStore &store) C3_FUNC_COLD;
 
   /////////////////////////////////////////////////////////////////////////////
   // CONFIGURATION API
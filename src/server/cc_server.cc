@@ -54,6 +54,7 @@ Server::Server() noexcept {
   sr_thread_quit_time = DEFAULT_THREAD_QUIT_TIME;
   sr_state = SS_INVALID;
   sr_cfg_num_threads = DEFAULT_NUM_CONNECTION_THREADS;
+  sr_cfg_num_recompressors = NUM_RECOMPRESSORS_IDLE_CORES;
   sr_cfg_log_path.set(DOMAIN_GLOBAL, DEFAULT_LOG_FILE_PATH);
   sr_disk_space_threshold = DEFAULT_FREE_DISK_SPACE_THRESHOLD;
   sr_thread_active_threshold = DEFAULT_THREAD_ACTIVITY_TIME_THRESHOLD;
@@ -66,8 +67,11 @@ Server::Server() noexcept {
   sr_fpc_db_sync = SM_NONE;
   sr_session_db_include = UA_USER;
   sr_fpc_db_include = UA_BOT;
+  sr_session_db_segments = 1;
+  sr_fpc_db_segments = 1;
   sr_session_auto_save.store(0, std::memory_order_relaxed); // disabled
   sr_fpc_auto_save.store(0, std::memory_order_relaxed); // disabled
+  sr_db_loads_in_progress.store(0, std::memory_order_relaxed);
   sr_binlog_saver_ok = true;
   sr_pid_file_created = false;
   sr_log_level_set = false;
@@ -309,9 +313,11 @@ bool Server::wait_for_quitting_thread(thread_id_t id) {
               // yep, that's the thread we were waiting for
               return true;
             } else {
-              // we do not wait specifically for connection threads to quit; their notifications arrive
-              // while we're waiting for other threads, so we do not report them
-              if (thread_id < TI_FIRST_CONNECTION_THREAD) {
+              // we do not wait specifically for connection and re-compression threads to quit, and tag
+              // manager and listener threads quit all at once; their notifications arrive while we're
+              // waiting for other threads, so we do not report them
+              if (thread_id < TI_FIRST_TAG_MANAGER &&
+                (thread_id < TI_FIRST_LISTENER || thread_id >= TI_FIRST_LISTENER + MAX_NUM_LISTENER_THREADS)) {
                 // some thread we tried to stop earlier was too late to respond, but finally did it...
                 log(LL_NORMAL, "%s (%u) finally responded to shutdown request",
                   Thread::get_name(thread_id), thread_id);
@@ -323,7 +329,7 @@ bool Server::wait_for_quitting_thread(thread_id_t id) {
       }
       case CMT_OBJECT: {
         CommandReader& cr = msg.get_object();
-        if (id == TI_LISTENER) {
+        if (id >= TI_FIRST_LISTENER && id < TI_FIRST_LISTENER + MAX_NUM_LISTENER_THREADS) {
           // the listener could be waiting for response to this command...
           server_listener.post_error_response(cr, "Server is shutting down");
         }
@@ -347,29 +353,68 @@ void Server::wait_for_deallocation(std::unique_lock<std::mutex>& lock) {
 // STORE PERSISTENCE SUPPORT
 ///////////////////////////////////////////////////////////////////////////////
 
-Server::store_db_context_t::store_db_context_t(PayloadObjectStore &store, FileOutputPipeline &pipeline,
-  user_agent_t user_agent): sdc_store(store), sdc_pipeline(pipeline), sdc_time(Timer::current_timestamp()),
-  sdc_user_agent(user_agent) {
-}
-
 bool Server::save_object(void* context, HashObject* ho) {
   auto db_context = (Server::store_db_context_t*) context;
   c3_assert(db_context && db_context->sdc_user_agent < UA_NUMBER_OF_ELEMENTS && ho && ho->flags_are_set(HOF_PAYLOAD));
   auto pho = (PayloadHashObject*) ho;
   if (pho->flags_are_clear(HOF_BEING_DELETED) && pho->get_user_agent() >= db_context->sdc_user_agent) {
-    LockableObjectGuard lock(pho);
-    if (lock.is_locked()) {
-      if (pho->flags_are_clear(HOF_BEING_DELETED) && pho->get_user_agent() >= db_context->sdc_user_agent) {
-        FileCommandWriter* fcw = db_context->sdc_store.create_file_command_writer(pho, db_context->sdc_time);
-        if (fcw != nullptr) {
-          db_context->sdc_pipeline.send_object(fcw);
+    FileCommandWriter* fcw = nullptr;
+    {
+      LockableObjectGuard lock(pho);
+      if (lock.is_locked()) {
+        if (pho->flags_are_clear(HOF_BEING_DELETED) && pho->get_user_agent() >= db_context->sdc_user_agent) {
+          fcw = db_context->sdc_store->create_file_command_writer(pho, db_context->sdc_time);
         }
       }
     }
+    /*
+     * The writer holds its own copy of the payload, so the object lock is released before the (synchronous)
+     * disk write: otherwise, a lengthy write would stall everyone waiting for this object.
+     */
+    if (fcw != nullptr) {
+      db_context->sdc_pipeline->save_object(fcw);
+      db_context->sdc_num_saved++;
+    }
   }
   return true;
 }
 
+bool Server::save_segment(void* context, FileOutputPipeline& pipeline) {
+  auto db_context = (Server::store_db_context_t*) context;
+  c3_assert(db_context && db_context->sdc_store && db_context->sdc_pipeline == &pipeline);
+  if (pipeline.is_service_active()) {
+    db_context->sdc_saved = db_context->sdc_store->enumerate_segment(context, save_object,
+      db_context->sdc_segment, db_context->sdc_num_segments);
+  } else {
+    server.log(LL_ERROR, "Cannot save segment %u of %s: database file is not open",
+      db_context->sdc_segment, db_context->sdc_store->get_name());
+  }
+  return db_context->sdc_saved;
+}
+
+bool Server::load_segment(void* context, FileOutputPipeline& pipeline) {
+  auto load_context = (Server::db_load_context_t*) context;
+  c3_assert(load_context && load_context->dlc_segment < MAX_NUM_STORE_DB_SEGMENTS);
+  bool result = segment_loaders[load_context->dlc_segment].load_file(load_context->dlc_path);
+  global_memory.free(load_context, sizeof(db_load_context_t));
+  server.sr_db_loads_in_progress.fetch_sub(1, std::memory_order_acq_rel);
+  return result;
+}
+
+FileOutputNotifyingPipeline& Server::get_db_saver(c3_uint_t segment) {
+  c3_assert(Thread::get_id() == TI_MAIN && segment < MAX_NUM_STORE_DB_SEGMENTS);
+  if (segment == 0) {
+    return binlog_saver;
+  }
+  // threads saving extra segments are only started when they are needed for the first time
+  c3_uint_t id = TI_FIRST_SEGMENT_SAVER + segment - 1;
+  SegmentSaver& saver = segment_savers[segment - 1];
+  if (Thread::get_state(id) == TS_UNUSED) {
+    Thread::start(id, FileOutputPipeline::thread_proc, ThreadArgument((FileOutputPipeline*) &saver));
+  }
+  return saver;
+}
+
 void Server::set_db_path(char* path, const char* name) {
   if (std::strchr(name, '/') != nullptr) {
     std::strcpy(path, name);
@@ -378,83 +423,331 @@ void Server::set_db_path(char* path, const char* name) {
   }
 }
 
+void Server::get_db_segment_path(char* buffer, const char* path, c3_uint_t segment) {
+  if (segment == 0) {
+    std::snprintf(buffer, MAX_FILE_PATH_LENGTH, "%s", path);
+  } else {
+    std::snprintf(buffer, MAX_FILE_PATH_LENGTH, "%s.%u", path, segment);
+  }
+}
+
+c3_uint_t Server::read_db_manifest(const char* path, c3_uint_t& session_records, c3_uint_t& fpc_records) {
+  session_records = 0;
+  fpc_records = 0;
+  char manifest_path[MAX_FILE_PATH_LENGTH];
+  std::snprintf(manifest_path, sizeof manifest_path, "%s%s", path, STORE_DB_MANIFEST_SUFFIX);
+  if (!c3_file_access(manifest_path, AM_EXISTS)) {
+    return 0; // a single-file database
+  }
+  size_t size;
+  auto manifest = (char*) c3_load_file(manifest_path, size);
+  if (manifest == nullptr) {
+    log(LL_ERROR, "Could not read database manifest '%s' (%s)", manifest_path, c3_get_error_message());
+    return 0;
+  }
+  /*
+   * The manifest lists names of all segment files, one per line, after the signature line; segments
+   * always reside in the same directory as the manifest, and the first segment is the database file.
+   * Signature may be followed by numbers of session and FPC records saved to all segments.
+   */
+  const char* base_name = std::strrchr(path, '/');
+  base_name = base_name != nullptr? base_name + 1: path;
+  c3_uint_t num_segments = 0;
+  bool valid = false;
+  char* line = manifest;
+  while (*line != '\0') {
+    char* eol = std::strchr(line, '\n');
+    if (eol != nullptr) {
+      *eol = '\0';
+    }
+    if (!valid) {
+      size_t length = std::strlen(STORE_DB_MANIFEST_SIGNATURE);
+      if (std::strncmp(line, STORE_DB_MANIFEST_SIGNATURE, length) != 0 ||
+        (line[length] != '\0' && line[length] != ' ')) {
+        break;
+      }
+      if (std::sscanf(line + length, "%u %u", &session_records, &fpc_records) != 2) {
+        session_records = 0;
+        fpc_records = 0;
+      }
+      valid = true;
+    } else if (line[0] != '\0') {
+      char segment_name[MAX_FILE_PATH_LENGTH];
+      get_db_segment_path(segment_name, base_name, num_segments);
+      if (num_segments == MAX_NUM_STORE_DB_SEGMENTS || std::strcmp(line, segment_name) != 0) {
+        valid = false;
+        break;
+      }
+      num_segments++;
+    }
+    if (eol == nullptr) {
+      break;
+    }
+    line = eol + 1;
+  }
+  global_memory.free(manifest, size + 1);
+  if (!valid || num_segments == 0) {
+    log(LL_ERROR, "Database manifest '%s' is not valid", manifest_path);
+    return 0;
+  }
+  return num_segments;
+}
+
+bool Server::load_compressor_dictionary(Optimizer& optimizer, PathString& dictionary, const char* path) {
+  c3_dictionary_t id = CDICT_NONE;
+  if (path[0] != '\0') {
+    c3_long_t file_size = c3_get_file_size(path);
+    if (file_size < 0) {
+      log(LL_ERROR, "Could not access compression dictionary '%s' (%s)", path, c3_get_error_message());
+      return false;
+    }
+    if (file_size < CompressorLibrary::MIN_DICTIONARY_SIZE || file_size > CompressorLibrary::MAX_DICTIONARY_SIZE) {
+      log(LL_ERROR, "Compression dictionary '%s' must be %u..%u bytes long (got %lld)", path,
+        CompressorLibrary::MIN_DICTIONARY_SIZE, CompressorLibrary::MAX_DICTIONARY_SIZE, file_size);
+      return false;
+    }
+    size_t size;
+    auto data = (c3_byte_t*) c3_load_file(path, size);
+    if (data == nullptr) {
+      log(LL_ERROR, "Could not read compression dictionary '%s' (%s)", path, c3_get_error_message());
+      return false;
+    }
+    /*
+     * Registered dictionaries are never removed: objects compressed with a dictionary that is no longer
+     * in use remain readable until they are re-written, re-compressed, or expire.
+     */
+    id = CompressorLibrary::add_dictionary(data, (c3_uint_t) size);
+    global_memory.free(data, size + 1);
+    if (id == CDICT_NONE) {
+      log(LL_ERROR, "Could not register compression dictionary '%s' (limit of %u dictionaries reached)",
+        path, CompressorLibrary::MAX_NUM_DICTIONARIES);
+      return false;
+    }
+  }
+  dictionary.set(path);
+  return optimizer.post_config_dictionary_message(id);
+}
+
+bool Server::set_session_dictionary_path(const char* path) {
+  return load_compressor_dictionary(session_optimizer, sr_session_dictionary, path);
+}
+
+bool Server::set_fpc_dictionary_path(const char* path) {
+  return load_compressor_dictionary(fpc_optimizer, sr_fpc_dictionary, path);
+}
+
+bool Server::write_db_manifest(const char* path, const PayloadObjectStore& store, c3_uint_t num_segments,
+  c3_uint_t num_records, bool overwrite) {
+  c3_assert(num_segments && num_segments <= MAX_NUM_STORE_DB_SEGMENTS);
+  c3_uint_t session_records = 0;
+  c3_uint_t fpc_records = 0;
+  if (!overwrite) {
+    // another store might have been saved to more segments of the same database
+    c3_uint_t num_saved_segments = read_db_manifest(path, session_records, fpc_records);
+    if (num_saved_segments > num_segments) {
+      num_segments = num_saved_segments;
+    }
+  }
+  /*
+   * Even single-file databases get manifests, since record counts let loader pre-size hash tables of
+   * the stores; databases without manifests are still loaded, just without pre-sizing.
+   */
+  if (store.get_domain() == DOMAIN_SESSION) {
+    session_records = num_records;
+  } else {
+    fpc_records = num_records;
+  }
+  const char* base_name = std::strrchr(path, '/');
+  base_name = base_name != nullptr? base_name + 1: path;
+  char manifest[MAX_NUM_STORE_DB_SEGMENTS * (MAX_FILE_PATH_LENGTH + 1) + 64];
+  int length = std::snprintf(manifest, sizeof manifest, "%s %u %u\n",
+    STORE_DB_MANIFEST_SIGNATURE, session_records, fpc_records);
+  for (c3_uint_t i = 0; i < num_segments; i++) {
+    char segment_name[MAX_FILE_PATH_LENGTH];
+    get_db_segment_path(segment_name, base_name, i);
+    length += std::snprintf(manifest + length, sizeof manifest - length, "%s\n", segment_name);
+  }
+  char manifest_path[MAX_FILE_PATH_LENGTH];
+  std::snprintf(manifest_path, sizeof manifest_path, "%s%s", path, STORE_DB_MANIFEST_SUFFIX);
+  if (!c3_save_file(manifest_path, manifest, (size_t) length)) {
+    log(LL_ERROR, "Could not write database manifest '%s' (%s)", manifest_path, c3_get_error_message());
+    return false;
+  }
+  return true;
+}
+
+bool Server::delete_db_files(const char* path) {
+  char file_path[MAX_FILE_PATH_LENGTH];
+  // the manifest goes first, so that remaining segments would never be mistaken for a complete database
+  std::snprintf(file_path, sizeof file_path, "%s%s", path, STORE_DB_MANIFEST_SUFFIX);
+  for (c3_uint_t i = 0; i <= MAX_NUM_STORE_DB_SEGMENTS; i++) {
+    if (i > 0) {
+      get_db_segment_path(file_path, path, i - 1);
+    }
+    if (c3_file_access(file_path, AM_EXISTS) && !c3_delete_file(file_path)) {
+      log(LL_ERROR, "Could not overwrite database file: '%s' (%s)", file_path, c3_get_error_message());
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Server::load_db_files(const char* path) {
+  c3_uint_t session_records, fpc_records;
+  c3_uint_t num_segments = read_db_manifest(path, session_records, fpc_records);
+  if (num_segments == 0) {
+    // a binlog, or a database saved by older server version: replay it using binlog loader
+    return binlog_loader.send_load_file_command(path);
+  }
+  // make sure tables will not have to be re-built (possibly many times) while records are being loaded
+  session_store.reserve_capacity(session_records);
+  fpc_store.reserve_capacity(fpc_records);
+  /*
+   * Each segment is loaded by the thread that saves it, so that segments are read in parallel; loaded
+   * commands are then processed by all connection threads.
+   */
+  for (c3_uint_t i = 0; i < num_segments; i++) {
+    auto context = (db_load_context_t*) global_memory.alloc(sizeof(db_load_context_t));
+    get_db_segment_path(context->dlc_path, path, i);
+    context->dlc_segment = i;
+    if (c3_file_access(context->dlc_path, AM_READABLE)) {
+      sr_db_loads_in_progress.fetch_add(1, std::memory_order_acq_rel);
+      if (!get_db_saver(i).send_run_job_command(load_segment, context)) {
+        sr_db_loads_in_progress.fetch_sub(1, std::memory_order_acq_rel);
+        global_memory.free(context, sizeof(db_load_context_t));
+        return false;
+      }
+    } else {
+      log(LL_WARNING, "Cannot load database segment '%s': it does not exist, or is not readable",
+        context->dlc_path);
+      global_memory.free(context, sizeof(db_load_context_t));
+    }
+  }
+  return true;
+}
+
 void Server::load_store(const char* name) {
   char path[MAX_FILE_PATH_LENGTH];
   set_db_path(path, name);
   if (c3_file_access(path, AM_READABLE)) {
-    binlog_loader.send_load_file_command(path);
+    load_db_files(path);
   } else {
     log(LL_WARNING, "Cannot load database file '%s': it does not exist, or is not readable", path);
   }
 }
 
-bool Server::save_store(PayloadObjectStore &store, const char* name, sync_mode_t sync, user_agent_t ua,
-  bool overwrite) {
-  c3_assert(name && sync < SM_NUMBER_OF_ELEMENTS && ua < UA_NUMBER_OF_ELEMENTS);
-  bool result = false;
-  if (sr_binlog_saver_ok) {
-    char path[MAX_FILE_PATH_LENGTH];
-    set_db_path(path, name);
-    // if database file already exists and we're told to overwrite it, remove it
-    if (overwrite && c3_file_access(path, AM_EXISTS)) {
-      if (!c3_delete_file(path)) {
-        log(LL_ERROR, "Could not overwrite database file: '%s' (%s)",
-          path, c3_get_error_message());
-        return false;
-      }
-    }
+bool Server::save_store(PayloadObjectStore &store, const char* name, c3_uint_t num_segments, sync_mode_t sync,
+  user_agent_t ua, bool overwrite) {
+  c3_assert(name && num_segments && num_segments <= MAX_NUM_STORE_DB_SEGMENTS &&
+    sync < SM_NUMBER_OF_ELEMENTS && ua < UA_NUMBER_OF_ELEMENTS);
+  if (!sr_binlog_saver_ok) {
+    log(LL_ERROR, "Cannot store `%s`: saving service is in error state after previous operation", name);
+    return false;
+  }
+  // saving a partially loaded store would overwrite complete database with incomplete one
+  if (sr_db_loads_in_progress.load(std::memory_order_acquire) != 0) {
+    log(LL_ERROR, "Cannot store `%s`: cache databases are still being loaded", name);
+    return false;
+  }
+  char path[MAX_FILE_PATH_LENGTH];
+  set_db_path(path, name);
+  // if database files already exist and we're told to overwrite them, remove them
+  if (overwrite && !delete_db_files(path)) {
+    return false;
+  }
+  // each segment is a group of tables, so there cannot be more segments than there are tables
+  if (num_segments > store.get_num_tables()) {
+    num_segments = store.get_num_tables();
+  }
+  /*
+   * Each segment is written to its own file by its own saver thread, which enumerates its share of
+   * the store's tables and writes objects directly, so the main thread only has to wait for them.
+   */
+  bool result = true;
+  c3_uint_t num_opened = 0;
+  c3_timestamp_t time = Timer::current_timestamp();
+  for (c3_uint_t i = 0; i < num_segments; i++) {
+    FileOutputNotifyingPipeline& saver = get_db_saver(i);
+    char segment_path[MAX_FILE_PATH_LENGTH];
+    get_db_segment_path(segment_path, path, i);
     /*
      * sync mode should be sent before opening binlog; otherwise, if the command is sent when binlog
      * is already open *and* sent mode does not match current, binlog will have to be re-opened; will
      * still work, but inefficiently
      */
-    if (binlog_saver.send_set_sync_mode_command(sync)) {
-      if (binlog_saver.send_open_binlog_command(path)) {
-        /*
-         * if we opened binlog, we will have to also close it *and* wait for closing notification (that
-         * is, eat it up), otherwise binlog saver becomes unusable
-         */
-        store_db_context_t context(store, binlog_saver, ua);
-        if (store.enumerate_all(&context, save_object)) {
-          result = true;
-        } else {
-          log(LL_ERROR, "While storing `%s` not all records were saved", name);
-        }
-        if (binlog_saver.send_close_binlog_command()) {
-          c3_timestamp_t started = Timer::current_timestamp();
-          bool warned = false;
-          while (!binlog_saver.wait_for_notification(sr_store_db_duration)) {
-            if (Timer::current_timestamp() - started >= sr_store_db_max_duration) {
-              log(LL_ERROR, "Could not store `%s`: operation took more than %u seconds",
-                name, sr_store_db_max_duration);
-              result = sr_binlog_saver_ok = false;
-              break;
-            }
-            if (!warned) {
-              log(LL_WARNING, "Storing '%s' took more than %u seconds", name, sr_store_db_duration);
-              warned = true;
-            }
-          }
-          log(LL_NORMAL, "Finished saving %s to '%s'", store.get_name(), name);
-        } else {
-          result = sr_binlog_saver_ok = false;
-          log(LL_ERROR, "Storing `%s` failed: could not send 'close binlog' command", name);
-        }
-      } else {
-        log(LL_ERROR, "Cannot store `%s`: could not send 'open binlog' command", name);
-      }
-    } else {
+    if (!saver.send_set_sync_mode_command(sync)) {
       log(LL_ERROR, "Cannot store `%s`: could not send 'sync mode change' command", name);
+      result = false;
+      break;
+    }
+    if (!saver.send_open_binlog_command(segment_path)) {
+      log(LL_ERROR, "Cannot store `%s`: could not send 'open binlog' command", name);
+      result = false;
+      break;
+    }
+    /*
+     * if we opened binlog, we will have to also close it *and* wait for closing notification (that
+     * is, eat it up), otherwise the saver becomes unusable
+     */
+    num_opened++;
+    store_db_context_t& context = sr_db_contexts[i];
+    context.sdc_store = &store;
+    context.sdc_pipeline = &saver;
+    context.sdc_time = time;
+    context.sdc_user_agent = ua;
+    context.sdc_segment = i;
+    context.sdc_num_segments = num_segments;
+    context.sdc_num_saved = 0;
+    context.sdc_saved = false;
+    if (!saver.send_run_job_command(save_segment, &context)) {
+      log(LL_ERROR, "Cannot store `%s`: could not send 'save objects' command", name);
+      result = false;
+      break;
+    }
+  }
+  c3_timestamp_t started = Timer::current_timestamp();
+  bool warned = false;
+  for (c3_uint_t i = 0; i < num_opened; i++) {
+    FileOutputNotifyingPipeline& saver = get_db_saver(i);
+    if (!saver.send_close_binlog_command()) {
+      log(LL_ERROR, "Storing `%s` failed: could not send 'close binlog' command", name);
+      return sr_binlog_saver_ok = false;
     }
+  }
+  c3_uint_t num_records = 0;
+  for (c3_uint_t i = 0; i < num_opened; i++) {
+    FileOutputNotifyingPipeline& saver = get_db_saver(i);
+    while (!saver.wait_for_notification(sr_store_db_duration)) {
+      if (Timer::current_timestamp() - started >= sr_store_db_max_duration) {
+        log(LL_ERROR, "Could not store `%s`: operation took more than %u seconds",
+          name, sr_store_db_max_duration);
+        return sr_binlog_saver_ok = false;
+      }
+      if (!warned) {
+        log(LL_WARNING, "Storing '%s' took more than %u seconds", name, sr_store_db_duration);
+        warned = true;
+      }
+    }
+    if (!sr_db_contexts[i].sdc_saved) {
+      result = false;
+    }
+    num_records += sr_db_contexts[i].sdc_num_saved;
+  }
+  if (result) {
+    result = write_db_manifest(path, store, num_segments, num_records, overwrite);
   } else {
-    log(LL_ERROR, "Cannot store `%s`: saving service is in error state after previous operation", name);
+    log(LL_ERROR, "While storing `%s` not all records were saved", name);
+  }
+  if (num_opened > 0) {
+    log(LL_NORMAL, "Finished saving %s to '%s' (%u record%s, %u file%s)", store.get_name(), name,
+      num_records, plural(num_records), num_opened, plural(num_opened));
   }
   return result;
 }
 
 bool Server::save_session_store() {
   if (is_session_db_file_set()) {
-    return save_store(session_store, get_session_db_file_name(),
+    return save_store(session_store, get_session_db_file_name(), get_session_db_segments(),
                       get_session_db_sync_mode(), get_session_db_included_agents(), true);
   }
   return false;
@@ -462,8 +755,8 @@ bool Server::save_session_store() {
 
 bool Server::save_fpc_store() {
   if (is_fpc_db_file_set()) {
-    return save_store(fpc_store, get_fpc_db_file_name(), get_fpc_db_sync_mode(),
-                      get_fpc_db_included_agents(),
+    return save_store(fpc_store, get_fpc_db_file_name(), get_fpc_db_segments(),
+                      get_fpc_db_sync_mode(), get_fpc_db_included_agents(),
       // only overwrite if different paths were given for session and FPC databases
                       std::strcmp(get_session_db_file_name(), get_fpc_db_file_name()) != 0);
   }
@@ -584,21 +877,54 @@ void Server::execute_check_command(const CommandReader& cr) {
 void Server::add_memory_info(PayloadListChunkBuilder& list, const char* name, Memory& memory) {
   list.addf("%s memory: %llu / %llu bytes (used / quota)",
     name, memory.get_used_size(), memory.get_quota());
+  add_slab_info(list, name, memory);
+}
+
+void Server::add_slab_info(PayloadListChunkBuilder& list, const char* name, Memory& memory) {
+  c3_ulong_t reserved_size = memory.get_slab_reserved_size();
+  c3_ulong_t allocated_size = memory.get_slab_allocated_size();
+  c3_uint_t fragmentation = reserved_size != 0?
+    (c3_uint_t)(((reserved_size - allocated_size) * 100) / reserved_size): 0;
+  list.addf("%s slabs: %llu / %llu bytes (allocated / reserved), %u%% free",
+    name, allocated_size, reserved_size, fragmentation);
 }
 
 void Server::add_connections_info(PayloadListChunkBuilder &list, const char* name, const SocketPipeline &pipeline) {
-  list.addf("Active %s connections: %u", name, pipeline.get_num_connections());
+  add_connections_info(list, name, pipeline.get_num_connections());
 }
 
-void Server::add_store_info(PayloadListChunkBuilder& list, const char* name, ObjectStore& store,
-  c3_uint_t bias) {
-  c3_uint_t num_records = store.get_num_elements() - bias;
-  c3_uint_t num_tables = store.get_num_tables();
-  c3_uint_t num_deleted = store.get_num_deleted_objects();
+void Server::add_connections_info(PayloadListChunkBuilder& list, const char* name, c3_uint_t num) {
+  list.addf("Active %s connections: %u", name, num);
+}
+
+void Server::add_store_info(PayloadListChunkBuilder& list, const char* name, c3_uint_t num_records,
+  c3_uint_t num_tables, c3_uint_t num_deleted) {
   list.addf("%s store: %u record%s in %u table%s (%u record%s marked as 'deleted')", name,
     num_records, plural(num_records), num_tables, plural(num_tables), num_deleted, plural(num_deleted));
 }
 
+void Server::add_store_info(PayloadListChunkBuilder& list, const char* name, ObjectStore& store,
+  c3_uint_t bias) {
+  add_store_info(list, name, store.get_num_elements() - bias, store.get_num_tables(),
+    store.get_num_deleted_objects());
+}
+
+void Server::add_tag_store_info(PayloadListChunkBuilder& list) {
+  // a tag used by objects of several shards is counted once per shard
+  c3_uint_t num_records = 0;
+  c3_uint_t num_tables = 0;
+  c3_uint_t num_deleted = 0;
+  for (c3_uint_t i = 0; i < tag_manager.get_num_shards(); i++) {
+    TagStore& shard = tag_manager.get_shard(i);
+    num_records += shard.get_num_elements() - 1; // exclude "list of untagged objects" record
+    num_tables += shard.get_num_tables();
+    num_deleted += shard.get_num_deleted_objects();
+  }
+  add_store_info(list, "Tag", num_records, num_tables, num_deleted);
+  c3_uint_t num_pending = tag_manager.get_num_pending_objects();
+  list.addf("Tag manager: %u record%s awaiting asynchronous cleanup", num_pending, plural(num_pending));
+}
+
 void Server::add_optimizer_info(PayloadListChunkBuilder& list, const char* name, Optimizer& optimizer) {
   char time[TIMER_FORMAT_STRING_LENGTH];
   c3_timestamp_t timestamp = optimizer.get_last_run_time();
@@ -611,11 +937,19 @@ void Server::add_optimizer_info(PayloadListChunkBuilder& list, const char* name,
   c3_uint_t ncompressions = optimizer.get_last_runs_compressions();
   list.addf("%s optimizer last run: %s, %u check%s, %u re-compression%s", name,
     time, nchecks, plural(nchecks), ncompressions, plural(ncompressions));
+  #if C3_ENTERPRISE
+  c3_uint_t ndictionary = optimizer.get_dictionary_compressions();
+  list.addf("%s optimizer used dictionaries: %u time%s", name, ndictionary, plural(ndictionary));
+  #endif // C3_ENTERPRISE
 }
 
 void Server::add_replicator_info(PayloadListChunkBuilder& list, const char* name,
-  SocketPipeline& pipeline) {
+  SocketOutputPipeline& pipeline) {
   list.addf("%s replicator: %s", name, pipeline.is_service_active()? "ON": "OFF");
+  c3_ulong_t lost = pipeline.get_lost_sequence();
+  if (lost != 0) {
+    list.addf("%s replicator: failed to deliver commands starting from sequence number %llu", name, lost);
+  }
 }
 
 void Server::add_service_info(PayloadListChunkBuilder& list, const char* name, FileBase& service) {
@@ -627,6 +961,16 @@ void Server::add_service_info(PayloadListChunkBuilder& list, const char* name, F
   }
 }
 
+void Server::add_sequence_info(PayloadListChunkBuilder& list, const char* name, FileOutputPipeline& binlog) {
+  list.addf("%s: last sequence number %llu", name, binlog.get_last_sequence());
+}
+
+void Server::add_binlog_writes_info(PayloadListChunkBuilder& list, const char* name, FileOutputPipeline& binlog) {
+  if (binlog.is_service_active()) {
+    list.addf("%s: %s writes", name, binlog.is_using_staged_writes()? "staged 'io_uring'": "regular");
+  }
+}
+
 void Server::execute_info_command(const CommandReader& cr) {
   command_status_t status = CS_FORMAT_ERROR;
   CommandHeaderIterator iterator(cr);
@@ -655,6 +999,7 @@ void Server::execute_info_command(const CommandReader& cr) {
         info_list.addf("Since start: %u error%s, %u warning%s",
           total_errors, plural(total_errors), total_warnings, plural(total_warnings));
         info_list.addf("Global memory: %llu bytes used", global_memory.get_used_size());
+        add_slab_info(info_list, "Global", global_memory);
         if (global_memory.is_quota_set()) {
           info_list.addf("Combined memory quota: %llu bytes", global_memory.get_quota());
         } else {
@@ -662,7 +1007,7 @@ void Server::execute_info_command(const CommandReader& cr) {
         }
         info_list.addf("Current load: %u%% (active / total worker threads)", get_current_server_load());
         add_service_info(info_list, "Logger", server_logger);
-        add_connections_info(info_list, "inbound", server_listener);
+        add_connections_info(info_list, "inbound", server_listener.get_num_connections());
         if (binlog_loader.is_service_active()) {
           info_list.addf("Binlog loader: %llu / %llu bytes (processed / total)",
             binlog_loader.get_current_size(), binlog_loader.get_max_size());
@@ -679,17 +1024,21 @@ void Server::execute_info_command(const CommandReader& cr) {
         add_replicator_info(info_list, "Session", session_replicator);
         add_connections_info(info_list, "session replicator", session_replicator);
         add_service_info(info_list, "Session binlog", session_binlog);
+        add_sequence_info(info_list, "Session binlog", session_binlog);
+        add_binlog_writes_info(info_list, "Session binlog", session_binlog);
       }
 
       // collect FPC domain information
       if ((dm & DM_FPC) != 0) {
         add_memory_info(info_list, "FPC", fpc_memory);
         add_store_info(info_list, "FPC", fpc_store, 0);
-        add_store_info(info_list, "Tag", tag_manager, 1); // exclude "list of untagged objects" record
+        add_tag_store_info(info_list);
         add_optimizer_info(info_list, "FPC", fpc_optimizer);
         add_replicator_info(info_list, "FPC", fpc_replicator);
         add_connections_info(info_list, "FPC replicator", fpc_replicator);
         add_service_info(info_list, "FPC binlog", fpc_binlog);
+        add_sequence_info(info_list, "FPC binlog", fpc_binlog);
+        add_binlog_writes_info(info_list, "FPC binlog", fpc_binlog);
       }
 
       // send response
@@ -819,7 +1168,7 @@ void Server::execute_restore_command(const CommandReader& cr) {
     char path[length];
     name.to_cstring(path, length);
     if (c3_file_access(path, AM_READABLE)) {
-      if (binlog_loader.send_load_file_command(path)) {
+      if (load_db_files(path)) {
         server_listener.post_ok_response(cr);
       } else {
         server_listener.post_error_response(cr, "Error triggering binlog restoration from '%s'", path);
@@ -851,13 +1200,13 @@ void Server::execute_store_command(const CommandReader &cr) {
           auto ua = (user_agent_t) ua_chunk.get_value();
           auto mode = (sync_mode_t) sync_chunk.get_value();
           if ((domains & DM_SESSION) != 0) {
-            if (!save_store(session_store, path, mode, ua, true)) {
+            if (!save_store(session_store, path, get_session_db_segments(), mode, ua, true)) {
               server_listener.post_error_response(cr, "Could not save session database to '%s', see log file", path);
               return;
             }
           }
           if ((domains & DM_FPC) != 0) {
-            if (!save_store(fpc_store, path, mode, ua, (domains & DM_SESSION) == 0)) {
+            if (!save_store(fpc_store, path, get_fpc_db_segments(), mode, ua, (domains & DM_SESSION) == 0)) {
               server_listener.post_error_response(cr, "Could not save FPC database to '%s', see log file", path);
               return;
             }
@@ -871,6 +1220,110 @@ void Server::execute_store_command(const CommandReader &cr) {
   server_listener.post_format_error_response(cr);
 }
 
+bool Server::dump_object(void* context, HashObject* ho) {
+  auto dump_context = (Server::dump_context_t*) context;
+  c3_assert(dump_context && ho && ho->flags_are_set(HOF_PAYLOAD));
+  if (dump_context->dc_num_samples >= dump_context->dc_max_samples || dump_context->dc_failed) {
+    return false; // == stop enumeration
+  }
+  if (++dump_context->dc_skipped < dump_context->dc_step) {
+    return true;
+  }
+  auto pho = (PayloadHashObject*) ho;
+  if (pho->flags_are_clear(HOF_BEING_DELETED)) {
+    Memory& memory = dump_context->dc_memory;
+    c3_byte_t* data = nullptr;
+    c3_uint_t usize = 0;
+    {
+      LockableObjectGuard lock(pho);
+      if (lock.is_locked() && pho->flags_are_clear(HOF_BEING_DELETED)) {
+        usize = pho->get_buffer_usize();
+        if (usize > 0) {
+          c3_uint_t size = pho->get_buffer_size();
+          c3_compressor_t compressor = pho->get_buffer_compressor();
+          c3_byte_t* buffer = pho->get_buffer_bytes(0, size);
+          if (compressor == CT_NONE) {
+            data = (c3_byte_t*) std::memcpy(memory.alloc(usize), buffer, usize);
+          } else {
+            data = global_compressor.unpack(compressor, buffer, size, usize, memory,
+              pho->get_buffer_dictionary());
+          }
+        }
+      }
+    }
+    // file is written after the object had been unlocked
+    if (data != nullptr) {
+      if (c3_write_file(dump_context->dc_fd, &usize, sizeof usize) == sizeof usize &&
+        c3_write_file(dump_context->dc_fd, data, usize) == (ssize_t) usize) {
+        dump_context->dc_num_samples++;
+        dump_context->dc_skipped = 0;
+      } else {
+        dump_context->dc_failed = true;
+      }
+      memory.free(data, usize);
+    }
+  }
+  return !dump_context->dc_failed;
+}
+
+bool Server::dump_store(PayloadObjectStore& store, const char* path, c3_uint_t max_samples) {
+  c3_assert(Thread::get_id() == TI_MAIN && path && max_samples);
+  int fd = c3_open_file(path, FM_CREATE);
+  if (fd < 0) {
+    log(LL_ERROR, "Could not create samples file '%s' (%s)", path, c3_get_error_message());
+    return false;
+  }
+  c3_uint_t num_objects = store.get_num_elements();
+  dump_context_t context = {
+    store.get_memory_object(),
+    fd,
+    num_objects > max_samples? num_objects / max_samples: 1,
+    0,
+    max_samples,
+    0,
+    c3_write_file(fd, DICTIONARY_SAMPLES_SIGNATURE, DICTIONARY_SAMPLES_SIGNATURE_LENGTH) !=
+      DICTIONARY_SAMPLES_SIGNATURE_LENGTH
+  };
+  if (!context.dc_failed) {
+    store.lock_enumerate_all(&context, dump_object);
+  }
+  if (!c3_close_file(fd)) {
+    context.dc_failed = true;
+  }
+  if (context.dc_failed) {
+    log(LL_ERROR, "Could not write samples file '%s' (%s)", path, c3_get_error_message());
+    return false;
+  }
+  log(LL_NORMAL, "%s: saved %u samples to '%s'", store.get_name(), context.dc_num_samples, path);
+  return true;
+}
+
+void Server::execute_dump_command(const CommandReader& cr) {
+  CommandHeaderIterator iterator(cr);
+  NumberChunk domain_chunk = iterator.get_number();
+  if (domain_chunk.is_valid_uint() && (domain_chunk.get_uint() == DM_SESSION || domain_chunk.get_uint() == DM_FPC)) {
+    StringChunk name_chunk = iterator.get_string();
+    if (name_chunk.is_valid() && name_chunk.get_length() > 0) {
+      NumberChunk max_chunk = iterator.get_number();
+      if (max_chunk.is_in_range(1, UINT_MAX_VAL) && !iterator.has_more_chunks() &&
+        !PayloadChunkIterator::has_payload_data(cr)) {
+        c3_uint_t length = name_chunk.get_length() + 1;
+        char path[length];
+        name_chunk.to_cstring(path, length);
+        PayloadObjectStore& store = domain_chunk.get_uint() == DM_SESSION?
+          (PayloadObjectStore&) session_store: (PayloadObjectStore&) fpc_store;
+        if (dump_store(store, path, max_chunk.get_uint())) {
+          server_listener.post_ok_response(cr);
+        } else {
+          server_listener.post_error_response(cr, "Could not save samples to '%s', see log file", path);
+        }
+        return;
+      }
+    }
+  }
+  server_listener.post_format_error_response(cr);
+}
+
 bool Server::option_enumeration_callback(void* context, const char* command) {
   c3_assert(context && command);
   const size_t command_length = std::strlen(command);
@@ -1062,6 +1515,108 @@ void Server::execute_rotate_command(const CommandReader& cr) {
   }
 }
 
+void Server::execute_sequence_command(const CommandReader& cr) {
+  /*
+   * Sequence number marks are only found in binlogs; when a binlog is restored, they make sure that
+   * commands written to our own binlogs will be numbered after the restored ones. The mark does not say
+   * which domain it belongs to, so both binlogs are updated; this is harmless, since numbers only have to
+   * keep growing within each binlog.
+   */
+  CommandHeaderIterator iterator(cr);
+  // protocol numbers are 32-bit, so sequence number is stored as two halves, higher one first
+  NumberChunk high = iterator.get_number();
+  NumberChunk low = iterator.get_number();
+  if (high.is_valid_uint() && low.is_valid_uint() && !iterator.has_more_chunks() &&
+    !PayloadChunkIterator::has_payload_data(cr)) {
+    c3_ulong_t sequence = ((c3_ulong_t) high.get_uint() << 32) | low.get_uint();
+    session_binlog.restore_sequence(sequence);
+    fpc_binlog.restore_sequence(sequence);
+    server_listener.post_ok_response(cr);
+  } else {
+    server_listener.post_format_error_response(cr);
+  }
+}
+
+Server::catch_up_result_t Server::request_catch_up(FileOutputPipeline& binlog, SocketOutputPipeline& replicator,
+  c3_ulong_t after) {
+  if (!replicator.is_service_active()) {
+    return CR_REPLICATOR_INACTIVE;
+  }
+  if (!binlog.is_service_active()) {
+    return CR_BINLOG_INACTIVE;
+  }
+  if (after == ULONG_MAX_VAL) {
+    // re-send everything starting from the first command that replicator failed to deliver
+    c3_ulong_t lost = replicator.get_lost_sequence();
+    if (lost == 0) {
+      return CR_SUCCEEDED;
+    }
+    after = lost - 1;
+  }
+  return binlog.send_catch_up_command(after, &replicator)? CR_SUCCEEDED: CR_FAILED;
+}
+
+void Server::execute_catchup_command(const CommandReader& cr) {
+  command_status_t status = CS_FORMAT_ERROR;
+  catch_up_result_t session_result = CR_NOT_REQUESTED;
+  catch_up_result_t fpc_result = CR_NOT_REQUESTED;
+
+  CommandHeaderIterator iterator(cr);
+  if (iterator.get_next_chunk_type() == CHUNK_NUMBER) {
+    NumberChunk domain = iterator.get_number();
+    // "use sequence number of the first command that replicator failed to deliver"
+    c3_ulong_t after = ULONG_MAX_VAL;
+    bool valid = domain.is_in_range(DM_SESSION, DM_SESSION | DM_FPC);
+    if (valid && iterator.get_next_chunk_type() == CHUNK_NUMBER) {
+      // sequence numbers are 64-bit, so they are passed as two halves, higher one first
+      NumberChunk high = iterator.get_number();
+      NumberChunk low = iterator.get_number();
+      if (high.is_valid_uint() && low.is_valid_uint()) {
+        after = ((c3_ulong_t) high.get_uint() << 32) | low.get_uint();
+      } else {
+        valid = false;
+      }
+    }
+    if (valid && !iterator.has_more_chunks() && !PayloadChunkIterator::has_payload_data(cr)) {
+      c3_uint_t dm = domain.get_uint();
+      status = CS_SUCCESS;
+      if ((dm & DM_SESSION) != 0) {
+        session_result = request_catch_up(session_binlog, session_replicator, after);
+      }
+      if ((dm & DM_FPC) != 0) {
+        fpc_result = request_catch_up(fpc_binlog, fpc_replicator, after);
+      }
+      if (session_result > CR_SUCCEEDED || fpc_result > CR_SUCCEEDED) {
+        status = CS_FAILURE;
+      }
+    }
+  }
+
+  // send back command result
+  switch (status) {
+    case CS_FORMAT_ERROR:
+      server_listener.post_format_error_response(cr);
+      break;
+    case CS_SUCCESS:
+      server_listener.post_ok_response(cr);
+      break;
+    case CS_FAILURE: {
+      static const char* results[] = {
+        "not_requested",
+        "ok",
+        "replicator inactive",
+        "binlog inactive",
+        "failed"
+      };
+      server_listener.post_error_response(cr, "Catch-up error: session=%s, FPC=%s",
+        results[session_result], results[fpc_result]);
+      break;
+    }
+    default:
+      c3_assert_failure();
+  }
+}
+
 bool Server::process_object_command(const CommandReader& cr) {
   switch (cr.get_command_id()) {
     case CMD_PING:
@@ -1087,6 +1642,9 @@ bool Server::process_object_command(const CommandReader& cr) {
     case CMD_STORE:
       execute_store_command(cr);
       break;
+    case CMD_DUMP:
+      execute_dump_command(cr);
+      break;
     case CMD_GET:
       execute_get_command(cr);
       break;
@@ -1099,6 +1657,12 @@ bool Server::process_object_command(const CommandReader& cr) {
     case CMD_ROTATE:
       execute_rotate_command(cr);
       break;
+    case CMD_SEQUENCE:
+      execute_sequence_command(cr);
+      break;
+    case CMD_CATCHUP:
+      execute_catchup_command(cr);
+      break;
     default:
       c3_assert_failure();
   }
@@ -1145,6 +1709,49 @@ bool Server::set_num_connection_threads(c3_uint_t num) {
   }
 }
 
+bool Server::set_num_recompression_threads(c3_uint_t num) {
+  c3_assert(sr_state && num <= MAX_NUM_RECOMPRESSION_THREADS);
+  if (sr_state <= SS_CONFIG) {
+    sr_cfg_num_recompressors = num;
+    return true;
+  } else {
+    return recompressor.set_num_threads(num);
+  }
+}
+
+bool Server::set_num_listener_threads(c3_uint_t num) {
+  c3_assert(sr_state && num > 0 && num <= MAX_NUM_LISTENER_THREADS);
+  if (sr_state <= SS_CONFIG) {
+    server_listener.set_num_shards(num);
+    return true;
+  } else {
+    log(LL_ERROR, "Number of listener threads cannot be changed after server startup");
+    return false;
+  }
+}
+
+bool Server::set_num_tag_manager_threads(c3_uint_t num) {
+  c3_assert(sr_state && num > 0 && num <= MAX_NUM_TAG_MANAGER_THREADS);
+  if (sr_state <= SS_CONFIG) {
+    tag_manager.set_num_shards(num);
+    return true;
+  } else {
+    log(LL_ERROR, "Number of tag manager threads cannot be changed after server startup");
+    return false;
+  }
+}
+
+bool Server::set_io_backend(io_backend_t backend) {
+  c3_assert(sr_state && backend > IOB_INVALID && backend < IOB_NUMBER_OF_ELEMENTS);
+  if (sr_state <= SS_CONFIG) {
+    FileOutputPipeline::set_io_backend(backend);
+    return true;
+  } else {
+    log(LL_ERROR, "I/O backend cannot be changed after server startup");
+    return false;
+  }
+}
+
 bool Server::set_log_file_path(const char* path) {
   c3_assert(sr_state && path);
   if (sr_state <= SS_CONFIG) {
@@ -1267,12 +1874,15 @@ bool Server::configure(int argc, char** argv) {
    */
   Memory::configure(this);
   server_logger.configure(this);
-  session_store.configure(&server_listener, &session_optimizer);
+  session_store.configure(&server_listener, &server_listener, &session_optimizer);
   fpc_store.configure(&server_listener, &fpc_optimizer, &tag_manager);
   tag_manager.configure(&server_listener, &fpc_optimizer, &fpc_store);
-  session_optimizer.configure(this, &session_store);
-  fpc_optimizer.configure(this, &fpc_store, &tag_manager);
+  session_optimizer.configure(this, &session_store, &recompressor);
+  fpc_optimizer.configure(this, &fpc_store, &tag_manager, &recompressor);
   binlog_loader.configure(&server_listener);
+  for (c3_uint_t i = 0; i <= MAX_NUM_SEGMENT_SAVERS; i++) {
+    segment_loaders[i].configure();
+  }
 
   if (!server_listener.initialize() || !session_replicator.initialize() || !fpc_replicator.initialize()) {
     log(LL_ERROR, "Could not initialize socket pipelines");
@@ -1356,6 +1966,11 @@ bool Server::configure(int argc, char** argv) {
   fpc_store.allocate();
   tag_manager.allocate();
 
+  // set up listener shards that are going to be started
+  if (!server_listener.prepare_shards()) {
+    return false;
+  }
+
   // configuration had been completed successfully
   return true;
 }
@@ -1394,23 +2009,38 @@ bool Server::start() {
   Thread::start(TI_BINLOG_SAVER, FileOutputPipeline::thread_proc,
     ThreadArgument((FileOutputPipeline*) &binlog_saver));
 
+  // start re-compression threads (if any) before optimizers that would use them
+  if (sr_cfg_num_recompressors == NUM_RECOMPRESSORS_IDLE_CORES) {
+    c3_uint_t num_cores = Thread::get_num_cpu_cores();
+    c3_uint_t num_idle_cores = num_cores > sr_cfg_num_threads? num_cores - sr_cfg_num_threads: 0;
+    sr_cfg_num_recompressors = num_idle_cores < MAX_NUM_RECOMPRESSION_THREADS?
+      num_idle_cores: MAX_NUM_RECOMPRESSION_THREADS;
+    log(LL_VERBOSE, "Using %u re-compression thread%s (%u CPU cores, %u connection threads)",
+      sr_cfg_num_recompressors, plural(sr_cfg_num_recompressors), num_cores, sr_cfg_num_threads);
+  }
+  set_num_recompression_threads(sr_cfg_num_recompressors);
+
   // start optimization threads
   Thread::start(TI_SESSION_OPTIMIZER, Optimizer::thread_proc,
     ThreadArgument((Optimizer*) &session_optimizer));
   Thread::start(TI_FPC_OPTIMIZER, Optimizer::thread_proc,
     ThreadArgument((Optimizer*) &fpc_optimizer));
 
-  // start tag manager's thread
-  Thread::start(TI_TAG_MANAGER, TagStore::thread_proc,
-    ThreadArgument((TagStore*) &tag_manager));
+  // start tag manager's threads (one per shard)
+  for (c3_uint_t i = 0; i < tag_manager.get_num_shards(); i++) {
+    Thread::start(TI_FIRST_TAG_MANAGER + i, TagStore::thread_proc,
+      ThreadArgument(&tag_manager.get_shard(i)));
+  }
 
   // start connection threads
   c3_assert(sr_cfg_num_threads);
   set_num_connection_threads(sr_cfg_num_threads);
 
-  // start listener for incoming connections
-  Thread::start(TI_LISTENER, SocketPipeline::thread_proc,
-    ThreadArgument((SocketPipeline*) &server_listener));
+  // start listener for incoming connections (one thread per shard)
+  for (c3_uint_t i = 0; i < server_listener.get_num_shards(); i++) {
+    Thread::start(TI_FIRST_LISTENER + i, SocketPipeline::thread_proc,
+      ThreadArgument((SocketPipeline*) &server_listener.get_shard(i)));
+  }
 
   // give threads some time to initialize their states
   Thread::sleep(THREAD_INITIALIZATION_WAIT_TIME);
@@ -1428,6 +2058,22 @@ bool Server::start() {
   #ifdef C3_SAFE
   bool all_threads_started = true;
   for (c3_uint_t i = 1; i < TI_FIRST_CONNECTION_THREAD + sr_cfg_num_threads; i++) {
+    if (i >= TI_FIRST_LISTENER + server_listener.get_num_shards() && i < TI_LOGGER) {
+      // only configured number of listener threads is started
+      continue;
+    }
+    if (i >= TI_FIRST_SEGMENT_SAVER && i < TI_SESSION_REPLICATOR) {
+      // segment savers are only started when multi-file databases are being saved
+      continue;
+    }
+    if (i >= TI_FIRST_TAG_MANAGER + tag_manager.get_num_shards() && i < TI_FIRST_RECOMPRESSOR) {
+      // only configured number of tag manager threads is started
+      continue;
+    }
+    if (i >= TI_FIRST_RECOMPRESSOR + sr_cfg_num_recompressors && i < TI_FIRST_CONNECTION_THREAD) {
+      // only configured number of re-compression threads is started
+      continue;
+    }
     if (!Thread::is_running(i)) {
       log(LL_ERROR, "Thread %s (%u) did not start", Thread::get_name(i), i);
       all_threads_started = false;
@@ -1510,9 +2156,15 @@ void Server::shutdown() {
   log(LL_NORMAL, "Shutting down the server...");
 
   // stop incoming connections listener
-  Thread::request_stop(TI_LISTENER);
+  for (c3_uint_t i = 0; i < server_listener.get_num_shards(); i++) {
+    Thread::request_stop(TI_FIRST_LISTENER + i);
+  }
   server_listener.send_quit_command();
-  wait_for_quitting_thread(TI_LISTENER);
+  for (c3_uint_t j = TI_FIRST_LISTENER; j < TI_LOGGER; j++) {
+    if (Thread::get_state(j) != TS_UNUSED) {
+      wait_for_quitting_thread((thread_id_t) j);
+    }
+  }
 
   // stop binlog loader
   Thread::request_stop(TI_BINLOG_LOADER);
@@ -1552,6 +2204,14 @@ void Server::shutdown() {
   fpc_optimizer.post_quit_message();
   wait_for_quitting_thread(TI_FPC_OPTIMIZER);
 
+  // stop re-compression threads (optimizers do not have jobs in flight once they quit)
+  recompressor.set_num_threads(0);
+  for (c3_uint_t i = TI_FIRST_RECOMPRESSOR; i < TI_FIRST_CONNECTION_THREAD; i++) {
+    if (Thread::get_state(i) != TS_UNUSED) {
+      wait_for_quitting_thread((thread_id_t) i);
+    }
+  }
+
   // optionally save cache databases
   save_session_store();
   save_fpc_store();
@@ -1561,10 +2221,26 @@ void Server::shutdown() {
   binlog_saver.send_quit_command();
   wait_for_quitting_thread(TI_BINLOG_SAVER);
 
+  // stop savers of extra database segments (if any had been started)
+  for (c3_uint_t i = 0; i < MAX_NUM_SEGMENT_SAVERS; i++) {
+    c3_uint_t id = TI_FIRST_SEGMENT_SAVER + i;
+    if (Thread::get_state(id) != TS_UNUSED) {
+      Thread::request_stop(id);
+      segment_savers[i].send_quit_command();
+      wait_for_quitting_thread((thread_id_t) id);
+    }
+  }
+
   // stop tag manager
-  Thread::request_stop(TI_TAG_MANAGER);
+  for (c3_uint_t i = 0; i < tag_manager.get_num_shards(); i++) {
+    Thread::request_stop(TI_FIRST_TAG_MANAGER + i);
+  }
   tag_manager.post_quit_message();
-  wait_for_quitting_thread(TI_TAG_MANAGER);
+  for (c3_uint_t j = TI_FIRST_TAG_MANAGER; j < TI_FIRST_RECOMPRESSOR; j++) {
+    if (Thread::get_state(j) != TS_UNUSED) {
+      wait_for_quitting_thread((thread_id_t) j);
+    }
+  }
 
   // dispose object stores
   session_store.dispose();
@@ -61,6 +61,7 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   static constexpr c3_long_t DEFAULT_THREAD_ACTIVITY_TIME_THRESHOLD = 5000000; // useconds
   static constexpr c3_uint_t DEFAULT_THREAD_QUIT_TIME = 3000; // milliseconds
   static constexpr c3_uint_t DEFAULT_NUM_CONNECTION_THREADS = 2;
+  static constexpr c3_uint_t NUM_RECOMPRESSORS_IDLE_CORES = UINT_MAX_VAL; // use cores not taken by workers
   static constexpr c3_uint_t THREAD_INITIALIZATION_WAIT_TIME = 200; // milliseconds
   static constexpr c3_ulong_t DEFAULT_DEALLOC_CHUNK_SIZE = megabytes2bytes(64);
   static constexpr c3_ulong_t DEFAULT_DEALLOC_MAX_WAIT_TIME = 1500; // milliseconds
@@ -70,6 +71,9 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   static constexpr const char* DEFAULT_LOG_FILE_PATH = "/var/log/cybercache/cybercached.log";
   static constexpr const char* PID_FILE_PATH = "/var/run/cybercache/cybercached.pid";
   static constexpr const char* DEFAULT_STORE_DB_PATH_PREFIX = "/var/lib/cybercache/";
+  static constexpr const char* STORE_DB_MANIFEST_SUFFIX = ".manifest";
+  static constexpr const char* STORE_DB_MANIFEST_SIGNATURE = "C3DBManifest";
+  static constexpr c3_uint_t MAX_NUM_STORE_DB_SEGMENTS = MAX_NUM_SEGMENT_SAVERS + 1;
 
   ServerMessageQueue      sr_queue;                   // configuration and notification messages
   const char*             sr_exe_file_path;           // path to executable file reported by the system
@@ -81,6 +85,7 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   c3_uint_t               sr_thread_quit_time;        // how long to wait for a thread to quit
   server_state_t          sr_state;                   // current server state
   c3_uint_t               sr_cfg_num_threads;         // worker threads requested in configuration
+  c3_uint_t               sr_cfg_num_recompressors;   // re-compression threads requested in configuration
   String                  sr_cfg_log_path;            // log file path requested in configuration
   String                  sr_cfg_user_password;       // "user" password requested in configuration
   String                  sr_cfg_admin_password;      // "admin" password requested in configuration
@@ -96,12 +101,17 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   c3_uint_t               sr_store_db_max_duration;   // how many seconds to wait before aborting save operation
   PathString              sr_session_db_file;         // session database [base] file name
   PathString              sr_fpc_db_file;             // FPC database [base] file name
+  PathString              sr_session_dictionary;      // session compression dictionary file name
+  PathString              sr_fpc_dictionary;          // FPC compression dictionary file name
   sync_mode_t             sr_session_db_sync;         // synchronization mode for writing session db files
   sync_mode_t             sr_fpc_db_sync;             // synchronization mode for writing FPC db files
   user_agent_t            sr_session_db_include;      // persist session records created by this or "higher" users
   user_agent_t            sr_fpc_db_include;          // persist FPC records created by this or "higher" users
+  c3_uint_t               sr_session_db_segments;     // number of files to save session database to
+  c3_uint_t               sr_fpc_db_segments;         // number of files to save FPC database to
   atomic_timestamp_t      sr_session_auto_save;       // session store auto-save interval, seconds
   atomic_timestamp_t      sr_fpc_auto_save;           // FPC store auto-save interval, seconds
+  std::atomic_uint        sr_db_loads_in_progress;    // database segments being loaded by saver threads
   bool                    sr_binlog_saver_ok;         // `false` if an unrecoverable error has ocured
   bool                    sr_pid_file_created;        // whether we have to delete PID file on exit
   bool                    sr_log_level_set;           // `true` if log level had been set using cmd line
@@ -140,18 +150,55 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   void wait_for_deallocation(std::unique_lock<std::mutex>& lock);
 
   // store persistence support
-  /// Structure that holds context of store saving procedure
+  /// Structure that holds context of the procedure saving one segment (group of tables) of a store
   struct store_db_context_t {
-    PayloadObjectStore&  sdc_store;      // store that is being saved
-    FileOutputPipeline&  sdc_pipeline;   // output pipeline that should receive objects being saved
-    const c3_timestamp_t sdc_time;       // when operation started
-    const user_agent_t   sdc_user_agent; // only objects created by this level and above should be saved
-    store_db_context_t(PayloadObjectStore& store, FileOutputPipeline& pipeline, user_agent_t user_agent);
+    PayloadObjectStore* sdc_store;        // store that is being saved
+    FileOutputPipeline* sdc_pipeline;     // output pipeline that writes objects being saved
+    c3_timestamp_t      sdc_time;         // when operation started
+    user_agent_t        sdc_user_agent;   // only objects created by this level and above should be saved
+    c3_uint_t           sdc_segment;      // index of the segment being saved
+    c3_uint_t           sdc_num_segments; // total number of segments the store is being saved to
+    c3_uint_t           sdc_num_saved;    // number of objects written to the segment
+    bool                sdc_saved;        // `true` if all objects of the segment were saved
   };
+  /// Structure that holds context of the procedure writing samples of store records to a file
+  struct dump_context_t {
+    Memory&   dc_memory;      // memory object of the store being sampled
+    int       dc_fd;          // descriptor of the file with samples
+    c3_uint_t dc_step;        // only every `dc_step`-th record is sampled
+    c3_uint_t dc_skipped;     // number of records skipped since last sample
+    c3_uint_t dc_max_samples; // maximum number of samples to write
+    c3_uint_t dc_num_samples; // number of samples written so far
+    bool      dc_failed;      // `true` if a sample could not be written
+  };
+  /// Structure that holds context of the procedure loading one segment of a database (allocated per job)
+  struct db_load_context_t {
+    char      dlc_path[MAX_FILE_PATH_LENGTH]; // path to the segment file
+    c3_uint_t dlc_segment;                    // index of the segment (and of its loader)
+  };
+  /*
+   * Contexts of segments being saved; they are accessed by saver threads, and so they cannot reside on
+   * the stack of the main thread, which may abandon waiting for the savers.
+   */
+  store_db_context_t      sr_db_contexts[MAX_NUM_STORE_DB_SEGMENTS];
+
   static bool save_object(void* context, HashObject* ho);
+  static bool save_segment(void* context, FileOutputPipeline& pipeline);
+  static bool load_segment(void* context, FileOutputPipeline& pipeline);
+  static bool dump_object(void* context, HashObject* ho);
+  bool dump_store(PayloadObjectStore& store, const char* path, c3_uint_t max_samples) C3_FUNC_COLD;
+  static FileOutputNotifyingPipeline& get_db_saver(c3_uint_t segment) C3_FUNC_COLD;
   void set_db_path(char* path, const char* name);
+  static void get_db_segment_path(char* buffer, const char* path, c3_uint_t segment);
+  c3_uint_t read_db_manifest(const char* path, c3_uint_t& session_records, c3_uint_t& fpc_records) C3_FUNC_COLD;
+  bool write_db_manifest(const char* path, const PayloadObjectStore& store, c3_uint_t num_segments,
+    c3_uint_t num_records, bool overwrite) C3_FUNC_COLD;
+  bool delete_db_files(const char* path) C3_FUNC_COLD;
+  bool load_db_files(const char* path) C3_FUNC_COLD;
   void load_store(const char* name);
-  bool save_store(PayloadObjectStore &store, const char* name, sync_mode_t sync, user_agent_t ua, bool overwrite);
+  bool load_compressor_dictionary(Optimizer& optimizer, PathString& dictionary, const char* path) C3_FUNC_COLD;
+  bool save_store(PayloadObjectStore &store, const char* name, c3_uint_t num_segments, sync_mode_t sync,
+    user_agent_t ua, bool overwrite);
   bool save_session_store();
   bool save_fpc_store();
 
@@ -161,13 +208,23 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   void execute_ping_command(const CommandReader& cr);
   void execute_check_command(const CommandReader& cr);
   void add_memory_info(PayloadListChunkBuilder& list, const char* name, Memory& memory) C3_FUNC_COLD;
+  void add_slab_info(PayloadListChunkBuilder& list, const char* name, Memory& memory) C3_FUNC_COLD;
   void add_connections_info(PayloadListChunkBuilder& list, const char* name, const SocketPipeline& pipeline)
     C3_FUNC_COLD;
+  void add_connections_info(PayloadListChunkBuilder& list, const char* name, c3_uint_t num) C3_FUNC_COLD;
+  void add_store_info(PayloadListChunkBuilder& list, const char* name, c3_uint_t num_records,
+    c3_uint_t num_tables, c3_uint_t num_deleted) C3_FUNC_COLD;
   void add_store_info(PayloadListChunkBuilder& list, const char* name, ObjectStore& store, c3_uint_t bias)
     C3_FUNC_COLD;
+  void add_tag_store_info(PayloadListChunkBuilder& list) C3_FUNC_COLD;
   void add_optimizer_info(PayloadListChunkBuilder& list, const char* name, Optimizer& optimizer) C3_FUNC_COLD;
-  void add_replicator_info(PayloadListChunkBuilder& list, const char* name, SocketPipeline& pipeline) C3_FUNC_COLD;
+  void add_replicator_info(PayloadListChunkBuilder& list, const char* name, SocketOutputPipeline& pipeline)
+    C3_FUNC_COLD;
   void add_service_info(PayloadListChunkBuilder& list, const char* name, FileBase& service) C3_FUNC_COLD;
+  void add_sequence_info(PayloadListChunkBuilder& list, const char* name, FileOutputPipeline& binlog)
+    C3_FUNC_COLD;
+  void add_binlog_writes_info(PayloadListChunkBuilder& list, const char* name, FileOutputPipeline& binlog)
+    C3_FUNC_COLD;
   void execute_info_command(const CommandReader& cr);
 
   #if C3_INSTRUMENTED
@@ -178,11 +235,23 @@ class Server: public MemoryInterface, public LogInterface, public ThreadInterfac
   void execute_loadconfig_command(const CommandReader& cr) C3_FUNC_COLD;
   void execute_restore_command(const CommandReader& cr) C3_FUNC_COLD;
   void execute_store_command(const CommandReader& cr) C3_FUNC_COLD;
+  void execute_dump_command(const CommandReader& cr) C3_FUNC_COLD;
   static bool option_enumeration_callback(void* context, const char* command) C3_FUNC_COLD;
   void execute_get_command(const CommandReader& cr) C3_FUNC_COLD;
   void execute_set_command(const CommandReader& cr) C3_FUNC_COLD;
   void execute_log_command(const CommandReader& cr) C3_FUNC_COLD;
   void execute_rotate_command(const CommandReader& cr) C3_FUNC_COLD;
+  void execute_sequence_command(const CommandReader& cr) C3_FUNC_COLD;
+  enum catch_up_result_t: c3_uint_t {
+    CR_NOT_REQUESTED = 0,
+    CR_SUCCEEDED,
+    CR_REPLICATOR_INACTIVE,
+    CR_BINLOG_INACTIVE,
+    CR_FAILED
+  };
+  static catch_up_result_t request_catch_up(FileOutputPipeline& binlog, SocketOutputPipeline& replicator,
+    c3_ulong_t after) C3_FUNC_COLD;
+  void execute_catchup_command(const CommandReader& cr) C3_FUNC_COLD;
   bool process_object_command(const CommandReader& cr) C3_FUNC_COLD;
 
 public:
@@ -199,6 +268,10 @@ public:
   c3_uint_t get_thread_quit_time() const { return sr_thread_quit_time; }
   void set_thread_quit_time(c3_uint_t msecs) { sr_thread_quit_time = msecs; }
   bool set_num_connection_threads(c3_uint_t num) C3_FUNC_COLD;
+  bool set_num_recompression_threads(c3_uint_t num) C3_FUNC_COLD;
+  bool set_num_listener_threads(c3_uint_t num) C3_FUNC_COLD;
+  bool set_num_tag_manager_threads(c3_uint_t num) C3_FUNC_COLD;
+  bool set_io_backend(io_backend_t backend) C3_FUNC_COLD;
   bool set_log_file_path(const char* path) C3_FUNC_COLD;
   bool set_user_password(const char* password) { return set_password(sr_cfg_user_password, password); }
   bool set_admin_password(const char* password) { return set_password(sr_cfg_admin_password, password); }
@@ -239,6 +312,17 @@ public:
   void set_session_db_included_agents(user_agent_t lowest_ua) { sr_session_db_include = lowest_ua; }
   user_agent_t get_fpc_db_included_agents() const { return sr_fpc_db_include; }
   void set_fpc_db_included_agents(user_agent_t lowest_ua) { sr_fpc_db_include = lowest_ua; }
+  static constexpr c3_uint_t get_max_db_segments() { return MAX_NUM_STORE_DB_SEGMENTS; }
+  c3_uint_t get_session_db_segments() const { return sr_session_db_segments; }
+  void set_session_db_segments(c3_uint_t num) { sr_session_db_segments = num; }
+  c3_uint_t get_fpc_db_segments() const { return sr_fpc_db_segments; }
+  void set_fpc_db_segments(c3_uint_t num) { sr_fpc_db_segments = num; }
+
+  // compression dictionaries (only main thread will use these, so no atomics needed)
+  const char* get_session_dictionary_path() const { return sr_session_dictionary.get(); }
+  bool set_session_dictionary_path(const char* path) C3_FUNC_COLD;
+  const char* get_fpc_dictionary_path() const { return sr_fpc_dictionary.get(); }
+  bool set_fpc_dictionary_path(const char* path) C3_FUNC_COLD;
 
   // auto-save interval getters and setters; used by main thread and optimizers
   c3_timestamp_t get_session_autosave_interval() const {
@@ -15,9 +15,12 @@
  */
 #include "cc_subsystems.h"
 #include "cc_server.h"
+#include "pl_net_configuration.h"
 
 namespace CyberCache {
 
+static_assert(MAX_NUM_SEGMENT_SAVERS == 3, "Adjust queue IDs of segment savers and loaders");
+
 Logger            server_logger;
 ServerListener    server_listener;
 SessionStore      session_store;
@@ -28,8 +31,77 @@ PageReplicator    fpc_replicator;
 SessionBinlog     session_binlog;
 PageBinlog        fpc_binlog;
 BinlogLoader      binlog_loader;
+SegmentLoader     segment_loaders[MAX_NUM_SEGMENT_SAVERS + 1] = { {5}, {6}, {7}, {8} };
 BinlogSaver       binlog_saver;
+SegmentSaver      segment_savers[MAX_NUM_SEGMENT_SAVERS] = { {2}, {3}, {4} };
 SessionOptimizer  session_optimizer;
 PageOptimizer     fpc_optimizer;
+Recompressor      recompressor;
+
+bool SegmentLoader::post_processors_quit_command() {
+  return server_listener.post_processors_quit_command();
+}
+
+/*
+ * Records inserted by the loader bypass connection threads, so the loader has to send their copies to
+ * replication services itself (just like commands loaded from files, they never go to binlogs). The copy
+ * must be created before the record is inserted, since insertion takes over reader's payload.
+ */
+static SocketCommandWriter* create_replication_copy(CommandReader& cr, SocketPipeline& replicator,
+  Memory& memory) {
+  if (replicator.is_service_active()) {
+    auto copy = alloc<SocketCommandWriter>(memory);
+    // passing zero `fd` sets "valid, but not active" object state
+    new (copy) SocketCommandWriter(memory, cr, 0);
+    return copy;
+  }
+  return nullptr;
+}
+
+static void complete_replication(CommandReader& cr, SocketCommandWriter* copy, SocketPipeline& replicator,
+  bool inserted) {
+  if (copy != nullptr) {
+    if (inserted) {
+      // same as in connection threads: replicas get bulk password instead of the user one
+      c3_hash_t password;
+      if (cr.get_command_pwd_hash(password) == CPT_USER_PASSWORD) {
+        cr.set_command_pwd_hash(CPT_BULK_PASSWORD, server_net_config.get_bulk_password());
+      }
+      replicator.send_input_object(copy);
+    } else {
+      // the command will be processed (and replicated) by a connection thread
+      ReaderWriter::dispose(copy);
+    }
+  }
+}
+
+bool SegmentLoader::post_command_reader(CommandReader* cr) {
+  c3_assert(cr);
+  bool inserted = false;
+  SocketCommandWriter* copy;
+  switch (cr->get_command_id()) {
+    case CMD_WRITE:
+      copy = create_replication_copy(*cr, session_replicator, session_memory);
+      inserted = session_store.insert_loaded_record(*cr);
+      complete_replication(*cr, copy, session_replicator, inserted);
+      break;
+    case CMD_SAVE:
+      copy = create_replication_copy(*cr, fpc_replicator, fpc_memory);
+      inserted = fpc_store.insert_loaded_record(*cr);
+      complete_replication(*cr, copy, fpc_replicator, inserted);
+      break;
+    default:
+      break;
+  }
+  if (inserted) {
+    ReaderWriter::dispose(cr);
+    return true;
+  }
+  return server_listener.post_command_reader(cr);
+}
+
+bool SegmentLoader::post_deferred_command_reader(CommandReader* cr) {
+  return server_listener.post_deferred_command_reader(cr);
+}
 
 } // CyberCache
@@ -31,15 +31,34 @@
 
 namespace CyberCache {
 
-/// Incoming server traffic listener
-class ServerListener: public SystemLogger, public SocketInputPipeline {
+/// Shard of the incoming server traffic listener
+class ListenerShard: public SystemLogger, public SocketInputPipeline {
   static constexpr c3_uint_t DEFAULT_INPUT_QUEUE_CAPACITY = 64;
+
+public:
+  C3_FUNC_COLD ListenerShard(const char* name, c3_uint_t output_capacity) noexcept:
+    SocketInputPipeline(name, DOMAIN_GLOBAL, HO_LISTENER, DEFAULT_INPUT_QUEUE_CAPACITY, output_capacity, 0) {
+  }
+};
+
+/// Incoming server traffic listener
+class ServerListener: public ShardedSocketInputPipeline {
+  // output queue of the first shard is shared by all shards
   static constexpr c3_uint_t DEFAULT_OUTPUT_QUEUE_CAPACITY = 64;
+  static_assert(MAX_NUM_LISTENER_THREADS == 4, "Number of listener shard names does not match max shards");
+
+  ListenerShard sl_shards[MAX_NUM_LISTENER_THREADS] = { // all shards, including those never started
+    { "Listener", DEFAULT_OUTPUT_QUEUE_CAPACITY },
+    { "Listener 2", 0 },
+    { "Listener 3", 0 },
+    { "Listener 4", 0 }
+  };
 
 public:
-  C3_FUNC_COLD ServerListener() noexcept:
-    SocketInputPipeline("Listener", DOMAIN_GLOBAL, HO_LISTENER,
-      DEFAULT_INPUT_QUEUE_CAPACITY, DEFAULT_OUTPUT_QUEUE_CAPACITY, 0) {
+  C3_FUNC_COLD ServerListener() noexcept {
+    for (c3_uint_t i = 0; i < MAX_NUM_LISTENER_THREADS; i++) {
+      set_shard(i, &sl_shards[i]);
+    }
   }
 };
 
@@ -49,8 +68,23 @@ class SessionStore: public SystemLogger, public SessionObjectStore {};
 /// FPC store
 class PageStore: public SystemLogger, public PageObjectStore {};
 
+/// Shard of the tag manager
+class TagManagerShard: public SystemLogger, public TagStore {};
+
 /// Tag manager
-class TagManager: public SystemLogger, public TagStore {};
+class TagManager: public ShardedTagStore {
+  TagManagerShard tm_shards[MAX_NUM_TAG_MANAGER_THREADS]; // all shards, including those never started
+
+public:
+  C3_FUNC_COLD TagManager() noexcept {
+    for (c3_uint_t i = 0; i < MAX_NUM_TAG_MANAGER_THREADS; i++) {
+      set_shard(i, &tm_shards[i]);
+    }
+  }
+};
+
+/// Pool of re-compression threads shared by session and FPC optimizers
+class Recompressor: public SystemLogger, public RecompressionPool {};
 
 /// Replication service for the session domain
 class SessionReplicator: public SystemLogger, public SocketOutputPipeline {
@@ -95,6 +129,25 @@ public:
     FileInputPipeline("Binlog loader", DOMAIN_GLOBAL, HO_BINLOG, 0) {}
 };
 
+/**
+ * Loader of segments of multi-file cache databases; run by threads of respective segment savers.
+ *
+ * The loader is its own command consumer: `WRITE` and `SAVE` commands of records that are not in the
+ * stores yet are inserted into store tables right on the loading thread; everything else is passed to
+ * the server listener and then processed by connection threads, just like commands loaded from binlogs.
+ */
+class SegmentLoader: public SystemLogger, public FileInputPipeline, public CommandObjectConsumer {
+public:
+  C3_FUNC_COLD SegmentLoader(c3_byte_t id) noexcept:
+    FileInputPipeline("Segment loader", DOMAIN_GLOBAL, HO_BINLOG, id) {}
+
+  void configure() C3_FUNC_COLD { FileInputPipeline::configure(this); }
+
+  bool post_processors_quit_command() override;
+  bool post_command_reader(CommandReader* cr) override;
+  bool post_deferred_command_reader(CommandReader* cr) override;
+};
+
 /// Cache database saver service
 class BinlogSaver: public SystemLogger, public FileOutputNotifyingPipeline {
 public:
@@ -102,6 +155,13 @@ public:
     FileOutputNotifyingPipeline("Binlog saver", DOMAIN_GLOBAL, HO_BINLOG, 1) {}
 };
 
+/// Saver of extra segments of multi-file cache databases
+class SegmentSaver: public SystemLogger, public FileOutputNotifyingPipeline {
+public:
+  C3_FUNC_COLD SegmentSaver(c3_byte_t id) noexcept:
+    FileOutputNotifyingPipeline("Segment saver", DOMAIN_GLOBAL, HO_BINLOG, id) {}
+};
+
 extern Logger            server_logger;
 extern ServerListener    server_listener;
 extern SessionStore      session_store;
@@ -112,9 +172,12 @@ extern PageReplicator    fpc_replicator;
 extern SessionBinlog     session_binlog;
 extern PageBinlog        fpc_binlog;
 extern BinlogLoader      binlog_loader;
+extern SegmentLoader     segment_loaders[MAX_NUM_SEGMENT_SAVERS + 1];
 extern BinlogSaver       binlog_saver;
+extern SegmentSaver      segment_savers[MAX_NUM_SEGMENT_SAVERS];
 extern SessionOptimizer  session_optimizer;
 extern PageOptimizer     fpc_optimizer;
+extern Recompressor      recompressor;
 
 } // CyberCache
 
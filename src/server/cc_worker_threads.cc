@@ -16,6 +16,9 @@
 #include "cc_worker_threads.h"
 #include "cc_server.h"
 #include "pl_net_configuration.h"
+#include "ht_shared_buffers.h"
+
+#include <algorithm>
 
 namespace CyberCache {
 
@@ -27,26 +30,34 @@ password_type_t ConnectionThread::ct_info_password_type = PT_NO_PASSWORD;
 ConnectionThread::ConnectionThread() noexcept {
   define_command(CMD_PING, CF_CONFIG_HANDLER | CF_INFO_PASSWORD);
   define_command(CMD_CHECK, CF_CONFIG_HANDLER | CF_INFO_PASSWORD);
+  define_command(CMD_SEQUENCE, CF_CONFIG_HANDLER | CF_USER_PASSWORD);
   define_command(CMD_INFO, CF_CONFIG_HANDLER | CF_INFO_PASSWORD);
   define_command(CMD_STATS, CF_CONFIG_HANDLER | CF_INFO_PASSWORD);
   define_command(CMD_SHUTDOWN, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_LOADCONFIG, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_RESTORE, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_STORE, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
+  define_command(CMD_DUMP, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_GET, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_SET, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_LOG, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
   define_command(CMD_ROTATE, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
+  define_command(CMD_CATCHUP, CF_CONFIG_HANDLER | CF_ADMIN_PASSWORD);
 
   define_command(CMD_READ, CF_SESSION_HANDLER | CF_USER_PASSWORD);
   define_command(CMD_WRITE, CF_SESSION_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
   define_command(CMD_DESTROY, CF_SESSION_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
   define_command(CMD_GC, CF_SESSION_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
+  define_command(CMD_BATCH, CF_SESSION_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
 
   define_command(CMD_LOAD, CF_FPC_HANDLER | CF_USER_PASSWORD);
   define_command(CMD_TEST, CF_FPC_HANDLER | CF_USER_PASSWORD);
   define_command(CMD_SAVE, CF_FPC_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
   define_command(CMD_REMOVE, CF_FPC_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
+  define_command(CMD_MLOAD, CF_FPC_HANDLER | CF_USER_PASSWORD);
+  define_command(CMD_MTEST, CF_FPC_HANDLER | CF_USER_PASSWORD);
+  define_command(CMD_MSAVE, CF_FPC_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
+  define_command(CMD_MREMOVE, CF_FPC_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
   define_command(CMD_CLEAN, CF_FPC_TAG_HANDLER | CF_USER_PASSWORD | CF_REPLICATE);
   define_command(CMD_GETIDS, CF_FPC_TAG_HANDLER | CF_USER_PASSWORD);
   define_command(CMD_GETTAGS, CF_FPC_TAG_HANDLER | CF_USER_PASSWORD);
@@ -107,7 +118,87 @@ bool ConnectionThread::stop_connection_threads(c3_uint_t num) {
   }
 }
 
-void ConnectionThread::process_command_object(CommandReader* cr) {
+bool ConnectionThread::process_batch_command(CommandReader* cr) {
+  CommandHeaderIterator iterator(*cr);
+  NumberChunk num_chunk = iterator.get_number();
+  payload_info_t pi;
+  if (num_chunk.is_valid_uint() && !iterator.has_more_chunks() && cr->get_payload_info(pi)) {
+    c3_assert(!pi.pi_has_errors);
+    Memory& memory = cr->get_memory_object();
+    c3_byte_t* buffer = pi.pi_compressor == CT_NONE? pi.pi_buffer:
+      global_compressor.unpack(pi.pi_compressor, pi.pi_buffer, pi.pi_size, pi.pi_usize, memory);
+    if (buffer != nullptr) {
+      /*
+       * Commands stored in the batch were already authenticated, replicated, and written to the binlog by
+       * the sender (or are going to be replicated and written to the binlog by us, as part of the batch),
+       * so they are dispatched bypassing step 3 of `process_command_object()`. Since they do not have
+       * "network" flag set, handlers will not send responses to them; the only response is that for the
+       * batch itself.
+       *
+       * An `MSAVE` command is a batch that may only contain `SAVE` commands; it is a separate command
+       * (rather than a `BATCH` with FPC commands) so that it would be replicated and written to the binlog
+       * by FPC services. Its `SAVE`s are not dispatched one by one: they are all decoded first, and then
+       * executed together by the FPC store, which locks each hash table only once for the whole batch.
+       * The `MSAVE` itself requires the same password as `SAVE`, and had already been authenticated.
+       */
+      bool saves_only = cr->get_command_id() == CMD_MSAVE;
+      c3_uint_t num = num_chunk.get_uint();
+      // every command takes at least one byte, so this also limits the size of the array of `SAVE`s
+      c3_uint_t max_saves = saves_only? std::min(num, pi.pi_usize): 0;
+      auto saves = max_saves > 0? (CommandReader**) memory.alloc(max_saves * sizeof(CommandReader*)): nullptr;
+      c3_uint_t offset = 0;
+      c3_uint_t i = 0;
+      while (i < num && offset < pi.pi_usize) {
+        auto bcr = alloc<BufferCommandReader>(memory);
+        auto sob = SharedObjectBuffers::create_object(memory);
+        new (bcr) BufferCommandReader(memory, cr->get_fd(), buffer + offset, pi.pi_usize - offset, sob);
+        c3_ulong_t size;
+        if (bcr->read(size) != IO_RESULT_OK ||
+          (saves_only && bcr->get_command_id() != CMD_SAVE)) {
+          ReaderWriter::dispose(bcr);
+          break;
+        }
+        offset += (c3_uint_t) size;
+        if (saves_only) {
+          c3_assert(i < max_saves);
+          saves[i] = bcr;
+        } else {
+          process_command_object(bcr, true);
+        }
+        i++;
+      }
+      if (buffer != pi.pi_buffer) {
+        memory.free(buffer, pi.pi_usize);
+      }
+      bool complete = i == num && offset == pi.pi_usize;
+      if (saves != nullptr) {
+        if (complete && !fpc_store.process_save_commands(saves, num)) {
+          complete = false;
+        }
+        for (c3_uint_t j = 0; j < i; j++) {
+          ReaderWriter::dispose(saves[j]);
+        }
+        memory.free(saves, max_saves * sizeof(CommandReader*));
+      }
+      if (complete) {
+        if (server_listener.post_ok_response(*cr)) {
+          ReaderWriter::dispose(cr);
+          return true;
+        }
+        return false;
+      }
+      server_logger.log(LL_ERROR, "Batch received from '%s' is corrupt: %u out of %u commands decoded",
+        c3_ip2address(cr->get_ipv4()), i, num);
+    }
+  }
+  if (server_listener.post_format_error_response(*cr)) {
+    ReaderWriter::dispose(cr);
+    return true;
+  }
+  return false;
+}
+
+void ConnectionThread::process_command_object(CommandReader* cr, bool batched) {
 
   // 1) Check that the command is a valid one
   // ----------------------------------------
@@ -181,9 +272,9 @@ void ConnectionThread::process_command_object(CommandReader* cr) {
     // 2e) see whether the command has passed authentication
     if (pwd_check_passed) {
 
-      // 3) Handle replication and binlog
-      // --------------------------------
-      if ((flags & CF_REPLICATE) != 0) {
+      // 3) Handle replication and binlog (batched commands were handled as part of their batch)
+      // ---------------------------------------------------------------------------------------
+      if ((flags & CF_REPLICATE) != 0 && !batched) {
 
         // 3a) optionally replace password
         c3_assert(provided_password_type != CPT_ADMIN_PASSWORD);
@@ -191,26 +282,37 @@ void ConnectionThread::process_command_object(CommandReader* cr) {
           cr->set_command_pwd_hash(CPT_BULK_PASSWORD, bulk_password);
         }
 
-        // 3b) try sending copies to replication and binlog services
+        // 3b) try sending copies to replication and binlog services; commands that go to the binlog get
+        // sequence numbers, so that replicator could later re-send them from there if they get lost
         if ((flags & CF_FPC_HANDLER) != 0) {
+          bool fpc_binlog_active = fpc_binlog.is_service_active() && cr->is_set(IO_FLAG_NETWORK);
+          if (fpc_binlog_active) {
+            cr->set_sequence(fpc_binlog.get_next_sequence());
+          }
           if (fpc_replicator.is_service_active()) {
             auto fpc_replication_copy = alloc<SocketCommandWriter>(fpc_memory);
-            new (fpc_replication_copy) SocketCommandWriter(fpc_memory, *cr);
+            // passing zero `fd` sets "valid, but not active" object state
+            new (fpc_replication_copy) SocketCommandWriter(fpc_memory, *cr, 0);
             fpc_replicator.send_input_object(fpc_replication_copy);
           }
-          if (fpc_binlog.is_service_active() && cr->is_set(IO_FLAG_NETWORK)) {
+          if (fpc_binlog_active) {
             auto fpc_binlog_copy = alloc<FileCommandWriter>(fpc_memory);
             // passing zero `fd` sets "valid, but not active" object state
             new (fpc_binlog_copy) FileCommandWriter(fpc_memory, *cr, 0);
             fpc_binlog.send_object(fpc_binlog_copy);
           }
         } else {
+          bool session_binlog_active = session_binlog.is_service_active() && cr->is_set(IO_FLAG_NETWORK);
+          if (session_binlog_active) {
+            cr->set_sequence(session_binlog.get_next_sequence());
+          }
           if (session_replicator.is_service_active()) {
             auto session_replication_copy = alloc<SocketCommandWriter>(session_memory);
-            new (session_replication_copy) SocketCommandWriter(session_memory, *cr);
+            // passing zero `fd` sets "valid, but not active" object state
+            new (session_replication_copy) SocketCommandWriter(session_memory, *cr, 0);
             session_replicator.send_input_object(session_replication_copy);
           }
-          if (session_binlog.is_service_active() && cr->is_set(IO_FLAG_NETWORK)) {
+          if (session_binlog_active) {
             auto session_binlog_copy = alloc<FileCommandWriter>(session_memory);
             // passing zero `fd` sets "valid, but not active" object state
             new (session_binlog_copy) FileCommandWriter(session_memory, *cr, 0);
@@ -226,10 +328,11 @@ void ConnectionThread::process_command_object(CommandReader* cr) {
           result = server.post_object_message(cr);
           break;
         case CF_SESSION_HANDLER:
-          result = session_store.process_command(cr);
+          // batches are unpacked here, and their commands are then dispatched one by one
+          result = command == CMD_BATCH? process_batch_command(cr): session_store.process_command(cr);
           break;
         case CF_FPC_HANDLER:
-          result = fpc_store.process_command(cr);
+          result = command == CMD_MSAVE? process_batch_command(cr): fpc_store.process_command(cr);
           break;
         case CF_FPC_TAG_HANDLER:
           result = tag_manager.post_command_message(cr);
@@ -266,7 +369,13 @@ void ConnectionThread::thread_proc(c3_uint_t id, ThreadArgument arg) {
   server_logger.log(LL_VERBOSE, "Started connection thread [%u]", id);
   for (;;) {
     Thread::set_state(TS_IDLE);
-    OutputSocketMessage msg = server_listener.get_output_message();
+    /*
+     * If there are READ commands waiting for session locks, we only wait for new commands until the
+     * earliest of them expires; otherwise, timeout is zero, and we wait indefinitely. There is always at
+     * least one thread that sees new waiters: the one that queued it becomes idle right after that.
+     */
+    OutputSocketMessage msg = server_listener.get_output_message(session_store.get_lock_wait_timeout());
+    session_store.process_expired_lock_waiters();
     command_message_type_t type = msg.get_type();
     if (type == CMT_ID_COMMAND) {
       Thread::set_state(TS_QUITTING);
@@ -61,7 +61,8 @@ class ConnectionThread {
   static c3_byte_t get_command_flags(c3_byte_t command) {
     return ct_command_info[command];
   }
-  static void process_command_object(CommandReader* cr);
+  static void process_command_object(CommandReader* cr, bool batched = false);
+  static bool process_batch_command(CommandReader* cr);
 
 public:
   ConnectionThread() noexcept C3_FUNC_COLD;
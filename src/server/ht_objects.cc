@@ -92,8 +92,8 @@ void HashObject::dispose(HashObject* ho) {
 
 constexpr c3_byte_t PayloadHashObject::ZERO_LENGTH_BUFFER[];
 
-void PayloadHashObject::set_buffer(c3_compressor_t compressor, c3_uint_t size, c3_uint_t usize,
-  c3_byte_t* buffer, Memory &memory) {
+void PayloadHashObject::set_buffer(c3_compressor_t compressor, c3_dictionary_t dictionary, c3_uint_t size,
+  c3_uint_t usize, c3_byte_t* buffer, Memory &memory) {
   assert(size <= usize && buffer);
   c3_assert(is_locked() && !has_readers() && flags_are_clear(HOF_BEING_DELETED));
   if (pho_buffer != nullptr) { // replacing an existing buffer?
@@ -110,6 +110,18 @@ void PayloadHashObject::set_buffer(c3_compressor_t compressor, c3_uint_t size, c
   pho_size = size;
   pho_usize = usize;
   pho_opt_comp = compressor;
+  pho_opt_dict = dictionary;
+}
+
+bool PayloadHashObject::add_unpacked_payload(PayloadChunkBuilder& payload, Memory& memory) const {
+  c3_assert(pho_buffer && pho_opt_dict != CDICT_NONE && pho_size > 0 && pho_size < pho_usize);
+  c3_byte_t* data = global_compressor.unpack(pho_opt_comp, pho_buffer, pho_size, pho_usize, memory, pho_opt_dict);
+  if (data != nullptr) {
+    payload.add(data, pho_usize);
+    memory.free(data, pho_usize);
+    return true;
+  }
+  return false;
 }
 
 c3_uint_t PayloadHashObject::dispose_buffer(Memory& memory) {
@@ -141,106 +153,36 @@ std::atomic_uint SessionObject::so_lock_wait_time;
 
 SessionObject::Initializer SessionObject::so_initializer;
 
-session_lock_result_t SessionObject::lock_session(c3_uint_t request_id) {
+session_lock_result_t SessionObject::lock_session(c3_uint_t request_id, c3_uint_t break_holder_id) {
   c3_assert(is_locked());
-  if (request_id != 0) {
-    /*
-     * Storing wait time in a local variable also ensures we wouldn't wait with zero timeout (indefinitely)
-     * if configuration changes between checking and actually using it.
-     */
-    const c3_uint_t lock_wait_time = get_lock_wait_time();
-    if (lock_wait_time != 0) {
+  if (request_id != 0 && get_lock_wait_time() != 0) {
+    c3_uint_t locking_request_id = so_request_id;
+    // does some *other* request hold session lock?
+    if (locking_request_id != 0 && locking_request_id != request_id) {
       /*
-       * We keep track of who was locking the session at the time we started waiting. If the session is locked
-       * by some other request, we will wait for session unlocking while our hash object is *unlocked*, so it is
-       * theoretically possible that the following sequence of actions/events occurs:
-       *
-       * -- we wait on timed event (with hash object unlocked),
-       * -- current session holder unlocks the session, triggers the event, and unlocks hash object,
-       * -- some other thread (with different request ID) acquires hash object lock, and then locks the session,
-       * -- we wake up, lock the hash object, and find out that request ID has changed.
-       *
-       * Similarly, it is theoretically possible that two threads' timeouts expire simultaneously, one of
-       * the threads acquires session lock first, and another finds out that yes, waiting has timed out, but
-       * request ID has changed...
-       *
-       * In such cases, we wouldn't want to break other request's session lock; so we should wait again instead.
+       * If the request that was holding the lock when the caller started waiting had changed, the caller
+       * should wait again: we wouldn't want to break the lock of a request that only just acquired it.
        */
-      c3_uint_t locking_request_id = so_request_id;
-      // does some *other* request hold session lock?
-      if (locking_request_id != 0 && locking_request_id != request_id) {
-        const c3_ulong_t mask = 1ull << Thread::get_id();
-        so_threads |= mask;
-        for(;;) {
-          PERF_INCREMENT_COUNTER(Session_Lock_Waits)
-          unlock();
-          Thread::wait_for_timed_event(lock_wait_time);
-          lock();
-          if (so_request_id != 0 && so_request_id != locking_request_id) {
-            // some other request acquired session lock; so keep waiting...
-            locking_request_id = so_request_id;
-          } else {
-            // either session is unlocked, or we'll break the lock
-            so_threads &= ~mask;
-            /*
-             * Checking request ID is more reliable than checking return value of `wait_for_timed_event()`
-             * because it is (again, theoretically) possible that the timeout expired exactly at the moment when
-             * session lock holder finally released session lock.
-             */
-            bool broke_the_lock = false;
-            if (so_request_id != 0) {
-              PERF_INCREMENT_COUNTER(Session_Broken_Locks)
-              broke_the_lock = true;
-            }
-            /*
-             * While we were waiting for the lock, the record was marked as deleted. It is still safe to
-             * manipulate object fields (because there should still be shared lock on the hash table, so the
-             * record could not have been disposed), but it is no longer safe to try to access its data buffer,
-             * so call site should not try to send back session data.
-             */
-            if (flags_are_set(HOF_BEING_DELETED)) {
-              PERF_INCREMENT_COUNTER(Session_Aborted_Locks)
-              so_request_id = 0; // release the lock in case there was a timeout
-              return SLR_DELETED;
-            }
-            so_request_id = request_id; // acquire the lock
-            if (broke_the_lock) {
-              return SLR_BROKE_LOCK;
-            }
-            // successfully acquired session lock
-            break;
-          }
-        }
+      if (break_holder_id == 0 || locking_request_id != break_holder_id) {
+        return SLR_LOCKED;
       }
+      PERF_INCREMENT_COUNTER(Session_Broken_Locks)
+      so_request_id = request_id;
+      return SLR_BROKE_LOCK;
     }
+    so_request_id = request_id; // acquire the lock
   }
   return SLR_SUCCESS;
 }
 
-void SessionObject::unlock_session(c3_uint_t request_id) {
+bool SessionObject::unlock_session(c3_uint_t request_id) {
   c3_assert(is_locked());
-  if (request_id != 0) {
-    // only unlock sessions that were locked with specified request ID
-    if (request_id == so_request_id) {
-      if (so_threads != 0) {
-        for (c3_uint_t i = 0; i < MAX_NUM_THREADS; i++) {
-          if ((so_threads & (1ull << i)) != 0) {
-            /*
-             * Even though we wake up waiting thread, the hash object is still locked, so woken up thread
-             * won't examine any fields (until we unlock hash object upon return).
-             *
-             * We do not clear the bit that corresponds to the thread (that we just woke up) in the mask of
-             * waiting threads as that's responsibility of the locking code (in `lock_session()` method).
-             */
-            Thread::trigger_timed_event(i);
-            break;
-          }
-        }
-      }
-      so_request_id = 0;
-    }
+  // only unlock sessions that were locked with specified request ID
+  if (request_id != 0 && request_id == so_request_id) {
+    so_request_id = 0;
+    return true;
   }
-  unlock();
+  return false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -312,6 +254,7 @@ PageObject::PageObject(c3_hash_t hash, const char* name, c3_ushort_t nlen):
   // the object is created in FPC store; tags will be added later, in tag manager
   set_count(0);
   po_xtags = nullptr;
+  po_ordinal = INVALID_ORDINAL;
 }
 
 PageObject::~PageObject() {
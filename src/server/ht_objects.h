@@ -157,6 +157,9 @@ public:
  * session data, or an FPC data chunk.
  */
 class PayloadHashObject: public HashObject {
+  static_assert(CT_NUMBER_OF_ELEMENTS < 16 && CompressorLibrary::MAX_NUM_DICTIONARIES < 16,
+    "Compressor type and dictionary ID must fit into four bits each");
+
   constexpr static c3_byte_t ZERO_LENGTH_BUFFER[] = "PHO_ZeroLengthBuffer";
 
   c3_byte_t*          pho_buffer;        // buffer with data associated with the object
@@ -169,7 +172,8 @@ class PayloadHashObject: public HashObject {
   QuickSemaphore      pho_semaphore;     // number of readers (and possibly index of waiting writer's thread)
   c3_ushort_t         pho_count;         // session writes for session object, tag records for `PageObject`
   user_agent_t        pho_opt_useragent; // user agent type
-  c3_compressor_t     pho_opt_comp;      // type of compressor used on `pho_buffer` contents
+  c3_compressor_t     pho_opt_comp: 4;   // type of compressor used on `pho_buffer` contents
+  c3_dictionary_t     pho_opt_dict: 4;   // ID of compression dictionary used on `pho_buffer` contents
 
 protected:
   PayloadHashObject(c3_hash_t hash, c3_byte_t flags, const char* name, c3_ushort_t nlen, c3_uint_t size):
@@ -188,6 +192,7 @@ protected:
     pho_opt_prev = pho_opt_next = nullptr;
     pho_opt_useragent = UA_NUMBER_OF_ELEMENTS;
     pho_opt_comp = CT_NUMBER_OF_ELEMENTS;
+    pho_opt_dict = CDICT_NONE;
   }
 
   // helper methods manipulating counts
@@ -225,13 +230,24 @@ public:
   c3_uint_t get_buffer_size() const { return pho_size; }
   c3_uint_t get_buffer_usize() const { return pho_usize; }
   c3_compressor_t get_buffer_compressor() const { return pho_opt_comp; }
+  c3_dictionary_t get_buffer_dictionary() const { return pho_opt_dict; }
   c3_byte_t* get_buffer_bytes(c3_uint_t offset, c3_uint_t size) const {
     assert(offset + size <= pho_size);
     c3_assert(pho_buffer);
     return pho_buffer + offset;
   }
-  void set_buffer(c3_compressor_t compressor, c3_uint_t size, c3_uint_t usize, c3_byte_t* buffer, Memory &memory);
+  void set_buffer(c3_compressor_t compressor, c3_dictionary_t dictionary, c3_uint_t size, c3_uint_t usize,
+    c3_byte_t* buffer, Memory &memory);
   c3_uint_t dispose_buffer(Memory& memory);
+  /**
+   * Unpacks buffer compressed using a dictionary, and adds its contents to the payload being built (which
+   * may then be re-compressed without the dictionary); must be called while the object is locked.
+   *
+   * @param payload Payload builder of a response or a file command
+   * @param memory Memory object to be used for temporary buffer
+   * @return `true` on success, `false` if the buffer could not be unpacked
+   */
+  bool add_unpacked_payload(PayloadChunkBuilder& payload, Memory& memory) const;
   void try_dispose_buffer(Memory& memory) {
     if (!has_readers()) {
       dispose_buffer(memory);
@@ -262,11 +278,15 @@ public:
 enum session_lock_result_t {
   SLR_SUCCESS,    // session record successfully locked
   SLR_BROKE_LOCK, // session record had been locked, but we broke existing lock for that
-  SLR_DELETED     // while we were waiting for the lock, session record had been marked as deleted
+  SLR_LOCKED      // session record is locked by another request; the caller should queue its command
 };
 
 /**
  * Object that stores session data; supports session locking.
+ *
+ * Session locking does not block any threads: if a session is locked by another request, the caller
+ * is expected to queue its command (see `SessionObjectStore`), which will be re-dispatched once the lock
+ * is released, or re-processed when lock wait time expires.
  */
 class SessionObject: public PayloadHashObject {
   static constexpr c3_uint_t DEFAULT_LOCK_WAIT_TIME = 8000; // 8 seconds
@@ -281,8 +301,8 @@ class SessionObject: public PayloadHashObject {
    * The following fields are only accessed by methods that are executed by threads holding
    * locks on the hash object (hence no `atomic` etc.).
    */
-  c3_ulong_t so_threads;    // mask of threads waiting for session lock
-  c3_uint_t  so_request_id; // ID of the request currently holding session lock
+  c3_uint_t so_num_waiters; // number of queued commands waiting for session lock (may be an overestimate)
+  c3_uint_t so_request_id;  // ID of the request currently holding session lock
 
 public:
   static c3_uint_t calculate_size(c3_uint_t name_length) { return name_length + sizeof(SessionObject); }
@@ -290,7 +310,7 @@ public:
   SessionObject(c3_hash_t hash, const char* name, c3_ushort_t nlen):
     PayloadHashObject(hash, HOF_PAYLOAD, name, nlen, calculate_size(nlen)) {
 
-    so_threads = 0;
+    so_num_waiters = 0;
     so_request_id = 0;
 
     PERF_INCREMENT_DOMAIN_COUNTER(SESSION, Store_Objects_Created)
@@ -308,30 +328,49 @@ public:
   }
 
   /**
-   * Locks the session: any subsequent `lock_session()` calls with different request IDs will be waiting
-   * until the session is unlocked, or until waiting times outs.
+   * Tries to lock the session: any subsequent `lock_session()` calls with different request IDs will
+   * fail with `SLR_LOCKED` until the session is unlocked, or until the lock is broken.
    *
    * If either session lock wait time or request ID is zero, does nothing.
    *
    * Called on an object that is already locked (with hash object lock); upon return, the object remains locked.
    *
    * @param request_id Request ID for which session lock should be obtained.
+   * @param break_holder_id If not zero, and the session is still locked by the request with this ID, then
+   *   the lock will be broken (used when the caller had already waited for the lock long enough).
    * @return Result of the attempt to acquire session lock, an `SLR_xxx` constant.
    */
-  session_lock_result_t lock_session(c3_uint_t request_id);
+  session_lock_result_t lock_session(c3_uint_t request_id, c3_uint_t break_holder_id = 0);
   /**
-   * If session was locked by request with specified ID, unlocks the session and wakes up one of the threads
-   * waiting for session lock.
+   * If session was locked by request with specified ID, unlocks the session.
    *
    * If the session was not locked by specified request or request ID (argument) is zero, then this method does
    * not try to unlock the session.
    *
-   * Called on an object that is locked (with hash object lock); upon return, always releases hash object
-   * lock (whether or not the session was unlocked).
+   * Called on an object that is locked (with hash object lock); upon return, the object remains locked.
    *
    * @param request_id ID of the request.
+   * @return `true` if the session had been unlocked, `false` otherwise.
+   */
+  bool unlock_session(c3_uint_t request_id);
+  /**
+   * Hands session lock over to a queued request; called on a hash object that is locked, while the session
+   * itself is unlocked.
    */
-  void unlock_session(c3_uint_t request_id);
+  void grant_session_lock(c3_uint_t request_id) {
+    c3_assert(is_locked() && so_request_id == 0 && request_id != 0);
+    so_request_id = request_id;
+  }
+  c3_uint_t get_session_lock_holder() const { return so_request_id; }
+
+  c3_uint_t get_num_waiters() const { return so_num_waiters; }
+  void add_waiter() { so_num_waiters++; }
+  void remove_waiter() {
+    if (so_num_waiters > 0) {
+      so_num_waiters--;
+    }
+  }
+  void reset_waiters() { so_num_waiters = 0; }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -340,6 +379,7 @@ public:
 
 // bug in GCC prevents it from treating "friend class TagRef" as proper forward reference
 class TagRef;
+class TagBitmap;
 
 /**
  * Object that represents FPC "tag" with which individual FPC entries can be marked.
@@ -347,6 +387,7 @@ class TagRef;
 class TagObject: public HashObject {
   friend class TagRef;
   TagRef*    to_first;    // first page reference object (in the chain) marked with this tag, or NULL
+  TagBitmap* to_bitmap;   // ordinals of marked page objects, or NULL if tag index is disabled
   c3_uint_t  to_num;      // number of page objects marked with this tag
   const bool to_untagged; // if `true`, the tag is actually a list of untagged `PageObject`s
 
@@ -362,11 +403,14 @@ public:
     PERF_UPDATE_DOMAIN_RANGE(GLOBAL, Store_Objects_Name_Length, (c3_uint_t) nlen)
 
     to_first = nullptr;
+    to_bitmap = nullptr;
     to_num = 0;
   }
 
   bool is_untagged() const { return to_untagged; }
   TagRef* get_first_ref() const { return to_first; }
+  TagBitmap* get_bitmap() const { return to_bitmap; }
+  void set_bitmap(TagBitmap* bitmap) { to_bitmap = bitmap; }
   c3_uint_t get_num_marked_objects() const { return to_num; }
 
   /// Supposed to be used to prevent tag disposal after the last "real" reference had been removed
@@ -415,8 +459,9 @@ public:
 class PageObject: public PayloadHashObject {
   static c3_uint_t po_num_internal_tag_refs;
 
-  TagRef* po_xtags;   // array with tag references in case their number exceeds max for internal tag refs
-  TagRef  po_tags[1]; // array of up to `po_num_internal_tag_refs` "built-in" tag references
+  TagRef*   po_xtags;   // array with tag references in case their number exceeds max for internal tag refs
+  c3_uint_t po_ordinal; // ordinal of the object in tag index, or `INVALID_ORDINAL`
+  TagRef    po_tags[1]; // array of up to `po_num_internal_tag_refs` "built-in" tag references
 
   c3_uint_t xrefs_size(c3_uint_t ntags) const {
     return (ntags - po_num_internal_tag_refs) * sizeof(TagRef);
@@ -425,6 +470,9 @@ class PageObject: public PayloadHashObject {
   void free_tag_xrefs();
 
 public:
+  /// Ordinal of a page object that is not in tag index
+  static constexpr c3_uint_t INVALID_ORDINAL = UINT_MAX_VAL;
+
   static c3_uint_t calculate_size(c3_uint_t name_length) {
     return name_length + po_num_internal_tag_refs * sizeof(TagRef) + C3_OFFSETOF(PageObject, po_tags);
   }
@@ -447,6 +495,8 @@ public:
     po_num_internal_tag_refs = num;
   }
   c3_uint_t get_num_tag_refs() const { return get_count(); }
+  c3_uint_t get_ordinal() const { return po_ordinal; }
+  void set_ordinal(c3_uint_t ordinal) { po_ordinal = ordinal; }
   void set_num_tag_refs(c3_uint_t ntags);
   void dispose_tag_refs();
 
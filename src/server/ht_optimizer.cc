@@ -19,6 +19,102 @@
 
 namespace CyberCache {
 
+///////////////////////////////////////////////////////////////////////////////
+// FrequencySketch
+///////////////////////////////////////////////////////////////////////////////
+
+c3_uint_t Optimizer::FrequencySketch::get_index(c3_hash_t hash, c3_uint_t row, c3_uint_t mask,
+  c3_uint_t& shift) {
+  static const c3_ulong_t seeds[4] = {
+    0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL
+  };
+  c3_assert(row < 4);
+  c3_ulong_t h = (hash + seeds[row]) * seeds[row];
+  h ^= h >> 32;
+  shift = (c3_uint_t)(h & 15) << 2;
+  return (c3_uint_t)(h >> 4) & mask;
+}
+
+void Optimizer::FrequencySketch::age() {
+  // halve all counters at once: shift every word, and clear bits that crossed 4-bit counter boundaries
+  for (c3_uint_t i = 0; i < fs_num_words; i++) {
+    fs_words[i] = (fs_words[i] >> 1) & 0x7777777777777777ULL;
+  }
+  fs_num_increments /= 2;
+}
+
+void Optimizer::FrequencySketch::ensure_capacity(c3_uint_t num_objects) {
+  c3_uint_t num_words = MIN_NUM_WORDS;
+  while (num_words < num_objects && num_words < MAX_NUM_WORDS) {
+    num_words <<= 1;
+  }
+  if (num_words > fs_num_words) {
+    /*
+     * Allocation may trigger freeing of some memory by this very optimizer, so the old table must stay
+     * valid until the new one is in place. Counts accumulated so far are discarded; they are not precise
+     * anyway, and the table only grows while the number of objects grows.
+     */
+    auto words = (c3_ulong_t*) fs_memory.calloc(num_words, sizeof(c3_ulong_t));
+    dispose();
+    fs_words = words;
+    fs_num_words = num_words;
+    fs_max_increments = num_words * AGING_FACTOR;
+  }
+}
+
+void Optimizer::FrequencySketch::dispose() {
+  if (fs_words != nullptr) {
+    fs_memory.free(fs_words, fs_num_words * sizeof(c3_ulong_t));
+    fs_words = nullptr;
+    fs_num_words = 0;
+  }
+  fs_num_increments = 0;
+  fs_max_increments = 0;
+}
+
+void Optimizer::FrequencySketch::increment(c3_hash_t hash) {
+  c3_assert(fs_words && fs_num_words);
+  const c3_uint_t mask = fs_num_words - 1;
+  bool incremented = false;
+  for (c3_uint_t row = 0; row < 4; row++) {
+    c3_uint_t shift;
+    c3_uint_t i = get_index(hash, row, mask, shift);
+    if (((fs_words[i] >> shift) & MAX_COUNT) != MAX_COUNT) {
+      fs_words[i] += (c3_ulong_t) 1 << shift;
+      incremented = true;
+    }
+  }
+  if (incremented && ++fs_num_increments >= fs_max_increments) {
+    age();
+  }
+}
+
+void Optimizer::FrequencySketch::decay(c3_hash_t hash) {
+  c3_assert(fs_words && fs_num_words);
+  const c3_uint_t mask = fs_num_words - 1;
+  for (c3_uint_t row = 0; row < 4; row++) {
+    c3_uint_t shift;
+    c3_uint_t i = get_index(hash, row, mask, shift);
+    c3_ulong_t value = (fs_words[i] >> shift) & MAX_COUNT;
+    fs_words[i] -= ((value + 1) >> 1) << shift;
+  }
+}
+
+c3_uint_t Optimizer::FrequencySketch::estimate(c3_hash_t hash) const {
+  c3_assert(fs_words && fs_num_words);
+  const c3_uint_t mask = fs_num_words - 1;
+  c3_uint_t count = MAX_COUNT;
+  for (c3_uint_t row = 0; row < 4; row++) {
+    c3_uint_t shift;
+    c3_uint_t i = get_index(hash, row, mask, shift);
+    auto value = (c3_uint_t)((fs_words[i] >> shift) & MAX_COUNT);
+    if (value < count) {
+      count = value;
+    }
+  }
+  return count;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // ObjectChain
 ///////////////////////////////////////////////////////////////////////////////
@@ -129,7 +225,8 @@ PayloadHashObject* Optimizer::ObjectChainIterator::get_gc_object(PayloadHashObje
    * - should be in a chain that still has more objects than its minimum allowed number,
    * - is not currently being used for data transfer (has zero registered readers),
    * - is not currently locked,
-   * - is not marked as "deleted" yet.
+   * - is not marked as "deleted" yet,
+   * - is not being re-compressed by a thread from the pool.
    *
    * First checks (and, if check passes, returns) the argument itself, hence no "next" in the method name.
    *
@@ -146,7 +243,8 @@ PayloadHashObject* Optimizer::ObjectChainIterator::get_gc_object(PayloadHashObje
           c3_assert(pho);
         }
         do {
-          if (pho->flags_are_clear(HOF_BEING_DELETED) && !pho->is_locked() && !pho->has_readers()) {
+          if (pho->flags_are_clear(HOF_BEING_DELETED) && !pho->is_locked() && !pho->has_readers() &&
+            oci_optimizer.find_job(pho) == nullptr) {
             return pho;
           }
           pho = pho->get_opt_next();
@@ -240,19 +338,25 @@ const c3_uint_t Optimizer::o_default_num_comp_attempts[NUM_LOAD_DEPENDENT_SLOTS]
 
 Optimizer::Optimizer(const char* name, domain_t domain, eviction_mode_t em, c3_uint_t capacity,
   c3_uint_t max_capacity): o_name(name), o_memory(Memory::get_memory_object(domain)),
-  o_queue(domain, HO_OPTIMIZER, capacity, max_capacity), o_iterator(*this) {
+  o_queue(domain, HO_OPTIMIZER, capacity, max_capacity), o_iterator(*this), o_sketch(o_memory),
+  o_model(domain) {
   o_host = nullptr;
+  o_pool = nullptr;
   o_store = nullptr;
   std::memcpy(o_compressors, o_default_compressors, sizeof o_compressors);
+  o_dictionary = CDICT_NONE;
   std::memcpy(o_num_checks, o_default_num_checks, sizeof o_num_checks);
   std::memcpy(o_num_comp_attempts, o_default_num_comp_attempts, sizeof o_num_comp_attempts);
+  o_num_jobs = 0;
   o_total_num_objects = 0;
   o_wait_time = DEFAULT_TIME_BETWEEN_RUNS;
   o_min_recompression_size = DEFAULT_MIN_RECOMPRESSION_SIZE;
   o_last_run_time.store(Timer::current_timestamp(), std::memory_order_relaxed);
   o_last_run_checks.store(0, std::memory_order_relaxed);
   o_last_run_compressions.store(0, std::memory_order_relaxed);
+  o_num_dict_compressions.store(0, std::memory_order_relaxed);
   o_last_save_time = 0;
+  o_admission_frequency = 0;
   o_eviction_mode = em;
   o_quitting = false;
 }
@@ -291,9 +395,10 @@ const char* Optimizer::get_eviction_mode_name(eviction_mode_t mode) {
     "strict-expiration-lru",
     "expiration-lru",
     "lru",
-    "strict-lru"
+    "strict-lru",
+    "tiny-lfu"
   };
-  static_assert(EM_NUMBER_OF_ELEMENTS == 5, "Number of eviction modes has changed");
+  static_assert(EM_NUMBER_OF_ELEMENTS == 6, "Number of eviction modes has changed");
   return mode_names[mode];
 }
 
@@ -328,7 +433,8 @@ bool Optimizer::is_above_memory_quota() const {
 void Optimizer::process_write_message(PayloadHashObject* pho, user_agent_t ua, c3_timestamp_t lifetime) {
   LockableObjectGuard guard(pho);
   if (pho->flags_are_clear(HOF_BEING_DELETED)) {
-    if (pho->flags_are_clear(HOF_LINKED_BY_OPTIMIZER)) {
+    bool admitted = pho->flags_are_clear(HOF_LINKED_BY_OPTIMIZER);
+    if (admitted) {
       pho->set_user_agent(ua);
       get_chain(ua).link(pho);
       o_total_num_objects++;
@@ -351,6 +457,10 @@ void Optimizer::process_write_message(PayloadHashObject* pho, user_agent_t ua, c
     }
     pho->set_modification_time();
     on_write(pho, lifetime);
+    record_access(pho);
+    if (admitted) {
+      record_admission(pho);
+    }
     c3_assert(pho->flags_are_set(HOF_LINKED_BY_OPTIMIZER));
   } else {
     // the object had already been marked as "deleted"
@@ -382,6 +492,13 @@ void Optimizer::process_read_message(PayloadHashObject* pho, user_agent_t ua) {
         get_chain(current_ua).promote(pho);
       }
       on_read(pho);
+      record_access(pho);
+      if (pho->get_buffer_dictionary() != CDICT_NONE && pho->flags_are_set(HOF_OPTIMIZED) &&
+        pho->flags_are_clear(HOF_BEING_OPTIMIZED) && select_dictionary(pho) == CDICT_NONE) {
+        // record packed with a dictionary became "hot": have next optimization run re-pack it without one
+        pho->clear_flags(HOF_OPTIMIZED);
+        PERF_INCREMENT_VAR_DOMAIN_COUNTER(o_memory.get_domain(), Optimizer_Hot_Dictionary_Buffers)
+      }
       c3_assert(pho->flags_are_set(HOF_LINKED_BY_OPTIMIZER));
     } else {
       C3_DEBUG(get_store().log(LL_WARNING, "Optimizer message READ '%.*s' came out of order (ignoring)",
@@ -406,6 +523,15 @@ void Optimizer::process_delete_message(Optimizer::OptimizerMessage& msg) {
      * otherwise, object's memory might be freed already at the time we unlock it, so we would end up
      * writing to a byte that if no longer part of the object.
      */
+    RecompressionJob* job = find_job(pho);
+    if (job != nullptr) {
+      /*
+       * A re-compression thread is working on the object's data right now; the object will be put into
+       * the store's queue of deleted objects after the job is completed.
+       */
+      job->set_unlink_pending();
+      return;
+    }
     guard.unlock();
     /*
      * This request came either from session store, or from the tag manager; it could not have come from
@@ -425,6 +551,12 @@ void Optimizer::process_delete_message(Optimizer::OptimizerMessage& msg) {
   }
 }
 
+void Optimizer::process_recompressed_message(RecompressionJob* job) {
+  c3_assert(o_num_jobs);
+  complete_recompression(job);
+  o_num_jobs--;
+}
+
 void Optimizer::process_gc_message(c3_uint_t seconds) {
   validate_eviction_mode();
   if (o_eviction_mode != EM_STRICT_LRU) {
@@ -437,7 +569,8 @@ void Optimizer::process_gc_message(c3_uint_t seconds) {
       if (guard.is_locked()) {
         c3_assert(pho->flags_are_set(HOF_LINKED_BY_OPTIMIZER));
         if (pho->flags_are_clear(HOF_BEING_DELETED)) {
-          if (is_above_memory_quota() || (o_eviction_mode <= EM_EXPIRATION_LRU && on_gc(pho, seconds))) {
+          if ((is_above_memory_quota() && !reprieve_object(pho)) ||
+            (o_eviction_mode <= EM_EXPIRATION_LRU && on_gc(pho, seconds))) {
             C3_DEBUG(get_store().log(LL_DEBUG, "GC: purging '%.*s'",
               pho->get_name_length(), pho->get_name()));
             pho->set_flags(HOF_BEING_DELETED);
@@ -461,7 +594,8 @@ void Optimizer::process_free_memory_message(c3_ulong_t min_size, bool direct) {
   while (pho != nullptr && size < min_size) {
     LockableObjectGuard guard(pho);
     if (guard.is_locked()) {
-      if (pho->flags_are_clear(HOF_BEING_DELETED) && !pho->has_readers()) {
+      if (pho->flags_are_clear(HOF_BEING_DELETED) && !pho->has_readers() &&
+        !reprieve_object(pho)) {
         pho->set_flags(HOF_BEING_DELETED);
         size += pho->dispose_buffer(o_memory);
         iterator.unlink(pho);
@@ -487,6 +621,59 @@ void Optimizer::process_free_memory_message(c3_ulong_t min_size, bool direct) {
   }
 }
 
+void Optimizer::update_frequency_sketch() {
+  // access counts are also needed to tell which records should not be packed with a dictionary
+  if (o_eviction_mode == EM_TINY_LFU || o_dictionary != CDICT_NONE) {
+    o_sketch.ensure_capacity(o_total_num_objects);
+  } else {
+    o_sketch.dispose();
+    o_admission_frequency = 0;
+  }
+}
+
+void Optimizer::record_admission(const PayloadHashObject* pho) {
+  // exponential moving average (newest sample has weight of 1/16) kept in 1/16ths of access count
+  if (o_sketch.is_allocated()) {
+    o_admission_frequency += o_sketch.estimate(pho->get_hash_code()) - (o_admission_frequency >> 4);
+  }
+}
+
+c3_dictionary_t Optimizer::select_dictionary(const PayloadHashObject* pho) const {
+  /*
+   * Clients do not have server's dictionaries, so a buffer packed with a dictionary has to be unpacked
+   * (under object lock) each time the record is read; for records that are read often, this would cost
+   * more than the memory that the dictionary saves, so they are only packed without dictionaries.
+   */
+  if (o_dictionary != CDICT_NONE && o_sketch.is_allocated() &&
+    o_sketch.estimate(pho->get_hash_code()) >= MIN_HOT_RECORD_ACCESSES) {
+    return CDICT_NONE;
+  }
+  return o_dictionary;
+}
+
+bool Optimizer::reprieve_object(PayloadHashObject* pho) {
+  /*
+   * In `EM_TINY_LFU` mode, an eviction candidate competes with newly admitted objects (which play the
+   * role of the "window" in W-TinyLFU): if the candidate had been accessed more often than an average new
+   * object, it is moved to the end of its chain (the eviction pass then continues with the next object,
+   * which the caller's iterator already points to). Counts of a reprieved object are halved, so it can
+   * only be reprieved a few times, and any eviction pass is guaranteed to terminate.
+   */
+  c3_assert(pho && pho->is_locked() && pho->flags_are_set(HOF_LINKED_BY_OPTIMIZER));
+  if (o_eviction_mode == EM_TINY_LFU && o_sketch.is_allocated()) {
+    c3_hash_t hash = pho->get_hash_code();
+    if ((o_sketch.estimate(hash) << 4) > o_admission_frequency) {
+      o_sketch.decay(hash);
+      o_iterator.exclude_object(pho);
+      get_chain(pho->get_user_agent()).promote(pho);
+      PERF_INCREMENT_VAR_DOMAIN_COUNTER(o_memory.get_domain(), Optimizer_LFU_Reprieves)
+      return true;
+    }
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(o_memory.get_domain(), Optimizer_LFU_Evictions)
+  }
+  return false;
+}
+
 void Optimizer::process_generic_load_slot_message(const char* what, c3_uint_t* dst, const c3_uint_t* src) {
   static_assert(NUM_LOAD_DEPENDENT_SLOTS == 5, "process_generic_load_slot_message() expects 5 slots");
   std::memcpy(dst, src, sizeof(c3_uint_t) * NUM_LOAD_DEPENDENT_SLOTS);
@@ -550,6 +737,7 @@ void Optimizer::process_config_eviction_mode_message(eviction_mode_t mode) {
   switch (mode) {
     case EM_LRU:
     case EM_STRICT_LRU:
+    case EM_TINY_LFU:
       notice = " (requires valid memory quota)";
       // fall through
     default:
@@ -557,6 +745,7 @@ void Optimizer::process_config_eviction_mode_message(eviction_mode_t mode) {
       get_store().log(LL_VERBOSE, "%s: eviction mode set to '%s'%s",
         o_name, get_eviction_mode_name(mode), notice);
   }
+  update_frequency_sketch();
 }
 
 void Optimizer::process_config_recompression_threshold_message(c3_uint_t threshold) {
@@ -565,6 +754,25 @@ void Optimizer::process_config_recompression_threshold_message(c3_uint_t thresho
   get_store().log(LL_VERBOSE, "%s: re-compression threshold set to %u bytes", o_name, threshold);
 }
 
+void Optimizer::process_config_dictionary_message(c3_dictionary_t dictionary) {
+  if (o_dictionary != dictionary) {
+    // compressors that support dictionaries are going to perform differently
+    o_model.reset();
+  }
+  o_dictionary = dictionary;
+  update_frequency_sketch();
+  if (dictionary != CDICT_NONE) {
+    get_store().log(LL_VERBOSE, "%s: compression dictionary set to #%u", o_name, (c3_uint_t) dictionary);
+  } else {
+    get_store().log(LL_VERBOSE, "%s: compression dictionary disabled", o_name);
+  }
+}
+
+void Optimizer::process_config_exploration_rate_message(c3_uint_t rate) {
+  o_model.set_exploration_rate(rate);
+  get_store().log(LL_VERBOSE, "%s: compressor exploration rate set to %u%%", o_name, rate);
+}
+
 void Optimizer::process_config_capacity_message(c3_uint_t capacity) {
   c3_uint_t actual = o_queue.set_capacity(capacity);
   get_store().log(LL_VERBOSE, "%s: queue capacity set to %u (requested: %u)", o_name, actual, capacity);
@@ -655,12 +863,21 @@ void Optimizer::process_message(Optimizer::OptimizerMessage &msg) {
     case OR_CONFIG_RECOMPRESSION_THRESHOLD:
       process_config_recompression_threshold_message(msg.get_uint());
       return;
+    case OR_CONFIG_DICTIONARY:
+      process_config_dictionary_message((c3_dictionary_t) msg.get_uint());
+      return;
+    case OR_CONFIG_EXPLORATION_RATE:
+      process_config_exploration_rate_message(msg.get_uint());
+      return;
     case OR_QUEUE_CAPACITY:
       process_config_capacity_message(msg.get_uint());
       return;
     case OR_QUEUE_MAX_CAPACITY:
       process_config_max_capacity_message(msg.get_uint());
       return;
+    case OR_RECOMPRESSED:
+      process_recompressed_message(msg.get_job());
+      return;
     case OR_QUIT:
       get_store().log(LL_VERBOSE, "%s: QUIT request received", o_name);
       enter_quit_state();
@@ -670,6 +887,115 @@ void Optimizer::process_message(Optimizer::OptimizerMessage &msg) {
   }
 }
 
+RecompressionJob* Optimizer::find_job(const PayloadHashObject* pho) {
+  if (o_num_jobs > 0) {
+    for (c3_uint_t i = 0; i < MAX_NUM_JOBS; i++) {
+      if (o_jobs[i].get_object() == pho) {
+        return o_jobs + i;
+      }
+    }
+  }
+  return nullptr;
+}
+
+RecompressionJob* Optimizer::get_free_job() {
+  for (c3_uint_t i = 0; i < MAX_NUM_JOBS; i++) {
+    if (o_jobs[i].is_free()) {
+      return o_jobs + i;
+    }
+  }
+  c3_assert_failure();
+  return nullptr;
+}
+
+c3_uint_t Optimizer::select_compressors(const PayloadHashObject* pho, c3_compressor_t* compressors) {
+  c3_assert(pho && pho->is_locked() && compressors);
+  c3_uint_t usize = pho->get_buffer_usize();
+  c3_compressor_t current = pho->get_buffer_compressor();
+  /*
+   * Re-compressing data with the same compressor can only make a difference if object's data would be
+   * packed using a different dictionary.
+   */
+  c3_dictionary_t dictionary = select_dictionary(pho);
+  if (dictionary != CDICT_NONE && !global_compressor.can_use_dictionary(current, usize)) {
+    dictionary = CDICT_NONE;
+  }
+  if (dictionary != pho->get_buffer_dictionary()) {
+    current = CT_NUMBER_OF_ELEMENTS;
+  }
+  return o_model.select(o_compressors, compressors, NUM_COMPRESSORS, pho->get_user_agent(), usize, current);
+}
+
+void Optimizer::complete_recompression(RecompressionJob* job) {
+
+  // 2E) Update compressor statistics, lock the object again and, if possible, set new buffer and flags
+  // --------------------------------------------------------------------------------------------------
+
+  for (c3_uint_t i = 0; i < job->get_num_attempts(); i++) {
+    const RecompressionJob::attempt_t& attempt = job->get_attempt(i);
+    o_model.update(job->get_user_agent(), attempt.a_compressor, job->get_usize(), job->get_snapshot_size(),
+      attempt.a_size, attempt.a_nanoseconds);
+  }
+
+  /*
+   * Even if re-compression attempt has failed, we still need to lock the object to at least clear the
+   * `HOF_BEING_OPTIMIZED` flag. The object may have been deleted in the meantime, but it could not be
+   * disposed: if it had been unlinked from optimizer's chains, unlinking from the store was postponed.
+   */
+  PayloadHashObject* pho = job->get_object();
+  c3_assert_def(bool locked) pho->lock();
+  c3_assert(locked);
+  if (pho->flags_are_clear(HOF_BEING_DELETED) && pho->flags_are_set(HOF_BEING_OPTIMIZED) &&
+    !pho->has_readers()) {
+    if (job->succeeded()) {
+      C3_DEBUG(get_store().log(LL_DEBUG, "Optimized '%.*s': %u -> %u bytes (%s/%u -> %s/%u)",
+        (int) pho->get_name_length(), pho->get_name(), pho->get_buffer_size(), job->get_size(),
+        global_compressor.get_name(pho->get_buffer_compressor()), (c3_uint_t) pho->get_buffer_dictionary(),
+        global_compressor.get_name(job->get_compressor()), (c3_uint_t) job->get_dictionary()));
+      c3_uint_t size = job->get_size();
+      c3_dictionary_t dictionary = job->get_dictionary();
+      pho->set_buffer(job->get_compressor(), dictionary, size, job->get_usize(), job->fetch_buffer(), o_memory);
+      if (dictionary != CDICT_NONE) {
+        o_num_dict_compressions.fetch_add(1, std::memory_order_relaxed);
+      }
+    } else {
+      // nothing interfered with re-compression, and yet the object could not be optimized; do not try again
+      C3_DEBUG(get_store().log(LL_DEBUG, "Object '%.*s' could not be optimized further: %u bytes (%s)",
+        (int) pho->get_name_length(), pho->get_name(), pho->get_buffer_size(),
+        global_compressor.get_name(pho->get_buffer_compressor())));
+    }
+    pho->set_flags(HOF_OPTIMIZED);
+  }
+  pho->clear_flags(HOF_BEING_OPTIMIZED);
+  bool unlink = job->is_unlink_pending();
+  job->release();
+  pho->unlock();
+  if (unlink) {
+    // see comments in process_delete_message()
+    get_store().post_unlink_message(pho);
+  }
+}
+
+void Optimizer::wait_for_recompression_jobs(bool all) {
+  /*
+   * We process *all* messages while waiting (not just `OR_RECOMPRESSED`): a re-compression thread may
+   * run out of memory and ask us to free some (using `OR_FREE_MEMORY`), so we must not block it.
+   */
+  c3_uint_t max_num_jobs = all? 0:
+    get_recompression_pool().get_num_threads() * RecompressionPool::MAX_JOBS_PER_THREAD;
+  if (max_num_jobs > MAX_NUM_JOBS) {
+    max_num_jobs = MAX_NUM_JOBS;
+  }
+  while (o_num_jobs > 0 && o_num_jobs >= max_num_jobs) {
+    Thread::set_state(TS_IDLE);
+    OptimizerMessage msg = o_queue.get();
+    Thread::set_state(o_quitting? TS_QUITTING: TS_ACTIVE);
+    if (msg.is_valid()) {
+      process_message(msg);
+    }
+  }
+}
+
 void Optimizer::run(c3_timestamp_t current_time) {
   PayloadHashObject* pho;
 
@@ -677,13 +1003,15 @@ void Optimizer::run(c3_timestamp_t current_time) {
   // ======================
 
   validate_eviction_mode();
+  update_frequency_sketch();
   if (is_above_memory_quota()) {
     ObjectChainIterator iterator(*this);
     pho = iterator.get_first_gc_object();
     while (pho != nullptr) {
       LockableObjectGuard guard(pho);
       if (guard.is_locked()) {
-        if (pho->flags_are_clear(HOF_BEING_DELETED) && !pho->has_readers()) {
+        if (pho->flags_are_clear(HOF_BEING_DELETED) && !pho->has_readers() &&
+          !reprieve_object(pho)) {
           pho->set_flags(HOF_BEING_DELETED);
           /*
            * Preconditions for calling `dispose_buffer()` (as opposed to `try_dispose_buffer()`) are
@@ -736,91 +1064,41 @@ void Optimizer::run(c3_timestamp_t current_time) {
 
     if (is_optimizable(pho)) {
       if (pho->try_lock()) {
-        if (is_optimizable(pho)) {
+        c3_compressor_t compressors[NUM_COMPRESSORS];
+        if (!is_optimizable(pho)) {
+          pho->unlock();
+        } else if (select_compressors(pho, compressors) == 0) {
+          // no compressor is expected to do better than the one that had packed the data
+          pho->set_flags(HOF_OPTIMIZED);
+          pho->unlock();
+        } else {
           pho->set_flags(HOF_BEING_OPTIMIZED);
 
-          // 2C) Get payload buffer data and unlock the object so that other threads could use it
-          // ------------------------------------------------------------------------------------
-
-          c3_uint_t size = pho->get_buffer_size();
-          c3_uint_t usize = pho->get_buffer_usize();
-          c3_compressor_t compressor = pho->get_buffer_compressor();
-          c3_byte_t* compressed_buffer = pho->get_buffer_bytes(0, size);
-          c3_assert(size && usize &&
-            ((compressor == CT_NONE && size == usize) || (compressor != CT_NONE && size < usize)) &&
-            compressor < CT_NUMBER_OF_ELEMENTS && compressed_buffer);
-          c3_byte_t* uncompressed_buffer = compressor == CT_NONE?
-            (c3_byte_t*) std::memcpy(o_memory.alloc(usize), compressed_buffer, usize):
-            global_compressor.unpack(compressor, compressed_buffer, size, usize, o_memory);
-          pho->unlock();
+          // 2C) Take snapshot of payload data and unlock the object so that other threads could use it
+          // -------------------------------------------------------------------------------------------
 
-          // 2D) Try to improve compression ratio using engines specified in the configuration
-          // ---------------------------------------------------------------------------------
-
-          c3_compressor_t best_compressor = CT_NUMBER_OF_ELEMENTS;
-          c3_uint_t best_size = size;
-          compressed_buffer = nullptr;
-          for (c3_uint_t i = 0; i < NUM_COMPRESSORS; i++) {
-            c3_compressor_t try_compressor = o_compressors[i];
-            if (try_compressor == CT_NONE) {
-              break;
-            }
-            // default compression strength is "best", so no reason to try the same compressor twice
-            if (try_compressor != compressor) {
-              c3_uint_t try_size = best_size;
-              // compressor returns `NULL` if result is bigger than or equal to `try_size`
-              c3_byte_t* try_buff = global_compressor.pack(try_compressor, uncompressed_buffer,
-                usize, try_size, o_memory, CL_BEST);
-              if (try_buff != nullptr) {
-                c3_assert(try_size < best_size);
-                if (compressed_buffer != nullptr) {
-                  o_memory.free(compressed_buffer, best_size);
-                }
-                best_compressor = try_compressor;
-                best_size = try_size;
-                compressed_buffer = try_buff;
-                PERF_UPDATE_ARRAY(Recompressions_Succeeded, (c3_uint_t) try_compressor)
-              } else {
-                PERF_UPDATE_ARRAY(Recompressions_Failed, (c3_uint_t) try_compressor)
-              }
-            }
-          }
-          o_memory.free(uncompressed_buffer, usize);
+          RecompressionJob* job = get_free_job();
+          job->prepare(this, o_memory, pho, compressors, select_dictionary(pho));
+          pho->unlock();
 
-          // 2E) Lock the object again and, if possible/necessary, set new buffer and flags
-          // ------------------------------------------------------------------------------
+          // 2D) Try to improve compression ratio using engine(s) selected by the model
+          // --------------------------------------------------------------------------
 
           /*
-           * Even if re-compression attempt has failed, we still need to lock the object to
-           * at least clear the `HOF_BEING_OPTIMIZED` flag.
+           * If the pool has running threads, the job is executed by one of them, and the object is then
+           * updated (in step 2E) upon processing of the `OR_RECOMPRESSED` message; we only wait here if
+           * we already have as many jobs in flight as the pool can handle. If the pool does not have
+           * running threads, we do all the work ourselves.
            */
-          c3_assert_def(bool locked) pho->lock();
-          c3_assert(locked);
-          if (best_compressor != CT_NUMBER_OF_ELEMENTS && pho->flags_are_clear(HOF_BEING_DELETED) &&
-            pho->flags_are_set(HOF_BEING_OPTIMIZED) && !pho->has_readers()) {
-            C3_DEBUG(get_store().log(LL_DEBUG, "Optimized '%.*s': %u -> %u bytes (%s -> %s)",
-              (int) pho->get_name_length(), pho->get_name(), pho->get_buffer_size(), best_size,
-              global_compressor.get_name(pho->get_buffer_compressor()),
-              global_compressor.get_name(best_compressor)));
-            pho->set_buffer(best_compressor, best_size, usize, compressed_buffer, o_memory);
-            pho->set_flags(HOF_OPTIMIZED);
+          if (get_recompression_pool().post_job(job)) {
+            o_num_jobs++;
+            wait_for_recompression_jobs(false);
           } else {
-            if (pho->flags_are_clear(HOF_BEING_DELETED) && pho->flags_are_set(HOF_BEING_OPTIMIZED) &&
-              !pho->has_readers()) {
-              // nothing interfered with re-compression, and yet the object could not be optimized; do not try again
-              C3_DEBUG(get_store().log(LL_DEBUG, "Object '%.*s' could not be optimized further: %u bytes (%s)",
-                (int) pho->get_name_length(), pho->get_name(), pho->get_buffer_size(),
-                global_compressor.get_name(pho->get_buffer_compressor())));
-              pho->set_flags(HOF_OPTIMIZED);
-            }
-            if (compressed_buffer != nullptr) {
-              o_memory.free(compressed_buffer, best_size);
-            }
+            job->execute();
+            complete_recompression(job);
           }
-          pho->clear_flags(HOF_BEING_OPTIMIZED);
           num_compressions++;
         }
-        pho->unlock();
       }
     }
     // 2F) See if we should break optimization run for reasons other than having checked all objects
@@ -829,11 +1107,13 @@ void Optimizer::run(c3_timestamp_t current_time) {
     c3_uint_t load = get_cpu_load();
     if (num_checks >= o_num_checks[load] ||
       num_compressions >= o_num_comp_attempts[load] ||
-      o_queue.has_messages() ||
+      o_queue.has_messages() || o_quitting ||
       Timer::current_timestamp() >= current_time + o_wait_time) {
       break;
     }
   }
+  // no jobs may remain in flight after the run: objects are not pinned outside of it
+  wait_for_recompression_jobs(true);
 
   // 3) See if we have to send auto-save request to the server
   // =========================================================
@@ -867,6 +1147,7 @@ void Optimizer::cleanup() {
   c3_assert(total == o_total_num_objects);
   o_total_num_objects = 0;
   o_iterator.reset();
+  o_sketch.dispose();
 }
 
 bool Optimizer::post_write_message(PayloadHashObject* object, user_agent_t user_agent, c3_uint_t lifetime) {
@@ -922,6 +1203,16 @@ bool Optimizer::post_config_recompression_threshold_message(c3_uint_t threshold)
   return o_queue.put(OptimizerMessage(OR_CONFIG_RECOMPRESSION_THRESHOLD, &threshold, 1));
 }
 
+bool Optimizer::post_config_dictionary_message(c3_dictionary_t dictionary) {
+  c3_uint_t id = dictionary;
+  return o_queue.put(OptimizerMessage(OR_CONFIG_DICTIONARY, &id, 1));
+}
+
+bool Optimizer::post_config_exploration_rate_message(c3_uint_t rate) {
+  c3_assert(rate <= 100);
+  return o_queue.put(OptimizerMessage(OR_CONFIG_EXPLORATION_RATE, &rate, 1));
+}
+
 bool Optimizer::post_queue_capacity_message(c3_uint_t capacity) {
   return o_queue.put(OptimizerMessage(OR_QUEUE_CAPACITY, &capacity, 1));
 }
@@ -934,6 +1225,11 @@ bool Optimizer::post_quit_message() {
   return o_queue.put(OptimizerMessage(OR_QUIT));
 }
 
+bool Optimizer::post_recompression_result(RecompressionJob* job) {
+  // re-compression threads must never block on optimizer's queue
+  return o_queue.put_always(OptimizerMessage(OR_RECOMPRESSED, job));
+}
+
 void Optimizer::thread_proc(c3_uint_t id, ThreadArgument arg) {
   Thread::set_state(TS_ACTIVE);
   bool first_run = true;
@@ -1090,6 +1386,7 @@ void SessionOptimizer::on_read(PayloadHashObject* pho) {
         }
       case EM_LRU:
       case EM_STRICT_LRU:
+      case EM_TINY_LFU:
         c3_uint_t new_expiration_time = current_time + so_read_extra_lifetimes[pho->get_user_agent()];
         if (new_expiration_time > expiration_time) {
           pho->set_expiration_time(new_expiration_time);
@@ -1248,6 +1545,7 @@ void PageOptimizer::on_read(PayloadHashObject* pho) {
         }
       case EM_LRU:
       case EM_STRICT_LRU:
+      case EM_TINY_LFU:
         c3_uint_t new_expiration_time = current_time + po_read_extra_lifetimes[pho->get_user_agent()];
         if (new_expiration_time > expiration_time) {
           pho->set_expiration_time(new_expiration_time);
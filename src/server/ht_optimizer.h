@@ -21,6 +21,7 @@
 
 #include "c3lib/c3lib.h"
 #include "ht_stores.h"
+#include "ht_recompressor.h"
 
 namespace CyberCache {
 
@@ -59,6 +60,17 @@ enum eviction_mode_t {
    * This mode works just like `EM_LRU`, except that it ignores even explicit garbage collection requests.
    */
   EM_STRICT_LRU,
+  /**
+   * This mode works like `EM_LRU` with respect to expiration, but takes access frequency into account
+   * when it has to free up memory. The optimizer maintains approximate counts of recent accesses to its
+   * objects (a count-min sketch with periodic aging), and an eviction candidate taken from the LRU end
+   * of the chains competes with recently admitted objects: if it had been accessed more often than an
+   * average new object, it is moved to the MRU end instead of being evicted (and its counts decay, so
+   * that it would not be reprieved indefinitely). New objects are thus still admitted unconditionally,
+   * but records that had been used only once (e.g. pages crawled by bots) are evicted before frequently
+   * used ones.
+   */
+  EM_TINY_LFU,
   EM_NUMBER_OF_ELEMENTS
 };
 
@@ -85,6 +97,12 @@ class Optimizer {
   static constexpr c3_uint_t DEFAULT_TIME_BETWEEN_RUNS = 20;
   /// Smallest buffer that the optimizer will attempt to re-compress, bytes
   static constexpr c3_uint_t DEFAULT_MIN_RECOMPRESSION_SIZE = 256;
+  /// Records accessed at least this many times (as estimated by the sketch) are never packed with dictionaries
+  static constexpr c3_uint_t MIN_HOT_RECORD_ACCESSES = 5;
+  /// Maximum number of re-compression jobs that the optimizer can have in flight
+  static constexpr c3_uint_t MAX_NUM_JOBS = MAX_NUM_RECOMPRESSION_THREADS * RecompressionPool::MAX_JOBS_PER_THREAD;
+
+  static_assert(NUM_COMPRESSORS == RecompressionJob::NUM_COMPRESSORS, "Number of compressors mismatch");
 
   /// Number of CPU cores in the system
   static c3_uint_t o_num_cores;
@@ -109,6 +127,42 @@ class Optimizer {
       pho->get_buffer_usize() >= o_min_recompression_size;
   }
 
+  /// Approximate counts of accesses to objects, used in `EM_TINY_LFU` eviction mode
+  class FrequencySketch {
+    /// Smallest number of 64-bit words in the table
+    static constexpr c3_uint_t MIN_NUM_WORDS = 1024;
+    /// Biggest number of 64-bit words in the table (32 megabytes)
+    static constexpr c3_uint_t MAX_NUM_WORDS = 4 * 1024 * 1024;
+    /// How many increments (relative to the number of words) trigger aging of all counters
+    static constexpr c3_uint_t AGING_FACTOR = 10;
+    /// Maximum value of a counter
+    static constexpr c3_ulong_t MAX_COUNT = 15;
+
+    Memory&     fs_memory;         // memory object used to allocate table of counters
+    c3_ulong_t* fs_words;          // table of 4-bit counters, 16 per word
+    c3_uint_t   fs_num_words;      // number of words in the table (a power of 2), or zero
+    c3_uint_t   fs_num_increments; // number of increments since last aging
+    c3_uint_t   fs_max_increments; // number of increments that triggers aging
+
+    static c3_uint_t get_index(c3_hash_t hash, c3_uint_t row, c3_uint_t mask, c3_uint_t& shift);
+    void age();
+
+  public:
+    explicit FrequencySketch(Memory& memory): fs_memory(memory) {
+      fs_words = nullptr;
+      fs_num_words = 0;
+      fs_num_increments = 0;
+      fs_max_increments = 0;
+    }
+
+    bool is_allocated() const { return fs_words != nullptr; }
+    void ensure_capacity(c3_uint_t num_objects) C3_FUNC_COLD;
+    void dispose() C3_FUNC_COLD;
+    void increment(c3_hash_t hash);
+    void decay(c3_hash_t hash);
+    c3_uint_t estimate(c3_hash_t hash) const;
+  };
+
   /// Collection of objects submitted by the same type of user agent
   class ObjectChain {
     PayloadHashObject* oc_first;   // first object in the chain for this user agent type
@@ -179,6 +233,8 @@ protected:
     OR_CONFIG_RETAIN_COUNTS,           // how many objects to retain per each user agent type
     OR_CONFIG_EVICTION_MODE,           // eviction mode to use during optimization and GC runs
     OR_CONFIG_RECOMPRESSION_THRESHOLD, // only attempt re-compression if object buffer is bigger than this
+    OR_CONFIG_DICTIONARY,              // what compression dictionary to use for re-compression attempts
+    OR_CONFIG_EXPLORATION_RATE,        // percentage of re-compression attempts that try all compressors
     OR_QUEUE_CAPACITY,                 // queue capacity
     OR_QUEUE_MAX_CAPACITY,             // maximum queue capacity
     OR_QUIT,                           // complete queue processing and then quit
@@ -190,6 +246,7 @@ protected:
     OR_FPC_READ_EXTRA_LIFETIMES,       // lifetimes to add upon some reads of FPC cache entries
     OR_FPC_MAX_LIFETIMES,              // max allowed lifetimes (clips specified in `SAVE` requests)
     OR_FPC_TOUCH,                      // update FPC record's expiration timestamp
+    OR_RECOMPRESSED,                   // re-compression thread completed a job
     OR_NUMBER_OF_ELEMENTS
   };
 
@@ -198,6 +255,7 @@ protected:
     OA_INVALID = 0,  // an invalid argument (placeholder)
     OA_NONE,         // there are not extra arguments
     OA_OBJECT,       // a pointer to `PayloadHashObject`
+    OA_JOB,          // a pointer to `RecompressionJob`
     OA_LONG,         // an unsigned long integer
     OA_BYTE_ARRAY,   // a byte array with up to eight elements (passed within request)
     OA_UINT_ARRAY,   // an array of unsigned integers possibly allocated on the heap (placeholder!)
@@ -214,6 +272,7 @@ protected:
 
     union {
       PayloadHashObject* om_object;        // pointer to the object being added/updated/deleted
+      RecompressionJob*  om_job;           // pointer to completed re-compression job
       c3_ulong_t         om_long;          // an unsigned long integer
       c3_uint_t          om_int_array[2];  // array of up to two integers
       c3_uint_t*         om_int_pointer;   // array of three or more integers
@@ -276,6 +335,12 @@ protected:
       om_argument = OA_NONE;
       om_lifetime = lifetime;
     }
+    OptimizerMessage(optimization_request_t request, RecompressionJob* job) {
+      c3_assert(request < OR_NUMBER_OF_ELEMENTS && job && !job->is_free());
+      om_request = request;
+      om_argument = OA_JOB;
+      om_job = job;
+    }
     OptimizerMessage(optimization_request_t request, c3_ulong_t num) {
       c3_assert(request < OR_NUMBER_OF_ELEMENTS);
       om_request = request;
@@ -353,6 +418,10 @@ protected:
       c3_assert(om_argument == OA_OBJECT && om_object && om_object->flags_are_set(HOF_PAYLOAD));
       return om_lifetime;
     }
+    RecompressionJob* get_job() const {
+      c3_assert(om_argument == OA_JOB && om_job);
+      return om_job;
+    }
     c3_ulong_t get_ulong() const {
       c3_assert(om_argument == OA_LONG);
       return om_long;
@@ -389,20 +458,28 @@ protected:
 
   ObjectChain         o_chain[UA_NUMBER_OF_ELEMENTS]; // objects managed by the optimizer
   MemoryInterface*    o_host;                         // object that has to be notified upon deallocation
+  RecompressionPool*  o_pool;                         // pool of re-compression threads
   PayloadObjectStore* o_store;                        // associated object store
   const char* const   o_name;                         // optimizer identification string
   Memory&             o_memory;                       // memory object
   OptimizerQueue      o_queue;                        // queue of optimization requests
   ObjectChainIterator o_iterator;                     // next object to check during optimization run
+  FrequencySketch     o_sketch;                       // access frequencies (in `EM_TINY_LFU` mode)
+  c3_uint_t           o_admission_frequency;          // average frequency of new objects, 1/16ths
   c3_compressor_t     o_compressors[NUM_COMPRESSORS]; // compression algorithms to use for re-compression
+  c3_dictionary_t     o_dictionary;                   // compression dictionary to use for re-compression
+  CompressorModel     o_model;                        // statistics used to select compressors to try
   c3_uint_t           o_num_checks[NUM_LOAD_DEPENDENT_SLOTS]; // checks to do during each run
   c3_uint_t           o_num_comp_attempts[NUM_LOAD_DEPENDENT_SLOTS]; // re-compresion attempts to do
+  RecompressionJob    o_jobs[MAX_NUM_JOBS];           // slots for re-compression jobs
+  c3_uint_t           o_num_jobs;                     // number of jobs handed over to re-compression threads
   c3_uint_t           o_total_num_objects;            // total num of objects managed by this optimizer
   c3_uint_t           o_wait_time;                    // seconds to wait between optimization runs
   c3_uint_t           o_min_recompression_size;       // smallest buffer that can be re-compressed
   atomic_timestamp_t  o_last_run_time;                // time of the last optimization run
   std::atomic_uint    o_last_run_checks;              // number of checks during last optimization run
   std::atomic_uint    o_last_run_compressions;        // number of re-compressions during last optimization run
+  std::atomic_uint    o_num_dict_compressions;        // total number of buffers re-compressed using a dictionary
   c3_timestamp_t      o_last_save_time;               // last time optimizer requested auto-save from the server
   eviction_mode_t     o_eviction_mode;                // current object eviction strategy
   bool                o_quitting;                     // `true` if `QUIT` request had been received
@@ -410,8 +487,18 @@ protected:
   void process_write_message(PayloadHashObject* pho, user_agent_t ua, c3_timestamp_t lifetime);
   void process_read_message(PayloadHashObject* pho, user_agent_t ua);
   void process_delete_message(Optimizer::OptimizerMessage& msg);
+  void process_recompressed_message(RecompressionJob* job);
   void process_gc_message(c3_uint_t seconds);
   void process_free_memory_message(c3_ulong_t min_size, bool direct);
+  void update_frequency_sketch() C3_FUNC_COLD;
+  void record_access(const PayloadHashObject* pho) {
+    if (o_sketch.is_allocated()) {
+      o_sketch.increment(pho->get_hash_code());
+    }
+  }
+  void record_admission(const PayloadHashObject* pho);
+  c3_dictionary_t select_dictionary(const PayloadHashObject* pho) const;
+  bool reprieve_object(PayloadHashObject* pho);
 
   void process_generic_load_slot_message(const char* what, c3_uint_t* dst, const c3_uint_t* src) C3_FUNC_COLD;
   void process_generic_ua_slot_message(const char* what, c3_uint_t* dst, const c3_uint_t* src) C3_FUNC_COLD;
@@ -421,10 +508,17 @@ protected:
   void process_config_retain_counts_message(const c3_uint_t* retain_counts) C3_FUNC_COLD;
   void process_config_eviction_mode_message(eviction_mode_t mode) C3_FUNC_COLD;
   void process_config_recompression_threshold_message(c3_uint_t threshold) C3_FUNC_COLD;
+  void process_config_dictionary_message(c3_dictionary_t dictionary) C3_FUNC_COLD;
+  void process_config_exploration_rate_message(c3_uint_t rate) C3_FUNC_COLD;
   void process_config_capacity_message(c3_uint_t capacity) C3_FUNC_COLD;
   void process_config_max_capacity_message(c3_uint_t max_capacity) C3_FUNC_COLD;
 
   void process_message(OptimizerMessage &msg);
+  RecompressionJob* find_job(const PayloadHashObject* pho);
+  RecompressionJob* get_free_job();
+  c3_uint_t select_compressors(const PayloadHashObject* pho, c3_compressor_t* compressors);
+  void complete_recompression(RecompressionJob* job);
+  void wait_for_recompression_jobs(bool all);
   void run(c3_timestamp_t current_time);
   void enter_quit_state() C3_FUNC_COLD;
   void cleanup() C3_FUNC_COLD;
@@ -522,6 +616,14 @@ protected:
     c3_assert(store && o_store == nullptr);
     o_store = store;
   }
+  RecompressionPool& get_recompression_pool() const {
+    c3_assert(o_pool);
+    return *o_pool;
+  }
+  void set_recompression_pool(RecompressionPool* pool) {
+    c3_assert(pool && o_pool == nullptr);
+    o_pool = pool;
+  }
   ObjectChain& get_chain(user_agent_t ua) {
     c3_assert(ua < UA_NUMBER_OF_ELEMENTS);
     return o_chain[ua];
@@ -533,6 +635,8 @@ public:
   eviction_mode_t get_eviction_mode() const { return o_eviction_mode; }
   c3_uint_t get_optimization_interval() const { return o_wait_time; }
   const c3_compressor_t* get_compressors() const { return o_compressors; }
+  c3_dictionary_t get_dictionary() const { return o_dictionary; }
+  c3_uint_t get_exploration_rate() const { return o_model.get_exploration_rate(); }
   c3_uint_t get_recompression_threshold() const { return o_min_recompression_size; }
   c3_uint_t get_queue_capacity() C3LM_OFF(const) { return o_queue.get_capacity(); }
   c3_uint_t get_max_queue_capacity() C3LM_OFF(const) { return o_queue.get_max_capacity(); }
@@ -542,6 +646,7 @@ public:
   c3_timestamp_t get_last_run_time() const { return o_last_run_time.load(std::memory_order_relaxed); }
   c3_uint_t get_last_run_checks() const { return o_last_run_checks.load(std::memory_order_relaxed); }
   c3_uint_t get_last_runs_compressions() const { return o_last_run_compressions.load(std::memory_order_relaxed); }
+  c3_uint_t get_dictionary_compressions() const { return o_num_dict_compressions.load(std::memory_order_relaxed); }
 
   bool post_write_message(PayloadHashObject* object, user_agent_t user_agent, c3_uint_t lifetime);
   bool post_read_message(PayloadHashObject* object, user_agent_t user_agent);
@@ -555,9 +660,12 @@ public:
   bool post_config_retain_counts_message(const c3_uint_t* retain_counts) C3_FUNC_COLD;
   bool post_config_eviction_mode_message(c3_uint_t mode) C3_FUNC_COLD;
   bool post_config_recompression_threshold_message(c3_uint_t threshold) C3_FUNC_COLD;
+  bool post_config_dictionary_message(c3_dictionary_t dictionary) C3_FUNC_COLD;
+  bool post_config_exploration_rate_message(c3_uint_t rate) C3_FUNC_COLD;
   bool post_queue_capacity_message(c3_uint_t capacity) C3_FUNC_COLD;
   bool post_queue_max_capacity_message(c3_uint_t max_capacity) C3_FUNC_COLD;
   bool post_quit_message() C3_FUNC_COLD;
+  bool post_recompression_result(RecompressionJob* job);
 
   static void thread_proc(c3_uint_t id, ThreadArgument arg);
 };
@@ -588,9 +696,10 @@ class SessionOptimizer: public Optimizer {
 public:
   SessionOptimizer() noexcept C3_FUNC_COLD;
 
-  void configure(MemoryInterface* host, PayloadObjectStore* store) C3_FUNC_COLD {
+  void configure(MemoryInterface* host, PayloadObjectStore* store, RecompressionPool* pool) C3_FUNC_COLD {
     set_host(host);
     set_store(store);
+    set_recompression_pool(pool);
   }
   const c3_uint_t* get_first_write_lifetimes() const { return so_first_write_lifetimes; }
   const c3_uint_t* get_first_write_nums() const { return so_first_write_nums; }
@@ -603,7 +712,7 @@ public:
   bool post_session_read_extra_lifetimes_message(const c3_uint_t* lifetimes) C3_FUNC_COLD;
 };
 
-class TagStore;
+class ShardedTagStore;
 
 /// Specialized optimizer for the session domain
 class PageOptimizer: public Optimizer {
@@ -614,16 +723,16 @@ class PageOptimizer: public Optimizer {
   static const c3_timestamp_t po_default_read_extra_lifetimes[UA_NUMBER_OF_ELEMENTS];
   static const c3_timestamp_t po_default_max_lifetimes[UA_NUMBER_OF_ELEMENTS];
 
-  c3_timestamp_t po_default_lifetimes[UA_NUMBER_OF_ELEMENTS];    // default lifetimes for FPC records
-  c3_timestamp_t po_read_extra_lifetimes[UA_NUMBER_OF_ELEMENTS]; // intervals to add to FPC records on reads
-  c3_timestamp_t po_max_lifetimes[UA_NUMBER_OF_ELEMENTS];        // maximum allowed lifetimes for FPC records
-  TagStore*      po_tag_store;                                   // pointer to associated tag manager
+  c3_timestamp_t   po_default_lifetimes[UA_NUMBER_OF_ELEMENTS];    // default lifetimes for FPC records
+  c3_timestamp_t   po_read_extra_lifetimes[UA_NUMBER_OF_ELEMENTS]; // intervals to add to FPC records on reads
+  c3_timestamp_t   po_max_lifetimes[UA_NUMBER_OF_ELEMENTS];        // maximum allowed lifetimes for FPC records
+  ShardedTagStore* po_tag_store;                                   // pointer to associated tag manager
 
-  TagStore& get_tag_manager() const {
+  ShardedTagStore& get_tag_manager() const {
     c3_assert(po_tag_store);
     return *po_tag_store;
   }
-  void set_tag_manager(TagStore* store) {
+  void set_tag_manager(ShardedTagStore* store) {
     c3_assert(store && po_tag_store == nullptr);
     po_tag_store = store;
   }
@@ -641,10 +750,12 @@ class PageOptimizer: public Optimizer {
 public:
   PageOptimizer() noexcept C3_FUNC_COLD;
 
-  void configure(MemoryInterface* host, PayloadObjectStore* object_store, TagStore* tag_store) C3_FUNC_COLD {
+  void configure(MemoryInterface* host, PayloadObjectStore* object_store, ShardedTagStore* tag_store,
+    RecompressionPool* pool) C3_FUNC_COLD {
     set_host(host);
     set_store(object_store);
     set_tag_manager(tag_store);
+    set_recompression_pool(pool);
   }
   const c3_uint_t* get_default_lifetimes() const { return po_default_lifetimes; }
   const c3_uint_t* get_read_extra_lifetimes() const { return po_read_extra_lifetimes; }
@@ -20,8 +20,120 @@
 #include "pl_net_configuration.h"
 #include "pl_socket_pipelines.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace CyberCache {
 
+bool PageObjectStore::get_page_keys(ListChunk& ids, page_key_t*& keys, c3_uint_t& num) {
+  if (ids.is_valid()) {
+    num = ids.get_count();
+    keys = num > 0? (page_key_t*) fpc_memory.alloc(num * sizeof(page_key_t)): nullptr;
+    for (c3_uint_t i = 0; i < num; i++) {
+      StringChunk id = ids.get_string();
+      if (!id.is_valid_name()) {
+        free_page_keys(keys, num);
+        return false;
+      }
+      page_key_t& key = keys[i];
+      key.pk_chars = id.get_chars();
+      key.pk_length = id.get_short_length();
+      key.pk_hash = table_hasher.hash(key.pk_chars, key.pk_length);
+      key.pk_table = get_table_index(key.pk_hash);
+    }
+    // group keys by tables, so that multi-key commands would lock each table only once
+    std::sort(keys, keys + num, [](const page_key_t& a, const page_key_t& b) {
+      return a.pk_table < b.pk_table;
+    });
+    return true;
+  }
+  return false;
+}
+
+void PageObjectStore::free_page_keys(page_key_t* keys, c3_uint_t num) {
+  if (keys != nullptr) {
+    fpc_memory.free(keys, num * sizeof(page_key_t));
+  }
+}
+
+bool PageObjectStore::get_page_data(PayloadListChunkBuilder& list, const page_key_t& key, const PageObject* po,
+  page_data_t& data) {
+  /*
+   * Records can be compressed with different compressors, while list response can only have one
+   * compressor for its entire payload, so we have to unpack record data before adding them to the list
+   * (the list itself may then get compressed as a whole). This method is called with table and object
+   * locks held, so compressed data are only copied here, and then unpacked by `add_page_data()` after
+   * the locks are released.
+   */
+  data.pd_buffer = nullptr;
+  c3_uint_t usize = po->get_buffer_usize();
+  if (usize == 0) {
+    return list.add(key.pk_length, key.pk_chars) && list.add(0, "");
+  }
+  c3_uint_t size = po->get_buffer_size();
+  c3_byte_t* buffer = po->get_buffer_bytes(0, size);
+  c3_compressor_t compressor = po->get_buffer_compressor();
+  if (compressor == CT_NONE) {
+    return list.add(key.pk_length, key.pk_chars) && list.add(usize, (const char*) buffer);
+  }
+  data.pd_key = &key;
+  data.pd_buffer = (c3_byte_t*) fpc_memory.alloc(size);
+  std::memcpy(data.pd_buffer, buffer, size);
+  data.pd_size = size;
+  data.pd_usize = usize;
+  data.pd_compressor = compressor;
+  data.pd_dictionary = po->get_buffer_dictionary();
+  return true;
+}
+
+bool PageObjectStore::add_page_data(PayloadListChunkBuilder& list, page_data_t& data) {
+  c3_assert(data.pd_key && data.pd_buffer);
+  bool result = false;
+  if (list.add(data.pd_key->pk_length, data.pd_key->pk_chars)) {
+    c3_byte_t* unpacked = global_compressor.unpack(data.pd_compressor, data.pd_buffer, data.pd_size,
+      data.pd_usize, fpc_memory, data.pd_dictionary);
+    if (unpacked != nullptr) {
+      result = list.add(data.pd_usize, (const char*) unpacked);
+      fpc_memory.free(unpacked, data.pd_usize);
+    }
+  }
+  fpc_memory.free(data.pd_buffer, data.pd_size);
+  data.pd_buffer = nullptr;
+  return result;
+}
+
+bool PageObjectStore::get_save_info(CommandReader& cr, page_key_t& key, payload_info_t& pi) {
+  CommandHeaderIterator iterator(cr);
+  StringChunk id = iterator.get_string();
+  if (id.is_valid_name()) {
+    NumberChunk agent = iterator.get_number();
+    if (agent.is_valid_uint() && agent.get_uint() < UA_NUMBER_OF_ELEMENTS) {
+      NumberChunk lifetime = iterator.get_number();
+      if (lifetime.is_in_range(-1, UINT_MAX_VAL)) {
+        ListChunk tags = iterator.get_list();
+        if (tags.is_valid()) {
+          c3_uint_t ntags = tags.get_count();
+          for (c3_uint_t i = 0; i < ntags; i++) {
+            StringChunk tag = tags.get_string();
+            if (!tag.is_valid_name()) {
+              return false;
+            }
+          }
+          if (!iterator.has_more_chunks() && cr.get_payload_info(pi)) {
+            c3_assert(!pi.pi_has_errors);
+            key.pk_chars = id.get_chars();
+            key.pk_length = id.get_short_length();
+            key.pk_hash = table_hasher.hash(key.pk_chars, key.pk_length);
+            key.pk_table = get_table_index(key.pk_hash);
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
 bool PageObjectStore::remove_fpc_record(const StringChunk& id, CommandReader& cr) {
   c3_hash_t hash = table_hasher.hash(id.get_chars(), id.get_length());
   TableLock lock(*this, hash);
@@ -271,6 +383,126 @@ bool PageObjectStore::process_save_command(CommandReader& cr) {
   return true;
 }
 
+bool PageObjectStore::insert_loaded_record(CommandReader& cr) {
+  c3_assert(cr.get_command_id() == CMD_SAVE && !cr.is_set(IO_FLAG_NETWORK));
+  page_key_t key;
+  payload_info_t pi;
+  if (get_save_info(cr, key, pi)) {
+    // tables had been pre-sized for the whole database, so they are locked exclusively right away
+    TableLock lock(*this, key.pk_hash, true);
+    HashTable& table = lock.get_table();
+    if (table.find(key.pk_hash, key.pk_chars, key.pk_length) == nullptr) {
+      auto po = (PageObject*) fpc_memory.alloc(PageObject::calculate_size(key.pk_length));
+      new (po) PageObject(key.pk_hash, key.pk_chars, key.pk_length);
+      po->lock();
+      lock.downgrade_lock(table.add(po));
+      cr.command_reader_transfer_payload(po, DOMAIN_FPC, pi.pi_usize, pi.pi_compressor);
+      po->unlock();
+      // tags are linked by the tag manager, exactly as they are for `SAVE` commands
+      get_tag_manager().post_command_message(cr.clone(false), po);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PageObjectStore::process_save_commands(CommandReader** crs, c3_uint_t num) {
+  c3_assert(crs || num == 0);
+  if (num == 0) {
+    return true;
+  }
+  auto saves = (page_save_t*) fpc_memory.alloc(num * sizeof(page_save_t));
+  for (c3_uint_t i = 0; i < num; i++) {
+    page_save_t& save = saves[i];
+    if (!get_save_info(*crs[i], save.ps_key, save.ps_info)) {
+      fpc_memory.free(saves, num * sizeof(page_save_t));
+      return false;
+    }
+    save.ps_reader = crs[i];
+    save.ps_object = nullptr;
+    save.ps_superseded = false;
+  }
+  /*
+   * Group records by tables, so that each table would be locked only once; within a table, `SAVE`s of
+   * the same record end up next to each other, in the order in which they were sent, and only the last
+   * one is executed (we could not lock the same record twice anyway). Different IDs may have the same
+   * hash code, so IDs themselves are compared as well, lest their `SAVE`s would get interleaved.
+   */
+  std::stable_sort(saves, saves + num, [](const page_save_t& a, const page_save_t& b) {
+    const page_key_t& ka = a.ps_key;
+    const page_key_t& kb = b.ps_key;
+    if (ka.pk_table != kb.pk_table) {
+      return ka.pk_table < kb.pk_table;
+    }
+    if (ka.pk_hash != kb.pk_hash) {
+      return ka.pk_hash < kb.pk_hash;
+    }
+    if (ka.pk_length != kb.pk_length) {
+      return ka.pk_length < kb.pk_length;
+    }
+    return std::memcmp(ka.pk_chars, kb.pk_chars, ka.pk_length) < 0;
+  });
+  for (c3_uint_t i = 1; i < num; i++) {
+    const page_key_t& prev = saves[i - 1].ps_key;
+    const page_key_t& key = saves[i].ps_key;
+    if (prev.pk_hash == key.pk_hash && prev.pk_length == key.pk_length &&
+      std::memcmp(prev.pk_chars, key.pk_chars, key.pk_length) == 0) {
+      saves[i - 1].ps_superseded = true;
+    }
+  }
+  c3_uint_t i = 0;
+  while (i < num) {
+    c3_uint_t first = i;
+    c3_uint_t index = saves[i].ps_key.pk_table;
+    bool resized = false;
+    // most `SAVE`s of a batch are expected to create new records, so the table is locked exclusively
+    TableLock lock(*this, saves[i].ps_key.pk_hash, true);
+    HashTable& table = lock.get_table();
+    do {
+      page_save_t& save = saves[i];
+      if (!save.ps_superseded) {
+        const page_key_t& key = save.ps_key;
+        auto po = (PageObject*) table.find(key.pk_hash, key.pk_chars, key.pk_length);
+        bool locked = false;
+        if (po != nullptr && po->flags_are_clear(HOF_BEING_DELETED)) {
+          locked = po->lock();
+        }
+        if (po == nullptr || po->flags_are_set(HOF_BEING_DELETED)) {
+          if (locked) {
+            // the object could have been marked as "deleted" while we were locking it
+            po->unlock();
+          }
+          po = (PageObject*) fpc_memory.alloc(PageObject::calculate_size(key.pk_length));
+          new (po) PageObject(key.pk_hash, key.pk_chars, key.pk_length);
+          locked = po->lock();
+          if (table.add(po)) {
+            resized = true;
+          }
+        }
+        c3_assert(po && po->get_type() == HOT_PAGE_OBJECT && locked);
+        save.ps_object = po;
+      }
+    } while (++i < num && saves[i].ps_key.pk_table == index);
+    // see comments in the `WRITE` command implementation for reasons for downgrading the lock here
+    lock.downgrade_lock(resized);
+    for (c3_uint_t j = first; j < i; j++) {
+      page_save_t& save = saves[j];
+      if (!save.ps_superseded) {
+        PageObject* po = save.ps_object;
+        // no-op for records created above, as no other thread could have started reading them
+        po->wait_until_no_readers();
+        save.ps_reader->command_reader_transfer_payload(po, DOMAIN_FPC,
+          save.ps_info.pi_usize, save.ps_info.pi_compressor);
+        po->unlock();
+        // see comments in `process_save_command()` on why tag manager gets a copy of the command
+        get_tag_manager().post_command_message(save.ps_reader->clone(false), po);
+      }
+    }
+  }
+  fpc_memory.free(saves, num * sizeof(page_save_t));
+  return true;
+}
+
 bool PageObjectStore::process_remove_command(CommandReader& cr) {
   command_status_t status = CS_FORMAT_ERROR;
   CommandHeaderIterator iterator(cr);
@@ -294,6 +526,183 @@ bool PageObjectStore::process_remove_command(CommandReader& cr) {
   return true;
 }
 
+bool PageObjectStore::process_mload_command(CommandReader& cr) {
+  /*
+   * RESPONSE: `LIST` response with pairs of strings (record ID, record data) for all records that were
+   * found, or `ERROR` response in case of format error.
+   */
+  command_status_t status = CS_FORMAT_ERROR;
+  CommandHeaderIterator iterator(cr);
+  ListChunk ids = iterator.get_list();
+  page_key_t* keys;
+  c3_uint_t num;
+  if (get_page_keys(ids, keys, num)) {
+    NumberChunk agent = iterator.get_number();
+    if (agent.is_valid_uint() && agent.get_uint() < UA_NUMBER_OF_ELEMENTS && !iterator.has_more_chunks()) {
+      auto ua = (user_agent_t) agent.get_uint();
+      SocketResponseWriter* srw = ResponseObjectConsumer::create_response(cr);
+      PayloadListChunkBuilder list(*srw, server_net_config, 0, num * 2, 0);
+      // compressed data of the records found in current table, to be unpacked after it is unlocked
+      auto packed = num > 0? (page_data_t*) fpc_memory.alloc(num * sizeof(page_data_t)): nullptr;
+      status = CS_SUCCESS;
+      c3_uint_t i = 0;
+      while (i < num && status == CS_SUCCESS) {
+        c3_uint_t npacked = 0;
+        {
+          TableLock lock(*this, keys[i].pk_hash);
+          HashTable& table = lock.get_table();
+          c3_uint_t index = keys[i].pk_table;
+          do {
+            const page_key_t& key = keys[i];
+            bool found = false;
+            auto po = (PageObject*) table.find(key.pk_hash, key.pk_chars, key.pk_length);
+            if (po != nullptr && po->flags_are_clear(HOF_BEING_DELETED)) {
+              c3_assert(po->get_type() == HOT_PAGE_OBJECT);
+              LockableObjectGuard guard(po);
+              // the object could have been deleted while we were trying to lock it
+              if (guard.is_locked() && po->flags_are_clear(HOF_BEING_DELETED)) {
+                if (get_page_data(list, key, po, packed[npacked])) {
+                  guard.unlock();
+                  if (packed[npacked].pd_buffer != nullptr) {
+                    npacked++;
+                  }
+                  // notify optimizer
+                  get_optimizer().post_read_message(po, ua);
+                  found = true;
+                } else {
+                  status = CS_INTERNAL_ERROR;
+                }
+              }
+            }
+            if (found) {
+              PERF_INCREMENT_DOMAIN_COUNTER(FPC, Cache_Hits)
+            } else {
+              PERF_INCREMENT_DOMAIN_COUNTER(FPC, Cache_Misses)
+            }
+          } while (++i < num && keys[i].pk_table == index && status == CS_SUCCESS);
+        }
+        // the table is not locked anymore, so unpacking does not hold up other requests to it
+        for (c3_uint_t j = 0; j < npacked; j++) {
+          if (!add_page_data(list, packed[j]) && status == CS_SUCCESS) {
+            status = CS_INTERNAL_ERROR;
+          }
+        }
+      }
+      if (packed != nullptr) {
+        fpc_memory.free(packed, num * sizeof(page_data_t));
+      }
+      if (status == CS_SUCCESS) {
+        free_page_keys(keys, num);
+        return get_consumer().post_list_response(srw, list);
+      }
+      ReaderWriter::dispose(srw);
+    }
+    free_page_keys(keys, num);
+  }
+  if (status == CS_FORMAT_ERROR) {
+    return get_consumer().post_format_error_response(cr);
+  }
+  return get_consumer().post_internal_error_response(cr);
+}
+
+bool PageObjectStore::process_mtest_command(CommandReader& cr) {
+  /*
+   * RESPONSE: `LIST` response with pairs of strings (record ID, last modification time) for all records
+   * that were found, or `ERROR` response in case of format error.
+   */
+  command_status_t status = CS_FORMAT_ERROR;
+  CommandHeaderIterator iterator(cr);
+  ListChunk ids = iterator.get_list();
+  page_key_t* keys;
+  c3_uint_t num;
+  if (get_page_keys(ids, keys, num)) {
+    NumberChunk agent = iterator.get_number();
+    if (agent.is_valid_uint() && agent.get_uint() < UA_NUMBER_OF_ELEMENTS && !iterator.has_more_chunks()) {
+      auto ua = (user_agent_t) agent.get_uint();
+      SocketResponseWriter* srw = ResponseObjectConsumer::create_response(cr);
+      PayloadListChunkBuilder list(*srw, server_net_config, 0, num * 2, 0);
+      status = CS_SUCCESS;
+      c3_uint_t i = 0;
+      while (i < num && status == CS_SUCCESS) {
+        TableLock lock(*this, keys[i].pk_hash);
+        HashTable& table = lock.get_table();
+        c3_uint_t index = keys[i].pk_table;
+        do {
+          const page_key_t& key = keys[i];
+          auto po = (PageObject*) table.find(key.pk_hash, key.pk_chars, key.pk_length);
+          if (po != nullptr && po->flags_are_clear(HOF_BEING_DELETED)) {
+            c3_assert(po->get_type() == HOT_PAGE_OBJECT);
+            LockableObjectGuard guard(po);
+            // the object could have been deleted while we were trying to lock it
+            if (guard.is_locked() && po->flags_are_clear(HOF_BEING_DELETED)) {
+              if (list.add(key.pk_length, key.pk_chars) && list.addf("%u", po->get_last_modification_time())) {
+                guard.unlock();
+                // notify optimizer
+                get_optimizer().post_read_message(po, ua);
+              } else {
+                status = CS_INTERNAL_ERROR;
+              }
+            }
+          }
+        } while (++i < num && keys[i].pk_table == index && status == CS_SUCCESS);
+      }
+      if (status == CS_SUCCESS) {
+        free_page_keys(keys, num);
+        return get_consumer().post_list_response(srw, list);
+      }
+      ReaderWriter::dispose(srw);
+    }
+    free_page_keys(keys, num);
+  }
+  if (status == CS_FORMAT_ERROR) {
+    return get_consumer().post_format_error_response(cr);
+  }
+  return get_consumer().post_internal_error_response(cr);
+}
+
+bool PageObjectStore::process_mremove_command(CommandReader& cr) {
+  /*
+   * Each removed record is sent to the tag manager along with its own "abridged" copy of the command
+   * (see comments in `process_save_command()`), because tag manager disposes command objects it receives.
+   *
+   * RESPONSE: `OK` response even if some (or all) records did not exist, or `ERROR` response in case of
+   * format error.
+   */
+  CommandHeaderIterator iterator(cr);
+  ListChunk ids = iterator.get_list();
+  page_key_t* keys;
+  c3_uint_t num;
+  if (get_page_keys(ids, keys, num)) {
+    if (!iterator.has_more_chunks() && !PayloadChunkIterator::has_payload_data(cr)) {
+      c3_uint_t i = 0;
+      while (i < num) {
+        TableLock lock(*this, keys[i].pk_hash);
+        HashTable& table = lock.get_table();
+        c3_uint_t index = keys[i].pk_table;
+        do {
+          const page_key_t& key = keys[i];
+          auto po = (PageObject*) table.find(key.pk_hash, key.pk_chars, key.pk_length);
+          if (po != nullptr && po->flags_are_clear(HOF_BEING_DELETED)) {
+            LockableObjectGuard guard(po);
+            if (guard.is_locked() && po->flags_are_clear(HOF_BEING_DELETED)) {
+              po->set_flags(HOF_BEING_DELETED);
+              // see comments in `remove_fpc_record()`
+              po->try_dispose_buffer(fpc_memory);
+              guard.unlock();
+              // it is tag manager that will send "delete" message to FPC optimizer
+              get_tag_manager().post_command_message(cr.clone(false), po);
+            }
+          }
+        } while (++i < num && keys[i].pk_table == index);
+      }
+      free_page_keys(keys, num);
+      return get_consumer().post_ok_response(cr);
+    }
+    free_page_keys(keys, num);
+  }
+  return get_consumer().post_format_error_response(cr);
+}
+
 bool PageObjectStore::process_getfillingpercentage_command(CommandReader& cr) {
   if (!ChunkIterator::has_any_data(cr)) {
     c3_uint_t percentage = 0;
@@ -397,7 +806,11 @@ FileCommandWriter* PageObjectStore::create_file_command_writer(PayloadHashObject
   c3_assert(pho && pho->flags_are_clear(HOF_BEING_DELETED) && pho->get_type() == HOT_PAGE_OBJECT && pho->is_locked());
   Memory& memory = get_memory_object();
   SharedObjectBuffers* sob = SharedObjectBuffers::create_object(memory);
-  sob->attach_payload(pho);
+  // buffers compressed using dictionaries are saved unpacked, so that database files would not depend on them
+  bool unpack = pho->get_buffer_dictionary() != CDICT_NONE;
+  if (!unpack) {
+    sob->attach_payload(pho);
+  }
   auto fcw = alloc<FileCommandWriter>(memory);
   new (fcw) FileCommandWriter(memory, 0, sob);
   CommandHeaderChunkBuilder header(*fcw, server_net_config, CMD_SAVE, false);
@@ -431,14 +844,20 @@ FileCommandWriter* PageObjectStore::create_file_command_writer(PayloadHashObject
       header.estimate_number(lifetime) != 0 &&
       header.estimate_list(list) != 0) {
       PayloadChunkBuilder payload(*fcw, server_net_config);
-      payload.add();
-      header.configure(&payload);
-      header.add_string(id_buff, id_len);
-      header.add_number(ua);
-      header.add_number(lifetime);
-      header.add_list(list);
-      header.check();
-      return fcw;
+      if (unpack) {
+        ok = po->add_unpacked_payload(payload, memory);
+      } else {
+        payload.add();
+      }
+      if (ok) {
+        header.configure(&payload);
+        header.add_string(id_buff, id_len);
+        header.add_number(ua);
+        header.add_number(lifetime);
+        header.add_list(list);
+        header.check();
+        return fcw;
+      }
     }
   }
   ReaderWriter::dispose(fcw);
@@ -463,6 +882,15 @@ bool PageObjectStore::process_command(CommandReader* cr) {
     case CMD_REMOVE:
       do_dispose = process_remove_command(*cr);
       break;
+    case CMD_MLOAD:
+      result = process_mload_command(*cr);
+      break;
+    case CMD_MTEST:
+      result = process_mtest_command(*cr);
+      break;
+    case CMD_MREMOVE:
+      result = process_mremove_command(*cr);
+      break;
     case CMD_GETFILLINGPERCENTAGE:
       result = process_getfillingpercentage_command(*cr);
       break;
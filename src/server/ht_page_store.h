@@ -26,7 +26,7 @@ namespace CyberCache {
 
 class Optimizer;
 class PageOptimizer;
-class TagStore;
+class ShardedTagStore;
 class CommandReader;
 
 /// Global storage of FPC data
@@ -37,9 +37,9 @@ class PageObjectStore: public PayloadObjectStore {
   static constexpr c3_uint_t DEFAULT_QUEUE_CAPACITY = 32;
   static constexpr c3_uint_t DEFAULT_MAX_QUEUE_CAPACITY = 2048;
 
-  TagStore* pos_tag_manager; // reference to the tag manager of the FPC domain
+  ShardedTagStore* pos_tag_manager; // reference to the tag manager of the FPC domain
 
-  TagStore& get_tag_manager() const {
+  ShardedTagStore& get_tag_manager() const {
     c3_assert(pos_tag_manager);
     return *pos_tag_manager;
   }
@@ -47,12 +47,48 @@ class PageObjectStore: public PayloadObjectStore {
     return *(PageOptimizer*)&(get_optimizer());
   }
 
+  /// Record ID passed to a multi-key command, along with information needed to find the record
+  struct page_key_t {
+    const char* pk_chars;  // characters of the ID (*not* '\0'-terminated)
+    c3_hash_t   pk_hash;   // hash code of the ID
+    c3_uint_t   pk_table;  // index of the table that would contain the record
+    c3_ushort_t pk_length; // length of the ID
+  };
+
+  /// Compressed data of a record found by `MLOAD`, copied so that they could be unpacked outside of locks
+  struct page_data_t {
+    const page_key_t* pd_key;        // ID of the record
+    c3_byte_t*        pd_buffer;     // copy of compressed record data
+    c3_uint_t         pd_size;       // size of compressed data
+    c3_uint_t         pd_usize;      // size of data once they are unpacked
+    c3_compressor_t   pd_compressor; // compressor that was used to pack the data
+    c3_dictionary_t   pd_dictionary; // dictionary that was used to pack the data
+  };
+
+  /// A `SAVE` command that is part of an `MSAVE` batch
+  struct page_save_t {
+    page_key_t     ps_key;        // ID of the record, along with information needed to find it
+    payload_info_t ps_info;       // record data
+    CommandReader* ps_reader;     // the `SAVE` command
+    PageObject*    ps_object;     // locked record, once it is found or created
+    bool           ps_superseded; // `true` if a later `SAVE` in the same batch targets the same record
+  };
+
+  bool get_page_keys(ListChunk& ids, page_key_t*& keys, c3_uint_t& num);
+  static void free_page_keys(page_key_t* keys, c3_uint_t num);
+  bool get_page_data(PayloadListChunkBuilder& list, const page_key_t& key, const PageObject* po,
+    page_data_t& data);
+  static bool add_page_data(PayloadListChunkBuilder& list, page_data_t& data);
+  bool get_save_info(CommandReader& cr, page_key_t& key, payload_info_t& pi);
   bool remove_fpc_record(const StringChunk& id, CommandReader& cr);
 
   bool process_load_command(CommandReader& cr);
   bool process_test_command(CommandReader& cr);
   bool process_save_command(CommandReader& cr);
   bool process_remove_command(CommandReader& cr);
+  bool process_mload_command(CommandReader& cr);
+  bool process_mtest_command(CommandReader& cr);
+  bool process_mremove_command(CommandReader& cr);
   bool process_getfillingpercentage_command(CommandReader& cr);
   bool process_getmetadatas_command(CommandReader& cr);
   bool process_touch_command(CommandReader& cr);
@@ -66,7 +102,7 @@ public:
 
   FileCommandWriter* create_file_command_writer(PayloadHashObject* pho, c3_timestamp_t time) override;
 
-  void configure(ResponseObjectConsumer* consumer, Optimizer* optimizer, TagStore* tag_manager) C3_FUNC_COLD {
+  void configure(ResponseObjectConsumer* consumer, Optimizer* optimizer, ShardedTagStore* tag_manager) C3_FUNC_COLD {
     c3_assert(tag_manager && pos_tag_manager == nullptr);
     set_consumer(consumer);
     set_optimizer(optimizer);
@@ -80,6 +116,20 @@ public:
     dispose_payload_object_store();
   }
 
+  /**
+   * Adds FPC record loaded from a database segment directly to its table, bypassing command dispatching,
+   * authentication, and responses; tags are still linked by the tag manager. Returns `false` if the
+   * command was not a well-formed `SAVE` of a record that is not in the store yet; the caller should
+   * then process it as a regular command. Command reader is never disposed by this method.
+   */
+  bool insert_loaded_record(CommandReader& cr);
+  /**
+   * Executes `SAVE` commands unpacked from an `MSAVE` batch; all commands are validated before any
+   * record is modified, and then each hash table is locked only once for all records that belong to it.
+   * Returns `false` if any of the commands is ill-formed. Command readers are never disposed by this
+   * method.
+   */
+  bool process_save_commands(CommandReader** crs, c3_uint_t num);
   bool process_command(CommandReader* cr);
 };
 
@@ -0,0 +1,345 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include "ht_recompressor.h"
+#include "ht_optimizer.h"
+
+namespace CyberCache {
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressorModel
+///////////////////////////////////////////////////////////////////////////////
+
+CompressorModel::CompressorModel(domain_t domain) noexcept: cm_domain(domain) {
+  cm_exploration_rate = DEFAULT_EXPLORATION_RATE;
+  reset();
+}
+
+void CompressorModel::set_exploration_rate(c3_uint_t rate) {
+  c3_assert(rate <= 100);
+  cm_exploration_rate = rate;
+}
+
+void CompressorModel::reset() {
+  std::memset(cm_stats, 0, sizeof cm_stats);
+  cm_exploration_credit = 0;
+}
+
+c3_uint_t CompressorModel::get_size_bucket(c3_uint_t usize) {
+  c3_uint_t bucket = 0;
+  c3_ulong_t threshold = FIRST_BUCKET_SIZE;
+  while (usize >= threshold && bucket < NUM_SIZE_BUCKETS - 1) {
+    bucket++;
+    threshold <<= 2;
+  }
+  return bucket;
+}
+
+bool CompressorModel::is_exploration_due() {
+  // spread exploration attempts evenly instead of doing them in bursts
+  cm_exploration_credit += cm_exploration_rate;
+  if (cm_exploration_credit >= 100) {
+    cm_exploration_credit -= 100;
+    return true;
+  }
+  return false;
+}
+
+c3_uint_t CompressorModel::select(const c3_compressor_t* compressors, c3_compressor_t* selected,
+  c3_uint_t num, user_agent_t ua, c3_uint_t usize, c3_compressor_t current) {
+  c3_assert(compressors && selected && num && ua < UA_NUMBER_OF_ELEMENTS && usize);
+  const compressor_stats_t* stats = cm_stats[ua][get_size_bucket(usize)];
+  c3_uint_t num_configured = 0;
+  bool explore = is_exploration_due();
+  while (num_configured < num) {
+    c3_compressor_t compressor = compressors[num_configured];
+    if (compressor == CT_NONE) {
+      break;
+    }
+    c3_assert(compressor < CT_NUMBER_OF_ELEMENTS);
+    if (compressor != current && stats[compressor].cs_num_attempts < MIN_NUM_ATTEMPTS) {
+      explore = true;
+    }
+    num_configured++;
+  }
+  std::memset(selected, CT_NONE, num * sizeof(c3_compressor_t));
+  if (explore) {
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(cm_domain, Optimizer_Recompressions_Explored)
+    std::memcpy(selected, compressors, num_configured * sizeof(c3_compressor_t));
+    return num_configured;
+  }
+
+  // expected savings are calculated in 1/65536ths of uncompressed data size
+  c3_compressor_t best_compressor = CT_NONE;
+  c3_ulong_t best_savings = 0;
+  c3_ulong_t savings[CT_NUMBER_OF_ELEMENTS];
+  for (c3_uint_t i = 0; i < num_configured; i++) {
+    c3_compressor_t compressor = compressors[i];
+    const compressor_stats_t& cs = stats[compressor];
+    savings[compressor] = cs.cs_usize != 0? (cs.cs_saved << 16) / cs.cs_usize: 0;
+    if (savings[compressor] > best_savings) {
+      best_compressor = compressor;
+      best_savings = savings[compressor];
+    }
+  }
+  if (best_compressor == CT_NONE) {
+    // no compressor is expected to improve compression ratio
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(cm_domain, Optimizer_Recompressions_Skipped)
+    return 0;
+  }
+  // among compressors that are almost as good, prefer the fastest one
+  c3_ulong_t min_savings = best_savings - best_savings / SAVINGS_TOLERANCE;
+  c3_ulong_t best_time = stats[best_compressor].cs_nanoseconds / stats[best_compressor].cs_num_attempts;
+  for (c3_uint_t i = 0; i < num_configured; i++) {
+    c3_compressor_t compressor = compressors[i];
+    if (savings[compressor] >= min_savings) {
+      const compressor_stats_t& cs = stats[compressor];
+      c3_ulong_t time = cs.cs_nanoseconds / cs.cs_num_attempts;
+      if (time < best_time) {
+        best_compressor = compressor;
+        best_time = time;
+      }
+    }
+  }
+  if (best_compressor == current) {
+    // object's data had already been packed with the most promising compressor
+    PERF_INCREMENT_VAR_DOMAIN_COUNTER(cm_domain, Optimizer_Recompressions_Skipped)
+    return 0;
+  }
+  selected[0] = best_compressor;
+  return 1;
+}
+
+void CompressorModel::update(user_agent_t ua, c3_compressor_t compressor, c3_uint_t usize, c3_uint_t size,
+  c3_uint_t new_size, c3_ulong_t nanoseconds) {
+  c3_assert(ua < UA_NUMBER_OF_ELEMENTS && compressor > CT_NONE && compressor < CT_NUMBER_OF_ELEMENTS &&
+    usize && size && new_size < size);
+  compressor_stats_t& cs = cm_stats[ua][get_size_bucket(usize)][compressor];
+  if (cs.cs_num_attempts >= MAX_NUM_ATTEMPTS) {
+    cs.cs_usize >>= 1;
+    cs.cs_saved >>= 1;
+    cs.cs_nanoseconds >>= 1;
+    cs.cs_num_attempts >>= 1;
+  }
+  cs.cs_usize += usize;
+  if (new_size != 0) {
+    cs.cs_saved += size - new_size;
+  }
+  cs.cs_nanoseconds += nanoseconds;
+  cs.cs_num_attempts++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RecompressionJob
+///////////////////////////////////////////////////////////////////////////////
+
+void RecompressionJob::prepare(Optimizer* optimizer, Memory& memory, PayloadHashObject* pho,
+  const c3_compressor_t* compressors, c3_dictionary_t dictionary) {
+  c3_assert(is_free() && optimizer && pho && pho->is_locked() && compressors);
+  c3_uint_t size = pho->get_buffer_size();
+  c3_uint_t usize = pho->get_buffer_usize();
+  c3_compressor_t compressor = pho->get_buffer_compressor();
+  c3_byte_t* buffer = pho->get_buffer_bytes(0, size);
+  c3_assert(size && usize &&
+    ((compressor == CT_NONE && size == usize) || (compressor != CT_NONE && size < usize)) &&
+    compressor < CT_NUMBER_OF_ELEMENTS && buffer);
+  rj_optimizer = optimizer;
+  rj_object = pho;
+  rj_memory = &memory;
+  rj_buffer = (c3_byte_t*) std::memcpy(memory.alloc(size), buffer, size);
+  rj_size = size;
+  rj_usize = usize;
+  rj_snapshot_size = size;
+  rj_num_attempts = 0;
+  rj_compressor = compressor;
+  rj_dictionary = pho->get_buffer_dictionary();
+  std::memcpy(rj_compressors, compressors, sizeof rj_compressors);
+  rj_try_dictionary = dictionary;
+  rj_user_agent = pho->get_user_agent();
+  rj_unlink_pending = false;
+}
+
+void RecompressionJob::execute() {
+  c3_assert(!is_free() && rj_memory && rj_buffer);
+  Memory& memory = *rj_memory;
+  c3_compressor_t compressor = rj_compressor;
+  c3_dictionary_t dictionary = rj_dictionary;
+  c3_uint_t size = rj_size;
+  c3_uint_t usize = rj_usize;
+  c3_byte_t* uncompressed_buffer = compressor == CT_NONE? rj_buffer:
+    global_compressor.unpack(compressor, rj_buffer, size, usize, memory, dictionary);
+
+  /*
+   * If the snapshot had been packed with a dictionary that must not be used anymore (the record became
+   * "hot"), the result only has to be smaller than unpacked data, so that the dictionary could be dropped.
+   */
+  bool drop_dictionary = dictionary != CDICT_NONE && rj_try_dictionary == CDICT_NONE;
+  c3_uint_t max_size = drop_dictionary? usize: size;
+  c3_compressor_t best_compressor = CT_NUMBER_OF_ELEMENTS;
+  c3_dictionary_t best_dictionary = CDICT_NONE;
+  c3_uint_t best_size = max_size;
+  c3_byte_t* compressed_buffer = nullptr;
+  for (c3_uint_t i = 0; i < NUM_COMPRESSORS && uncompressed_buffer != nullptr; i++) {
+    c3_compressor_t try_compressor = rj_compressors[i];
+    if (try_compressor == CT_NONE) {
+      break;
+    }
+    // small buffers are packed using configured dictionary, if compressor supports dictionaries
+    c3_dictionary_t try_dictionary = rj_try_dictionary != CDICT_NONE &&
+      global_compressor.can_use_dictionary(try_compressor, usize)? rj_try_dictionary: CDICT_NONE;
+    // default compression strength is "best", so no reason to try the same compressor twice
+    if (try_compressor != compressor || try_dictionary != dictionary) {
+      /*
+       * Each compressor is given a chance to beat the snapshot (not just the best result so far), so
+       * that statistics collected by the optimizer would not depend on the order of compressors.
+       */
+      c3_uint_t try_size = max_size;
+      c3_long_t start_time = PrecisionTimer::nanoseconds_since_epoch();
+      // compressor returns `NULL` if result is bigger than or equal to `try_size`
+      c3_byte_t* try_buff = global_compressor.pack(try_compressor, uncompressed_buffer,
+        usize, try_size, memory, CL_BEST, CD_DEFAULT, try_dictionary);
+      attempt_t& attempt = rj_attempts[rj_num_attempts++];
+      attempt.a_nanoseconds = (c3_ulong_t) PrecisionTimer::nanoseconds_since(start_time);
+      attempt.a_size = try_buff != nullptr? try_size: 0;
+      attempt.a_compressor = try_compressor;
+      if (try_buff != nullptr && try_size < best_size) {
+        if (compressed_buffer != nullptr) {
+          memory.free(compressed_buffer, best_size);
+        }
+        best_compressor = try_compressor;
+        best_dictionary = try_dictionary;
+        best_size = try_size;
+        compressed_buffer = try_buff;
+        PERF_UPDATE_ARRAY(Recompressions_Succeeded, (c3_uint_t) try_compressor)
+      } else {
+        if (try_buff != nullptr) {
+          memory.free(try_buff, try_size);
+        }
+        PERF_UPDATE_ARRAY(Recompressions_Failed, (c3_uint_t) try_compressor)
+      }
+    }
+  }
+  if (drop_dictionary && compressed_buffer == nullptr && uncompressed_buffer != nullptr) {
+    // no compressor could pack the data without the dictionary, so they will be stored as is
+    best_compressor = CT_NONE;
+    best_size = usize;
+    compressed_buffer = uncompressed_buffer;
+    uncompressed_buffer = nullptr;
+  }
+  if (uncompressed_buffer != rj_buffer && uncompressed_buffer != nullptr) {
+    memory.free(uncompressed_buffer, usize);
+  }
+  memory.free(rj_buffer, size);
+
+  // snapshot is replaced with the best result, if any
+  rj_buffer = compressed_buffer;
+  rj_size = compressed_buffer != nullptr? best_size: 0;
+  rj_compressor = best_compressor;
+  rj_dictionary = best_dictionary;
+}
+
+void RecompressionJob::release() {
+  c3_assert(!is_free() && rj_memory);
+  if (rj_buffer != nullptr) {
+    rj_memory->free(rj_buffer, rj_size);
+    rj_buffer = nullptr;
+  }
+  rj_size = 0;
+  rj_object = nullptr;
+  rj_unlink_pending = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RecompressionPool
+///////////////////////////////////////////////////////////////////////////////
+
+RecompressionPool::RecompressionPool() noexcept:
+  rp_queue(DOMAIN_GLOBAL, HO_OPTIMIZER, DEFAULT_QUEUE_CAPACITY, DEFAULT_QUEUE_CAPACITY) {
+  // jobs of both optimizers, plus "quit" requests
+  static_assert(DEFAULT_QUEUE_CAPACITY >= MAX_NUM_RECOMPRESSION_THREADS * (MAX_JOBS_PER_THREAD * 2 + 1),
+    "Re-compression queue is too small to never block");
+  rp_num_threads.store(0, std::memory_order_relaxed);
+}
+
+bool RecompressionPool::set_num_threads(c3_uint_t num) {
+  c3_assert(Thread::get_id() == TI_MAIN && num <= MAX_NUM_RECOMPRESSION_THREADS);
+  std::lock_guard<std::mutex> lock(rp_mutex);
+  c3_uint_t current_num = get_num_threads();
+  if (num > current_num) {
+    c3_uint_t num_to_start = num - current_num;
+    c3_uint_t num_started = 0;
+    ThreadArgument arg(this);
+    for (c3_uint_t i = TI_FIRST_RECOMPRESSOR; i < TI_FIRST_CONNECTION_THREAD; i++) {
+      // threads that were requested to quit but were not `join()`ed yet will not be "unused"
+      if (Thread::get_state(i) == TS_UNUSED) {
+        Thread::start(i, thread_proc, arg);
+        if (++num_started == num_to_start) {
+          break;
+        }
+      }
+    }
+    rp_num_threads.store(current_num + num_started, std::memory_order_relaxed);
+    if (num_started < num_to_start) {
+      log(LL_ERROR, "Could NOT start %u out of %u re-compression threads",
+        num_to_start - num_started, num_to_start);
+      return false;
+    }
+    log(LL_NORMAL, "Started %u re-compression threads", num_to_start);
+  } else if (num < current_num) {
+    c3_uint_t num_to_stop = current_num - num;
+    /*
+     * We do not know which threads will receive these requests; each of them will complete the job it
+     * is working on (if any), quit, and thread proc wrapper will post thread ID to the configuration
+     * queue as an "ID message", causing main thread to `join()` quitting thread.
+     */
+    for (c3_uint_t i = 0; i < num_to_stop; i++) {
+      c3_assert_def(bool posted) rp_queue.put(RecompressionMessage(true));
+      c3_assert(posted);
+    }
+    rp_num_threads.store(num, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool RecompressionPool::post_job(RecompressionJob* job) {
+  std::lock_guard<std::mutex> lock(rp_mutex);
+  if (get_num_threads() > 0) {
+    return rp_queue.put(RecompressionMessage(job));
+  }
+  return false;
+}
+
+void RecompressionPool::thread_proc(c3_uint_t id, ThreadArgument arg) {
+  Thread::set_state(TS_ACTIVE);
+  auto pool = (RecompressionPool*) arg.get_pointer();
+  assert(pool);
+  pool->log(LL_VERBOSE, "Started re-compression thread [%u]", id);
+  for (;;) {
+    Thread::set_state(TS_IDLE);
+    RecompressionMessage msg = pool->rp_queue.get();
+    if (msg.is_quit_request()) {
+      Thread::set_state(TS_QUITTING);
+      pool->log(LL_VERBOSE, "Re-compression thread [%u] is quitting", id);
+      break;
+    } else if (msg.is_valid()) {
+      Thread::set_state(TS_ACTIVE);
+      RecompressionJob* job = msg.get_job();
+      job->execute();
+      job->get_optimizer().post_recompression_result(job);
+    }
+  }
+}
+
+} // CyberCache
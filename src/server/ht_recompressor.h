@@ -0,0 +1,274 @@
+/*
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Pool of worker threads that re-compress object data on behalf of session and FPC optimizers.
+ */
+#ifndef _HT_RECOMPRESSOR_H
+#define _HT_RECOMPRESSOR_H
+
+#include "c3lib/c3lib.h"
+#include "mt_threads.h"
+#include "mt_message_queue.h"
+#include "ht_objects.h"
+
+namespace CyberCache {
+
+class Optimizer;
+
+/**
+ * Statistics of re-compression attempts made on behalf of an optimizer, used to pick the compressor that
+ * is most likely to improve compression ratio of an object instead of trying all configured compressors.
+ *
+ * Statistics are kept separately for each user agent type and "bucket" of uncompressed data sizes; for
+ * each compressor, the model knows how many bytes it saved (on average, per byte of uncompressed data,
+ * counting failed attempts) and how much time it spent on an attempt. The compressor with the biggest
+ * expected savings is selected; if other compressors are expected to save almost as much, the fastest
+ * of them is selected instead. If selected compressor is the one that was used to pack the object in
+ * the first place, or if no compressor is expected to save anything, re-compression is not attempted.
+ *
+ * To keep the statistics up to date, some re-compression attempts ("exploration" attempts, as opposed
+ * to those of "exploitation") still try all configured compressors; same is done whenever there is not
+ * enough data for an informed choice. The model is not thread-safe, and is only accessed by its
+ * optimizer.
+ */
+class CompressorModel {
+public:
+  /// Default percentage of re-compression attempts that try all configured compressors
+  static constexpr c3_uint_t DEFAULT_EXPLORATION_RATE = 10;
+
+private:
+  /// Number of uncompressed size ranges: <1k, <4k, <16k, <64k, <256k, and bigger
+  static constexpr c3_uint_t NUM_SIZE_BUCKETS = 6;
+  /// Upper bound of the first size range, bytes (each next one is four times bigger)
+  static constexpr c3_uint_t FIRST_BUCKET_SIZE = 1024;
+  /// Minimum number of attempts for the statistics on a compressor to be trusted
+  static constexpr c3_uint_t MIN_NUM_ATTEMPTS = 8;
+  /// Number of attempts upon reaching which statistics on a compressor are halved (so that it could adapt)
+  static constexpr c3_uint_t MAX_NUM_ATTEMPTS = 1024;
+  /// Compressors with expected savings within 1/Nth of the best one are selected based on their speed
+  static constexpr c3_uint_t SAVINGS_TOLERANCE = 16;
+
+  /// Statistics on one compressor for particular user agent type and size range
+  struct compressor_stats_t {
+    c3_ulong_t cs_usize;        // total size of uncompressed data in all attempts
+    c3_ulong_t cs_saved;        // total number of bytes saved by successful attempts
+    c3_ulong_t cs_nanoseconds;  // total time spent on all attempts
+    c3_uint_t  cs_num_attempts; // number of attempts
+  };
+
+  compressor_stats_t cm_stats[UA_NUMBER_OF_ELEMENTS][NUM_SIZE_BUCKETS][CT_NUMBER_OF_ELEMENTS];
+  c3_uint_t          cm_exploration_rate;   // percentage of attempts that try all compressors
+  c3_uint_t          cm_exploration_credit; // accumulated "exploration rate"; explore once it reaches 100%
+  const domain_t     cm_domain;             // domain of the optimizer that owns the model
+
+  static c3_uint_t get_size_bucket(c3_uint_t usize);
+  bool is_exploration_due();
+
+public:
+  explicit CompressorModel(domain_t domain) noexcept C3_FUNC_COLD;
+
+  c3_uint_t get_exploration_rate() const { return cm_exploration_rate; }
+  void set_exploration_rate(c3_uint_t rate) C3_FUNC_COLD;
+  void reset() C3_FUNC_COLD;
+
+  /**
+   * Selects compressor(s) to try on an object.
+   *
+   * @param compressors Configured compressors; list is terminated with `CT_NONE` if it is shorter than
+   *   `num` elements
+   * @param selected Where to store compressor(s) to try; must have room for `num` elements; unused
+   *   elements are set to `CT_NONE`
+   * @param num Number of elements in both arrays
+   * @param ua Type of the user agent that created the object
+   * @param usize Size of object's uncompressed data
+   * @param current Compressor that was used to pack object's data, or `CT_NUMBER_OF_ELEMENTS` if
+   *   re-compressing data with it could still make a difference (e.g. because of a dictionary)
+   * @return Number of selected compressors; zero if re-compression should not be attempted
+   */
+  c3_uint_t select(const c3_compressor_t* compressors, c3_compressor_t* selected, c3_uint_t num,
+    user_agent_t ua, c3_uint_t usize, c3_compressor_t current);
+
+  /**
+   * Updates statistics with results of a re-compression attempt.
+   *
+   * @param ua Type of the user agent that created the object
+   * @param compressor Compressor that had been tried
+   * @param usize Size of uncompressed data
+   * @param size Size of the data before re-compression
+   * @param new_size Size of re-compressed data, or zero if attempt had failed
+   * @param nanoseconds Time spent on the attempt
+   */
+  void update(user_agent_t ua, c3_compressor_t compressor, c3_uint_t usize, c3_uint_t size,
+    c3_uint_t new_size, c3_ulong_t nanoseconds);
+};
+
+/**
+ * Re-compression request submitted by an optimizer. Optimizer takes a snapshot of object's data while
+ * the object is locked, and then hands the job over to a worker thread, which unpacks the snapshot and
+ * tries selected compressors on it. The worker never accesses the object itself: once it is done,
+ * it passes the job back to the optimizer, and it's the optimizer that locks the object again, checks
+ * that the object had not been modified or deleted in the meantime, and installs the new buffer.
+ */
+class RecompressionJob {
+public:
+  /// Maximum number of compression algorithms to try (must match that of the optimizer)
+  static constexpr c3_uint_t NUM_COMPRESSORS = 8;
+
+  /// Result of trying one compressor
+  struct attempt_t {
+    c3_ulong_t      a_nanoseconds; // time spent on the attempt
+    c3_uint_t       a_size;        // size of compressed data, or zero if attempt had failed
+    c3_compressor_t a_compressor;  // compressor that had been tried
+  };
+
+private:
+  Optimizer*         rj_optimizer;                    // optimizer that submitted this job
+  PayloadHashObject* rj_object;                       // object being re-compressed, or NULL if slot is free
+  Memory*            rj_memory;                       // memory object of optimizer's domain
+  c3_byte_t*         rj_buffer;                       // snapshot of the data, then best re-compressed data
+  c3_uint_t          rj_size;                         // size of the data in `rj_buffer`
+  c3_uint_t          rj_usize;                        // size of uncompressed data
+  c3_uint_t          rj_snapshot_size;                // size of the snapshot
+  c3_uint_t          rj_num_attempts;                 // number of elements in `rj_attempts`
+  attempt_t          rj_attempts[NUM_COMPRESSORS];    // results of trying compressors
+  c3_compressor_t    rj_compressor;                   // compressor of the snapshot, then best compressor
+  c3_compressor_t    rj_compressors[NUM_COMPRESSORS]; // compression algorithms to try
+  c3_dictionary_t    rj_dictionary;                   // dictionary of the snapshot, then of the best result
+  c3_dictionary_t    rj_try_dictionary;               // dictionary to try with compressors supporting them
+  user_agent_t       rj_user_agent;                   // type of the user agent that created the object
+  bool               rj_unlink_pending;               // object was deleted while being re-compressed
+
+public:
+  RecompressionJob() {
+    rj_optimizer = nullptr;
+    rj_object = nullptr;
+    rj_memory = nullptr;
+    rj_buffer = nullptr;
+    rj_size = 0;
+    rj_usize = 0;
+    rj_snapshot_size = 0;
+    rj_num_attempts = 0;
+    rj_compressor = CT_NONE;
+    rj_dictionary = CDICT_NONE;
+    rj_try_dictionary = CDICT_NONE;
+    rj_user_agent = UA_UNKNOWN;
+    rj_unlink_pending = false;
+  }
+  RecompressionJob(const RecompressionJob&) = delete;
+  RecompressionJob(RecompressionJob&&) = delete;
+  RecompressionJob& operator=(const RecompressionJob&) = delete;
+  RecompressionJob& operator=(RecompressionJob&&) = delete;
+
+  bool is_free() const { return rj_object == nullptr; }
+  Optimizer& get_optimizer() const {
+    c3_assert(rj_optimizer);
+    return *rj_optimizer;
+  }
+  PayloadHashObject* get_object() const { return rj_object; }
+  c3_byte_t* get_buffer() const { return rj_buffer; }
+  c3_uint_t get_size() const { return rj_size; }
+  c3_uint_t get_usize() const { return rj_usize; }
+  c3_compressor_t get_compressor() const { return rj_compressor; }
+  c3_dictionary_t get_dictionary() const { return rj_dictionary; }
+  c3_uint_t get_snapshot_size() const { return rj_snapshot_size; }
+  user_agent_t get_user_agent() const { return rj_user_agent; }
+  c3_uint_t get_num_attempts() const { return rj_num_attempts; }
+  const attempt_t& get_attempt(c3_uint_t i) const {
+    c3_assert(i < rj_num_attempts);
+    return rj_attempts[i];
+  }
+  bool is_unlink_pending() const { return rj_unlink_pending; }
+  void set_unlink_pending() { rj_unlink_pending = true; }
+  bool succeeded() const { return rj_buffer != nullptr; }
+  c3_byte_t* fetch_buffer() {
+    c3_byte_t* buffer = rj_buffer;
+    rj_buffer = nullptr;
+    return buffer;
+  }
+
+  // takes snapshot of locked object's data; has to be called by the optimizer
+  void prepare(Optimizer* optimizer, Memory& memory, PayloadHashObject* pho,
+    const c3_compressor_t* compressors, c3_dictionary_t dictionary);
+  // tries selected compressors on the snapshot; can be called by any thread
+  void execute();
+  // frees re-compressed data (if any), and marks the job slot as free
+  void release();
+};
+
+/**
+ * Pool of re-compression threads shared by session and FPC optimizers.
+ *
+ * If the pool does not have any running threads, `post_job()` rejects the job, and optimizer executes
+ * it by itself (which is how optimizers worked before the pool was introduced). Jobs and "quit" requests
+ * are put into the same queue, and the check whether the pool has running threads is done under the
+ * same lock as posting of "quit" requests, so a job can never be "stranded" in the queue after the last
+ * thread exits: all jobs that had been accepted before the "quit" requests will be processed.
+ */
+class RecompressionPool: public virtual AbstractLogger {
+public:
+  /// How many jobs (at most) an optimizer can have in flight per each running thread
+  static constexpr c3_uint_t MAX_JOBS_PER_THREAD = 2;
+
+private:
+  static constexpr c3_uint_t DEFAULT_QUEUE_CAPACITY = 64;
+
+  /// Message type for use with the pool's queue
+  class RecompressionMessage {
+    RecompressionJob* rm_job;  // job to execute
+    bool              rm_quit; // `true` if the thread receiving the message has to quit
+
+  public:
+    RecompressionMessage() {
+      rm_job = nullptr;
+      rm_quit = false;
+    }
+    explicit RecompressionMessage(RecompressionJob* job) {
+      c3_assert(job && !job->is_free());
+      rm_job = job;
+      rm_quit = false;
+    }
+    explicit RecompressionMessage(bool quit) {
+      rm_job = nullptr;
+      rm_quit = quit;
+    }
+
+    bool is_valid() const { return rm_job != nullptr || rm_quit; }
+    bool is_quit_request() const { return rm_quit; }
+    RecompressionJob* get_job() const {
+      c3_assert(rm_job);
+      return rm_job;
+    }
+  };
+
+  typedef MessageQueue<RecompressionMessage> RecompressionQueue;
+
+  std::mutex         rp_mutex;       // guards posting of jobs and changes to the number of threads
+  RecompressionQueue rp_queue;       // queue of jobs and "quit" requests
+  std::atomic_uint   rp_num_threads; // number of threads that are not requested to quit
+
+public:
+  RecompressionPool() noexcept C3_FUNC_COLD;
+
+  c3_uint_t get_num_threads() const { return rp_num_threads.load(std::memory_order_relaxed); }
+  bool set_num_threads(c3_uint_t num) C3_FUNC_COLD;
+  bool post_job(RecompressionJob* job);
+
+  static void thread_proc(c3_uint_t id, ThreadArgument arg);
+};
+
+} // CyberCache
+
+#endif // _HT_RECOMPRESSOR_H
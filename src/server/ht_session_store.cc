@@ -21,39 +21,235 @@
 
 namespace CyberCache {
 
-void SessionObjectStore::destroy_session_record(StringChunk& id) {
-  c3_hash_t hash = table_hasher.hash(id.get_chars(), id.get_length());
-  TableLock lock(*this, hash);
-  HashTable& table = lock.get_table();
-  auto so = (SessionObject*) table.find(hash, id.get_chars(), id.get_short_length());
-  if (so != nullptr && so->flags_are_clear(HOF_BEING_DELETED)) {
-    LockableObjectGuard guard(so);
-    if (guard.is_locked() && so->flags_are_clear(HOF_BEING_DELETED)) {
-      so->set_flags(HOF_BEING_DELETED);
+void SessionObjectStore::add_lock_waiter(CommandReader& cr, SessionObject* so, c3_uint_t request_id) {
+  c3_assert(so && so->is_locked() && request_id != 0);
+  auto lw = alloc<lock_waiter_t>(session_memory);
+  lw->lw_next = nullptr;
+  lw->lw_reader = &cr;
+  lw->lw_object = so;
+  lw->lw_hash = so->get_hash_code();
+  lw->lw_deadline = PrecisionTimer::milliseconds_since_epoch() + SessionObject::get_lock_wait_time();
+  lw->lw_request_id = request_id;
+  lw->lw_holder_id = so->get_session_lock_holder();
+  so->add_waiter();
+  PERF_INCREMENT_COUNTER(Session_Lock_Waits)
+
+  /*
+   * The queue is kept sorted by deadlines, so that expired waiters could be popped from its head. Since
+   * all waiters get the same wait time, a new one almost always goes to the tail; the queue only has to be
+   * scanned if lock wait time had been reduced at run time.
+   */
+  SpinLockGuard guard(sos_lock);
+  if (sos_last_waiter == nullptr) {
+    sos_first_waiter = lw;
+    sos_last_waiter = lw;
+  } else if (sos_last_waiter->lw_deadline <= lw->lw_deadline) {
+    sos_last_waiter->lw_next = lw;
+    sos_last_waiter = lw;
+  } else if (lw->lw_deadline < sos_first_waiter->lw_deadline) {
+    lw->lw_next = sos_first_waiter;
+    sos_first_waiter = lw;
+  } else {
+    lock_waiter_t* prev = sos_first_waiter;
+    while (prev->lw_next->lw_deadline <= lw->lw_deadline) {
+      prev = prev->lw_next;
+    }
+    lw->lw_next = prev->lw_next;
+    prev->lw_next = lw;
+  }
+  sos_num_waiters.fetch_add(1, std::memory_order_release);
+}
+
+SessionObjectStore::lock_waiter_t* SessionObjectStore::remove_lock_waiters(const SessionObject* so, bool all) {
+  // called on a locked hash object, so no new waiters for this session can be added meanwhile
+  c3_assert(so && so->is_locked());
+  lock_waiter_t* first = nullptr;
+  lock_waiter_t* last = nullptr;
+  if (so->get_num_waiters() != 0) {
+    c3_hash_t hash = so->get_hash_code();
+    c3_uint_t num_removed = 0;
+    SpinLockGuard guard(sos_lock);
+    lock_waiter_t* prev = nullptr;
+    lock_waiter_t* lw = sos_first_waiter;
+    while (lw != nullptr) {
+      lock_waiter_t* next = lw->lw_next;
+      if (lw->lw_object == so && lw->lw_hash == hash) {
+        if (prev != nullptr) {
+          prev->lw_next = next;
+        } else {
+          sos_first_waiter = next;
+        }
+        if (next == nullptr) {
+          sos_last_waiter = prev;
+        }
+        lw->lw_next = nullptr;
+        if (last != nullptr) {
+          last->lw_next = lw;
+        } else {
+          first = lw;
+        }
+        last = lw;
+        num_removed++;
+        if (!all) {
+          break;
+        }
+        PERF_INCREMENT_COUNTER(Session_Aborted_Locks)
+      } else {
+        prev = lw;
+      }
+      lw = next;
+    }
+    sos_num_waiters.fetch_sub(num_removed, std::memory_order_release);
+  }
+  /*
+   * Waiters that had expired were removed from the queue without adjusting object's counter (the object
+   * could have been disposed by then), so the counter is only a hint, and is corrected here.
+   */
+  if (first == nullptr || all) {
+    const_cast<SessionObject*>(so)->reset_waiters();
+  } else {
+    const_cast<SessionObject*>(so)->remove_waiter();
+  }
+  return first;
+}
+
+SessionObjectStore::lock_waiter_t* SessionObjectStore::unlock_session(SessionObject* so, c3_uint_t request_id) {
+  c3_assert(so && so->is_locked());
+  lock_waiter_t* waiter = nullptr;
+  if (so->unlock_session(request_id)) {
+    waiter = remove_lock_waiters(so, false);
+    if (waiter != nullptr) {
+      // hand the lock over, so that no other request would grab it before the waiter is re-dispatched
+      so->grant_session_lock(waiter->lw_request_id);
+    }
+  }
+  so->unlock();
+  return waiter;
+}
+
+void SessionObjectStore::resume_lock_waiters(lock_waiter_t* waiters) {
+  // must be called when no table or object locks are held, as the commands may be processed right here
+  while (waiters != nullptr) {
+    lock_waiter_t* next = waiters->lw_next;
+    CommandReader* cr = waiters->lw_reader;
+    dealloc<lock_waiter_t>(session_memory, waiters);
+    if (!get_dispatcher().post_deferred_command_reader(cr)) {
+      // output queue is full: process the command ourselves rather than waiting for a free thread
+      PERF_INCREMENT_COUNTER(Session_Lock_Inline_Resumes)
+      if (!process_command(cr)) {
+        get_consumer().post_internal_error_response(*cr);
+        ReaderWriter::dispose(cr);
+      }
+    }
+    waiters = next;
+  }
+}
+
+c3_uint_t SessionObjectStore::get_lock_wait_timeout() {
+  if (sos_num_waiters.load(std::memory_order_acquire) != 0) {
+    c3_long_t deadline;
+    {
+      SpinLockGuard guard(sos_lock);
+      if (sos_first_waiter == nullptr) {
+        return 0;
+      }
+      // waiters are queued in the order of their deadlines
+      deadline = sos_first_waiter->lw_deadline;
+    }
+    c3_long_t timeout = deadline - PrecisionTimer::milliseconds_since_epoch();
+    // zero would mean "wait indefinitely"
+    return timeout > 0? (c3_uint_t) timeout: 1;
+  }
+  return 0;
+}
+
+void SessionObjectStore::process_expired_lock_waiters() {
+  if (sos_num_waiters.load(std::memory_order_acquire) != 0) {
+    lock_waiter_t* first = nullptr;
+    c3_long_t now = PrecisionTimer::milliseconds_since_epoch();
+    {
+      // the queue is sorted by deadlines, so expired waiters are detached from its head as one chain
+      c3_uint_t num_removed = 0;
+      SpinLockGuard guard(sos_lock);
+      lock_waiter_t* last = nullptr;
+      lock_waiter_t* lw = sos_first_waiter;
+      while (lw != nullptr && lw->lw_deadline <= now) {
+        last = lw;
+        lw = lw->lw_next;
+        num_removed++;
+      }
+      if (last != nullptr) {
+        first = sos_first_waiter;
+        last->lw_next = nullptr;
+        sos_first_waiter = lw;
+        if (lw == nullptr) {
+          sos_last_waiter = nullptr;
+        }
+        sos_num_waiters.fetch_sub(num_removed, std::memory_order_release);
+      }
+    }
+    while (first != nullptr) {
+      lock_waiter_t* next = first->lw_next;
+      CommandReader* cr = first->lw_reader;
+      c3_uint_t holder_id = first->lw_holder_id;
+      dealloc<lock_waiter_t>(session_memory, first);
       /*
-       * Make first attempt to dispose session object buffer.
-       *
-       * If it fails (because there are still some readers transferring buffer contents over socket
-       * pipeline, of dumping it to binlog), then second attempt will be done by session optimizer.
-       *
-       * If that one also fails, third attempt will be done by table lock cleanup code, which processes
-       * queue of deleted objects immediately before releasing an exclusive lock. That code would try
-       * to release the buffer and, if there are still some readers, will put the object back to the
-       * queue for later continued attempts, until the buffer can be finally released.
-       *
-       * Since the object is already marked as "deleted", new readers cannot be attached to it, so
-       * release process is guaranteed to be completed at some point.
+       * If the session is still locked by the same request, the lock will be broken; if it had been
+       * acquired by another request meanwhile, the command will be queued again, and will keep waiting.
        */
-      so->try_dispose_buffer(session_memory);
-      guard.unlock();
+      bool do_dispose = true;
+      if (process_read_command(*cr, holder_id, do_dispose)) {
+        if (do_dispose) {
+          ReaderWriter::dispose(cr);
+        }
+      } else {
+        get_consumer().post_internal_error_response(*cr);
+        ReaderWriter::dispose(cr);
+      }
+      first = next;
+    }
+  }
+}
+
+void SessionObjectStore::destroy_session_record(StringChunk& id) {
+  lock_waiter_t* waiters = nullptr;
+  c3_hash_t hash = table_hasher.hash(id.get_chars(), id.get_length());
+  {
+    TableLock lock(*this, hash);
+    HashTable& table = lock.get_table();
+    auto so = (SessionObject*) table.find(hash, id.get_chars(), id.get_short_length());
+    if (so != nullptr && so->flags_are_clear(HOF_BEING_DELETED)) {
+      LockableObjectGuard guard(so);
+      if (guard.is_locked() && so->flags_are_clear(HOF_BEING_DELETED)) {
+        so->set_flags(HOF_BEING_DELETED);
+        // commands waiting for session lock will not find the record, and will report cache misses
+        waiters = remove_lock_waiters(so, true);
+        /*
+         * Make first attempt to dispose session object buffer.
+         *
+         * If it fails (because there are still some readers transferring buffer contents over socket
+         * pipeline, of dumping it to binlog), then second attempt will be done by session optimizer.
+         *
+         * If that one also fails, third attempt will be done by table lock cleanup code, which processes
+         * queue of deleted objects immediately before releasing an exclusive lock. That code would try
+         * to release the buffer and, if there are still some readers, will put the object back to the
+         * queue for later continued attempts, until the buffer can be finally released.
+         *
+         * Since the object is already marked as "deleted", new readers cannot be attached to it, so
+         * release process is guaranteed to be completed at some point.
+         */
+        so->try_dispose_buffer(session_memory);
+        guard.unlock();
 
-      // notify optimizer
-      get_optimizer().post_delete_message(so);
+        // notify optimizer
+        get_optimizer().post_delete_message(so);
+      }
     }
   }
+  resume_lock_waiters(waiters);
 }
 
-bool SessionObjectStore::process_read_command(CommandReader& cr) {
+bool SessionObjectStore::process_read_command(CommandReader& cr, c3_uint_t break_holder_id, bool& do_dispose) {
   command_status_t status = CS_FORMAT_ERROR;
   CommandHeaderIterator iterator(cr);
   StringChunk id = iterator.get_string();
@@ -74,6 +270,10 @@ bool SessionObjectStore::process_read_command(CommandReader& cr) {
         }
         if (format_ok && !iterator.has_more_chunks()) {
           status = CS_FAILURE;
+          if (cr.is_clear(IO_FLAG_NETWORK)) {
+            // batched commands do not get responses, and cannot be queued, so they do not lock sessions
+            request_id = 0;
+          }
           c3_hash_t hash = table_hasher.hash(id.get_chars(), id.get_length());
           TableLock lock(*this, hash);
           HashTable& table = lock.get_table();
@@ -86,7 +286,7 @@ bool SessionObjectStore::process_read_command(CommandReader& cr) {
               if (so->flags_are_clear(HOF_BEING_DELETED)) {
                 if (so->get_expiration_time() >= Timer::current_timestamp()) {
                   // lock the session (to prevent reads with different request IDs)
-                  switch (so->lock_session(request_id)) {
+                  switch (so->lock_session(request_id, break_holder_id)) {
                     case SLR_BROKE_LOCK:
                       log(LL_WARNING, "Broke lock on session record '%.*s'",
                         (int) so->get_name_length(), so->get_name());
@@ -98,10 +298,15 @@ bool SessionObjectStore::process_read_command(CommandReader& cr) {
                       get_optimizer().post_read_message(so, ua);
                       status = CS_SUCCESS;
                       break;
-                    default: // SLR_DELETED
-                      // the hash object will be unlocked by lock guard
-                      // "failure" status will cause sending "OK" response
-                      c3_assert(status == CS_FAILURE);
+                    default: // SLR_LOCKED
+                      /*
+                       * The command will be re-dispatched when the session is unlocked, or re-processed when
+                       * lock wait time expires; it must not be touched after the hash object is unlocked
+                       * (by lock guard) since by then it could have been already picked up by other thread.
+                       */
+                      add_lock_waiter(cr, so, request_id);
+                      do_dispose = false;
+                      return true;
                   }
                 } else {
                   C3_DEBUG(log(LL_DEBUG, "Deleting expired session record '%.*s' (%u : %s)",
@@ -137,6 +342,7 @@ bool SessionObjectStore::process_read_command(CommandReader& cr) {
 
 bool SessionObjectStore::process_write_command(CommandReader& cr) {
   command_status_t status = CS_FORMAT_ERROR;
+  lock_waiter_t* waiter = nullptr;
   CommandHeaderIterator iterator(cr);
   StringChunk id = iterator.get_string();
   if (id.is_valid_name()) {
@@ -200,8 +406,8 @@ bool SessionObjectStore::process_write_command(CommandReader& cr) {
               c3_assert(so && so->get_type() == HOT_SESSION_OBJECT && locked);
               cr.command_reader_transfer_payload(so, DOMAIN_SESSION, pi.pi_usize, pi.pi_compressor);
               get_consumer().post_ok_response(cr);
-              // unlocks both session and hash object
-              so->unlock_session(request_id);
+              // unlocks both session and hash object, handing session lock over to the first waiter
+              waiter = unlock_session(so, request_id);
 
               // notify optimizer
               get_optimizer().post_write_message(so, ua, lifetime);
@@ -212,6 +418,8 @@ bool SessionObjectStore::process_write_command(CommandReader& cr) {
       }
     }
   }
+  // table lock is released by now, so the waiter can be processed even by current thread
+  resume_lock_waiters(waiter);
   switch (status) {
     case CS_SUCCESS:
       return true;
@@ -224,6 +432,45 @@ bool SessionObjectStore::process_write_command(CommandReader& cr) {
   }
 }
 
+bool SessionObjectStore::insert_loaded_record(CommandReader& cr) {
+  c3_assert(cr.get_command_id() == CMD_WRITE && !cr.is_set(IO_FLAG_NETWORK));
+  lock_waiter_t* waiter = nullptr;
+  bool result = false;
+  CommandHeaderIterator iterator(cr);
+  StringChunk id = iterator.get_string();
+  if (id.is_valid_name()) {
+    NumberChunk agent = iterator.get_number();
+    if (agent.is_valid_uint()) {
+      auto ua = (user_agent_t) agent.get_uint();
+      if (ua < UA_NUMBER_OF_ELEMENTS) {
+        NumberChunk lifetime_chunk = iterator.get_number();
+        payload_info_t pi;
+        if (lifetime_chunk.is_valid() && !iterator.has_more_chunks() && cr.get_payload_info(pi)) {
+          c3_assert(!pi.pi_has_errors);
+          c3_timestamp_t lifetime = lifetime_chunk.is_negative()? Timer::MAX_TIMESTAMP: lifetime_chunk.get_uint();
+          c3_hash_t hash = table_hasher.hash(id.get_chars(), id.get_length());
+          // tables had been pre-sized for the whole database, so they are locked exclusively right away
+          TableLock lock(*this, hash, true);
+          HashTable& table = lock.get_table();
+          if (table.find(hash, id.get_chars(), id.get_short_length()) == nullptr) {
+            auto so = (SessionObject*) session_memory.alloc(SessionObject::calculate_size(id.get_length()));
+            new (so) SessionObject(hash, id.get_chars(), id.get_short_length());
+            so->lock();
+            lock.downgrade_lock(table.add(so));
+            cr.command_reader_transfer_payload(so, DOMAIN_SESSION, pi.pi_usize, pi.pi_compressor);
+            // a READ could have found the record after the table had been unlocked, and started waiting
+            waiter = unlock_session(so, 0);
+            get_optimizer().post_write_message(so, ua, lifetime);
+            result = true;
+          }
+        }
+      }
+    }
+  }
+  resume_lock_waiters(waiter);
+  return result;
+}
+
 bool SessionObjectStore::process_destroy_command(CommandReader& cr) {
   CommandHeaderIterator iterator(cr);
   StringChunk id = iterator.get_string();
@@ -253,7 +500,11 @@ FileCommandWriter* SessionObjectStore::create_file_command_writer(PayloadHashObj
   if (expiration_time > time) {
     Memory& memory = get_memory_object();
     SharedObjectBuffers* sob = SharedObjectBuffers::create_object(memory);
-    sob->attach_payload(pho);
+    // buffers compressed using dictionaries are saved unpacked, so that database files would not depend on them
+    bool unpack = pho->get_buffer_dictionary() != CDICT_NONE;
+    if (!unpack) {
+      sob->attach_payload(pho);
+    }
     auto fcw = alloc<FileCommandWriter>(memory);
     new (fcw) FileCommandWriter(memory, 0, sob);
     CommandHeaderChunkBuilder header(*fcw, server_net_config, CMD_WRITE, false);
@@ -265,13 +516,20 @@ FileCommandWriter* SessionObjectStore::create_file_command_writer(PayloadHashObj
       header.estimate_number(ua) != 0 &&
       header.estimate_number(lifetime) != 0) {
       PayloadChunkBuilder payload(*fcw, server_net_config);
-      payload.add();
-      header.configure(&payload);
-      header.add_string(id_buff, id_len);
-      header.add_number(ua);
-      header.add_number(lifetime);
-      header.check();
-      return fcw;
+      bool ok = true;
+      if (unpack) {
+        ok = pho->add_unpacked_payload(payload, memory);
+      } else {
+        payload.add();
+      }
+      if (ok) {
+        header.configure(&payload);
+        header.add_string(id_buff, id_len);
+        header.add_number(ua);
+        header.add_number(lifetime);
+        header.check();
+        return fcw;
+      }
     }
     ReaderWriter::dispose(fcw);
     log(LL_ERROR, "Could not create WRITE command for '%.*s'", id_len, id_buff);
@@ -279,12 +537,25 @@ FileCommandWriter* SessionObjectStore::create_file_command_writer(PayloadHashObj
   return nullptr;
 }
 
+void SessionObjectStore::dispose() {
+  while (sos_first_waiter != nullptr) {
+    lock_waiter_t* next = sos_first_waiter->lw_next;
+    ReaderWriter::dispose(sos_first_waiter->lw_reader);
+    dealloc<lock_waiter_t>(session_memory, sos_first_waiter);
+    sos_first_waiter = next;
+  }
+  sos_last_waiter = nullptr;
+  sos_num_waiters.store(0, std::memory_order_relaxed);
+  dispose_payload_object_store();
+}
+
 bool SessionObjectStore::process_command(CommandReader* cr) {
   assert(cr != nullptr && cr->is_active());
+  bool do_dispose = true;
   bool result = false;
   switch (cr->get_command_id()) {
     case CMD_READ:
-      result = process_read_command(*cr);
+      result = process_read_command(*cr, 0, do_dispose);
       break;
     case CMD_WRITE:
       result = process_write_command(*cr);
@@ -299,8 +570,8 @@ bool SessionObjectStore::process_command(CommandReader* cr) {
       // unknown commands are handled by connection threads
       c3_assert_failure();
   }
-  if (result) {
-    // otherwise, caller will need command reader to do its own reporting
+  if (result && do_dispose) {
+    // otherwise, caller will need command reader to do its own reporting (or the command was queued)
     ReaderWriter::dispose(cr);
   }
   return result;
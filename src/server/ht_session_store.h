@@ -21,13 +21,24 @@
 
 #include "c3lib/c3lib.h"
 #include "ht_stores.h"
+#include "mt_spinlock.h"
+
+#include <atomic>
 
 namespace CyberCache {
 
 class Optimizer;
 class CommandReader;
+class CommandObjectConsumer;
 
-/// Global storage of session data
+/**
+ * Global storage of session data.
+ *
+ * READ commands that find their session locked by another request do not block connection threads;
+ * instead, they are put into a queue of lock waiters. When the session is unlocked, the lock is handed
+ * over to the first waiter, and its command is re-dispatched to the connection threads; if lock wait time
+ * expires first, the command is re-processed by an idle connection thread, which then breaks the lock.
+ */
 class SessionObjectStore: public PayloadObjectStore {
 
   static constexpr c3_uint_t DEFAULT_NUM_TABLES = 2;
@@ -35,9 +46,35 @@ class SessionObjectStore: public PayloadObjectStore {
   static constexpr c3_uint_t DEFAULT_QUEUE_CAPACITY = 32;
   static constexpr c3_uint_t DEFAULT_MAX_QUEUE_CAPACITY = 1024;
 
+  /// A READ command waiting for session lock
+  struct lock_waiter_t {
+    lock_waiter_t*       lw_next;       // next waiter in the queue
+    CommandReader*       lw_reader;     // the command that is waiting for the lock
+    const SessionObject* lw_object;     // session object (only compared; never dereferenced)
+    c3_hash_t            lw_hash;       // hash code of the session object
+    c3_long_t            lw_deadline;   // time when waiting expires, milliseconds since epoch
+    c3_uint_t            lw_request_id; // ID of the request that is waiting for the lock
+    c3_uint_t            lw_holder_id;  // ID of the request that held the lock when waiting started
+  };
+
+  CommandObjectConsumer* sos_dispatcher;   // where to re-dispatch commands that got session lock
+  lock_waiter_t*         sos_first_waiter; // head of the queue of lock waiters (sorted by deadlines)
+  lock_waiter_t*         sos_last_waiter;  // tail of the queue of lock waiters
+  std::atomic_uint       sos_num_waiters;  // number of entries in the queue of lock waiters
+  SpinLock               sos_lock;         // lock protecting the queue of lock waiters
+
+  CommandObjectConsumer& get_dispatcher() const {
+    c3_assert(sos_dispatcher);
+    return *sos_dispatcher;
+  }
+
+  void add_lock_waiter(CommandReader& cr, SessionObject* so, c3_uint_t request_id);
+  lock_waiter_t* remove_lock_waiters(const SessionObject* so, bool all);
+  lock_waiter_t* unlock_session(SessionObject* so, c3_uint_t request_id);
+  void resume_lock_waiters(lock_waiter_t* waiters);
   void destroy_session_record(StringChunk& id);
 
-  bool process_read_command(CommandReader& cr);
+  bool process_read_command(CommandReader& cr, c3_uint_t break_holder_id, bool& do_dispose);
   bool process_write_command(CommandReader& cr);
   bool process_destroy_command(CommandReader& cr);
   bool process_gc_command(CommandReader& cr);
@@ -45,23 +82,51 @@ class SessionObjectStore: public PayloadObjectStore {
 public:
   C3_FUNC_COLD SessionObjectStore() noexcept:
     PayloadObjectStore("Session store", DOMAIN_SESSION, DEFAULT_NUM_TABLES, DEFAULT_TABLE_CAPACITY,
-      DEFAULT_QUEUE_CAPACITY, DEFAULT_MAX_QUEUE_CAPACITY) {
+      DEFAULT_QUEUE_CAPACITY, DEFAULT_MAX_QUEUE_CAPACITY)
+    #if C3_INSTRUMENTED
+    // in non-instrumented mode, `SpinLock` ctor does not take any arguments
+    , sos_lock(DOMAIN_SESSION)
+    #endif
+  {
+    sos_dispatcher = nullptr;
+    sos_first_waiter = nullptr;
+    sos_last_waiter = nullptr;
+    sos_num_waiters.store(0, std::memory_order_relaxed);
   }
 
   FileCommandWriter* create_file_command_writer(PayloadHashObject* pho, c3_timestamp_t time) override;
 
-  void configure(ResponseObjectConsumer* consumer, Optimizer* optimizer) C3_FUNC_COLD {
+  void configure(ResponseObjectConsumer* consumer, CommandObjectConsumer* dispatcher,
+    Optimizer* optimizer) C3_FUNC_COLD {
     set_consumer(consumer);
+    c3_assert(dispatcher && sos_dispatcher == nullptr);
+    sos_dispatcher = dispatcher;
     set_optimizer(optimizer);
   }
   void allocate() C3_FUNC_COLD {
     // to be called after initial configuration had been loaded
     init_payload_object_store();
   }
-  void dispose() C3_FUNC_COLD {
-    dispose_payload_object_store();
-  }
+  void dispose() C3_FUNC_COLD;
+
+  /**
+   * Returns number of milliseconds until the earliest lock waiter expires, or zero if there are no lock
+   * waiters (meaning that connection threads may wait for new commands indefinitely).
+   */
+  c3_uint_t get_lock_wait_timeout();
+  /**
+   * Re-processes READ commands whose session lock wait time has expired; called by connection threads
+   * whenever they are done waiting for new commands.
+   */
+  void process_expired_lock_waiters();
 
+  /**
+   * Adds session record loaded from a database segment directly to its table, bypassing command
+   * dispatching, authentication, and responses. Returns `false` if the command was not a well-formed
+   * `WRITE` of a record that is not in the store yet; the caller should then process it as a regular
+   * command. Command reader is never disposed by this method.
+   */
+  bool insert_loaded_record(CommandReader& cr);
   bool process_command(CommandReader* cr);
 };
 
@@ -120,7 +120,7 @@ void SharedObjectBuffers::transfer_payload(Payload* payload, domain_t domain, c3
   c3_byte_t* buffer = size != 0? sb_payload.get_bytes(): (c3_byte_t*) ZERO_LENGTH_BUFFER;
   c3_assert(is_usable(pho) && !pho->has_readers() && sob_object == nullptr && buffer != nullptr && usize >= size);
   Memory& memory = Memory::get_memory_object(domain); // TARGET memory object
-  pho->set_buffer(compressor, size, usize, buffer, memory);
+  pho->set_buffer(compressor, CDICT_NONE, size, usize, buffer, memory);
   // attach object to these shared buffers and register them as a reader
   pho->register_reader();
   sob_object = pho;
@@ -16,6 +16,10 @@
 #include "ht_tag_manager.h"
 #include "pl_socket_pipelines.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace CyberCache {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -36,12 +40,70 @@ void Store::set_index_shift(c3_uint_t ntables) {
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// SlotGroup
+///////////////////////////////////////////////////////////////////////////////
+
+/// Helper class for scanning control bytes of the slots of "Swiss" hash tables
+class SlotGroup {
+  #ifdef __SSE2__
+  const __m128i sg_ctrl; // control bytes of the group
+  #else
+  const c3_byte_t* const sg_ctrl;
+  #endif
+
+  #ifndef __SSE2__
+  c3_uint_t match_bytes(c3_byte_t byte, c3_byte_t mask) const {
+    c3_uint_t matches = 0;
+    for (c3_uint_t i = 0; i < SIZE; i++) {
+      if ((sg_ctrl[i] & mask) == byte) {
+        matches |= 1u << i;
+      }
+    }
+    return matches;
+  }
+  #endif
+
+public:
+  static constexpr c3_uint_t SIZE = 16;       // number of slots in a group
+  static constexpr c3_byte_t EMPTY = 0x80;    // control byte of a slot that was never used
+  static constexpr c3_byte_t DELETED = 0xFE;  // control byte of a slot whose object was removed
+
+  #ifdef __SSE2__
+  explicit SlotGroup(const c3_byte_t* ctrl): sg_ctrl(_mm_loadu_si128((const __m128i*) ctrl)) {}
+  c3_uint_t match(c3_byte_t fingerprint) const {
+    return (c3_uint_t) _mm_movemask_epi8(_mm_cmpeq_epi8(sg_ctrl, _mm_set1_epi8((char) fingerprint)));
+  }
+  // both "empty" and "deleted" control bytes have their high bits set, while fingerprints do not
+  c3_uint_t match_empty_or_deleted() const { return (c3_uint_t) _mm_movemask_epi8(sg_ctrl); }
+  #else
+  explicit SlotGroup(const c3_byte_t* ctrl): sg_ctrl(ctrl) {}
+  c3_uint_t match(c3_byte_t fingerprint) const { return match_bytes(fingerprint, 0xFF); }
+  c3_uint_t match_empty_or_deleted() const { return match_bytes(0x80, 0x80); }
+  #endif
+  c3_uint_t match_empty() const { return match(EMPTY); }
+
+  static c3_uint_t get_first(c3_uint_t matches) { return (c3_uint_t) __builtin_ctz(matches); }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // HashTable
 ///////////////////////////////////////////////////////////////////////////////
 
-HashTable::HashTable(Store& store, c3_uint_t init_capacity): ht_store(store) {
-  c3_uint_t nbuckets = (c3_uint_t)(init_capacity / store.get_fill_factor());
+HashTable::HashTable(Store& store, c3_uint_t init_capacity, table_engine_t engine):
+  ht_store(store), ht_engine(engine) {
+  c3_assert(engine > TE_INVALID && engine < TE_NUMBER_OF_ELEMENTS);
+  static_assert(MIN_NUM_BUCKETS % SlotGroup::SIZE == 0, "Minimal table size must be a multiple of group size");
+  ht_buckets = nullptr;
+  ht_old_buckets = nullptr;
+  ht_ctrl = nullptr;
+  ht_old_ctrl = nullptr;
+  ht_old_nbuckets = 0;
+  ht_migrated = 0;
+  ht_num_deleted = 0;
+  c3_uint_t nbuckets = engine == TE_SWISS?
+    (c3_uint_t)((c3_ulong_t) init_capacity * 8 / 7):
+    (c3_uint_t)(init_capacity / store.get_fill_factor());
   if (nbuckets < MIN_NUM_BUCKETS) {
     nbuckets = MIN_NUM_BUCKETS;
   }
@@ -55,40 +117,245 @@ HashTable::HashTable(Store& store, c3_uint_t init_capacity): ht_store(store) {
 }
 
 void HashTable::allocate_buckets() {
-  c3_assert(ht_buckets == nullptr);
-  ht_buckets = (HashObject**) ht_store.get_memory_object().calloc(ht_nbuckets, sizeof(HashObject*));
+  c3_assert(ht_buckets == nullptr && ht_ctrl == nullptr);
+  Memory& memory = ht_store.get_memory_object();
+  ht_buckets = (HashObject**) memory.calloc(ht_nbuckets, sizeof(HashObject*));
+  if (ht_engine == TE_SWISS) {
+    ht_ctrl = (c3_byte_t*) std::memset(memory.alloc(ht_nbuckets), SlotGroup::EMPTY, ht_nbuckets);
+  }
 }
 
 void HashTable::free_buckets() {
   c3_assert(ht_buckets);
-  ht_store.get_memory_object().free(ht_buckets, ht_nbuckets * sizeof(HashObject*));
+  Memory& memory = ht_store.get_memory_object();
+  memory.free(ht_buckets, ht_nbuckets * sizeof(HashObject*));
   ht_buckets = nullptr;
+  if (ht_ctrl != nullptr) {
+    memory.free(ht_ctrl, ht_nbuckets);
+    ht_ctrl = nullptr;
+  }
 }
 
-bool HashTable::resize_table() {
-  if (ht_nbuckets < MAX_NUM_BUCKETS) {
-    free_buckets();
-    ht_nbuckets <<= 1;
+void HashTable::free_old_buckets() {
+  c3_assert(ht_old_buckets);
+  Memory& memory = ht_store.get_memory_object();
+  memory.free(ht_old_buckets, ht_old_nbuckets * sizeof(HashObject*));
+  ht_old_buckets = nullptr;
+  if (ht_old_ctrl != nullptr) {
+    memory.free(ht_old_ctrl, ht_old_nbuckets);
+    ht_old_ctrl = nullptr;
+  }
+  ht_old_nbuckets = 0;
+  ht_migrated = 0;
+}
+
+bool HashTable::start_resizing(c3_uint_t nbuckets) {
+  c3_assert(!is_being_resized());
+  // "Swiss" tables can also be re-built without growing, just to get rid of slots marked as "deleted"
+  if (nbuckets > ht_nbuckets || (ht_engine == TE_SWISS && nbuckets == ht_nbuckets)) {
+    ht_old_buckets = ht_buckets;
+    ht_old_ctrl = ht_ctrl;
+    ht_old_nbuckets = ht_nbuckets;
+    ht_migrated = 0;
+    ht_buckets = nullptr;
+    ht_ctrl = nullptr;
+    ht_nbuckets = nbuckets;
+    ht_num_deleted = 0;
     allocate_buckets();
-    HashObject* ho = ht_first;
-    while (ho != nullptr) {
-      ho->ho_ht_prev = nullptr;
-      c3_uint_t index = get_bucket_index(ho->ho_hash);
-      if ((ho->ho_ht_next = ht_buckets[index]) != nullptr) {
-        ho->ho_ht_next->ho_ht_prev = ho;
+    return true;
+  }
+  return false;
+}
+
+bool HashTable::migrate_buckets(c3_uint_t num) {
+  if (is_being_resized()) {
+    c3_uint_t end = ht_old_nbuckets - ht_migrated > num? ht_migrated + num: ht_old_nbuckets;
+    if (ht_engine == TE_SWISS) {
+      while (ht_migrated < end) {
+        c3_uint_t slot = ht_migrated++;
+        if ((ht_old_ctrl[slot] & SlotGroup::EMPTY) == 0) {
+          HashObject* ho = ht_old_buckets[slot];
+          // lookups of objects that are still in the old array have to keep probing past this slot
+          ht_old_ctrl[slot] = SlotGroup::DELETED;
+          ht_old_buckets[slot] = nullptr;
+          link_into_slots(ho);
+        }
       }
-      ht_buckets[index] = ho;
-      ho = ho->ho_next;
     }
+    while (ht_migrated < end) {
+      HashObject* ho = ht_old_buckets[ht_migrated];
+      ht_old_buckets[ht_migrated++] = nullptr;
+      while (ho != nullptr) {
+        HashObject* next = ho->ho_ht_next;
+        // now that `ht_migrated` is incremented, this returns bucket from the new array
+        HashObject** bucket = get_bucket(ho->ho_hash);
+        ho->ho_ht_prev = nullptr;
+        if ((ho->ho_ht_next = *bucket) != nullptr) {
+          ho->ho_ht_next->ho_ht_prev = ho;
+        }
+        *bucket = ho;
+        ho = next;
+      }
+    }
+    if (ht_migrated == ht_old_nbuckets) {
+      free_old_buckets();
+    }
+    return true;
+  }
+  return false;
+}
+
+HashObject* HashTable::find_in_slots(HashObject* const* slots, const c3_byte_t* ctrl, c3_uint_t nslots,
+  c3_hash_t hash, const char* name, c3_ushort_t len) const {
+  c3_byte_t fingerprint = get_fingerprint(hash);
+  c3_uint_t mask = nslots / SlotGroup::SIZE - 1;
+  c3_uint_t group = ht_store.get_base_index(hash) & mask;
+  for (c3_uint_t step = 1;; step++) {
+    c3_uint_t first_slot = group * SlotGroup::SIZE;
+    SlotGroup slot_group(ctrl + first_slot);
+    for (c3_uint_t matches = slot_group.match(fingerprint); matches != 0; matches &= matches - 1) {
+      HashObject* ho = slots[first_slot + SlotGroup::get_first(matches)];
+      if (ho->ho_hash == hash && ho->ho_nlength == len && std::memcmp(ho->get_name(), name, len) == 0) {
+        return ho;
+      }
+    }
+    // the table is never full, so we are guaranteed to hit a group with an empty slot eventually
+    if (slot_group.match_empty() != 0) {
+      return nullptr;
+    }
+    // triangular probing visits all groups, since their number is a power of 2
+    group = (group + step) & mask;
+  }
+}
+
+void HashTable::link_into_slots(HashObject* ho) {
+  c3_uint_t mask = ht_nbuckets / SlotGroup::SIZE - 1;
+  c3_uint_t group = ht_store.get_base_index(ho) & mask;
+  for (c3_uint_t step = 1;; step++) {
+    c3_uint_t first_slot = group * SlotGroup::SIZE;
+    c3_uint_t matches = SlotGroup(ht_ctrl + first_slot).match_empty_or_deleted();
+    if (matches != 0) {
+      c3_uint_t slot = first_slot + SlotGroup::get_first(matches);
+      if (ht_ctrl[slot] == SlotGroup::DELETED) {
+        c3_assert(ht_num_deleted);
+        ht_num_deleted--;
+      }
+      ht_ctrl[slot] = get_fingerprint(ho->ho_hash);
+      ht_buckets[slot] = ho;
+      return;
+    }
+    group = (group + step) & mask;
+  }
+}
+
+bool HashTable::unlink_from_slots(HashObject** slots, c3_byte_t* ctrl, c3_uint_t nslots, HashObject* ho,
+  c3_uint_t* num_deleted) {
+  c3_byte_t fingerprint = get_fingerprint(ho->ho_hash);
+  c3_uint_t mask = nslots / SlotGroup::SIZE - 1;
+  c3_uint_t group = ht_store.get_base_index(ho) & mask;
+  for (c3_uint_t step = 1;; step++) {
+    c3_uint_t first_slot = group * SlotGroup::SIZE;
+    SlotGroup slot_group(ctrl + first_slot);
+    for (c3_uint_t matches = slot_group.match(fingerprint); matches != 0; matches &= matches - 1) {
+      c3_uint_t slot = first_slot + SlotGroup::get_first(matches);
+      if (slots[slot] == ho) {
+        /*
+         * If the group still has an empty slot, no lookup has ever gone past it, so the slot can be
+         * marked as empty; otherwise, it has to be marked as "deleted" for lookups to keep probing.
+         */
+        if (slot_group.match_empty() != 0) {
+          ctrl[slot] = SlotGroup::EMPTY;
+        } else {
+          ctrl[slot] = SlotGroup::DELETED;
+          if (num_deleted != nullptr) {
+            (*num_deleted)++;
+          }
+        }
+        slots[slot] = nullptr;
+        return true;
+      }
+    }
+    if (slot_group.match_empty() != 0) {
+      // while the table is being resized, the object may still be in the old array
+      return false;
+    }
+    group = (group + step) & mask;
+  }
+}
+
+void HashTable::rebuild_slots(c3_uint_t nslots) {
+  c3_assert(!is_being_resized());
+  HashObject** buckets = ht_buckets;
+  c3_byte_t* ctrl = ht_ctrl;
+  c3_uint_t nbuckets = ht_nbuckets;
+  ht_buckets = nullptr;
+  ht_ctrl = nullptr;
+  ht_nbuckets = nslots;
+  allocate_buckets();
+  ht_num_deleted = 0;
+  for (c3_uint_t i = 0; i < nbuckets; i++) {
+    if ((ctrl[i] & SlotGroup::EMPTY) == 0) {
+      link_into_slots(buckets[i]);
+    }
+  }
+  Memory& memory = ht_store.get_memory_object();
+  memory.free(buckets, nbuckets * sizeof(HashObject*));
+  memory.free(ctrl, nbuckets);
+}
+
+bool HashTable::reserve_slot() {
+  c3_uint_t num_objects = ht_count.load(std::memory_order_relaxed);
+  if (num_objects + ht_num_deleted >= get_max_num_used_slots(ht_nbuckets)) {
+    /*
+     * Each call to `add()` or `remove()` migrates a group of slots, so previous re-build is going to be
+     * completed well before the new slot array fills up; just in case, we complete it here.
+     */
+    migrate_buckets(ht_old_nbuckets);
+    // if at least half of used slots are marked as "deleted", re-building table of the same size will do
+    c3_uint_t nslots = ht_nbuckets;
+    if (num_objects > ht_num_deleted && ht_nbuckets < MAX_NUM_BUCKETS) {
+      nslots <<= 1;
+    }
+    start_resizing(nslots);
+    c3_assert(num_objects < get_max_num_used_slots(ht_nbuckets));
     return true;
   }
   return false;
 }
 
+bool HashTable::reserve(c3_uint_t num) {
+  c3_ulong_t capacity = (c3_ulong_t) ht_count.load(std::memory_order_relaxed) + num;
+  c3_ulong_t nbuckets = ht_engine == TE_SWISS?
+    capacity * 8 / 7 + 1:
+    (c3_ulong_t)(capacity / ht_store.get_fill_factor()) + 1;
+  c3_uint_t new_nbuckets = nbuckets < MAX_NUM_BUCKETS? get_next_power_of_2((c3_uint_t) nbuckets): MAX_NUM_BUCKETS;
+  if (new_nbuckets == 0) {
+    new_nbuckets = MAX_NUM_BUCKETS;
+  }
+  if (new_nbuckets <= ht_nbuckets) {
+    return false;
+  }
+  // complete pending resize (if any), and then move all objects into the new bucket array at once
+  migrate_buckets(ht_old_nbuckets);
+  if (ht_engine == TE_SWISS) {
+    rebuild_slots(new_nbuckets);
+  } else {
+    start_resizing(new_nbuckets);
+    migrate_buckets(ht_old_nbuckets);
+  }
+  return true;
+}
+
 HashObject* HashTable::find(c3_hash_t hash, const char* name, c3_ushort_t len) const {
   assert(hash != INVALID_HASH_VALUE && name && len);
-  c3_uint_t index = get_bucket_index(hash);
-  HashObject* ho = ht_buckets[index];
+  if (ht_engine == TE_SWISS) {
+    HashObject* ho = find_in_slots(ht_buckets, ht_ctrl, ht_nbuckets, hash, name, len);
+    if (ho == nullptr && is_being_resized()) {
+      ho = find_in_slots(ht_old_buckets, ht_old_ctrl, ht_old_nbuckets, hash, name, len);
+    }
+    return ho;
+  }
+  HashObject* ho = *get_bucket(hash);
   while (ho != nullptr) {
     if (ho->ho_hash == hash && ho->ho_nlength == len && std::memcmp(ho->get_name(), name, len) == 0) {
       return ho;
@@ -99,10 +366,25 @@ HashObject* HashTable::find(c3_hash_t hash, const char* name, c3_ushort_t len) c
 }
 
 bool HashTable::add(HashObject* ho) {
-  // resize the table if needed
+  /*
+   * Continue resizing the table, or start new resize if needed; only the call that actually starts a
+   * resize reports it, as the caller then expects more objects to be disposed upon lock release.
+   */
   bool table_resized = false;
-  if (ht_count.load(std::memory_order_relaxed) >= (c3_uint_t)(ht_nbuckets * ht_store.get_fill_factor())) {
-    table_resized = resize_table();
+  migrate_buckets(NUM_BUCKETS_PER_MIGRATION_STEP);
+  if (ht_engine == TE_SWISS) {
+    table_resized = reserve_slot();
+  }
+  if (ht_engine == TE_CHAINED &&
+    ht_count.load(std::memory_order_relaxed) >= (c3_uint_t)(ht_nbuckets * ht_store.get_fill_factor())) {
+    /*
+     * Each call to `add()` migrates some buckets, so, with any sane fill factor, previous resize is
+     * going to be completed well before the table gets full again; just in case, we complete it here.
+     */
+    migrate_buckets(ht_old_nbuckets);
+    if (ht_nbuckets < MAX_NUM_BUCKETS && start_resizing(ht_nbuckets << 1)) {
+      table_resized = true;
+    }
   }
 
   // link the object into the global chain
@@ -112,13 +394,17 @@ bool HashTable::add(HashObject* ho) {
   }
   ht_first = ho;
 
-  // link the object into the bucket chain
-  c3_uint_t index = get_bucket_index(ho->ho_hash);
-  ho->ho_ht_prev = nullptr;
-  if ((ho->ho_ht_next = ht_buckets[index]) != nullptr) {
-    ho->ho_ht_next->ho_ht_prev = ho;
+  // link the object into the bucket chain (or a slot)
+  if (ht_engine == TE_SWISS) {
+    link_into_slots(ho);
+  } else {
+    HashObject** bucket = get_bucket(ho->ho_hash);
+    ho->ho_ht_prev = nullptr;
+    if ((ho->ho_ht_next = *bucket) != nullptr) {
+      ho->ho_ht_next->ho_ht_prev = ho;
+    }
+    *bucket = ho;
   }
-  ht_buckets[index] = ho;
 
   // increment table object count (more efficient than atomic overload for "++")
   ht_count.fetch_add(1, std::memory_order_relaxed);
@@ -142,26 +428,37 @@ void HashTable::remove(HashObject* ho) {
   ho->ho_prev = ho->ho_next = nullptr;
   #endif
 
-  // unlink from the bucket chain
-  if (ho->ho_ht_prev != nullptr) {
-    assert(ho->ho_ht_prev->ho_ht_next == ho);
-    ho->ho_ht_prev->ho_ht_next = ho->ho_ht_next;
+  // unlink from the bucket chain (or a slot)
+  if (ht_engine == TE_SWISS) {
+    if (!unlink_from_slots(ht_buckets, ht_ctrl, ht_nbuckets, ho, &ht_num_deleted)) {
+      // object has not been migrated yet; "deleted" marks in the old array are not accounted
+      c3_assert_def(bool unlinked) unlink_from_slots(ht_old_buckets, ht_old_ctrl, ht_old_nbuckets, ho, nullptr);
+      c3_assert(is_being_resized() && unlinked);
+    }
   } else {
-    c3_uint_t index = get_bucket_index(ho->ho_hash);
-    assert(ht_buckets[index] == ho);
-    ht_buckets[index] = ho->ho_ht_next;
-  }
-  if (ho->ho_ht_next != nullptr) {
-    assert(ho->ho_ht_next->ho_ht_prev == ho);
-    ho->ho_ht_next->ho_ht_prev = ho->ho_ht_prev;
+    if (ho->ho_ht_prev != nullptr) {
+      assert(ho->ho_ht_prev->ho_ht_next == ho);
+      ho->ho_ht_prev->ho_ht_next = ho->ho_ht_next;
+    } else {
+      HashObject** bucket = get_bucket(ho->ho_hash);
+      assert(*bucket == ho);
+      *bucket = ho->ho_ht_next;
+    }
+    if (ho->ho_ht_next != nullptr) {
+      assert(ho->ho_ht_next->ho_ht_prev == ho);
+      ho->ho_ht_next->ho_ht_prev = ho->ho_ht_prev;
+    }
+    #ifdef C3_SAFE
+    ho->ho_ht_prev = ho->ho_ht_next = nullptr;
+    #endif
   }
-  #ifdef C3_SAFE
-  ho->ho_ht_prev = ho->ho_ht_next = nullptr;
-  #endif
 
   // decrement table object count (more efficient than atomic overload for "--")
   c3_assert_def(c3_uint_t prev_count) ht_count.fetch_sub(1, std::memory_order_relaxed);
   c3_assert(prev_count);
+
+  // if the table is being resized, continue migration
+  migrate_buckets(NUM_BUCKETS_PER_MIGRATION_STEP);
 }
 
 bool HashTable::enumerate(void* context, object_callback_t callback) const {
@@ -210,8 +507,12 @@ void HashTable::dispose() {
     ho = next;
   }
   ht_first = nullptr;
+  if (is_being_resized()) {
+    free_old_buckets();
+  }
   free_buckets();
   ht_nbuckets = 0;
+  ht_num_deleted = 0;
   ht_count.store(0, std::memory_order_relaxed);
 }
 
@@ -229,13 +530,14 @@ ObjectStore::ObjectStore(const char* name, domain_t domain, c3_uint_t default_nt
   os_ntables = default_ntables;
   set_index_shift(os_ntables);
   os_capacity = default_capacity;
+  os_engine = TE_CHAINED;
 }
 
 void ObjectStore::init_object_store() {
   c3_assert(os_tables == nullptr && os_ntables > 0);
   os_tables = (HashTable*) get_memory_object().calloc(os_ntables, sizeof(HashTable));
   for (c3_uint_t i = 0; i < os_ntables; ++i) {
-    new (os_tables + i) HashTable(*this, os_capacity);
+    new (os_tables + i) HashTable(*this, os_capacity, os_engine);
   }
 }
 
@@ -277,6 +579,12 @@ void ObjectStore::set_table_capacity(c3_uint_t capacity) {
   os_capacity = capacity;
 }
 
+void ObjectStore::set_table_engine(table_engine_t engine) {
+  // configuration manager should have blocked this request
+  c3_assert(os_tables == nullptr && engine > TE_INVALID && engine < TE_NUMBER_OF_ELEMENTS);
+  os_engine = engine;
+}
+
 bool ObjectStore::enumerate_all(void* context, object_callback_t callback) const {
   if (is_initialized()) {
     for (c3_uint_t i = 0; i < get_num_tables(); i++) {
@@ -288,6 +596,19 @@ bool ObjectStore::enumerate_all(void* context, object_callback_t callback) const
   return true;
 }
 
+bool ObjectStore::enumerate_segment(void* context, object_callback_t callback, c3_uint_t segment,
+  c3_uint_t num_segments) const {
+  c3_assert(num_segments && segment < num_segments);
+  if (is_initialized()) {
+    for (c3_uint_t i = segment; i < get_num_tables(); i += num_segments) {
+      if (!table(i).enumerate(context, callback)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 c3_uint_t ObjectStore::get_num_deleted_objects() const {
   // only payload object stores have specialized queues that keep pointer to object marked as "deleted"
   return 0;
@@ -427,6 +748,26 @@ bool PayloadObjectStore::lock_enumerate_all(void* context, object_callback_t cal
   return true;
 }
 
+void PayloadObjectStore::reserve_capacity(c3_uint_t num) {
+  if (is_initialized() && num > 0) {
+    c3_assert(pos_mutexes);
+    // objects are spread evenly across tables, so reserve a bit more than an exact share
+    c3_uint_t num_per_table = num / get_num_tables();
+    num_per_table += num_per_table / 8 + 1;
+    c3_uint_t num_resized = 0;
+    for (c3_uint_t i = 0; i < get_num_tables(); i++) {
+      DynamicMutexLock lock(pos_mutexes[i], true);
+      if (table(i).reserve(num_per_table)) {
+        num_resized++;
+      }
+    }
+    if (num_resized > 0) {
+      log(LL_VERBOSE, "%s: pre-sized %u table%s for %u more records",
+        get_name(), num_resized, plural(num_resized), num);
+    }
+  }
+}
+
 c3_uint_t PayloadObjectStore::get_num_deleted_objects() const {
   return pos_num_deleted_objects.load(std::memory_order_relaxed);
 }
@@ -83,35 +83,83 @@ public:
 // HashTable
 ///////////////////////////////////////////////////////////////////////////////
 
+/// Layouts of hash table buckets
+enum table_engine_t: c3_byte_t {
+  TE_INVALID = 0, // an invalid engine (placeholder)
+  TE_CHAINED,     // each bucket is a chain of objects linked through their headers (the default)
+  TE_SWISS,       // open addressing: groups of slots with one-byte hash fingerprints ("Swiss table")
+  TE_NUMBER_OF_ELEMENTS
+};
+
 /**
  * Container that stores hash objects.
  *
- * Its capacity is defined as number of buckets times fill factor; when count of elements contained in
- * the table is about to exceed table capacity (number of buckets times fill factor), the number of
- * buckets is doubled, and the table gets re-built.
+ * With the "chained" engine, table capacity is defined as number of buckets times fill factor; when
+ * count of elements contained in the table is about to exceed table capacity, the number of buckets is
+ * doubled. The table is re-built incrementally: objects are moved from the old bucket array to the new
+ * one in small batches, upon subsequent calls to `add()` and `remove()`; until all old buckets are
+ * migrated, lookups check either old or new array, depending upon whether respective old bucket had
+ * already been migrated.
+ *
+ * With the "Swiss" engine, buckets are slots that store pointers to objects, and each slot has a
+ * control byte that is either "empty", "deleted", or holds 7-bit fingerprint of object's hash code.
+ * Control bytes are scanned in groups of 16 (using SIMD instructions, if available), so that most
+ * lookups of missing objects complete without touching objects' memory. Such tables ignore store's
+ * fill factor (they are kept at most 7/8 full), and are also re-built incrementally, one group of
+ * slots per call to `add()` or `remove()`; migrated old slots are marked as "deleted", so that lookups
+ * that did not find an object in the new slot array could still probe the old one. Explicit pre-sizing
+ * with `reserve()` still re-builds slot arrays in one go.
+ *
+ * All modifications (including migration of the buckets) are done under exclusive table lock; `find()`
+ * can be called under shared lock, so it never migrates anything.
  */
 class HashTable {
   static constexpr c3_uint_t MIN_NUM_BUCKETS = 64;
   static constexpr c3_uint_t MAX_NUM_BUCKETS = 1u << 31;
-
-  Store&           ht_store;    // reference to the container
-  HashObject**     ht_buckets;  // array of buckets
-  HashObject*      ht_first;    // first object in the chain of all objects in this table
-  c3_uint_t        ht_nbuckets; // current number of buckets in the table (size of bucket array)
-  std::atomic_uint ht_count;    // total number of objects in the table
-
-  c3_uint_t get_bucket_index(const HashObject* ho) const {
-    return ht_store.get_base_index(ho) & (ht_nbuckets - 1);
-  }
-  c3_uint_t get_bucket_index(c3_hash_t hash) const {
-    return ht_store.get_base_index(hash) & (ht_nbuckets - 1);
+  static constexpr c3_uint_t NUM_BUCKETS_PER_MIGRATION_STEP = 16;
+
+  Store&           ht_store;        // reference to the container
+  HashObject**     ht_buckets;      // array of buckets (slots, if engine is "Swiss")
+  HashObject**     ht_old_buckets;  // array of buckets being migrated, or NULL if not resizing
+  c3_byte_t*       ht_ctrl;         // control bytes of the slots, or NULL if engine is "chained"
+  c3_byte_t*       ht_old_ctrl;     // control bytes of the slots being migrated ("Swiss" engine only)
+  HashObject*      ht_first;        // first object in the chain of all objects in this table
+  c3_uint_t        ht_nbuckets;     // current number of buckets in the table (size of bucket array)
+  c3_uint_t        ht_old_nbuckets; // number of buckets in the array being migrated
+  c3_uint_t        ht_migrated;     // number of old buckets that have already been migrated
+  c3_uint_t        ht_num_deleted;  // number of slots marked as "deleted" ("Swiss" engine only)
+  std::atomic_uint ht_count;        // total number of objects in the table
+  const table_engine_t ht_engine;   // layout of the buckets
+
+  bool is_being_resized() const { return ht_old_buckets != nullptr; }
+  HashObject** get_bucket(c3_hash_t hash) const {
+    c3_uint_t base_index = ht_store.get_base_index(hash);
+    if (is_being_resized()) {
+      c3_uint_t old_index = base_index & (ht_old_nbuckets - 1);
+      if (old_index >= ht_migrated) {
+        return ht_old_buckets + old_index;
+      }
+    }
+    return ht_buckets + (base_index & (ht_nbuckets - 1));
   }
   void allocate_buckets();
   void free_buckets();
-  bool resize_table();
+  void free_old_buckets();
+  bool start_resizing(c3_uint_t nbuckets);
+  bool migrate_buckets(c3_uint_t num);
+
+  static c3_byte_t get_fingerprint(c3_hash_t hash) { return (c3_byte_t)(hash >> 57); }
+  static c3_uint_t get_max_num_used_slots(c3_uint_t nslots) { return nslots - nslots / 8; }
+  HashObject* find_in_slots(HashObject* const* slots, const c3_byte_t* ctrl, c3_uint_t nslots,
+    c3_hash_t hash, const char* name, c3_ushort_t len) const;
+  void link_into_slots(HashObject* ho);
+  bool unlink_from_slots(HashObject** slots, c3_byte_t* ctrl, c3_uint_t nslots, HashObject* ho,
+    c3_uint_t* num_deleted);
+  bool reserve_slot();
+  void rebuild_slots(c3_uint_t nslots);
 
 public:
-  HashTable(Store& store, c3_uint_t init_capacity) C3_FUNC_COLD;
+  HashTable(Store& store, c3_uint_t init_capacity, table_engine_t engine) C3_FUNC_COLD;
   HashTable(const HashTable&) = delete;
   HashTable(HashTable&&) = delete;
   ~HashTable() C3_FUNC_COLD { dispose(); }
@@ -120,8 +168,11 @@ public:
   HashTable& operator=(HashTable&&) = delete;
 
   c3_uint_t get_num_elements() const { return ht_count.load(std::memory_order_relaxed); }
+  table_engine_t get_engine() const { return ht_engine; }
   HashObject* find(c3_hash_t hash, const char* name, c3_ushort_t len) const;
   bool add(HashObject* ho);
+  // makes sure `num` more objects can be added without resizing; returns `true` if table was resized
+  bool reserve(c3_uint_t num) C3_FUNC_COLD;
   void remove(HashObject* ho);
   bool enumerate(void* context, object_callback_t callback) const;
   void dispose() C3_FUNC_COLD;
@@ -143,6 +194,7 @@ class ObjectStore: public Store {
   HashTable*              os_tables;    // array of hash table objects, *not* pointers
   c3_uint_t               os_ntables;   // number of tables in the array; can't change after initialization
   c3_uint_t               os_capacity;  // initial capacity of each individual table
+  table_engine_t          os_engine;    // layout of tables' buckets; can't change after initialization
 
 protected:
   ObjectStore(const char* name, domain_t domain, c3_uint_t default_ntables,
@@ -195,8 +247,13 @@ public:
 
   c3_uint_t get_num_elements() const;
   void set_table_capacity(c3_uint_t capacity) C3_FUNC_COLD;
+  table_engine_t get_table_engine() const { return os_engine; }
+  void set_table_engine(table_engine_t engine) C3_FUNC_COLD;
 
   bool enumerate_all(void* context, object_callback_t callback) const;
+  // enumerates objects in tables whose indices are `segment`, `segment + num_segments`, and so on
+  bool enumerate_segment(void* context, object_callback_t callback, c3_uint_t segment,
+    c3_uint_t num_segments) const;
 
   virtual c3_uint_t get_num_deleted_objects() const;
 };
@@ -263,6 +320,8 @@ public:
 
   bool post_unlink_message(PayloadHashObject* pho);
   bool lock_enumerate_all(void* context, object_callback_t callback) const;
+  // grows tables (under exclusive locks) so that they could accommodate `num` more objects in total
+  void reserve_capacity(c3_uint_t num) C3_FUNC_COLD;
 
   c3_uint_t get_num_deleted_objects() const override;
   void dispose_deleted_objects(c3_uint_t index, c3_uint_t num);
@@ -0,0 +1,689 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include "ht_tag_index.h"
+
+#include <cstring>
+#include <new>
+
+namespace CyberCache {
+
+///////////////////////////////////////////////////////////////////////////////
+// TagBitmap
+///////////////////////////////////////////////////////////////////////////////
+
+c3_ushort_t* TagBitmap::alloc_values(c3_uint_t capacity) {
+  return (c3_ushort_t*) fpc_memory.alloc(capacity * sizeof(c3_ushort_t));
+}
+
+void TagBitmap::free_values(c3_ushort_t* values, c3_uint_t capacity) {
+  fpc_memory.free(values, capacity * sizeof(c3_ushort_t));
+}
+
+c3_ulong_t* TagBitmap::alloc_words() {
+  return (c3_ulong_t*) fpc_memory.calloc(NUM_BITMAP_WORDS, sizeof(c3_ulong_t));
+}
+
+void TagBitmap::free_words(c3_ulong_t* words) {
+  fpc_memory.free(words, BITMAP_SIZE);
+}
+
+c3_uint_t TagBitmap::count_bits(const c3_ulong_t* words) {
+  c3_uint_t num = 0;
+  for (c3_uint_t i = 0; i < NUM_BITMAP_WORDS; i++) {
+    num += (c3_uint_t) __builtin_popcountll(words[i]);
+  }
+  return num;
+}
+
+bool TagBitmap::find_value(const c3_ushort_t* values, c3_uint_t num, c3_uint_t value, c3_uint_t& pos) {
+  c3_uint_t low = 0;
+  c3_uint_t high = num;
+  while (low < high) {
+    c3_uint_t middle = (low + high) >> 1;
+    if (values[middle] < value) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  pos = low;
+  return low < num && values[low] == value;
+}
+
+void TagBitmap::copy_container(Container& dst, const Container& src) {
+  dst.c_key = src.c_key;
+  dst.c_num = src.c_num;
+  if (src.is_bitmap()) {
+    dst.c_capacity = 0;
+    dst.c_words = (c3_ulong_t*) fpc_memory.alloc(BITMAP_SIZE);
+    std::memcpy(dst.c_words, src.c_words, BITMAP_SIZE);
+  } else {
+    dst.c_capacity = src.c_num;
+    dst.c_values = alloc_values(src.c_num);
+    std::memcpy(dst.c_values, src.c_values, src.c_num * sizeof(c3_ushort_t));
+  }
+}
+
+void TagBitmap::dispose_container(Container& c) {
+  if (c.is_bitmap()) {
+    free_words(c.c_words);
+  } else {
+    free_values(c.c_values, c.c_capacity);
+  }
+}
+
+void TagBitmap::convert_to_bitmap(Container& c) {
+  c3_assert(!c.is_bitmap());
+  c3_ulong_t* words = alloc_words();
+  for (c3_uint_t i = 0; i < c.c_num; i++) {
+    set_bit(words, c.c_values[i]);
+  }
+  free_values(c.c_values, c.c_capacity);
+  c.c_capacity = 0;
+  c.c_words = words;
+}
+
+void TagBitmap::convert_to_array(Container& c) {
+  c3_assert(c.is_bitmap() && c.c_num);
+  c3_ushort_t* values = alloc_values(c.c_num);
+  c3_uint_t num = 0;
+  for (c3_uint_t i = 0; i < NUM_BITMAP_WORDS; i++) {
+    c3_ulong_t word = c.c_words[i];
+    while (word != 0) {
+      values[num++] = (c3_ushort_t)((i << 6) + (c3_uint_t) __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
+  c3_assert(num == c.c_num);
+  free_words(c.c_words);
+  c.c_capacity = num;
+  c.c_values = values;
+}
+
+void TagBitmap::normalize_container(Container& c) {
+  if (c.is_bitmap() && c.c_num != 0 && c.c_num <= MIN_BITMAP_CARDINALITY) {
+    convert_to_array(c);
+  }
+}
+
+void TagBitmap::intersect_containers(Container& a, const Container& b) {
+  c3_assert(a.c_key == b.c_key);
+  if (a.is_bitmap()) {
+    if (b.is_bitmap()) {
+      c3_ulong_t* a_words = a.c_words;
+      const c3_ulong_t* b_words = b.c_words;
+      c3_uint_t num = 0;
+      for (c3_uint_t i = 0; i < NUM_BITMAP_WORDS; i++) {
+        c3_ulong_t word = a_words[i] & b_words[i];
+        a_words[i] = word;
+        num += (c3_uint_t) __builtin_popcountll(word);
+      }
+      a.c_num = num;
+      normalize_container(a);
+    } else {
+      // result cannot be bigger than the array, so we build a new array
+      c3_ushort_t* values = alloc_values(b.c_num);
+      c3_uint_t num = 0;
+      for (c3_uint_t i = 0; i < b.c_num; i++) {
+        c3_ushort_t value = b.c_values[i];
+        if (test_bit(a.c_words, value)) {
+          values[num++] = value;
+        }
+      }
+      free_words(a.c_words);
+      a.c_num = num;
+      a.c_capacity = b.c_num;
+      a.c_values = values;
+    }
+  } else {
+    // intersection is done in place, since result cannot have more values than `a` already has
+    c3_ushort_t* values = a.c_values;
+    c3_uint_t num = 0;
+    if (b.is_bitmap()) {
+      for (c3_uint_t i = 0; i < a.c_num; i++) {
+        c3_ushort_t value = values[i];
+        if (test_bit(b.c_words, value)) {
+          values[num++] = value;
+        }
+      }
+    } else {
+      c3_uint_t i = 0, j = 0;
+      while (i < a.c_num && j < b.c_num) {
+        c3_ushort_t a_value = values[i];
+        c3_ushort_t b_value = b.c_values[j];
+        if (a_value < b_value) {
+          i++;
+        } else if (a_value > b_value) {
+          j++;
+        } else {
+          values[num++] = a_value;
+          i++;
+          j++;
+        }
+      }
+    }
+    a.c_num = num;
+  }
+}
+
+void TagBitmap::unite_containers(Container& a, const Container& b) {
+  c3_assert(a.c_key == b.c_key);
+  if (!a.is_bitmap()) {
+    if (!b.is_bitmap() && a.c_num + b.c_num <= MAX_ARRAY_CARDINALITY) {
+      c3_uint_t capacity = a.c_num + b.c_num;
+      c3_ushort_t* values = alloc_values(capacity);
+      c3_uint_t i = 0, j = 0, num = 0;
+      while (i < a.c_num && j < b.c_num) {
+        c3_ushort_t a_value = a.c_values[i];
+        c3_ushort_t b_value = b.c_values[j];
+        if (a_value < b_value) {
+          values[num++] = a_value;
+          i++;
+        } else if (a_value > b_value) {
+          values[num++] = b_value;
+          j++;
+        } else {
+          values[num++] = a_value;
+          i++;
+          j++;
+        }
+      }
+      while (i < a.c_num) {
+        values[num++] = a.c_values[i++];
+      }
+      while (j < b.c_num) {
+        values[num++] = b.c_values[j++];
+      }
+      free_values(a.c_values, a.c_capacity);
+      a.c_num = num;
+      a.c_capacity = capacity;
+      a.c_values = values;
+      return;
+    }
+    convert_to_bitmap(a);
+  }
+  c3_ulong_t* words = a.c_words;
+  if (b.is_bitmap()) {
+    const c3_ulong_t* b_words = b.c_words;
+    c3_uint_t num = 0;
+    for (c3_uint_t i = 0; i < NUM_BITMAP_WORDS; i++) {
+      c3_ulong_t word = words[i] | b_words[i];
+      words[i] = word;
+      num += (c3_uint_t) __builtin_popcountll(word);
+    }
+    a.c_num = num;
+  } else {
+    for (c3_uint_t i = 0; i < b.c_num; i++) {
+      set_bit(words, b.c_values[i]);
+    }
+    a.c_num = count_bits(words);
+  }
+  normalize_container(a);
+}
+
+void TagBitmap::subtract_containers(Container& a, const Container& b) {
+  c3_assert(a.c_key == b.c_key);
+  if (a.is_bitmap()) {
+    c3_ulong_t* words = a.c_words;
+    if (b.is_bitmap()) {
+      const c3_ulong_t* b_words = b.c_words;
+      c3_uint_t num = 0;
+      for (c3_uint_t i = 0; i < NUM_BITMAP_WORDS; i++) {
+        c3_ulong_t word = words[i] & ~b_words[i];
+        words[i] = word;
+        num += (c3_uint_t) __builtin_popcountll(word);
+      }
+      a.c_num = num;
+    } else {
+      c3_uint_t num = a.c_num;
+      for (c3_uint_t i = 0; i < b.c_num; i++) {
+        c3_ushort_t value = b.c_values[i];
+        if (test_bit(words, value)) {
+          clear_bit(words, value);
+          num--;
+        }
+      }
+      a.c_num = num;
+    }
+    normalize_container(a);
+  } else {
+    c3_ushort_t* values = a.c_values;
+    c3_uint_t num = 0;
+    if (b.is_bitmap()) {
+      for (c3_uint_t i = 0; i < a.c_num; i++) {
+        c3_ushort_t value = values[i];
+        if (!test_bit(b.c_words, value)) {
+          values[num++] = value;
+        }
+      }
+    } else {
+      c3_uint_t i = 0, j = 0;
+      while (i < a.c_num) {
+        c3_ushort_t value = values[i];
+        while (j < b.c_num && b.c_values[j] < value) {
+          j++;
+        }
+        if (j == b.c_num || b.c_values[j] != value) {
+          values[num++] = value;
+        }
+        i++;
+      }
+    }
+    a.c_num = num;
+  }
+}
+
+bool TagBitmap::find_container(c3_uint_t key, c3_uint_t& pos) const {
+  c3_uint_t low = 0;
+  c3_uint_t high = tb_num;
+  while (low < high) {
+    c3_uint_t middle = (low + high) >> 1;
+    if (tb_containers[middle].c_key < key) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  pos = low;
+  return low < tb_num && tb_containers[low].c_key == key;
+}
+
+void TagBitmap::reserve_containers(c3_uint_t num) {
+  if (num > tb_capacity) {
+    c3_uint_t capacity = tb_capacity != 0? tb_capacity: 4;
+    while (capacity < num) {
+      capacity *= 2;
+    }
+    if (tb_containers != nullptr) {
+      tb_containers = (Container*) fpc_memory.realloc(tb_containers,
+        capacity * sizeof(Container), tb_capacity * sizeof(Container));
+    } else {
+      tb_containers = (Container*) fpc_memory.alloc(capacity * sizeof(Container));
+    }
+    tb_capacity = capacity;
+  }
+}
+
+void TagBitmap::insert_container(c3_uint_t pos, c3_uint_t key, c3_ushort_t value) {
+  c3_assert(pos <= tb_num);
+  reserve_containers(tb_num + 1);
+  if (pos < tb_num) {
+    std::memmove(tb_containers + pos + 1, tb_containers + pos, (tb_num - pos) * sizeof(Container));
+  }
+  tb_num++;
+  Container& c = tb_containers[pos];
+  c.c_key = key;
+  c.c_num = 1;
+  c.c_capacity = INITIAL_ARRAY_CAPACITY;
+  c.c_values = alloc_values(INITIAL_ARRAY_CAPACITY);
+  c.c_values[0] = value;
+}
+
+void TagBitmap::remove_container(c3_uint_t pos) {
+  c3_assert(pos < tb_num);
+  dispose_container(tb_containers[pos]);
+  if (--tb_num > pos) {
+    std::memmove(tb_containers + pos, tb_containers + pos + 1, (tb_num - pos) * sizeof(Container));
+  }
+}
+
+c3_uint_t TagBitmap::get_cardinality() const {
+  c3_uint_t num = 0;
+  for (c3_uint_t i = 0; i < tb_num; i++) {
+    num += tb_containers[i].c_num;
+  }
+  return num;
+}
+
+void TagBitmap::add(c3_uint_t ordinal) {
+  c3_uint_t key = ordinal >> 16;
+  auto value = (c3_ushort_t) ordinal;
+  c3_uint_t pos;
+  if (find_container(key, pos)) {
+    Container& c = tb_containers[pos];
+    if (c.is_bitmap()) {
+      if (!test_bit(c.c_words, value)) {
+        set_bit(c.c_words, value);
+        c.c_num++;
+      }
+    } else {
+      c3_uint_t vpos;
+      if (!find_value(c.c_values, c.c_num, value, vpos)) {
+        if (c.c_num == MAX_ARRAY_CARDINALITY) {
+          convert_to_bitmap(c);
+          set_bit(c.c_words, value);
+        } else {
+          if (c.c_num == c.c_capacity) {
+            c3_uint_t capacity = min(c.c_capacity * 2, MAX_ARRAY_CARDINALITY);
+            c.c_values = (c3_ushort_t*) fpc_memory.realloc(c.c_values,
+              capacity * sizeof(c3_ushort_t), c.c_capacity * sizeof(c3_ushort_t));
+            c.c_capacity = capacity;
+          }
+          if (vpos < c.c_num) {
+            std::memmove(c.c_values + vpos + 1, c.c_values + vpos, (c.c_num - vpos) * sizeof(c3_ushort_t));
+          }
+          c.c_values[vpos] = value;
+        }
+        c.c_num++;
+      }
+    }
+  } else {
+    insert_container(pos, key, value);
+  }
+}
+
+void TagBitmap::remove(c3_uint_t ordinal) {
+  c3_uint_t key = ordinal >> 16;
+  auto value = (c3_ushort_t) ordinal;
+  c3_uint_t pos;
+  if (find_container(key, pos)) {
+    Container& c = tb_containers[pos];
+    if (c.is_bitmap()) {
+      if (test_bit(c.c_words, value)) {
+        clear_bit(c.c_words, value);
+        // going back to array only at half the conversion threshold, to avoid thrashing
+        if (--c.c_num <= MIN_BITMAP_CARDINALITY) {
+          convert_to_array(c);
+        }
+      }
+    } else {
+      c3_uint_t vpos;
+      if (find_value(c.c_values, c.c_num, value, vpos)) {
+        if (--c.c_num == 0) {
+          remove_container(pos);
+        } else if (vpos < c.c_num) {
+          std::memmove(c.c_values + vpos, c.c_values + vpos + 1, (c.c_num - vpos) * sizeof(c3_ushort_t));
+        }
+      }
+    }
+  }
+}
+
+void TagBitmap::assign(const TagBitmap& other) {
+  if (this != &other) {
+    dispose();
+    if (other.tb_num != 0) {
+      reserve_containers(other.tb_num);
+      for (c3_uint_t i = 0; i < other.tb_num; i++) {
+        copy_container(tb_containers[i], other.tb_containers[i]);
+      }
+      tb_num = other.tb_num;
+    }
+  }
+}
+
+void TagBitmap::intersect_with(const TagBitmap& other) {
+  c3_uint_t i = 0, j = 0, num = 0;
+  while (i < tb_num && j < other.tb_num) {
+    Container& a = tb_containers[i];
+    const Container& b = other.tb_containers[j];
+    if (a.c_key < b.c_key) {
+      dispose_container(a);
+      i++;
+    } else if (a.c_key > b.c_key) {
+      j++;
+    } else {
+      intersect_containers(a, b);
+      if (a.c_num != 0) {
+        tb_containers[num++] = a;
+      } else {
+        dispose_container(a);
+      }
+      i++;
+      j++;
+    }
+  }
+  while (i < tb_num) {
+    dispose_container(tb_containers[i++]);
+  }
+  tb_num = num;
+}
+
+void TagBitmap::unite_with(const TagBitmap& other) {
+  if (other.tb_num == 0 || this == &other) {
+    return;
+  }
+  // count resulting containers first, so that merging could be done in place, from the end
+  c3_uint_t i = 0, j = 0, num = 0;
+  while (i < tb_num && j < other.tb_num) {
+    c3_uint_t a_key = tb_containers[i].c_key;
+    c3_uint_t b_key = other.tb_containers[j].c_key;
+    if (a_key <= b_key) {
+      i++;
+    }
+    if (b_key <= a_key) {
+      j++;
+    }
+    num++;
+  }
+  num += (tb_num - i) + (other.tb_num - j);
+  reserve_containers(num);
+  c3_uint_t k = num;
+  i = tb_num;
+  j = other.tb_num;
+  while (j > 0) {
+    const Container& b = other.tb_containers[j - 1];
+    if (i > 0 && tb_containers[i - 1].c_key > b.c_key) {
+      tb_containers[--k] = tb_containers[--i];
+    } else if (i > 0 && tb_containers[i - 1].c_key == b.c_key) {
+      Container& a = tb_containers[--k];
+      a = tb_containers[--i];
+      unite_containers(a, b);
+      j--;
+    } else {
+      copy_container(tb_containers[--k], b);
+      j--;
+    }
+  }
+  c3_assert(k == i);
+  tb_num = num;
+}
+
+void TagBitmap::subtract(const TagBitmap& other) {
+  if (this == &other) {
+    dispose();
+    return;
+  }
+  c3_uint_t i = 0, j = 0, num = 0;
+  while (i < tb_num) {
+    Container& a = tb_containers[i];
+    while (j < other.tb_num && other.tb_containers[j].c_key < a.c_key) {
+      j++;
+    }
+    if (j < other.tb_num && other.tb_containers[j].c_key == a.c_key) {
+      subtract_containers(a, other.tb_containers[j]);
+    }
+    if (a.c_num != 0) {
+      tb_containers[num++] = a;
+    } else {
+      dispose_container(a);
+    }
+    i++;
+  }
+  tb_num = num;
+}
+
+void TagBitmap::dispose() {
+  if (tb_containers != nullptr) {
+    for (c3_uint_t i = 0; i < tb_num; i++) {
+      dispose_container(tb_containers[i]);
+    }
+    fpc_memory.free(tb_containers, tb_capacity * sizeof(Container));
+    tb_containers = nullptr;
+    tb_num = 0;
+    tb_capacity = 0;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TagIndex
+///////////////////////////////////////////////////////////////////////////////
+
+TagIndex::TagIndex() noexcept {
+  ti_slots = nullptr;
+  ti_capacity = 0;
+  ti_used = 0;
+  ti_free = PageObject::INVALID_ORDINAL;
+  ti_num_pages = 0;
+  ti_enabled = false;
+}
+
+TagBitmap& TagIndex::get_bitmap(TagObject* to) {
+  c3_assert(to);
+  TagBitmap* bitmap = to->get_bitmap();
+  if (bitmap == nullptr) {
+    bitmap = new (fpc_memory.alloc(sizeof(TagBitmap))) TagBitmap();
+    to->set_bitmap(bitmap);
+  }
+  return *bitmap;
+}
+
+c3_uint_t TagIndex::acquire_ordinal(PageObject* po) {
+  c3_uint_t ordinal = ti_free;
+  if (ordinal != PageObject::INVALID_ORDINAL) {
+    c3_uintptr_t slot = ti_slots[ordinal];
+    c3_assert(slot & 1);
+    ti_free = (c3_uint_t)(slot >> 1);
+  } else {
+    if (ti_used == ti_capacity) {
+      c3_uint_t capacity = ti_capacity * 2;
+      ti_slots = (c3_uintptr_t*) fpc_memory.realloc(ti_slots,
+        capacity * sizeof(c3_uintptr_t), ti_capacity * sizeof(c3_uintptr_t));
+      ti_capacity = capacity;
+    }
+    ordinal = ti_used++;
+  }
+  ti_slots[ordinal] = (c3_uintptr_t) po;
+  ti_num_pages++;
+  ti_universe.add(ordinal);
+  po->set_ordinal(ordinal);
+  return ordinal;
+}
+
+void TagIndex::enable() {
+  if (!ti_enabled) {
+    c3_assert(ti_slots == nullptr);
+    ti_slots = (c3_uintptr_t*) fpc_memory.alloc(INITIAL_CAPACITY * sizeof(c3_uintptr_t));
+    ti_capacity = INITIAL_CAPACITY;
+    ti_enabled = true;
+  }
+}
+
+void TagIndex::dispose() {
+  /*
+   * Bitmaps of the tags are not disposed here: the caller (tag store) has to enumerate its tags and
+   * call `dispose_tag()` on each one of them.
+   */
+  if (ti_slots != nullptr) {
+    for (c3_uint_t i = 0; i < ti_used; i++) {
+      c3_uintptr_t slot = ti_slots[i];
+      if ((slot & 1) == 0) {
+        ((PageObject*) slot)->set_ordinal(PageObject::INVALID_ORDINAL);
+      }
+    }
+    fpc_memory.free(ti_slots, ti_capacity * sizeof(c3_uintptr_t));
+    ti_slots = nullptr;
+  }
+  ti_capacity = 0;
+  ti_used = 0;
+  ti_free = PageObject::INVALID_ORDINAL;
+  ti_num_pages = 0;
+  ti_universe.dispose();
+  ti_enabled = false;
+}
+
+void TagIndex::link(PageObject* po, TagObject* to) {
+  c3_assert(ti_enabled && po);
+  c3_uint_t ordinal = po->get_ordinal();
+  if (ordinal == PageObject::INVALID_ORDINAL) {
+    ordinal = acquire_ordinal(po);
+  }
+  get_bitmap(to).add(ordinal);
+}
+
+void TagIndex::unlink(PageObject* po, TagObject* to) {
+  c3_assert(ti_enabled && po && po->get_ordinal() != PageObject::INVALID_ORDINAL && to);
+  TagBitmap* bitmap = to->get_bitmap();
+  if (bitmap != nullptr) {
+    bitmap->remove(po->get_ordinal());
+  }
+}
+
+void TagIndex::remove_page(PageObject* po) {
+  c3_assert(ti_enabled && po);
+  c3_uint_t ordinal = po->get_ordinal();
+  if (ordinal != PageObject::INVALID_ORDINAL) {
+    c3_assert(ordinal < ti_used && ti_slots[ordinal] == (c3_uintptr_t) po && ti_num_pages);
+    ti_universe.remove(ordinal);
+    ti_slots[ordinal] = ((c3_uintptr_t) ti_free << 1) | 1;
+    ti_free = ordinal;
+    ti_num_pages--;
+    po->set_ordinal(PageObject::INVALID_ORDINAL);
+  }
+}
+
+void TagIndex::dispose_tag(TagObject* to) {
+  c3_assert(to);
+  TagBitmap* bitmap = to->get_bitmap();
+  if (bitmap != nullptr) {
+    bitmap->~TagBitmap();
+    fpc_memory.free(bitmap, sizeof(TagBitmap));
+    to->set_bitmap(nullptr);
+  }
+}
+
+void TagIndex::find_all(TagBitmap& result, TagObject** tags, c3_uint_t ntags) const {
+  c3_assert(ti_enabled && tags && ntags);
+  // caller is supposed to pass tag with the shortest chain first
+  TagBitmap* bitmap = tags[0]->get_bitmap();
+  if (bitmap != nullptr) {
+    result.assign(*bitmap);
+    for (c3_uint_t i = 1; i < ntags && !result.is_empty(); i++) {
+      bitmap = tags[i]->get_bitmap();
+      if (bitmap != nullptr) {
+        result.intersect_with(*bitmap);
+      } else {
+        result.dispose();
+      }
+    }
+  } else {
+    result.dispose();
+  }
+}
+
+void TagIndex::find_any(TagBitmap& result, TagObject** tags, c3_uint_t ntags) const {
+  c3_assert(ti_enabled && tags && ntags);
+  result.dispose();
+  for (c3_uint_t i = 0; i < ntags; i++) {
+    TagBitmap* bitmap = tags[i]->get_bitmap();
+    if (bitmap != nullptr) {
+      result.unite_with(*bitmap);
+    }
+  }
+}
+
+void TagIndex::find_none(TagBitmap& result, TagObject** tags, c3_uint_t ntags) const {
+  c3_assert(ti_enabled && tags);
+  result.assign(ti_universe);
+  for (c3_uint_t i = 0; i < ntags && !result.is_empty(); i++) {
+    TagBitmap* bitmap = tags[i]->get_bitmap();
+    if (bitmap != nullptr) {
+      result.subtract(*bitmap);
+    }
+  }
+}
+
+} // CyberCache
@@ -0,0 +1,208 @@
+/*
+ * CyberCache Cluster
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Compressed bitmap index of tagged page objects used by the tag manager.
+ */
+#ifndef _HT_TAG_INDEX_H
+#define _HT_TAG_INDEX_H
+
+#include "c3lib/c3lib.h"
+#include "ht_objects.h"
+
+namespace CyberCache {
+
+/**
+ * Compressed set of page ordinals, organized the same way as "Roaring" bitmaps: 32-bit ordinals are
+ * split into "containers" by their upper 16 bits, and each container stores lower 16 bits of its
+ * ordinals either as a sorted array (if there are few of them), or as a 64k-bit bitmap. Set operations
+ * are then done container by container, using merges of sorted arrays, bit tests, or word-wise logical
+ * operations on bitmaps (which compiler can vectorize), whichever fits the pair of containers at hand.
+ *
+ * All memory is allocated from the FPC domain. The bitmap is not thread-safe; it is only ever accessed
+ * by the tag manager thread.
+ */
+class TagBitmap {
+  /// Array containers are converted to bitmaps when they grow beyond this cardinality
+  static constexpr c3_uint_t MAX_ARRAY_CARDINALITY = 4096;
+  /// Bitmap containers are converted back to arrays when their cardinality drops down to this value
+  static constexpr c3_uint_t MIN_BITMAP_CARDINALITY = 2048;
+  /// Number of 64-bit words in a bitmap container
+  static constexpr c3_uint_t NUM_BITMAP_WORDS = 65536 / 64;
+  /// Size of the bitmap of a bitmap container, bytes
+  static constexpr size_t BITMAP_SIZE = NUM_BITMAP_WORDS * sizeof(c3_ulong_t);
+  /// Initial capacity of array containers
+  static constexpr c3_uint_t INITIAL_ARRAY_CAPACITY = 4;
+
+  /// Container of ordinals sharing the same upper 16 bits
+  struct Container {
+    c3_uint_t c_key;      // upper 16 bits of all ordinals in the container
+    c3_uint_t c_num;      // number of ordinals in the container; never zero
+    c3_uint_t c_capacity; // number of allocated array elements, or zero for bitmap containers
+    union {
+      c3_ushort_t* c_values; // sorted lower 16 bits of the ordinals (array containers)
+      c3_ulong_t*  c_words;  // bitmap of the lower 16 bits of the ordinals (bitmap containers)
+    };
+
+    bool is_bitmap() const { return c_capacity == 0; }
+  };
+
+  Container* tb_containers; // containers sorted by their keys
+  c3_uint_t  tb_num;        // number of containers in use
+  c3_uint_t  tb_capacity;   // number of allocated containers
+
+  static c3_ushort_t* alloc_values(c3_uint_t capacity);
+  static void free_values(c3_ushort_t* values, c3_uint_t capacity);
+  static c3_ulong_t* alloc_words();
+  static void free_words(c3_ulong_t* words);
+  static c3_uint_t count_bits(const c3_ulong_t* words);
+  static bool test_bit(const c3_ulong_t* words, c3_uint_t value) {
+    return (words[value >> 6] & ((c3_ulong_t) 1 << (value & 63))) != 0;
+  }
+  static void set_bit(c3_ulong_t* words, c3_uint_t value) {
+    words[value >> 6] |= (c3_ulong_t) 1 << (value & 63);
+  }
+  static void clear_bit(c3_ulong_t* words, c3_uint_t value) {
+    words[value >> 6] &= ~((c3_ulong_t) 1 << (value & 63));
+  }
+  static bool find_value(const c3_ushort_t* values, c3_uint_t num, c3_uint_t value, c3_uint_t& pos);
+
+  static void copy_container(Container& dst, const Container& src);
+  static void dispose_container(Container& c);
+  static void convert_to_bitmap(Container& c);
+  static void convert_to_array(Container& c);
+  static void normalize_container(Container& c);
+  static void intersect_containers(Container& a, const Container& b);
+  static void unite_containers(Container& a, const Container& b);
+  static void subtract_containers(Container& a, const Container& b);
+
+  bool find_container(c3_uint_t key, c3_uint_t& pos) const;
+  void insert_container(c3_uint_t pos, c3_uint_t key, c3_ushort_t value);
+  void remove_container(c3_uint_t pos);
+  void reserve_containers(c3_uint_t num);
+
+public:
+  TagBitmap() noexcept {
+    tb_containers = nullptr;
+    tb_num = 0;
+    tb_capacity = 0;
+  }
+  TagBitmap(const TagBitmap&) = delete;
+  TagBitmap(TagBitmap&&) = delete;
+  ~TagBitmap() { dispose(); }
+
+  TagBitmap& operator=(const TagBitmap&) = delete;
+  TagBitmap& operator=(TagBitmap&&) = delete;
+
+  bool is_empty() const { return tb_num == 0; }
+  c3_uint_t get_cardinality() const;
+
+  // modification of individual ordinals
+  void add(c3_uint_t ordinal);
+  void remove(c3_uint_t ordinal);
+
+  // set operations; results are stored in `this` bitmap
+  void assign(const TagBitmap& other);
+  void intersect_with(const TagBitmap& other);
+  void unite_with(const TagBitmap& other);
+  void subtract(const TagBitmap& other);
+  void dispose();
+
+  /**
+   * Calls specified function for each ordinal in the set, in ascending order. The bitmap must not be
+   * modified by the function.
+   *
+   * @param proc Function (or functor, or lambda) accepting ordinal as its only argument
+   */
+  template <class P> void for_each(P proc) const {
+    for (c3_uint_t i = 0; i < tb_num; i++) {
+      const Container& c = tb_containers[i];
+      const c3_uint_t base = c.c_key << 16;
+      if (c.is_bitmap()) {
+        for (c3_uint_t j = 0; j < NUM_BITMAP_WORDS; j++) {
+          c3_ulong_t word = c.c_words[j];
+          while (word != 0) {
+            proc(base + (j << 6) + (c3_uint_t) __builtin_ctzll(word));
+            word &= word - 1;
+          }
+        }
+      } else {
+        for (c3_uint_t k = 0; k < c.c_num; k++) {
+          proc(base + c.c_values[k]);
+        }
+      }
+    }
+  }
+};
+
+/**
+ * Index of tagged page objects maintained by the tag manager, if enabled.
+ *
+ * Each page object linked into tag chains is assigned a dense "ordinal" (freed ordinals are re-used,
+ * so that bitmaps stay compact), and each tag gets a bitmap of ordinals of the pages marked with it.
+ * The index also maintains "universe" bitmap of all linked pages, which is needed to answer "not
+ * matching any tags" queries.
+ */
+class TagIndex {
+  static constexpr c3_uint_t INITIAL_CAPACITY = 1024;
+
+  /*
+   * Slots contain either pointers to page objects, or, for unused slots, ordinal of the next free slot
+   * shifted left by one and with lowest bit set (page objects are always aligned).
+   */
+  c3_uintptr_t* ti_slots;     // array of page objects indexed by ordinals
+  c3_uint_t     ti_capacity;  // number of allocated slots
+  c3_uint_t     ti_used;      // number of slots that had ever been used (high-water mark)
+  c3_uint_t     ti_free;      // first free slot, or `INVALID_ORDINAL`
+  c3_uint_t     ti_num_pages; // number of indexed page objects
+  TagBitmap     ti_universe;  // ordinals of all indexed page objects
+  bool          ti_enabled;   // whether the index is maintained
+
+  c3_uint_t acquire_ordinal(PageObject* po);
+  static TagBitmap& get_bitmap(TagObject* to);
+
+public:
+  TagIndex() noexcept;
+  TagIndex(const TagIndex&) = delete;
+  TagIndex(TagIndex&&) = delete;
+  ~TagIndex() { dispose(); }
+
+  TagIndex& operator=(const TagIndex&) = delete;
+  TagIndex& operator=(TagIndex&&) = delete;
+
+  bool is_enabled() const { return ti_enabled; }
+  c3_uint_t get_num_pages() const { return ti_num_pages; }
+  void enable() C3_FUNC_COLD;
+  void dispose() C3_FUNC_COLD;
+
+  // index maintenance
+  void link(PageObject* po, TagObject* to);
+  void unlink(PageObject* po, TagObject* to);
+  void remove_page(PageObject* po);
+  static void dispose_tag(TagObject* to);
+
+  // queries
+  PageObject* get_page(c3_uint_t ordinal) const {
+    c3_assert(ordinal < ti_used && (ti_slots[ordinal] & 1) == 0);
+    return (PageObject*) ti_slots[ordinal];
+  }
+  void find_all(TagBitmap& result, TagObject** tags, c3_uint_t ntags) const;
+  void find_any(TagBitmap& result, TagObject** tags, c3_uint_t ntags) const;
+  void find_none(TagBitmap& result, TagObject** tags, c3_uint_t ntags) const;
+};
+
+} // CyberCache
+
+#endif // _HT_TAG_INDEX_H
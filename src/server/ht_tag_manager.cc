@@ -18,13 +18,180 @@
 #include "pl_socket_pipelines.h"
 #include "pl_net_configuration.h"
 
+#include <algorithm>
+
 namespace CyberCache {
 
+///////////////////////////////////////////////////////////////////////////////
+// TagCommandJob
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Shared state of a command executed by all shards of the tag manager. Each shard collects results
+ * into its own list, and then merges that list into the job; the shard that completes the command last
+ * sends the response, and then disposes both the command and the job.
+ */
+class TagCommandJob {
+  /// Reference to a string stored in a payload list
+  struct list_string_t {
+    const char* ls_chars;  // string characters
+    c3_uint_t   ls_length; // string length
+
+    bool operator<(const list_string_t& other) const {
+      if (ls_length != other.ls_length) {
+        return ls_length < other.ls_length;
+      }
+      return std::memcmp(ls_chars, other.ls_chars, ls_length) < 0;
+    }
+    bool operator==(const list_string_t& other) const {
+      return ls_length == other.ls_length && std::memcmp(ls_chars, other.ls_chars, ls_length) == 0;
+    }
+  };
+
+  std::mutex              tcj_mutex;   // guards merging of shard results
+  CommandReader* const    tcj_cr;      // command being executed
+  SocketResponseWriter*   tcj_srw;     // response object
+  PayloadListChunkBuilder tcj_list;    // merged results of all shards
+  command_status_t        tcj_status;  // worst of the statuses reported by the shards so far
+  c3_uint_t               tcj_pending; // number of shards that have not completed the command yet
+
+  TagCommandJob(CommandReader* cr, SocketResponseWriter* srw, c3_uint_t num_shards):
+    tcj_cr(cr), tcj_srw(srw), tcj_list(*srw, server_net_config, 0, 0, 0) {
+    tcj_status = CS_SUCCESS;
+    tcj_pending = num_shards;
+  }
+
+  bool post_unique_list_response(ResponseObjectConsumer& consumer);
+  void send_response(ResponseObjectConsumer& consumer);
+
+public:
+  static TagCommandJob* create(CommandReader* cr, c3_uint_t num_shards);
+  static void dispose(TagCommandJob* job);
+
+  SocketResponseWriter& get_response_writer() const { return *tcj_srw; }
+  void complete(ResponseObjectConsumer& consumer, command_status_t status, const PayloadListChunkBuilder* list);
+};
+
+TagCommandJob* TagCommandJob::create(CommandReader* cr, c3_uint_t num_shards) {
+  c3_assert(cr && num_shards > 1);
+  SocketResponseWriter* srw = ResponseObjectConsumer::create_response(*cr);
+  auto job = alloc<TagCommandJob>(fpc_memory);
+  return new (job) TagCommandJob(cr, srw, num_shards);
+}
+
+void TagCommandJob::dispose(TagCommandJob* job) {
+  c3_assert(job);
+  job->~TagCommandJob();
+  dealloc<TagCommandJob>(fpc_memory, job);
+}
+
+bool TagCommandJob::post_unique_list_response(ResponseObjectConsumer& consumer) {
+  /*
+   * Tags are stored by all shards that have objects marked with them, so shards' lists of tags may
+   * contain duplicates. We sort references to the strings (they are not copied), and then build new list
+   * from the unique ones.
+   */
+  c3_uint_t count = tcj_list.get_count();
+  if (count < 2) {
+    return consumer.post_list_response(tcj_srw, tcj_list);
+  }
+  size_t size = count * sizeof(list_string_t);
+  auto strings = (list_string_t*) fpc_memory.alloc(size);
+  const c3_byte_t* p = tcj_list.get_buffer();
+  for (c3_uint_t i = 0; i < count; i++) {
+    // see `ListChunkBuilder::put_string()`
+    c3_uint_t length = 0;
+    c3_byte_t n;
+    do {
+      n = *p++;
+      length += n;
+    } while (n == 255);
+    strings[i].ls_chars = (const char*) p;
+    strings[i].ls_length = length;
+    p += length;
+  }
+  c3_assert(p == tcj_list.get_buffer() + tcj_list.get_size());
+  std::sort(strings, strings + count);
+  c3_uint_t num_unique = (c3_uint_t)(std::unique(strings, strings + count) - strings);
+  PayloadListChunkBuilder list(*tcj_srw, server_net_config, num_unique, num_unique, 0);
+  bool result = true;
+  for (c3_uint_t j = 0; j < num_unique && result; j++) {
+    result = list.add(strings[j].ls_length, strings[j].ls_chars);
+  }
+  fpc_memory.free(strings, size);
+  if (result) {
+    return consumer.post_list_response(tcj_srw, list);
+  }
+  ReaderWriter::dispose(tcj_srw);
+  return false;
+}
+
+void TagCommandJob::send_response(ResponseObjectConsumer& consumer) {
+  bool result;
+  switch (tcj_status) {
+    case CS_SUCCESS:
+      switch (tcj_cr->get_command_id()) {
+        case CMD_CLEAN:
+          result = consumer.post_ok_response(tcj_srw);
+          break;
+        case CMD_GETTAGS:
+          result = post_unique_list_response(consumer);
+          break;
+        default:
+          result = consumer.post_list_response(tcj_srw, tcj_list);
+      }
+      if (!result) {
+        consumer.post_internal_error_response(*tcj_cr);
+      }
+      break;
+    case CS_FORMAT_ERROR:
+      ReaderWriter::dispose(tcj_srw);
+      consumer.post_format_error_response(*tcj_cr);
+      break;
+    default:
+      ReaderWriter::dispose(tcj_srw);
+      consumer.post_internal_error_response(*tcj_cr);
+  }
+}
+
+void TagCommandJob::complete(ResponseObjectConsumer& consumer, command_status_t status,
+  const PayloadListChunkBuilder* list) {
+  {
+    std::lock_guard<std::mutex> lock(tcj_mutex);
+    if (status == CS_SUCCESS && list != nullptr && !tcj_list.add(*list)) {
+      status = CS_INTERNAL_ERROR;
+    }
+    if (status < tcj_status) {
+      tcj_status = status;
+    }
+    c3_assert(tcj_pending);
+    if (--tcj_pending != 0) {
+      return;
+    }
+  }
+  // this was the last shard working on the command
+  send_response(consumer);
+  ReaderWriter::dispose(tcj_cr);
+  dispose(this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TagStore
+///////////////////////////////////////////////////////////////////////////////
+
 TagStore::TagStore() noexcept:
   ObjectStore("Tag manager", DOMAIN_FPC, DEFAULT_NUM_TABLES, DEFAULT_TABLE_CAPACITY),
   ts_queue(DOMAIN_FPC, HO_TAG_MANAGER, DEFAULT_QUEUE_CAPACITY, DEFAULT_MAX_QUEUE_CAPACITY, 255) {
   ts_page_store = nullptr;
   ts_untagged = nullptr;
+  ts_pending = nullptr;
+  ts_pending_capacity = 0;
+  ts_num_pending.store(0, std::memory_order_relaxed);
+  ts_clean_batch = 0;
+  ts_cfg_clean_batch = 0;
+  ts_shard = 0;
+  ts_num_shards = 1;
+  ts_use_index = false;
   ts_quitting = false;
 }
 
@@ -42,9 +209,20 @@ void TagStore::allocate_tag_store() {
 }
 
 void TagStore::dispose_tag_store() {
+  // tag index is disposed first, so that unlinking objects would not have to update it
+  if (ts_index.is_enabled()) {
+    disable_tag_index();
+  }
+  // pages hidden by asynchronous `CLEAN` are unlinked along with all others, below
+  if (ts_pending != nullptr) {
+    fpc_memory.free(ts_pending, ts_pending_capacity * sizeof(PageObject*));
+    ts_pending = nullptr;
+    ts_pending_capacity = 0;
+    ts_num_pending.store(0, std::memory_order_relaxed);
+  }
   // if FPC store had already been initialized...
   if (ts_page_store != nullptr) {
-    // ... unlink all tags from all objects
+    // ... unlink all tags from all objects of this shard
     ts_page_store->enumerate_all(this, object_cleanup_unlink_callback);
   }
   // both dispose() calls, below, have internal guards allowing calling them multiple times
@@ -135,21 +313,94 @@ void TagStore::dispose_tag(TagObject* to) const {
   c3_assert(to && !to->get_num_marked_objects());
   HashTable& ht = table(get_table_index(to));
   ht.remove(to);
+  TagIndex::dispose_tag(to);
   fpc_memory.free(to, to->get_size());
 }
 
 void TagStore::unlink_object_tags(PageObject* po) const {
   c3_assert(po && po->flags_are_set(HOF_LINKED_BY_TM) && po->get_num_tag_refs());
+  bool indexed = ts_index.is_enabled();
   c3_uint_t i = 0;
   do {
-    TagObject* empty = po->get_tag_ref(i).unlink();
+    TagRef& ref = po->get_tag_ref(i);
+    if (indexed) {
+      ts_index.unlink(po, ref.get_tag_object());
+    }
+    TagObject* empty = ref.unlink();
     if (empty != nullptr) { // unlink() guarantees that it's not the "untagged" chain
       dispose_tag(empty);
     }
   } while (++i < po->get_num_tag_refs());
+  if (indexed) {
+    ts_index.remove_page(po);
+  }
   po->clear_flags(HOF_LINKED_BY_TM);
 }
 
+void TagStore::delete_object(PageObject* po, LockableObjectGuard& guard) const {
+  c3_assert(po && guard.is_locked() && po->flags_are_clear(HOF_BEING_DELETED) &&
+    po->flags_are_set(HOF_LINKED_BY_TM));
+  // from this point on, connection threads will not "see" the object
+  po->set_flags(HOF_BEING_DELETED);
+  if (ts_clean_batch != 0) {
+    // object's tags will be unlinked later, by `unlink_pending_objects()`
+    guard.unlock();
+    add_pending_object(po);
+  } else {
+    unlink_object_tags(po);
+    guard.unlock();
+    // notify optimizer
+    get_optimizer().post_delete_message(po);
+  }
+}
+
+void TagStore::add_pending_object(PageObject* po) const {
+  c3_uint_t num = ts_num_pending.load(std::memory_order_relaxed);
+  if (num == ts_pending_capacity) {
+    c3_uint_t capacity = ts_pending_capacity != 0? ts_pending_capacity * 2: 256;
+    if (ts_pending != nullptr) {
+      ts_pending = (PageObject**) fpc_memory.realloc(ts_pending,
+        capacity * sizeof(PageObject*), ts_pending_capacity * sizeof(PageObject*));
+    } else {
+      ts_pending = (PageObject**) fpc_memory.alloc(capacity * sizeof(PageObject*));
+    }
+    ts_pending_capacity = capacity;
+  }
+  ts_pending[num++] = po;
+  ts_num_pending.store(num, std::memory_order_relaxed);
+  PERF_INCREMENT_COUNTER(Tags_Deferred_Unlinks)
+  PERF_UPDATE_MAXIMUM(Tags_Max_Deferred_Unlinks, num)
+}
+
+void TagStore::unlink_pending_objects() {
+  /*
+   * Objects in the array are marked as "being deleted" but are still linked into our tag chains, and
+   * nobody else would unlink them: connection threads and optimizer never delete objects that are
+   * already marked, and all other tag manager code paths skip them. Therefore, the objects cannot be
+   * disposed before we process them here.
+   *
+   * If asynchronous mode had been turned off while there were pending objects, all of them are unlinked
+   * at once.
+   */
+  c3_uint_t num = ts_num_pending.load(std::memory_order_relaxed);
+  c3_assert(num && ts_pending);
+  c3_uint_t batch = ts_clean_batch != 0 && ts_clean_batch < num? ts_clean_batch: num;
+  do {
+    PageObject* po = ts_pending[--num];
+    LockableObjectGuard guard(po);
+    if (guard.is_locked()) {
+      c3_assert(po->flags_are_set(HOF_BEING_DELETED | HOF_LINKED_BY_TM));
+      unlink_object_tags(po);
+      po->try_dispose_buffer(fpc_memory);
+      guard.unlock();
+      // notify optimizer
+      get_optimizer().post_delete_message(po);
+    }
+  } while (--batch > 0);
+  ts_num_pending.store(num, std::memory_order_relaxed);
+  PERF_INCREMENT_COUNTER(Tags_Deferred_Unlink_Batches)
+}
+
 void TagStore::unlink_object(PayloadHashObject* pho) const {
   /*
    * An "unlink object" message came from FPC optimizer that was doing garbage collection.
@@ -189,9 +440,9 @@ bool TagStore::tag_enum_callback(void* context, HashObject* ho) {
 
 bool TagStore::object_cleanup_unlink_callback(void* context, HashObject* ho) {
   c3_assert(context && ho && ho->get_type() == HOT_PAGE_OBJECT);
-  if (ho->flags_are_set(HOF_LINKED_BY_TM)) {
+  auto tag_store = (TagStore*) context;
+  if (ho->flags_are_set(HOF_LINKED_BY_TM) && tag_store->owns(ho)) {
     auto po = (PageObject*) ho;
-    auto tag_store = (TagStore*) context;
     tag_store->unlink_object_tags(po);
   }
   return true;
@@ -199,11 +450,15 @@ bool TagStore::object_cleanup_unlink_callback(void* context, HashObject* ho) {
 
 bool TagStore::object_unlink_callback(void* context, HashObject* ho) {
   c3_assert(context && ho && ho->get_type() == HOT_PAGE_OBJECT);
+  auto info = (tag_unlink_info_t*) context;
+  if (!info->tui_tag_store.owns(ho)) {
+    // objects of other shards are linked into other shards' tags
+    return true;
+  }
   auto po = (PageObject*) ho;
   LockableObjectGuard guard(po);
   if (guard.is_locked()) {
     if (po->flags_are_clear(HOF_BEING_DELETED) && po->flags_are_set(HOF_LINKED_BY_TM)) {
-      auto info = (tag_unlink_info_t*) context;
       bool do_unlink;
       switch (info->tui_condition) {
         case TSC_ALWAYS:
@@ -221,11 +476,7 @@ bool TagStore::object_unlink_callback(void* context, HashObject* ho) {
           do_unlink = false;
       }
       if (do_unlink) {
-        info->tui_tag_store.unlink_object_tags(po);
-        po->set_flags(HOF_BEING_DELETED);
-        guard.unlock();
-        // notify optimizer
-        info->tui_tag_store.get_optimizer().post_delete_message(po);
+        info->tui_tag_store.delete_object(po, guard);
       }
     }
   }
@@ -234,10 +485,13 @@ bool TagStore::object_unlink_callback(void* context, HashObject* ho) {
 
 bool TagStore::object_enum_callback(void* context, HashObject* ho) {
   c3_assert(context && ho && ho->get_type() == HOT_PAGE_OBJECT);
+  auto info = (tag_object_info_t*) context;
+  if (info->toi_tag_store != nullptr && !info->toi_tag_store->owns(ho)) {
+    return true;
+  }
   auto po = (PageObject*) ho;
   LockableObjectGuard guard(po);
   if (guard.is_locked()) {
-    auto info = (tag_object_info_t*) context;
     if (po->flags_are_clear(HOF_BEING_DELETED) && po->flags_are_set(HOF_LINKED_BY_TM)) {
       bool do_list;
       switch (info->toi_condition) {
@@ -275,12 +529,13 @@ bool TagStore::unlink_all_objects() const {
 
 bool TagStore::enum_objects(PayloadListChunkBuilder& list, TagObject** tags, c3_uint_t ntags,
   TagStore::tag_select_condition_t condition) const {
-  tag_object_info_t info(list, tags, ntags, condition);
+  tag_object_info_t info(this, list, tags, ntags, condition);
   return get_page_store().lock_enumerate_all(&info, object_enum_callback);
 }
 
-bool TagStore::enum_all_objects(PayloadListChunkBuilder& list) const {
-  return enum_objects(list, nullptr, 0, TSC_ALWAYS);
+bool TagStore::enum_all_objects(PayloadListChunkBuilder& list, bool all_shards) const {
+  tag_object_info_t info(all_shards? nullptr: this, list, nullptr, 0, TSC_ALWAYS);
+  return get_page_store().lock_enumerate_all(&info, object_enum_callback);
 }
 
 void TagStore::add_dummy_references(TagObject** tags, c3_uint_t ntags) {
@@ -303,6 +558,73 @@ void TagStore::remove_dummy_references(TagObject** tags, c3_uint_t ntags) const
   }
 }
 
+void TagStore::unlink_indexed_objects(const TagBitmap& objects) const {
+  /*
+   * Tag chains are not walked here at all: the set of objects had been computed using bitmaps of the
+   * tags, and only the objects that made it into the result are locked and processed. Unlinking objects
+   * releases their ordinals, but those can only be re-used by subsequent commands.
+   */
+  objects.for_each([this](c3_uint_t ordinal) {
+    PageObject* po = ts_index.get_page(ordinal);
+    if (po->flags_are_clear(HOF_BEING_DELETED)) {
+      LockableObjectGuard guard(po);
+      if (guard.is_locked()) {
+        if (po->flags_are_clear(HOF_BEING_DELETED)) {
+          delete_object(po, guard);
+        }
+      }
+    }
+  });
+}
+
+void TagStore::enum_indexed_objects(PayloadListChunkBuilder& list, const TagBitmap& objects) const {
+  objects.for_each([this, &list](c3_uint_t ordinal) {
+    PageObject* po = ts_index.get_page(ordinal);
+    LockableObjectGuard guard(po);
+    if (guard.is_locked()) {
+      if (po->flags_are_clear(HOF_BEING_DELETED)) {
+        c3_assert(po->flags_are_set(HOF_LINKED_BY_TM));
+        list.add(po->get_name_length(), po->get_name());
+      }
+    }
+  });
+}
+
+bool TagStore::tag_index_build_callback(void* context, HashObject* ho) {
+  c3_assert(context && ho && ho->get_type() == HOT_TAG_OBJECT);
+  auto tag_store = (TagStore*) context;
+  auto to = (TagObject*) ho;
+  TagRef* ref = to->get_first_ref();
+  while (ref != nullptr) {
+    tag_store->ts_index.link(ref->get_page_object(), to);
+    ref = ref->get_next_ref();
+  }
+  return true;
+}
+
+bool TagStore::tag_index_dispose_callback(void* context, HashObject* ho) {
+  c3_assert(ho && ho->get_type() == HOT_TAG_OBJECT);
+  TagIndex::dispose_tag((TagObject*) ho);
+  return true;
+}
+
+void TagStore::enable_tag_index() {
+  if (!ts_index.is_enabled()) {
+    ts_index.enable();
+    enumerate_all(this, tag_index_build_callback);
+    c3_uint_t num = ts_index.get_num_pages();
+    log(LL_VERBOSE, "%s: bitmap index enabled (%u page%s)", get_name(), num, plural(num));
+  }
+}
+
+void TagStore::disable_tag_index() {
+  if (ts_index.is_enabled()) {
+    enumerate_all(nullptr, tag_index_dispose_callback);
+    ts_index.dispose();
+    log(LL_VERBOSE, "%s: bitmap index disabled", get_name());
+  }
+}
+
 void TagStore::process_save_command(CommandReader& cr, PayloadHashObject* pho) {
   /*
    * A `SAVE` command came from a connection thread.
@@ -319,6 +641,15 @@ void TagStore::process_save_command(CommandReader& cr, PayloadHashObject* pho) {
   LockableObjectGuard guard(po);
   if (guard.is_locked()) {
 
+    /*
+     * A concurrent request could have managed to delete the object before it was linked into TM chains
+     * or, if the object is still linked, it could have been hidden by an asynchronous `CLEAN` (and will be
+     * unlinked later); either way, there is nothing to update.
+     */
+    if (po->flags_are_set(HOF_BEING_DELETED)) {
+      return;
+    }
+
     // 1) unlink (but not dispose yet!) existing tags
     c3_uint_t num_existing_tags = po->get_num_tag_refs();
     TagObject* empty_tags[num_existing_tags];
@@ -327,16 +658,17 @@ void TagStore::process_save_command(CommandReader& cr, PayloadHashObject* pho) {
       c3_assert(num_existing_tags);
       c3_uint_t i = 0;
       do {
-        TagObject* empty = po->get_tag_ref(i).unlink();
+        TagRef& ref = po->get_tag_ref(i);
+        if (ts_index.is_enabled()) {
+          // the object retains its ordinal, only tag bitmaps are updated
+          ts_index.unlink(po, ref.get_tag_object());
+        }
+        TagObject* empty = ref.unlink();
         if (empty != nullptr) { // unlink() guarantees that it's not the "untagged" chain
           empty_tags[num_empty_tags++] = empty;
         }
       } while (++i < num_existing_tags);
     } else {
-      if (po->flags_are_set(HOF_BEING_DELETED)) {
-        // a concurrent request managed to delete the object before it was linked into TM chains
-        return;
-      }
       c3_assert(num_existing_tags == 0);
     }
 
@@ -373,11 +705,17 @@ void TagStore::process_save_command(CommandReader& cr, PayloadHashObject* pho) {
       for (c3_uint_t l = 0; l < num_unique_tags; l++) {
         TagObject* to = find_create_tag(tag_names[l], tag_name_lengths[l]);
         po->get_tag_ref(l).link(po, to);
+        if (ts_index.is_enabled()) {
+          ts_index.link(po, to);
+        }
       }
     } else {
       po->set_num_tag_refs(1);
       c3_assert(ts_untagged);
       po->get_tag_ref(0).link(po, ts_untagged);
+      if (ts_index.is_enabled()) {
+        ts_index.link(po, ts_untagged);
+      }
     }
 
     // 3) remove tags that remain empty after we re-linked new tags
@@ -425,7 +763,7 @@ void TagStore::process_remove_command(PayloadHashObject* pho) {
   }
 }
 
-void TagStore::process_clean_command(CommandReader& cr) {
+void TagStore::process_clean_command(CommandReader& cr, TagCommandJob* job) {
   /*
    * A `CLEAN` command came from a connection thread.
    *
@@ -442,6 +780,14 @@ void TagStore::process_clean_command(CommandReader& cr) {
    * execution had already been started; however, that object's tags would not be linked yet, so it
    * cannot be affected either: we just need to check if the object is tagged already.
    *
+   * If asynchronous mode is on (`perf_tags_clean_batch_size` is not zero), matched objects are only
+   * marked as deleted (so that connection threads stop "seeing" them right away), and then the response
+   * is sent; the objects are then unlinked from tags and passed to the optimizer in batches, between
+   * processing other messages (see `thread_proc()`).
+   *
+   * If tag manager has several shards, the command is executed by all of them (each one processing its
+   * own objects), and the response is sent by the shard that completes it last.
+   *
    * RESPONSE: `OK` on success, or `ERROR` in case of invalid format (tags' existence does *not* affect
    * format checks).
    */
@@ -457,8 +803,10 @@ void TagStore::process_clean_command(CommandReader& cr) {
       }
     } else if (mode == CM_OLD) {
       if (!iterator.has_more_chunks()) {
-        // notify optimizer
-        get_optimizer().post_gc_message(0);
+        // notify optimizer (only once, even if the command is executed by all shards)
+        if (ts_shard == 0) {
+          get_optimizer().post_gc_message(0);
+        }
         status = CS_SUCCESS;
       }
     } else {
@@ -484,6 +832,15 @@ void TagStore::process_clean_command(CommandReader& cr) {
                */
               if (shortest != nullptr && all_tags_found) {
                 c3_assert(shortest->get_num_marked_objects());
+                if (ts_index.is_enabled()) {
+                  tags[ntags++] = shortest;
+                  std::swap(tags[0], tags[ntags - 1]); // intersection should start with the shortest set
+                  TagBitmap objects;
+                  ts_index.find_all(objects, tags, ntags);
+                  unlink_indexed_objects(objects);
+                  status = CS_SUCCESS;
+                  break;
+                }
                 shortest->add_reference();
                 add_dummy_references(tags, ntags);
                 TagRef* ref = shortest->get_first_ref();
@@ -496,11 +853,7 @@ void TagStore::process_clean_command(CommandReader& cr) {
                       if (po->flags_are_clear(HOF_BEING_DELETED)) {
                         c3_assert(po->flags_are_set(HOF_LINKED_BY_TM));
                         if (ntags == 0 || po->matches_tags(ntags, tags, ntags)) {
-                          po->set_flags(HOF_BEING_DELETED);
-                          unlink_object_tags(po);
-                          guard.unlock();
-                          // notify optimizer
-                          get_optimizer().post_delete_message(po);
+                          delete_object(po, guard);
                         }
                       }
                     }
@@ -522,9 +875,19 @@ void TagStore::process_clean_command(CommandReader& cr) {
             case CM_MATCHING_ANY_TAG:
               if (shortest != nullptr) {
                 tags[ntags++] = shortest;
-                add_dummy_references(tags, ntags);
-                unlink_objects(tags, ntags, mode == CM_MATCHING_ANY_TAG? TSC_MATCH: TSC_NOT_MATCH);
-                remove_dummy_references(tags, ntags);
+                if (ts_index.is_enabled()) {
+                  TagBitmap objects;
+                  if (mode == CM_MATCHING_ANY_TAG) {
+                    ts_index.find_any(objects, tags, ntags);
+                  } else {
+                    ts_index.find_none(objects, tags, ntags);
+                  }
+                  unlink_indexed_objects(objects);
+                } else {
+                  add_dummy_references(tags, ntags);
+                  unlink_objects(tags, ntags, mode == CM_MATCHING_ANY_TAG? TSC_MATCH: TSC_NOT_MATCH);
+                  remove_dummy_references(tags, ntags);
+                }
               }
               status = CS_SUCCESS;
               break;
@@ -535,7 +898,9 @@ void TagStore::process_clean_command(CommandReader& cr) {
       }
     }
   }
-  if (status == CS_SUCCESS) {
+  if (job != nullptr) {
+    job->complete(get_consumer(), status, nullptr);
+  } else if (status == CS_SUCCESS) {
     get_consumer().post_ok_response(cr);
   } else {
     get_consumer().post_format_error_response(cr);
@@ -559,8 +924,8 @@ void TagStore::process_getids_command(CommandReader& cr) {
     SocketResponseWriter* srw = ResponseObjectConsumer::create_response(cr);
     PayloadListChunkBuilder id_list(*srw, server_net_config, 0, 0, 0);
 
-    // collect object IDs
-    enum_all_objects(id_list);
+    // collect object IDs (this command is never executed by more than one shard)
+    enum_all_objects(id_list, true);
 
     // configure response object and send it back to the socket pipeline
     if (!get_consumer().post_list_response(srw, id_list)) {
@@ -569,7 +934,7 @@ void TagStore::process_getids_command(CommandReader& cr) {
   }
 }
 
-void TagStore::process_gettags_command(CommandReader& cr) {
+void TagStore::process_gettags_command(CommandReader& cr, TagCommandJob* job) {
   /*
    * A `GETTAGS` command came from a connection thread.
    *
@@ -577,22 +942,29 @@ void TagStore::process_gettags_command(CommandReader& cr) {
    * error (extraneous chunks).
    */
   if (ChunkIterator::has_any_data(cr)) {
-    get_consumer().post_format_error_response(cr);
+    if (job != nullptr) {
+      job->complete(get_consumer(), CS_FORMAT_ERROR, nullptr);
+    } else {
+      get_consumer().post_format_error_response(cr);
+    }
   } else {
-    SocketResponseWriter* srw = ResponseObjectConsumer::create_response(cr);
+    SocketResponseWriter* srw = job != nullptr? &job->get_response_writer():
+      ResponseObjectConsumer::create_response(cr);
     PayloadListChunkBuilder list(*srw, server_net_config, 0, 0, 0);
 
     // collect tag IDs
     enumerate_all(&list, tag_enum_callback);
 
     // configure response object and send it back to the socket pipeline
-    if (!get_consumer().post_list_response(srw, list)) {
+    if (job != nullptr) {
+      job->complete(get_consumer(), CS_SUCCESS, &list);
+    } else if (!get_consumer().post_list_response(srw, list)) {
       get_consumer().post_internal_error_response(cr);
     }
   }
 }
 
-void TagStore::process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr) {
+void TagStore::process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr, TagCommandJob* job) {
   /*
    * One of the following commands had been received from a connection thread:
    * - `GETIDSMATCHINGTAGS`, or
@@ -614,13 +986,22 @@ void TagStore::process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr)
     TagObject* shortest = extract_tag_names(tag_list, tags, ntags, format_is_ok, all_tags_found);
     if (format_is_ok) {
       // create response object
-      SocketResponseWriter* srw = ResponseObjectConsumer::create_response(cr);
+      SocketResponseWriter* srw = job != nullptr? &job->get_response_writer():
+        ResponseObjectConsumer::create_response(cr);
       PayloadListChunkBuilder id_list(*srw, server_net_config, 0, 0, 0);
 
       // collect object IDs
       switch (cmd) {
         case CMD_GETIDSMATCHINGTAGS:
           if (shortest != nullptr && all_tags_found) {
+            if (ts_index.is_enabled()) {
+              tags[ntags++] = shortest;
+              std::swap(tags[0], tags[ntags - 1]); // intersection should start with the shortest set
+              TagBitmap objects;
+              ts_index.find_all(objects, tags, ntags);
+              enum_indexed_objects(id_list, objects);
+              break;
+            }
             TagRef* ref = shortest->get_first_ref();
             while (ref != nullptr) {
               PageObject* po = ref->get_page_object();
@@ -646,13 +1027,27 @@ void TagStore::process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr)
         case CMD_GETIDSMATCHINGANYTAGS:
           if (shortest != nullptr) {
             tags[ntags++] = shortest;
-            enum_objects(id_list, tags, ntags, cmd == CMD_GETIDSMATCHINGANYTAGS? TSC_MATCH: TSC_NOT_MATCH);
+            if (ts_index.is_enabled()) {
+              TagBitmap objects;
+              if (cmd == CMD_GETIDSMATCHINGANYTAGS) {
+                ts_index.find_any(objects, tags, ntags);
+              } else {
+                ts_index.find_none(objects, tags, ntags);
+              }
+              enum_indexed_objects(id_list, objects);
+            } else {
+              enum_objects(id_list, tags, ntags, cmd == CMD_GETIDSMATCHINGANYTAGS? TSC_MATCH: TSC_NOT_MATCH);
+            }
           }
           break;
         default:
           c3_assert_failure();
       }
       // configure response object and send it back to the socket pipeline
+      if (job != nullptr) {
+        job->complete(get_consumer(), CS_SUCCESS, &id_list);
+        return;
+      }
       if (get_consumer().post_list_response(srw, id_list)) {
         status = CS_SUCCESS;
       } else {
@@ -661,6 +1056,11 @@ void TagStore::process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr)
     }
   }
 
+  if (job != nullptr) {
+    c3_assert(status == CS_FORMAT_ERROR);
+    job->complete(get_consumer(), status, nullptr);
+    return;
+  }
   switch (status) {
     case CS_FORMAT_ERROR:
       get_consumer().post_format_error_response(cr);
@@ -757,6 +1157,17 @@ void TagStore::process_id_message(TagStore::TagMessage &msg) {
       num = ts_queue.set_max_capacity(requested);
       log(LL_VERBOSE, "%s: max queue capacity set to %u (requested: %u)", get_name(), num, requested);
       return;
+    case TC_INDEX_CHANGE:
+      if (msg.get_switch()) {
+        enable_tag_index();
+      } else {
+        disable_tag_index();
+      }
+      return;
+    case TC_CLEAN_BATCH_CHANGE:
+      ts_clean_batch = msg.get_capacity();
+      log(LL_VERBOSE, "%s: asynchronous CLEAN batch size set to %u", get_name(), ts_clean_batch);
+      return;
     case TC_QUIT:
       enter_quit_state();
       return;
@@ -769,38 +1180,40 @@ void TagStore::process_command_message(TagStore::TagMessage& msg) {
   CommandReader* cr = msg.get_command();
   c3_assert(cr && cr->is_active());
   PayloadHashObject* pho = msg.get_object();
+  TagCommandJob* job = nullptr;
   switch (cr->get_command_id()) {
     case CMD_SAVE:
       c3_assert(pho);
       process_save_command(*cr, pho);
       break;
     case CMD_REMOVE:
+    case CMD_MREMOVE:
       c3_assert(pho);
       process_remove_command(pho);
       break;
     case CMD_CLEAN:
-      c3_assert(pho == nullptr);
-      process_clean_command(*cr);
+      job = msg.get_job();
+      process_clean_command(*cr, job);
       break;
     case CMD_GETIDS:
       c3_assert(pho == nullptr);
       process_getids_command(*cr);
       break;
     case CMD_GETTAGS:
-      c3_assert(pho == nullptr);
-      process_gettags_command(*cr);
+      job = msg.get_job();
+      process_gettags_command(*cr, job);
       break;
     case CMD_GETIDSMATCHINGTAGS:
-      c3_assert(pho == nullptr);
-      process_getmatchingids_command(CMD_GETIDSMATCHINGTAGS, *cr);
+      job = msg.get_job();
+      process_getmatchingids_command(CMD_GETIDSMATCHINGTAGS, *cr, job);
       break;
     case CMD_GETIDSNOTMATCHINGTAGS:
-      c3_assert(pho == nullptr);
-      process_getmatchingids_command(CMD_GETIDSNOTMATCHINGTAGS, *cr);
+      job = msg.get_job();
+      process_getmatchingids_command(CMD_GETIDSNOTMATCHINGTAGS, *cr, job);
       break;
     case CMD_GETIDSMATCHINGANYTAGS:
-      c3_assert(pho == nullptr);
-      process_getmatchingids_command(CMD_GETIDSMATCHINGANYTAGS, *cr);
+      job = msg.get_job();
+      process_getmatchingids_command(CMD_GETIDSMATCHINGANYTAGS, *cr, job);
       break;
     case CMD_GETMETADATAS:
       c3_assert(pho);
@@ -809,7 +1222,9 @@ void TagStore::process_command_message(TagStore::TagMessage& msg) {
     default:
       c3_assert_failure();
   }
-  ReaderWriter::dispose(cr);
+  if (job == nullptr) {
+    ReaderWriter::dispose(cr);
+  } // otherwise, the command is disposed by the last shard that completes it
 }
 
 void TagStore::thread_proc(c3_uint_t id, ThreadArgument arg) {
@@ -822,11 +1237,21 @@ void TagStore::thread_proc(c3_uint_t id, ThreadArgument arg) {
     if (!ts->ts_quitting && Thread::received_stop_request()) {
       ts->enter_quit_state();
     }
+    // unlink next batch of objects hidden by asynchronous `CLEAN` commands, if any
+    bool pending = ts->has_pending_objects();
+    if (pending) {
+      ts->unlink_pending_objects();
+      pending = ts->has_pending_objects();
+    }
     // get next message
     TagMessage msg;
-    if (ts->ts_quitting) {
+    if (ts->ts_quitting || pending) {
       msg = ts->ts_queue.try_get();
       if (!msg.is_valid()) {
+        if (pending) {
+          // keep unlinking pending objects until new messages arrive
+          continue;
+        }
         // no [more] outstanding messages to process; we're done
         break;
       }
@@ -845,4 +1270,116 @@ void TagStore::thread_proc(c3_uint_t id, ThreadArgument arg) {
   ts->dispose_tag_store();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// ShardedTagStore
+///////////////////////////////////////////////////////////////////////////////
+
+ShardedTagStore::ShardedTagStore() noexcept {
+  sts_consumer = nullptr;
+  sts_optimizer = nullptr;
+  sts_page_store = nullptr;
+  std::memset(sts_shards, 0, sizeof sts_shards);
+  sts_num_shards = 1;
+  sts_allocated = false;
+}
+
+void ShardedTagStore::allocate() {
+  // number of shards is only known after configuration file is loaded
+  c3_assert(sts_consumer && !sts_allocated);
+  for (c3_uint_t i = 0; i < sts_num_shards; i++) {
+    TagStore& shard = get_shard(i);
+    shard.configure(sts_consumer, sts_optimizer, sts_page_store, i, sts_num_shards);
+    shard.allocate();
+  }
+  sts_allocated = true;
+}
+
+bool ShardedTagStore::post_capacity_change_message(c3_uint_t capacity) {
+  bool result = true;
+  for (c3_uint_t i = 0; i < get_num_messaged_shards(); i++) {
+    if (!get_shard(i).post_capacity_change_message(capacity)) {
+      result = false;
+    }
+  }
+  return result;
+}
+
+bool ShardedTagStore::post_max_capacity_change_message(c3_uint_t max_capacity) {
+  bool result = true;
+  for (c3_uint_t i = 0; i < get_num_messaged_shards(); i++) {
+    if (!get_shard(i).post_max_capacity_change_message(max_capacity)) {
+      result = false;
+    }
+  }
+  return result;
+}
+
+bool ShardedTagStore::post_index_change_message(bool use_index) {
+  bool result = true;
+  for (c3_uint_t i = 0; i < get_num_messaged_shards(); i++) {
+    if (!get_shard(i).post_index_change_message(use_index)) {
+      result = false;
+    }
+  }
+  return result;
+}
+
+bool ShardedTagStore::post_clean_batch_change_message(c3_uint_t batch_size) {
+  bool result = true;
+  for (c3_uint_t i = 0; i < get_num_messaged_shards(); i++) {
+    if (!get_shard(i).post_clean_batch_change_message(batch_size)) {
+      result = false;
+    }
+  }
+  return result;
+}
+
+c3_uint_t ShardedTagStore::get_num_pending_objects() const {
+  c3_uint_t num = 0;
+  for (c3_uint_t i = 0; i < sts_num_shards; i++) {
+    num += get_shard(i).get_num_pending_objects();
+  }
+  return num;
+}
+
+bool ShardedTagStore::post_job_messages(CommandReader* cr) {
+  TagCommandJob* job = TagCommandJob::create(cr, sts_num_shards);
+  if (!get_shard(0).post_job_message(cr, job)) {
+    // the caller will respond to and dispose the command
+    ReaderWriter::dispose(&job->get_response_writer());
+    TagCommandJob::dispose(job);
+    return false;
+  }
+  for (c3_uint_t i = 1; i < sts_num_shards; i++) {
+    if (!get_shard(i).post_job_message(cr, job)) {
+      // the command is already owned by the job, so we complete it on shard's behalf
+      job->complete(*sts_consumer, CS_INTERNAL_ERROR, nullptr);
+    }
+  }
+  return true;
+}
+
+bool ShardedTagStore::post_command_message(CommandReader* cr, PayloadHashObject* pho) {
+  c3_assert(cr && sts_allocated);
+  if (pho != nullptr) {
+    // commands operating on a particular object go to the shard that owns it
+    return get_object_shard(pho).post_command_message(cr, pho);
+  }
+  if (sts_num_shards == 1 || cr->get_command_id() == CMD_GETIDS) {
+    // `GETIDS` only enumerates page store, so any shard can execute it
+    return get_shard(0).post_command_message(cr);
+  }
+  return post_job_messages(cr);
+}
+
+bool ShardedTagStore::post_quit_message() {
+  bool result = true;
+  for (c3_uint_t i = 0; i < sts_num_shards; i++) {
+    if (!get_shard(i).post_quit_message()) {
+      result = false;
+    }
+  }
+  return result;
+}
+
 }
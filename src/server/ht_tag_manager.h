@@ -21,14 +21,19 @@
 
 #include "c3lib/c3lib.h"
 #include "ht_stores.h"
+#include "ht_tag_index.h"
 
 namespace CyberCache {
 
 class PageObjectStore;
 class SocketResponseWriter;
 class PayloadListChunkBuilder;
+class TagCommandJob;
 
-/// Concurrent tag manager for the FPC
+/**
+ * Concurrent tag manager for the FPC, or one of its shards. Each shard has its own tag tables, queue, and
+ * thread, and only links and unlinks page objects assigned to it (see `get_shard_index()`).
+ */
 class TagStore: public ObjectStore {
 
   static constexpr c3_uint_t DEFAULT_NUM_TABLES = 1;
@@ -45,6 +50,8 @@ class TagStore: public ObjectStore {
     TC_UNLINK_OBJECT,       // the object had been deleted by *optimizer*, unlink it from all tags
     TC_CAPACITY_CHANGE,     // queue capacity change request
     TC_MAX_CAPACITY_CHANGE, // maximum queue capacity change request
+    TC_INDEX_CHANGE,        // request to enable or disable bitmap tag index
+    TC_CLEAN_BATCH_CHANGE,  // request to change number of pages unlinked per batch by asynchronous `CLEAN`
     TC_QUIT,                // should process remaining messages and then quit
     TC_NUMBER_OF_ELEMENTS
   };
@@ -57,6 +64,7 @@ class TagStore: public ObjectStore {
     };
     union {
       PayloadHashObject* tm_pho;      // hash object to operate on
+      TagCommandJob*     tm_job;      // shared state of a command executed by all shards
       c3_uint_t          tm_capacity; // argument for configuration requests
     };
 
@@ -77,6 +85,10 @@ class TagStore: public ObjectStore {
       tm_cmd_cr = cr;
       tm_pho = pho;
     }
+    TagMessage(CommandReader* cr, TagCommandJob* job) {
+      tm_cmd_cr = cr;
+      tm_job = job;
+    }
 
     bool is_valid() const { return tm_cmd_id > TC_INVALID; }
     bool is_id_command() const { return tm_cmd_id < TC_NUMBER_OF_ELEMENTS; }
@@ -89,18 +101,32 @@ class TagStore: public ObjectStore {
       return tm_cmd_cr;
     }
     PayloadHashObject* get_object() const { return tm_pho; }
+    TagCommandJob* get_job() const {
+      c3_assert(!is_id_command());
+      return tm_job;
+    }
     c3_uint_t get_capacity() const {
       c3_assert(is_id_command());
       return tm_capacity;
     }
+    bool get_switch() const { return get_capacity() != 0; }
   };
   /// Type of the queue used for sending messages *to* the tag manager
   typedef MessageQueue<TagMessage> TagQueue;
 
-  TagQueue            ts_queue;      // queue with messages to tag manager
-  PayloadObjectStore* ts_page_store; // page store reference for posting "unlink" to its queues
-  TagObject*          ts_untagged;   // special tag linking all pages not marked with user tags
-  bool                ts_quitting;   // `true` if tag manager thread has received "quit" request
+  TagQueue                 ts_queue;            // queue with messages to tag manager
+  PayloadObjectStore*      ts_page_store;       // page store reference for posting "unlink" to its queues
+  TagObject*               ts_untagged;         // special tag linking all pages not marked with user tags
+  mutable TagIndex         ts_index;            // bitmap index of tagged pages (owned by tag manager thread)
+  mutable PageObject**     ts_pending;          // pages hidden by asynchronous `CLEAN`, but not unlinked yet
+  mutable c3_uint_t        ts_pending_capacity; // number of allocated elements in `ts_pending`
+  mutable std::atomic_uint ts_num_pending;      // number of pages awaiting unlinking (also read by `INFO`)
+  c3_uint_t                ts_clean_batch;      // pages unlinked per batch; `0` means synchronous `CLEAN`
+  c3_uint_t                ts_cfg_clean_batch;  // last requested batch size (owned by configuration thread)
+  c3_uint_t                ts_shard;            // index of this shard
+  c3_uint_t                ts_num_shards;       // total number of shards of the tag manager
+  bool                     ts_use_index;        // last requested bitmap index mode (owned by config thread)
+  bool                     ts_quitting;         // `true` if tag manager thread has received "quit" request
 
   /// Conditions for selecting an object
   enum tag_select_condition_t {
@@ -124,14 +150,15 @@ class TagStore: public ObjectStore {
 
   /// Structure used to pass extra info to callbacks implementing conditional object ID listing
   struct tag_object_info_t {
+    const TagStore* const        toi_tag_store; // store issuing the request, or `NULL` to list objects of all shards
     PayloadListChunkBuilder&     toi_list;      // list to which object IDs will be added
     TagObject** const            toi_tags;      // array of pointers to tags to compare against
     const c3_uint_t              toi_ntags;     // number of tags in the tag pointer array
     const tag_select_condition_t toi_condition; // match condition
 
-    tag_object_info_t(PayloadListChunkBuilder& list, TagObject** tags, c3_uint_t ntags,
+    tag_object_info_t(const TagStore* ts, PayloadListChunkBuilder& list, TagObject** tags, c3_uint_t ntags,
       tag_select_condition_t condition):
-      toi_list(list), toi_tags(tags), toi_ntags(ntags), toi_condition(condition) {
+      toi_tag_store(ts), toi_list(list), toi_tags(tags), toi_ntags(ntags), toi_condition(condition) {
     }
   };
 
@@ -139,6 +166,9 @@ class TagStore: public ObjectStore {
     c3_assert(ts_page_store);
     return *ts_page_store;
   }
+  bool owns(const HashObject* ho) const {
+    return ts_num_shards == 1 || get_shard_index(ho->get_hash_code(), ts_num_shards) == ts_shard;
+  }
 
   TagObject* find_tag(const char* name, c3_ushort_t nlen) const;
   TagObject* create_tag(c3_hash_t hash, const char* name, c3_ushort_t nlen, bool untagged = false) const;
@@ -147,6 +177,10 @@ class TagStore: public ObjectStore {
     bool& format_is_ok, bool& all_tags_found) const;
   void dispose_tag(TagObject* to) const;
   void unlink_object_tags(PageObject* po) const;
+  void delete_object(PageObject* po, LockableObjectGuard& guard) const;
+  void add_pending_object(PageObject* po) const;
+  bool has_pending_objects() const { return ts_num_pending.load(std::memory_order_relaxed) != 0; }
+  void unlink_pending_objects();
   void unlink_object(PayloadHashObject* pho) const;
   static bool tag_enum_callback(void* context, HashObject* ho);
   static bool object_cleanup_unlink_callback(void* context, HashObject* ho);
@@ -156,16 +190,22 @@ class TagStore: public ObjectStore {
   bool unlink_all_objects() const;
   bool enum_objects(PayloadListChunkBuilder& list, TagObject** tags, c3_uint_t ntags,
     tag_select_condition_t condition) const;
-  bool enum_all_objects(PayloadListChunkBuilder& list) const;
+  bool enum_all_objects(PayloadListChunkBuilder& list, bool all_shards = false) const;
   static void add_dummy_references(TagObject** tags, c3_uint_t ntags);
   void remove_dummy_references(TagObject** tags, c3_uint_t ntags) const;
+  void unlink_indexed_objects(const TagBitmap& objects) const;
+  void enum_indexed_objects(PayloadListChunkBuilder& list, const TagBitmap& objects) const;
+  static bool tag_index_build_callback(void* context, HashObject* ho);
+  static bool tag_index_dispose_callback(void* context, HashObject* ho);
+  void enable_tag_index() C3_FUNC_COLD;
+  void disable_tag_index() C3_FUNC_COLD;
 
   void process_save_command(CommandReader& cr, PayloadHashObject* pho);
   void process_remove_command(PayloadHashObject* pho);
-  void process_clean_command(CommandReader& cr);
+  void process_clean_command(CommandReader& cr, TagCommandJob* job);
   void process_getids_command(CommandReader& cr);
-  void process_gettags_command(CommandReader& cr);
-  void process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr);
+  void process_gettags_command(CommandReader& cr, TagCommandJob* job);
+  void process_getmatchingids_command(c3_byte_t cmd, CommandReader& cr, TagCommandJob* job);
   void process_getmetadatas_command(CommandReader& cr, PayloadHashObject* pho);
   void process_id_message(TagMessage &msg);
   void process_command_message(TagMessage& msg);
@@ -183,11 +223,14 @@ public:
   TagStore& operator=(const TagStore&) = delete;
   TagStore& operator=(TagStore&&) = delete;
 
-  void configure(ResponseObjectConsumer* consumer, Optimizer* optimizer, PayloadObjectStore* page_store) C3_FUNC_COLD {
-    c3_assert(page_store && ts_page_store == nullptr);
+  void configure(ResponseObjectConsumer* consumer, Optimizer* optimizer, PayloadObjectStore* page_store,
+    c3_uint_t shard, c3_uint_t num_shards) C3_FUNC_COLD {
+    c3_assert(page_store && ts_page_store == nullptr && shard < num_shards);
     set_consumer(consumer);
     set_optimizer(optimizer);
     ts_page_store = page_store;
+    ts_shard = shard;
+    ts_num_shards = num_shards;
   }
 
   void allocate() C3_FUNC_COLD {
@@ -196,6 +239,11 @@ public:
 
   c3_uint_t get_queue_capacity() C3LM_OFF(const) C3_FUNC_COLD { return ts_queue.get_capacity(); }
   c3_uint_t get_max_queue_capacity() C3LM_OFF(const) C3_FUNC_COLD { return ts_queue.get_max_capacity(); }
+  bool is_using_tag_index() const C3_FUNC_COLD { return ts_use_index; }
+  c3_uint_t get_clean_batch_size() const C3_FUNC_COLD { return ts_cfg_clean_batch; }
+  c3_uint_t get_num_pending_objects() const C3_FUNC_COLD {
+    return ts_num_pending.load(std::memory_order_relaxed);
+  }
 
   bool post_unlink_message(PayloadHashObject* pho) {
     return ts_queue.put(TagMessage(TC_UNLINK_OBJECT, pho));
@@ -206,16 +254,125 @@ public:
   bool post_max_capacity_change_message(c3_uint_t max_capacity) C3_FUNC_COLD {
     return ts_queue.put(TagMessage(TC_MAX_CAPACITY_CHANGE, max_capacity));
   }
+  bool post_index_change_message(bool use_index) C3_FUNC_COLD {
+    ts_use_index = use_index;
+    return ts_queue.put(TagMessage(TC_INDEX_CHANGE, (c3_uint_t) use_index));
+  }
+  bool post_clean_batch_change_message(c3_uint_t batch_size) C3_FUNC_COLD {
+    ts_cfg_clean_batch = batch_size;
+    return ts_queue.put(TagMessage(TC_CLEAN_BATCH_CHANGE, batch_size));
+  }
   bool post_command_message(CommandReader* cr, PayloadHashObject* pho = nullptr) {
     return ts_queue.put(TagMessage(cr, pho));
   }
+  bool post_job_message(CommandReader* cr, TagCommandJob* job) {
+    return ts_queue.put(TagMessage(cr, job));
+  }
   bool post_quit_message() C3_FUNC_COLD {
     return ts_queue.put(TagMessage(TC_QUIT));
   }
 
+  static c3_uint_t get_shard_index(c3_hash_t hash, c3_uint_t num_shards) {
+    // lower bits of the hash code select page store's table, so we use upper bits here
+    return (c3_uint_t)(hash >> 32) % num_shards;
+  }
+
   static void thread_proc(c3_uint_t id, ThreadArgument arg);
 };
 
+/**
+ * Tag manager split into shards, each running in its own thread. Page objects are assigned to shards
+ * by their hash codes, so that all updates of a particular object's tags (`SAVE`, `REMOVE`, unlinking by
+ * optimizer) are done by the same shard, in order, and do not wait for bulk operations performed by
+ * other shards. Commands that select objects by tags are executed by all shards in parallel, and their
+ * results are merged by the shard that completes the command last.
+ *
+ * Shards themselves are owned by the derived class; configuration options that are not processed by tag
+ * manager thread are applied to all shards, including those that will not be started.
+ */
+class ShardedTagStore {
+  ResponseObjectConsumer* sts_consumer;                              // where to post responses
+  Optimizer*              sts_optimizer;                             // FPC optimizer
+  PayloadObjectStore*     sts_page_store;                            // FPC store
+  TagStore*               sts_shards[MAX_NUM_TAG_MANAGER_THREADS]; // all shards, started or not
+  c3_uint_t               sts_num_shards;                            // number of shards to be started
+  bool                    sts_allocated;                             // whether shards had been allocated
+
+  c3_uint_t get_num_messaged_shards() const {
+    // before shards are allocated, we do not know yet which of them will be started
+    return sts_allocated? sts_num_shards: MAX_NUM_TAG_MANAGER_THREADS;
+  }
+  TagStore& get_object_shard(const PayloadHashObject* pho) const {
+    c3_assert(pho);
+    return *sts_shards[TagStore::get_shard_index(pho->get_hash_code(), sts_num_shards)];
+  }
+  bool post_job_messages(CommandReader* cr);
+
+protected:
+  ShardedTagStore() noexcept C3_FUNC_COLD;
+  void set_shard(c3_uint_t i, TagStore* shard) C3_FUNC_COLD {
+    c3_assert(i < MAX_NUM_TAG_MANAGER_THREADS && shard && sts_shards[i] == nullptr);
+    sts_shards[i] = shard;
+  }
+
+public:
+  ShardedTagStore(const ShardedTagStore&) = delete;
+  ShardedTagStore(ShardedTagStore&&) = delete;
+
+  ShardedTagStore& operator=(const ShardedTagStore&) = delete;
+  ShardedTagStore& operator=(ShardedTagStore&&) = delete;
+
+  c3_uint_t get_num_shards() const { return sts_num_shards; }
+  void set_num_shards(c3_uint_t num) C3_FUNC_COLD {
+    c3_assert(num > 0 && num <= MAX_NUM_TAG_MANAGER_THREADS && !sts_allocated);
+    sts_num_shards = num;
+  }
+  TagStore& get_shard(c3_uint_t i) const {
+    c3_assert(i < MAX_NUM_TAG_MANAGER_THREADS && sts_shards[i]);
+    return *sts_shards[i];
+  }
+
+  /**
+   * Applies a setting to all shards, including those that will not be started (configuration options can
+   * be processed before the number of shards is known). Stops at first failure.
+   *
+   * @param proc Function (or functor, or lambda) accepting `ObjectStore` reference, and returning `true`
+   *   on success
+   * @return `true` if the setting was applied successfully to all shards, `false` otherwise
+   */
+  template <class P> bool configure_shards(P proc) const {
+    for (c3_uint_t i = 0; i < MAX_NUM_TAG_MANAGER_THREADS; i++) {
+      if (!proc((ObjectStore&) get_shard(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+  void configure(ResponseObjectConsumer* consumer, Optimizer* optimizer, PayloadObjectStore* page_store) C3_FUNC_COLD {
+    c3_assert(consumer && optimizer && page_store && sts_consumer == nullptr);
+    sts_consumer = consumer;
+    sts_optimizer = optimizer;
+    sts_page_store = page_store;
+  }
+  void allocate() C3_FUNC_COLD;
+
+  c3_uint_t get_queue_capacity() C3LM_OFF(const) C3_FUNC_COLD { return get_shard(0).get_queue_capacity(); }
+  c3_uint_t get_max_queue_capacity() C3LM_OFF(const) C3_FUNC_COLD { return get_shard(0).get_max_queue_capacity(); }
+  bool is_using_tag_index() const C3_FUNC_COLD { return get_shard(0).is_using_tag_index(); }
+  c3_uint_t get_clean_batch_size() const C3_FUNC_COLD { return get_shard(0).get_clean_batch_size(); }
+  c3_uint_t get_num_pending_objects() const C3_FUNC_COLD;
+
+  bool post_unlink_message(PayloadHashObject* pho) {
+    return get_object_shard(pho).post_unlink_message(pho);
+  }
+  bool post_capacity_change_message(c3_uint_t capacity) C3_FUNC_COLD;
+  bool post_max_capacity_change_message(c3_uint_t max_capacity) C3_FUNC_COLD;
+  bool post_index_change_message(bool use_index) C3_FUNC_COLD;
+  bool post_clean_batch_change_message(c3_uint_t batch_size) C3_FUNC_COLD;
+  bool post_command_message(CommandReader* cr, PayloadHashObject* pho = nullptr);
+  bool post_quit_message() C3_FUNC_COLD;
+};
+
 }
 
 #endif // _HT_TAG_MANAGER_H
@@ -428,6 +428,25 @@ public:
     return false;
   }
 
+  bool try_put(T&& o) {
+    c3_assert(mq_buffer);
+    ThreadMessageQueuePutGuard guard(this);
+    if (guard.check_passed()) {
+      std::lock_guard<std::mutex> lock(mq_mutex);
+      if (mq_count == mq_capacity && mq_capacity < mq_max_capacity) {
+        configure_capacity(mq_capacity * 2, false);
+      }
+      if (mq_count < mq_capacity) {
+        mq_buffer[mq_put_index++] = std::move(o);
+        mq_put_index &= mq_index_mask;
+        mq_count++;
+        mq_not_empty.notify_one();
+        return true;
+      }
+    }
+    return false;
+  }
+
   bool put(T&& o, c3_uint_t msecs) {
     bool ready = false;
     c3_assert(mq_buffer);
@@ -80,6 +80,7 @@ void Thread::initialize(c3_uint_t id) {
 
   assert(id < MAX_NUM_THREADS);
   local_thread_id = id;
+  Memory::set_thread_id(id);
   Thread& thread = thread_pool[id];
   thread.t_start_time = get_current_time();
   C3LM_ON(thread.t_mutex_ref = nullptr);
@@ -185,14 +186,12 @@ void Thread::trigger_timed_event(c3_uint_t id) {
 ///////////////////////////////////////////////////////////////////////////////
 
 const char* Thread::get_name(c3_uint_t id) {
-  static_assert(TI_FIRST_CONNECTION_THREAD == 13, "Number of service threads has changed");
+  static_assert(TI_FIRST_CONNECTION_THREAD == 24, "Number of service threads has changed");
   switch (id) {
     case TI_MAIN:
       return "Main thread";
     case TI_SIGNAL_HANDLER:
       return "Signal handler";
-    case TI_LISTENER:
-      return "Listener";
     case TI_LOGGER:
       return "Logger";
     case TI_SESSION_BINLOG:
@@ -211,10 +210,24 @@ const char* Thread::get_name(c3_uint_t id) {
       return "Session optimizer";
     case TI_FPC_OPTIMIZER:
       return "FPC optimizer";
-    case TI_TAG_MANAGER:
-      return "Tag manager";
     default:
-      c3_assert(id >= TI_FIRST_CONNECTION_THREAD && id < MAX_NUM_THREADS);
+      if (id < TI_LOGGER) {
+        c3_assert(id >= TI_FIRST_LISTENER);
+        return "Listener";
+      }
+      if (id < TI_SESSION_REPLICATOR) {
+        c3_assert(id >= TI_FIRST_SEGMENT_SAVER);
+        return "Segment saver";
+      }
+      if (id < TI_FIRST_RECOMPRESSOR) {
+        c3_assert(id >= TI_FIRST_TAG_MANAGER);
+        return "Tag manager";
+      }
+      if (id < TI_FIRST_CONNECTION_THREAD) {
+        c3_assert(id >= TI_FIRST_RECOMPRESSOR);
+        return "Re-compressor";
+      }
+      c3_assert(id < MAX_NUM_THREADS);
       return "Connection thread";
   }
 }
@@ -51,25 +51,47 @@ public:
   virtual bool thread_is_quitting(c3_uint_t id) = 0;
 };
 
+/**
+ * Maximum number of re-compression worker threads shared by session and FPC optimizers; lock masks of
+ * hash objects limit total number of threads to 63, so IDs of the workers are taken from the budget of
+ * connection threads (which is why Enterprise edition only supports 33 of those).
+ */
+constexpr c3_uint_t MAX_NUM_RECOMPRESSION_THREADS = 8;
+
+/// Maximum number of tag manager threads, each serving its own shard of the FPC tag store
+constexpr c3_uint_t MAX_NUM_TAG_MANAGER_THREADS = 4;
+
+/// Maximum number of listener threads, each serving its own share of incoming connections
+constexpr c3_uint_t MAX_NUM_LISTENER_THREADS = 4;
+
+/// Maximum number of extra database savers, each writing its own segment of a multi-file database
+constexpr c3_uint_t MAX_NUM_SEGMENT_SAVERS = 3;
+
 /// Thread IDs, used as indices into global array of thread objects
 enum thread_id_t {
   TI_MAIN = 0,               // main application thread
   TI_SIGNAL_HANDLER,         // thread that handles various signals (errors, interruptions etc.)
-  TI_LISTENER,               // incoming connections listener
-  TI_LOGGER,                 // server logger
+  TI_FIRST_LISTENER,         // ID of the first thread of incoming connections listener (one per shard)
+  TI_LOGGER = TI_FIRST_LISTENER + MAX_NUM_LISTENER_THREADS, // server logger
   TI_SESSION_BINLOG,         // binlog of the "session" domain
   TI_FPC_BINLOG,             // binlog of the "fpc" domain
   TI_BINLOG_LOADER,          // shared binlog loader
   TI_BINLOG_SAVER,           // cache database saver, used by main server thread only
-  TI_SESSION_REPLICATOR,     // replicator of rhe "session" domain
+  TI_FIRST_SEGMENT_SAVER,    // ID of the first thread saving extra segments of multi-file cache databases
+  // replicator of rhe "session" domain
+  TI_SESSION_REPLICATOR = TI_FIRST_SEGMENT_SAVER + MAX_NUM_SEGMENT_SAVERS,
   TI_FPC_REPLICATOR,         // replicator of the "fpc" domain
   TI_SESSION_OPTIMIZER,      // optimizer of the "session" domain
   TI_FPC_OPTIMIZER,          // optimizer of the "fpc" domain
-  TI_TAG_MANAGER,            // concurrent tag manager for the FPC
-  TI_FIRST_CONNECTION_THREAD // ID of the first thread from the pool of threads handling incoming commands
+  TI_FIRST_TAG_MANAGER,      // ID of the first thread of concurrent tag manager for the FPC (one per shard)
+  // ID of the first thread from the pool of optimizers' re-compression workers
+  TI_FIRST_RECOMPRESSOR = TI_FIRST_TAG_MANAGER + MAX_NUM_TAG_MANAGER_THREADS,
+  // ID of the first thread from the pool of threads handling incoming commands
+  TI_FIRST_CONNECTION_THREAD = TI_FIRST_RECOMPRESSOR + MAX_NUM_RECOMPRESSION_THREADS
 };
 
-static_assert(TI_FIRST_CONNECTION_THREAD == 13, "Adjust 'Waits_Until_No_Readers' perf counter array size");
+static_assert(TI_FIRST_CONNECTION_THREAD == 30,
+  "Adjust sizes of 'Waits_Until_No_Readers' and 'Memory_Thread_XXX_Calls' perf counter arrays");
 
 /// Maximum total number of threads supported by the server
 constexpr c3_uint_t MAX_NUM_THREADS = TI_FIRST_CONNECTION_THREAD + MAX_NUM_CONNECTION_THREADS;
@@ -14,6 +14,7 @@
  * GNU General Public License for more details.
  */
 #include "pl_file_pipelines.h"
+#include "pl_net_configuration.h"
 #include "ls_utils.h"
 #include "ht_shared_buffers.h"
 
@@ -33,6 +34,7 @@ FilePipeline::FilePipeline(const char* name, domain_t domain, c3_ulong_t max_siz
 void FilePipeline::close_binlog() {
   if (is_fd_valid()) {
     c3_assert(!fp_path.is_empty());
+    on_closing_binlog();
     if (close_file()) {
       log(LL_NORMAL, "%s: closed binlog '%s'", fp_name, fp_path.get_chars());
     } else {
@@ -109,7 +111,8 @@ FileInputPipeline::FileInputPipeline(const char* name, domain_t domain, host_obj
   fip_command_consumer = nullptr;
 }
 
-void FileInputPipeline::load_binlog(const char* path, c3_uint_t length) {
+bool FileInputPipeline::load_binlog(const char* path, c3_uint_t length) {
+  bool result = false;
   if (open_file(path, FM_READ)) {
     log(LL_NORMAL, "%s: loading binlog '%s'...", fp_name, path);
     fp_path.set(fp_domain, path, length);
@@ -142,6 +145,7 @@ void FileInputPipeline::load_binlog(const char* path, c3_uint_t length) {
         }
         log(LL_NORMAL, "%s: loaded %llu commands (%llu bytes) from binlog '%s'",
           fp_name, num, get_current_size(), path);
+        result = get_current_size() >= get_max_size();
         reset_max_size();
       } else {
         log(LL_ERROR, "%s: could not get binlog file size: '%s'", fp_name, path);
@@ -151,6 +155,7 @@ void FileInputPipeline::load_binlog(const char* path, c3_uint_t length) {
   } else {
     log(LL_ERROR, "%s: could not open binlog file '%s' (%s)", fp_name, path, c3_get_error_message());
   }
+  return result;
 }
 
 bool FileInputPipeline::send_command(file_input_command_t cmd) {
@@ -166,6 +171,11 @@ bool FileInputPipeline::send_load_file_command(const char* path) {
   return send_command(FIC_LOAD_FILE, path, strlen(path) + 1);
 }
 
+bool FileInputPipeline::load_file(const char* path) {
+  assert(path && is_fd_invalid());
+  return load_binlog(path, (c3_uint_t) strlen(path) + 1);
+}
+
 void FileInputPipeline::thread_proc(c3_uint_t id, ThreadArgument arg) {
   Thread::set_state(TS_ACTIVE);
   auto fip = (FileInputPipeline*) arg.get_pointer();
@@ -220,15 +230,35 @@ void FileInputPipeline::thread_proc(c3_uint_t id, ThreadArgument arg) {
 // FileOutputPipeline
 ///////////////////////////////////////////////////////////////////////////////
 
+io_backend_t FileOutputPipeline::fop_io_backend = IOB_EPOLL;
+
 FileOutputPipeline::FileOutputPipeline(const char* name, domain_t domain, host_object_t host, c3_byte_t id) noexcept:
   FilePipeline(name, domain, DEFAULT_ROTATION_THRESHOLD),
   fop_input_queue(domain, host, DEFAULT_QUEUE_CAPACITY, MAX_QUEUE_CAPACITY, id) {
   fop_sync_mode = SM_NONE;
   fop_binlog_size_warning = false;
   fop_binlog_io_error = false;
+  fop_staged_writes.store(false, std::memory_order_relaxed);
+  fop_next_sequence = 0;
+  fop_first_sequence = 0;
+  fop_last_sequence = 0;
+  fop_rotated_head = 0;
+  fop_num_rotated = 0;
+  for (c3_ulong_t& sequence: fop_rotated_sequences) {
+    sequence = 0;
+  }
+  fop_sequence.store((c3_ulong_t) Timer::current_timestamp() << 32, std::memory_order_relaxed);
 }
 
 void FileOutputPipeline::on_closing_binlog() {
+  // data staged for asynchronous writing must reach the file before it is closed
+  if (fop_ring_writer.is_attached(get_fd()) && !fop_ring_writer.detach()) {
+    write_binlog_error();
+  }
+  fop_staged_writes.store(false, std::memory_order_relaxed);
+}
+
+void FileOutputPipeline::on_binlog_closed() {
   // do nothing by default
 }
 
@@ -237,6 +267,10 @@ void FileOutputPipeline::dispose() {
   close_binlog();
   fp_path.empty();
   fop_rotation_path.empty();
+  for (String& path: fop_rotated_paths) {
+    path.empty();
+  }
+  fop_num_rotated = 0;
   fop_input_queue.dispose();
 }
 
@@ -262,21 +296,69 @@ void FileOutputPipeline::open_binlog_error(const char* action) {
 void FileOutputPipeline::open_binlog(const char* reason) {
   c3_assert(is_fd_invalid());
   const char* path = fp_path.get_chars();
+  // first command written to the [re-]opened binlog will be preceded with a sequence number mark
+  fop_next_sequence = 0;
+  fop_first_sequence = 0;
   if (path != nullptr) {
     log(LL_NORMAL, "%s: opening binlog '%s' %s", fp_name, path, reason);
     if (c3_file_access(path)) {
       ssize_t pos;
-      if (!open_file(path, FM_READWRITE, fop_sync_mode) ||
-          !read_binlog_header() || (pos = c3_seek_file(get_fd(), 0, PM_END)) < 0) {
+      if (!open_file(path, FM_READWRITE, fop_sync_mode) || !read_binlog_header()) {
         open_binlog_error("restart existing");
       } else {
-        set_current_size((c3_ulong_t) pos);
+        read_first_sequence();
+        if ((pos = c3_seek_file(get_fd(), 0, PM_END)) < 0) {
+          open_binlog_error("restart existing");
+        } else {
+          set_current_size((c3_ulong_t) pos);
+        }
       }
     } else {
       if (!open_file(path, FM_CREATE, fop_sync_mode) || !write_binlog_header()) {
         open_binlog_error("start");
       }
     }
+    /*
+     * Staged data are only written out when a buffer fills up or the queue runs dry, so a command
+     * would be reported as stored before it reaches the file; if a sync mode is set, that would break
+     * its guarantees, so the binlog is then written using regular (synchronous) `write()` calls.
+     */
+    if (is_fd_valid() && fop_ring_writer.is_initialized()) {
+      if (fop_sync_mode != SM_NONE) {
+        log(LL_VERBOSE, "%s: sync mode is set, not staging writes to binlog '%s'", fp_name, path);
+      } else if (fop_ring_writer.attach(get_fd())) {
+        fop_staged_writes.store(true, std::memory_order_relaxed);
+      } else {
+        log(LL_ERROR, "%s: could not set up asynchronous writing to binlog '%s' (%s)",
+          fp_name, path, c3_get_error_message());
+      }
+    }
+  }
+}
+
+void FileOutputPipeline::write_binlog_error() {
+  if (!fop_binlog_io_error) {
+    log(LL_ERROR, "%s: could not write command to binlog '%s' (%s)",
+      fp_name, fp_path.get_chars(), c3_get_error_message());
+    log(LL_ERROR, "%s: subsequent errors will NOT be logged", fp_name);
+    fop_binlog_io_error = true;
+  }
+}
+
+void FileOutputPipeline::flush_binlog(bool wait) {
+  if (fop_ring_writer.is_attached(get_fd()) &&
+    !(wait? fop_ring_writer.wait(): fop_ring_writer.submit())) {
+    write_binlog_error();
+  }
+}
+
+void FileOutputPipeline::start_ring_writer() {
+  if (fop_ring_writer.initialize(get_memory_object())) {
+    RingFileWriter::set_thread_writer(&fop_ring_writer);
+    log(LL_VERBOSE, "%s: using 'io_uring' for binlog writes", fp_name);
+  } else {
+    log(LL_WARNING, "%s: could not set up 'io_uring' (%s), falling back to regular writes",
+      fp_name, c3_get_error_message());
   }
 }
 
@@ -288,6 +370,16 @@ void FileOutputPipeline::rotate_binlog(const char* reason) {
     case RR_SUCCESS:
     case RR_SUCCESS_RND:
       log(LL_NORMAL, "%s: binlog successfully moved to '%s'", fp_name, rotation_path);
+      if (fop_first_sequence != 0) {
+        // remember the file so that replicator could catch up from it; forget the oldest one if necessary
+        if (fop_num_rotated == MAX_ROTATED_BINLOGS) {
+          fop_rotated_head = (fop_rotated_head + 1) % MAX_ROTATED_BINLOGS;
+          fop_num_rotated--;
+        }
+        c3_uint_t i = (fop_rotated_head + fop_num_rotated++) % MAX_ROTATED_BINLOGS;
+        fop_rotated_paths[i].set(fp_domain, rotation_path);
+        fop_rotated_sequences[i] = fop_first_sequence;
+      }
       break;
     default:
       log(LL_ERROR, "%s: could not rotate binlog (template: '%s')", fp_name, fop_rotation_path.get_chars());
@@ -295,6 +387,142 @@ void FileOutputPipeline::rotate_binlog(const char* reason) {
   open_binlog("after rotation");
 }
 
+void FileOutputPipeline::read_first_sequence() {
+  c3_assert(is_fd_valid() && get_current_size() == BINLOG_HEADER_SIZE);
+  Memory& memory = get_memory_object();
+  auto fcr = alloc<FileCommandReader>(memory);
+  auto sob = SharedObjectBuffers::create_object(memory);
+  new (fcr) FileCommandReader(memory, get_fd(), sob);
+  c3_ulong_t size;
+  if (fcr->read(size) == IO_RESULT_OK && fcr->get_command_id() == CMD_SEQUENCE) {
+    CommandHeaderIterator iterator(*fcr);
+    NumberChunk high = iterator.get_number();
+    NumberChunk low = iterator.get_number();
+    if (high.is_valid_uint() && low.is_valid_uint()) {
+      fop_first_sequence = ((c3_ulong_t) high.get_uint() << 32) | low.get_uint();
+    }
+  }
+  ReaderWriter::dispose(fcr);
+}
+
+bool FileOutputPipeline::write_sequence_mark(c3_ulong_t sequence) {
+  Memory& memory = get_memory_object();
+  auto fcw = alloc<FileCommandWriter>(memory);
+  auto sob = SharedObjectBuffers::create_object(memory);
+  new (fcw) FileCommandWriter(memory, get_fd(), sob);
+  CommandHeaderChunkBuilder header(*fcw, server_net_config, CMD_SEQUENCE, false);
+  bool result = false;
+  // protocol numbers are 32-bit, so sequence number is stored as two halves, higher one first
+  c3_uint_t high = (c3_uint_t)(sequence >> 32);
+  c3_uint_t low = (c3_uint_t)(sequence & UINT_MAX_VAL);
+  if (header.estimate_number(high) != 0 && header.estimate_number(low) != 0) {
+    header.configure();
+    header.add_number(high);
+    header.add_number(low);
+    header.check();
+    // same as replicated commands stored in the binlog, marks use "bulk" password
+    c3_hash_t password;
+    if (fcw->get_command_pwd_hash(password) == CPT_USER_PASSWORD) {
+      fcw->set_command_pwd_hash(CPT_BULK_PASSWORD, server_net_config.get_bulk_password());
+    }
+    c3_ulong_t ntotal;
+    if (fcw->write(ntotal) == IO_RESULT_OK) {
+      increment_current_size(ntotal);
+      result = true;
+    }
+  }
+  ReaderWriter::dispose(fcw);
+  return result;
+}
+
+void FileOutputPipeline::catch_up(c3_ulong_t after, SocketOutputPipeline* replicator) {
+  c3_assert(replicator);
+  if (is_fd_invalid()) {
+    log(LL_ERROR, "%s: received CATCHUP request, but binlog is not active", fp_name);
+    return;
+  }
+  // current binlog is going to be read by the replicator, so it must contain everything written so far
+  flush_binlog(true);
+  c3_ulong_t from = after + 1;
+  if (from > fop_last_sequence) {
+    log(LL_VERBOSE, "%s: received CATCHUP request, but there are no commands after sequence number %llu",
+      fp_name, after);
+    return;
+  }
+  /*
+   * Candidate files are rotated binlogs, oldest first, and then the current binlog; we look for the
+   * newest of them that starts with a command numbered `from` or lower, and send everything from there.
+   */
+  const char* paths[catch_up_plan_t::MAX_NUM_FILES];
+  c3_ulong_t sequences[catch_up_plan_t::MAX_NUM_FILES];
+  c3_uint_t num = 0;
+  for (c3_uint_t i = 0; i < fop_num_rotated; i++) {
+    c3_uint_t j = (fop_rotated_head + i) % MAX_ROTATED_BINLOGS;
+    paths[num] = fop_rotated_paths[j].get_chars();
+    sequences[num++] = fop_rotated_sequences[j];
+  }
+  paths[num] = fp_path.get_chars();
+  sequences[num++] = fop_first_sequence;
+  c3_uint_t first = num;
+  for (c3_uint_t i = num; i > 0; i--) {
+    if (sequences[i - 1] != 0 && sequences[i - 1] <= from) {
+      first = i - 1;
+      break;
+    }
+  }
+  if (first == num) {
+    // requested commands are older than anything we have; send what is still available
+    for (c3_uint_t i = 0; i < num; i++) {
+      if (sequences[i] != 0) {
+        first = i;
+        break;
+      }
+    }
+    if (first == num) {
+      log(LL_ERROR, "%s: cannot catch up: binlogs do not contain sequence number marks", fp_name);
+      return;
+    }
+    log(LL_WARNING, "%s: commands with sequence numbers %llu..%llu are no longer available",
+      fp_name, from, sequences[first] - 1);
+    from = sequences[first];
+  }
+  catch_up_plan_t plan;
+  plan.cp_from = from;
+  plan.cp_num_files = 0;
+  for (c3_uint_t i = first; i < num; i++) {
+    // files that do not have sequence number marks cannot contain commands we need
+    if (sequences[i] != 0) {
+      c3_ulong_t size;
+      int fd = c3_open_file(paths[i], FM_READ);
+      if (i + 1 == num) {
+        // current binlog is still being written to; only send what is already there
+        size = get_current_size();
+      } else {
+        c3_long_t file_size = fd >= 0? c3_get_file_size(fd): -1;
+        size = file_size > 0? (c3_ulong_t) file_size: 0;
+      }
+      if (fd < 0 || size < BINLOG_HEADER_SIZE || c3_seek_file(fd, BINLOG_HEADER_SIZE) < 0) {
+        log(LL_ERROR, "%s: cannot catch up: could not open binlog '%s'", fp_name, paths[i]);
+        if (fd >= 0) {
+          c3_close_file(fd);
+        }
+        for (c3_uint_t k = 0; k < plan.cp_num_files; k++) {
+          c3_close_file(plan.cp_fds[k]);
+        }
+        return;
+      }
+      plan.cp_fds[plan.cp_num_files] = fd;
+      plan.cp_sizes[plan.cp_num_files++] = size - BINLOG_HEADER_SIZE;
+    }
+  }
+  if (!replicator->send_catch_up_command(plan)) {
+    log(LL_ERROR, "%s: could not send catch-up request to replicator", fp_name);
+    for (c3_uint_t k = 0; k < plan.cp_num_files; k++) {
+      c3_close_file(plan.cp_fds[k]);
+    }
+  }
+}
+
 void FileOutputPipeline::process_id_command(file_output_command_t cmd) {
   switch (cmd) {
     case FOC_DISABLE_ROTATION:
@@ -341,7 +569,7 @@ void FileOutputPipeline::process_id_command(file_output_command_t cmd) {
       return;
     case FOC_CLOSE_BINLOG:
       close_binlog();
-      on_closing_binlog();
+      on_binlog_closed();
       return;
     case FOC_QUIT:
       log(LL_VERBOSE, "%s: received QUIT request", fp_name);
@@ -393,6 +621,21 @@ void FileOutputPipeline::process_data_command(const PipelineCommand& pc) {
       log(LL_VERBOSE, "%s: max queue capacity set to %u (requested %u)",
         fp_name, set_capacity, requested_capacity);
       break;
+    case FOC_CATCH_UP: {
+      c3_assert(pc.get_size() == sizeof(catch_up_request_t));
+      auto request = (const catch_up_request_t*) pc.get_data();
+      catch_up(request->cr_after, request->cr_replicator);
+      break;
+    }
+    case FOC_RUN_JOB: {
+      c3_assert(pc.get_size() == sizeof(run_job_request_t));
+      auto request = (const run_job_request_t*) pc.get_data();
+      // jobs log their errors themselves
+      if (!request->rjr_job(request->rjr_context, *this)) {
+        log(LL_VERBOSE, "%s: job did not complete successfully", fp_name);
+      }
+      break;
+    }
     default:
       c3_assert_failure();
   }
@@ -401,9 +644,31 @@ void FileOutputPipeline::process_data_command(const PipelineCommand& pc) {
 void FileOutputPipeline::process_object(ReaderWriter& rw) {
   c3_assert(rw.is_clear(IO_FLAG_IS_RESPONSE) && rw.is_clear(IO_FLAG_IS_READER) && rw.is_clear(IO_FLAG_NETWORK));
   if (is_fd_valid()) { // is binlog enabled? if not, just silently ignore the object
+    c3_ulong_t sequence = rw.get_sequence();
+    if (sequence != 0 && sequence != fop_next_sequence) {
+      /*
+       * Start of the file, or commands coming from different connection threads in different order
+       * (which is fine: marks make it possible to tell exact sequence number of each command).
+       */
+      if (write_sequence_mark(sequence)) {
+        if (fop_first_sequence == 0) {
+          fop_first_sequence = sequence;
+        }
+      } else {
+        // the command is still written, but it will not be possible to re-send it
+        sequence = 0;
+        fop_next_sequence = 0;
+      }
+    }
     rw.io_rewind(get_fd(), INVALID_IPV4_ADDRESS);
     c3_ulong_t ntotal;
     if (rw.write(ntotal) == IO_RESULT_OK) {
+      if (sequence != 0) {
+        fop_next_sequence = sequence + 1;
+        if (sequence > fop_last_sequence) {
+          fop_last_sequence = sequence;
+        }
+      }
       increment_current_size(ntotal);
       if (get_current_size() >= get_max_size()) {
         if (fop_rotation_path.is_empty()) {
@@ -418,12 +683,7 @@ void FileOutputPipeline::process_object(ReaderWriter& rw) {
         }
       }
     } else {
-      if (!fop_binlog_io_error) {
-        log(LL_ERROR, "%s: could not write command to binlog '%s'",
-          fp_name, fp_path.get_chars());
-        log(LL_ERROR, "%s: subsequent errors will NOT be logged", fp_name);
-        fop_binlog_io_error = true;
-      }
+      write_binlog_error();
     }
   }
 }
@@ -464,10 +724,18 @@ bool FileOutputPipeline::send_object(FileCommandWriter* rw) {
   return fop_input_queue.put(FileOutputMessage(rw));
 }
 
+void FileOutputPipeline::save_object(FileCommandWriter* rw) {
+  FileOutputMessage msg(rw); // will dispose the object
+  process_object(msg.get_object());
+}
+
 void FileOutputPipeline::thread_proc(c3_uint_t id, ThreadArgument arg) {
   Thread::set_state(TS_ACTIVE);
   auto fop = (FileOutputPipeline*) arg.get_pointer();
   assert(fop && fop->fp_active && fop->fp_path.is_empty() && fop->is_fd_invalid());
+  if (fop_io_backend == IOB_IO_URING) {
+    fop->start_ring_writer();
+  }
   bool keep_going = true;
   do {
     if (fop->fp_active && Thread::received_stop_request()) {
@@ -476,9 +744,18 @@ void FileOutputPipeline::thread_proc(c3_uint_t id, ThreadArgument arg) {
     // in "quitting" mode, we only fetch messages until the queue is depleted
     FileOutputMessage msg;
     if (fop->fp_active) {
-      Thread::set_state(TS_IDLE);
-      msg = fop->fop_input_queue.get();
-      Thread::set_state(TS_ACTIVE);
+      if (fop->fop_ring_writer.has_staged_data()) {
+        // do not let staged data wait for the next command: write them out if there's nothing else to do
+        msg = fop->fop_input_queue.try_get();
+        if (msg.get_type() == CMT_INVALID) {
+          fop->flush_binlog(false);
+        }
+      }
+      if (msg.get_type() == CMT_INVALID) {
+        Thread::set_state(TS_IDLE);
+        msg = fop->fop_input_queue.get();
+        Thread::set_state(TS_ACTIVE);
+      }
     } else {
       msg = fop->fop_input_queue.try_get();
     }
@@ -501,6 +778,7 @@ void FileOutputPipeline::thread_proc(c3_uint_t id, ThreadArgument arg) {
   } while (keep_going);
 
   fop->dispose();
+  fop->fop_ring_writer.dispose();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -514,7 +792,7 @@ FileOutputNotifyingPipeline::FileOutputNotifyingPipeline(const char* name, domai
   set_max_size(terabytes2bytes(1));
 }
 
-void FileOutputNotifyingPipeline::on_closing_binlog() {
+void FileOutputNotifyingPipeline::on_binlog_closed() {
   fonp_output_queue.put(binlog_notification_t(FON_BINLOG_CLOSED));
 }
 
@@ -42,6 +42,8 @@ class FilePipeline: public virtual AbstractLogger, public FileBase {
   };
 
 protected:
+  static constexpr c3_uint_t BINLOG_HEADER_SIZE = sizeof(binlog_header_t);
+
   String             fp_path;         // current file path
   const char* const  fp_name;         // name of the pipeline (for logging etc.)
   const domain_t     fp_domain;       // memory domain
@@ -52,6 +54,8 @@ protected:
 
   Memory& get_memory_object() const { return Memory::get_memory_object(fp_domain); }
   void close_binlog() C3_FUNC_COLD;
+  // called by `close_binlog()` right before an open binlog file is closed
+  virtual void on_closing_binlog() C3_FUNC_COLD {}
   bool read_binlog_header() C3_FUNC_COLD;
   bool write_binlog_header() C3_FUNC_COLD;
   void enter_quit_state() C3_FUNC_COLD;
@@ -112,7 +116,7 @@ class FileInputPipeline: public FilePipeline {
     fip_command_consumer = command_consumer;
   }
 
-  void load_binlog(const char* path, c3_uint_t length);
+  bool load_binlog(const char* path, c3_uint_t length);
 
   bool send_command(file_input_command_t cmd) C3_FUNC_COLD;
   bool send_command(file_input_command_t cmd, const void* data, size_t size) C3_FUNC_COLD;
@@ -128,6 +132,11 @@ public:
   c3_uint_t get_max_queue_capacity() C3LM_OFF(const) { return fip_input_queue.get_max_capacity(); }
 
   bool send_load_file_command(const char* path) C3_FUNC_COLD;
+  /*
+   * Loads binlog using caller's thread; must not be called if pipeline's own thread had been started.
+   * Returns `true` if the entire file had been loaded.
+   */
+  bool load_file(const char* path) C3_FUNC_COLD;
   bool send_set_capacity_command(c3_uint_t capacity) C3_FUNC_COLD {
     return send_command(FIC_SET_CAPACITY, &capacity, sizeof capacity);
   }
@@ -158,12 +167,31 @@ enum file_output_command_t: c3_uintptr_t {
   FOC_CLOSE_BINLOG,            // close binlog and stop saving objects, but keep getting messages
   FOC_SET_CAPACITY,            // set size of the input (object) queue
   FOC_SET_MAX_CAPACITY,        // set size limit to which input queue can grow automatically
+  FOC_CATCH_UP,                // have replicator re-send commands from the binlog
+  FOC_RUN_JOB,                 // run a job (e.g. one writing objects to the binlog directly)
   FOC_QUIT,                    // deplete input queue (only processing objects), then quit
   FOC_NUMBER_OF_ELEMENTS
 };
 
+class FileOutputPipeline;
+
+/**
+ * Job run by a binlog writer's own thread; it can, for instance, create objects and pass them to
+ * `FileOutputPipeline::save_object()`, or load a file that had been written by that writer. Return
+ * value tells whether the job succeeded.
+ */
+typedef bool (*file_job_t)(void* context, FileOutputPipeline& pipeline);
+
 /**
  * Server binlog writer, a pipeline that is used to pump data to persistent storage.
+ *
+ * Commands written to binlogs are numbered (see `get_next_sequence()`); a binlog writer inserts a
+ * `SEQUENCE` mark before the first command in each file, and before any command whose number does not
+ * immediately follow that of the previous command. It also remembers binlog files that it rotated, so
+ * that replicator of the same domain could re-send commands it failed to deliver from those files.
+ *
+ * If `io_uring` backend is selected at startup, commands are copied into staging buffers that are
+ * written out asynchronously when they become full, or when the input queue becomes empty.
  */
 class FileOutputPipeline: public FilePipeline {
 
@@ -172,6 +200,19 @@ class FileOutputPipeline: public FilePipeline {
   static constexpr c3_ulong_t MIN_ROTATION_THRESHOLD = megabytes2bytes(1);
   static constexpr c3_ulong_t DEFAULT_ROTATION_THRESHOLD = megabytes2bytes(256);
   static constexpr c3_ulong_t MAX_ROTATION_THRESHOLD = terabytes2bytes(1);
+  static constexpr c3_uint_t  MAX_ROTATED_BINLOGS = catch_up_plan_t::MAX_NUM_FILES - 1;
+
+  /// Data of the "catch-up" command
+  struct catch_up_request_t {
+    c3_ulong_t            cr_after;      // sequence number of the last command that does not have to be re-sent
+    SocketOutputPipeline* cr_replicator; // replicator that is going to re-send commands
+  };
+
+  /// Data of the "run job" command
+  struct run_job_request_t {
+    file_job_t rjr_job;     // callback to run
+    void*      rjr_context; // argument to pass to the callback
+  };
 
   /// Message type for binlog writer's input message queue
   typedef CommandMessage<file_output_command_t, PipelineCommand, ReaderWriter, FOC_NUMBER_OF_ELEMENTS>
@@ -184,6 +225,18 @@ class FileOutputPipeline: public FilePipeline {
   sync_mode_t     fop_sync_mode;           // what kind of synchronization to use during writing
   bool            fop_binlog_size_warning; // whether binlog size warning had been issued
   bool            fop_binlog_io_error;     // whether binlog I/O error had been logged
+  c3_ulong_t      fop_next_sequence;       // expected sequence number of the next command; 0 if unknown
+  c3_ulong_t      fop_first_sequence;      // sequence number of the first command in current binlog, or 0
+  c3_ulong_t      fop_last_sequence;       // sequence number of the last command written to the binlog
+  c3_uint_t       fop_rotated_head;        // index of the oldest rotated binlog in the arrays below
+  c3_uint_t       fop_num_rotated;         // number of remembered rotated binlogs
+  String          fop_rotated_paths[MAX_ROTATED_BINLOGS];     // paths to binlogs rotated since server start
+  c3_ulong_t      fop_rotated_sequences[MAX_ROTATED_BINLOGS]; // first sequence numbers in rotated binlogs
+  std::atomic<c3_ulong_t> fop_sequence;    // last sequence number assigned to a command
+  RingFileWriter  fop_ring_writer;         // writer used if binlog writes are submitted using `io_uring`
+  std::atomic_bool fop_staged_writes;      // whether current binlog is written through `fop_ring_writer`
+
+  static io_backend_t fop_io_backend;      // how binlog writers should write their files
 
   bool send_command(file_output_command_t cmd) C3_FUNC_COLD;
   bool send_command(file_output_command_t cmd, const void* data, size_t size) C3_FUNC_COLD;
@@ -191,12 +244,20 @@ class FileOutputPipeline: public FilePipeline {
 
   void open_binlog_error(const char* action) C3_FUNC_COLD;
   void open_binlog(const char* reason) C3_FUNC_COLD;
+  void write_binlog_error() C3_FUNC_COLD;
+  void flush_binlog(bool wait);
+  void start_ring_writer() C3_FUNC_COLD;
   void rotate_binlog(const char* reason) C3_FUNC_COLD;
+  void read_first_sequence() C3_FUNC_COLD;
+  bool write_sequence_mark(c3_ulong_t sequence);
+  void catch_up(c3_ulong_t after, SocketOutputPipeline* replicator) C3_FUNC_COLD;
   void process_id_command(file_output_command_t cmd) C3_FUNC_COLD;
   void process_data_command(const PipelineCommand& pc) C3_FUNC_COLD;
   void process_object(ReaderWriter& rw);
   void dispose() C3_FUNC_COLD;
-  virtual void on_closing_binlog() C3_FUNC_COLD;
+  void on_closing_binlog() override C3_FUNC_COLD;
+  // called after binlog had been closed upon "close binlog" request
+  virtual void on_binlog_closed() C3_FUNC_COLD;
 
 public:
   FileOutputPipeline(const char* name, domain_t domain, host_object_t host, c3_byte_t id) noexcept C3_FUNC_COLD;
@@ -204,8 +265,11 @@ public:
   c3_uint_t get_queue_capacity() C3LM_OFF(const) { return fop_input_queue.get_capacity(); }
   c3_uint_t get_max_queue_capacity() C3LM_OFF(const) { return fop_input_queue.get_max_capacity(); }
   sync_mode_t get_sync_mode() const { return fop_sync_mode; }
+  bool is_using_staged_writes() const { return fop_staged_writes.load(std::memory_order_relaxed); }
   static constexpr c3_ulong_t get_min_rotation_threshold() { return MIN_ROTATION_THRESHOLD; }
   static constexpr c3_ulong_t get_max_rotation_threshold() { return MAX_ROTATION_THRESHOLD; }
+  static io_backend_t get_io_backend() { return fop_io_backend; }
+  static void set_io_backend(io_backend_t backend) C3_FUNC_COLD { fop_io_backend = backend; }
 
   bool send_open_binlog_command(const char* path) C3_FUNC_COLD;
   bool send_close_binlog_command() C3_FUNC_COLD { return send_open_binlog_command(nullptr); }
@@ -222,9 +286,40 @@ public:
     return send_command(FOC_SET_MAX_CAPACITY, &max_capacity, sizeof max_capacity);
   }
   bool send_quit_command() C3_FUNC_COLD { return send_command(FOC_QUIT); }
+  bool send_catch_up_command(c3_ulong_t after, SocketOutputPipeline* replicator) C3_FUNC_COLD {
+    catch_up_request_t request = { after, replicator };
+    return send_command(FOC_CATCH_UP, &request, sizeof request);
+  }
+  bool send_run_job_command(file_job_t job, void* context) C3_FUNC_COLD {
+    run_job_request_t request = { job, context };
+    return send_command(FOC_RUN_JOB, &request, sizeof request);
+  }
+
+  /*
+   * Sequence numbers are assigned by connection threads to commands that are about to be sent to the
+   * binlog writer (and, possibly, to replicator); they start with server start time in upper 32 bits, so
+   * that they keep growing across server restarts.
+   */
+  c3_ulong_t get_next_sequence() { return fop_sequence.fetch_add(1, std::memory_order_relaxed) + 1; }
+  c3_ulong_t get_last_sequence() const { return fop_sequence.load(std::memory_order_relaxed); }
+  /*
+   * Called when a `SEQUENCE` mark is found in a binlog that is being restored: makes sure that commands
+   * written from now on get numbers greater than those of the restored commands.
+   */
+  void restore_sequence(c3_ulong_t sequence) {
+    c3_ulong_t current = fop_sequence.load(std::memory_order_relaxed);
+    while (current < sequence &&
+      !fop_sequence.compare_exchange_weak(current, sequence, std::memory_order_relaxed));
+  }
 
   bool send_object(FileCommandWriter* rw);
 
+  /*
+   * Writes object to the binlog (if it is open) and disposes it; bypasses input queue, and so must only
+   * be called by jobs run by this pipeline's own thread (see `send_run_job_command()`).
+   */
+  void save_object(FileCommandWriter* rw);
+
   // this method must *NOT* be called directly: its name should be passed to Thread::start()
   static void thread_proc(c3_uint_t id, ThreadArgument arg);
 };
@@ -272,7 +367,7 @@ class FileOutputNotifyingPipeline: public FileOutputPipeline {
 
   FileOutputNotificationQueue fonp_output_queue; // output notifications
 
-  void on_closing_binlog() override C3_FUNC_COLD;
+  void on_binlog_closed() override C3_FUNC_COLD;
 
 public:
   FileOutputNotifyingPipeline(const char* name, domain_t domain, host_object_t host, c3_byte_t id)
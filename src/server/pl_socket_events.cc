@@ -75,7 +75,11 @@ void SocketEventProcessor::create_listening_sockets(const c3_ipv4_t* ips, c3_uin
     sp_socket_events.push(PipelineSocketEvent());
     PipelineSocketEvent& pse = sp_socket_events.get(i);
     c3_ipv4_t ipv4 = ips[i];
-    int fd = c3_socket(C3_SOCK_NON_BLOCKING | C3_SOCK_REUSE_ADDR);
+    int options = C3_SOCK_NON_BLOCKING | C3_SOCK_REUSE_ADDR;
+    if (sp_share_port) {
+      options |= C3_SOCK_REUSE_PORT;
+    }
+    int fd = c3_socket(options);
     if (fd > 0) {
       bool result = false;
       if (c3_bind(fd, ipv4, sp_port) == 0) {
@@ -137,7 +141,10 @@ bool SocketEventProcessor::set_connection_sockets_info(const c3_ipv4_t* ips, c3_
   for (c3_uint_t i = 0; i < num; i++) {
     sp_logger.log(LL_VERBOSE, "%s: will connect to IP %s",
       sp_service_name, c3_ip2address(ips[i]));
-    sp_socket_events.push(PipelineSocketEvent(ips[i], -1));
+    // connection sockets are created on demand, so the event does not have valid handle yet
+    PipelineSocketEvent event;
+    event.set_socket(-1, ips[i]);
+    sp_socket_events.push(std::move(event));
   }
   return true;
 }
@@ -157,7 +164,8 @@ int SocketEventProcessor::create_connection_socket(c3_uint_t i, c3_ipv4_t &ipv4,
   }
   fd = c3_socket(C3_SOCK_NON_BLOCKING);
   if (fd > 0) {
-    if (c3_connect(fd, ipv4, sp_port) != 0) {
+    // socket is non-blocking, so connection is usually still in progress; writes will be retried till it's done
+    if (c3_connect(fd, ipv4, sp_port) != 0 && errno != EINPROGRESS) {
       c3_close_socket(fd);
     } else {
       if (persistent) {
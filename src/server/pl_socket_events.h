@@ -228,6 +228,7 @@ class SocketEventProcessor {
   c3_uint_t          sp_num_events;    // number of events in `epoll` event buffer
   c3_uint_t          sp_next_event;    // index of the next event to be retrieved from event buffer
   c3_ushort_t        sp_port;          // port number to listen or connect to
+  bool               sp_share_port;    // whether listening sockets share port with other processors
 
 public:
   C3_FUNC_COLD SocketEventProcessor(const char* service_name, AbstractLogger& logger, c3_ushort_t port):
@@ -236,6 +237,7 @@ public:
     sp_num_events = 0;
     sp_next_event = 0;
     sp_port = port;
+    sp_share_port = false;
   }
   SocketEventProcessor(const SocketEventProcessor&) = delete;
   SocketEventProcessor(SocketEventProcessor&&) = delete;
@@ -252,6 +254,7 @@ public:
   c3_uint_t get_num_events() const { return sp_num_events; }
   size_t get_num_sockets() const { return sp_socket_events.get_count(); }
 
+  void set_port_sharing(bool share) C3_FUNC_COLD { sp_share_port = share; }
   void create_listening_sockets(const c3_ipv4_t* ips, c3_uint_t num) C3_FUNC_COLD;
   void dispose_listening_sockets() C3_FUNC_COLD;
 
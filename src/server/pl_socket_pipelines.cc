@@ -17,6 +17,8 @@
 #include "pl_socket_pipelines.h"
 #include "ht_shared_buffers.h"
 
+#include <sys/resource.h>
+
 namespace CyberCache {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -40,18 +42,39 @@ SocketPipeline::SocketPipeline(const char* name, domain_t domain, host_object_t
   sp_port_change = 0;
   sp_persistent = true;
   sp_quitting = false;
+  sp_shared_output = false;
 }
 
 SocketPipeline::~SocketPipeline() { cleanup_socket_pipeline(); }
 
 void SocketPipeline::cleanup_socket_pipeline() {
   if (sp_output_queue != nullptr) {
-    sp_output_queue->dispose();
-    get_memory_object().free(sp_output_queue, sizeof(OutputSocketQueue));
+    if (!sp_shared_output) {
+      sp_output_queue->dispose();
+      get_memory_object().free(sp_output_queue, sizeof(OutputSocketQueue));
+    }
     sp_output_queue = nullptr;
   }
 }
 
+void SocketPipeline::share_output_queue(const SocketPipeline& owner) {
+  c3_assert(sp_output_queue == nullptr && owner.sp_output_queue != nullptr && !owner.sp_shared_output);
+  sp_output_queue = owner.sp_output_queue;
+  sp_shared_output = true;
+}
+
+void SocketPipeline::shutdown_unused_pipeline() {
+  // dispose configuration commands that had been sent before it became known that we won't be started
+  for (;;) {
+    InputSocketMessage msg = sp_input_queue.try_get();
+    if (msg.get_type() == CMT_INVALID) {
+      break;
+    }
+    c3_assert(msg.get_type() != CMT_OBJECT);
+  }
+  sp_event_processor.shutdown_processor();
+}
+
 bool SocketPipeline::send_output_command(socket_output_command_t cmd) {
   if (sp_output_queue != nullptr) {
     return sp_output_queue->put(OutputSocketMessage(cmd));
@@ -66,6 +89,13 @@ bool SocketPipeline::send_output_object(ReaderWriter* object) {
   return false;
 }
 
+bool SocketPipeline::try_send_output_object(ReaderWriter* object) {
+  if (sp_output_queue != nullptr) {
+    return sp_output_queue->try_put(OutputSocketMessage(object));
+  }
+  return false;
+}
+
 bool SocketPipeline::send_input_command(socket_input_command_t cmd) {
   if (sp_input_queue.put(InputSocketMessage(cmd))) {
     sp_event_processor.trigger_queue_event();
@@ -131,6 +161,14 @@ OutputSocketMessage SocketPipeline::get_output_message() {
   }
 }
 
+OutputSocketMessage SocketPipeline::get_output_message(c3_uint_t msecs) {
+  if (sp_output_queue != nullptr) {
+    return std::move(sp_output_queue->get(msecs));
+  } else {
+    return std::move(OutputSocketMessage());
+  }
+}
+
 void SocketPipeline::process_queue_event() {
   sp_event_processor.consume_queue_event();
   for (;;) {
@@ -139,6 +177,7 @@ void SocketPipeline::process_queue_event() {
       case CMT_INVALID:
         C3_DEBUG_LOG("SP queue: no more events");
         // no more messages in the input queue
+        process_input_queue_end();
         return;
       case CMT_ID_COMMAND:
         C3_DEBUG_LOG("SP queue: command event");
@@ -210,6 +249,16 @@ void SocketPipeline::process_queue_event() {
           case SIC_LOCAL_QUEUE_MAX_CAPACITY_CHANGE:
             process_local_max_capacity_change(cmd.get_uint_data());
             break;
+          case SIC_WINDOW_CHANGE:
+            process_window_change(cmd.get_uint_data());
+            break;
+          case SIC_BATCH_SIZE_CHANGE:
+            process_batch_size_change(cmd.get_uint_data());
+            break;
+          case SIC_CATCH_UP:
+            c3_assert(cmd.get_size() == sizeof(catch_up_plan_t));
+            process_catch_up(*(const catch_up_plan_t*) cmd.get_data());
+            break;
           default:
             c3_assert_failure();
         }
@@ -388,11 +437,18 @@ bool ResponseObjectConsumer::post_data_response_impl(SocketResponseWriter* srw,
   if (ok) {
     if (pho != nullptr) {
       PayloadChunkBuilder payload(*srw, server_net_config);
-      payload.add(pho);
+      if (pho->get_buffer_dictionary() == CDICT_NONE) {
+        payload.add(pho);
+      } else {
+        // clients do not have server's compression dictionaries, so such buffers can only be sent unpacked
+        ok = pho->add_unpacked_payload(payload, srw->get_memory_object());
+      }
       header.configure(&payload);
     } else {
       header.configure(nullptr);
     }
+  }
+  if (ok) {
 
     // add data chunks to the header
     type = format;
@@ -472,6 +528,18 @@ SocketResponseWriter* ResponseObjectConsumer::create_object_response(const Comma
  * CMD_REMOVE (in `ht_page_store.cc`):
  *   post_ok_response(const CommandReader& cr);
  *   post_format_error_response(const CommandReader& cr);
+ * CMD_MREMOVE (in `ht_page_store.cc`):
+ *   post_ok_response(const CommandReader& cr);
+ *   post_format_error_response(const CommandReader& cr);
+ * CMD_MSAVE (in `cc_worker_threads.cc`):
+ *   post_ok_response(const CommandReader& cr);
+ *   post_format_error_response(const CommandReader& cr);
+ * CMD_BATCH (in `cc_worker_threads.cc`):
+ *   post_ok_response(const CommandReader& cr);
+ *   post_format_error_response(const CommandReader& cr);
+ * CMD_SEQUENCE (in `cc_server.cc`):
+ *   post_ok_response(const CommandReader& cr);
+ *   post_format_error_response(const CommandReader& cr);
  * CMD_CLEAN (in `ht_tag_manager.cc`):
  *   post_ok_response(const CommandReader& cr);
  *   post_format_error_response(const CommandReader& cr);
@@ -659,6 +727,17 @@ void SocketInputPipeline::process_socket_event(const pipeline_event_t& event) {
         if (fd > 0) {
           PERF_INCREMENT_COUNTER(Incoming_Connections)
 
+          if (sip_owners != nullptr) {
+            if ((c3_uint_t) fd >= sip_num_owners) {
+              log(LL_ERROR, "%s: connection handle %d (remote IP: %s) exceeds max number of handles, closing",
+                sp_name, fd, c3_ip2address(ipv4));
+              c3_close_socket(fd);
+              continue;
+            }
+            // responses to commands received over this connection will be routed back to this shard
+            sip_owners[fd] = sip_index;
+          }
+
           Memory& memory = get_memory_object();
           auto scr = alloc<SocketCommandReader>(memory);
           auto sob = SharedObjectBuffers::create_object(memory);
@@ -866,6 +945,18 @@ void SocketInputPipeline::process_local_max_capacity_change(c3_uint_t max_capaci
   c3_assert_failure();
 }
 
+void SocketInputPipeline::process_window_change(c3_uint_t window) {
+  c3_assert_failure();
+}
+
+void SocketInputPipeline::process_batch_size_change(c3_uint_t size) {
+  c3_assert_failure();
+}
+
+void SocketInputPipeline::process_catch_up(const catch_up_plan_t& plan) {
+  c3_assert_failure();
+}
+
 void SocketInputPipeline::reset_event_processor() {
   sp_event_processor.dispose_listening_sockets();
 }
@@ -890,6 +981,10 @@ bool SocketInputPipeline::post_command_reader(CommandReader* cr) {
   return send_output_object(cr);
 }
 
+bool SocketInputPipeline::post_deferred_command_reader(CommandReader* cr) {
+  return try_send_output_object(cr);
+}
+
 bool SocketInputPipeline::post_response_writer(ResponseWriter* rw) {
   return send_input_object(rw);
 }
@@ -898,15 +993,317 @@ bool SocketInputPipeline::log_error_response(const char* message, int length) {
   return log_message(LL_ERROR, message, length);
 }
 
+void SocketInputPipeline::configure_shard(c3_byte_t index, c3_byte_t* owners, c3_uint_t num_owners,
+  bool share_port) {
+  sip_index = index;
+  sip_owners = owners;
+  sip_num_owners = num_owners;
+  sp_event_processor.set_port_sharing(share_port);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SHARDED SOCKET INPUT PIPELINE
+///////////////////////////////////////////////////////////////////////////////
+
+ShardedSocketInputPipeline::ShardedSocketInputPipeline() noexcept {
+  std::memset(ssp_shards, 0, sizeof ssp_shards);
+  ssp_owners = nullptr;
+  ssp_num_owners = 0;
+  ssp_num_shards = 1;
+  ssp_started = false;
+}
+
+ShardedSocketInputPipeline::~ShardedSocketInputPipeline() {
+  if (ssp_owners != nullptr) {
+    global_memory.free(ssp_owners, ssp_num_owners);
+    ssp_owners = nullptr;
+  }
+}
+
+void ShardedSocketInputPipeline::set_shard(c3_uint_t i, SocketInputPipeline* shard) {
+  c3_assert(i < MAX_NUM_LISTENER_THREADS && shard && ssp_shards[i] == nullptr);
+  ssp_shards[i] = shard;
+  if (i > 0) {
+    // all shards post received commands to the queue listened to by connection threads
+    shard->share_output_queue(get_shard(0));
+  }
+}
+
+bool ShardedSocketInputPipeline::initialize() {
+  for (c3_uint_t i = 0; i < MAX_NUM_LISTENER_THREADS; i++) {
+    if (!get_shard(i).initialize()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ShardedSocketInputPipeline::prepare_shards() {
+  c3_assert(!ssp_started && ssp_owners == nullptr);
+  if (ssp_num_shards > 1) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+      get_shard(0).log(LL_ERROR, "Could not retrieve max number of file handles: %s", c3_get_error_message());
+      return false;
+    }
+    if (limit.rlim_max == RLIM_INFINITY || limit.rlim_max > MAX_NUM_OWNERS) {
+      ssp_num_owners = MAX_NUM_OWNERS;
+    } else {
+      ssp_num_owners = (c3_uint_t) limit.rlim_max;
+    }
+    ssp_owners = (c3_byte_t*) global_memory.calloc(ssp_num_owners, 1);
+  }
+  for (c3_uint_t i = 0; i < MAX_NUM_LISTENER_THREADS; i++) {
+    SocketInputPipeline& shard = get_shard(i);
+    if (i < ssp_num_shards) {
+      shard.configure_shard((c3_byte_t) i, ssp_owners, ssp_num_owners, ssp_num_shards > 1);
+    } else {
+      shard.shutdown_unused_pipeline();
+    }
+  }
+  ssp_started = true;
+  return true;
+}
+
+bool ShardedSocketInputPipeline::is_service_active() const {
+  for (c3_uint_t i = 0; i < ssp_num_shards; i++) {
+    if (get_shard(i).is_service_active()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+c3_uint_t ShardedSocketInputPipeline::get_num_connections() const {
+  c3_uint_t num = 0;
+  for (c3_uint_t i = 0; i < ssp_num_shards; i++) {
+    num += get_shard(i).get_num_connections();
+  }
+  return num;
+}
+
+bool ShardedSocketInputPipeline::post_processors_quit_command() {
+  return get_shard(0).post_processors_quit_command();
+}
+
+bool ShardedSocketInputPipeline::post_command_reader(CommandReader* cr) {
+  return get_shard(0).post_command_reader(cr);
+}
+
+bool ShardedSocketInputPipeline::post_deferred_command_reader(CommandReader* cr) {
+  return get_shard(0).post_deferred_command_reader(cr);
+}
+
+bool ShardedSocketInputPipeline::post_response_writer(ResponseWriter* rw) {
+  return get_owner_shard(rw->get_fd()).post_response_writer(rw);
+}
+
+bool ShardedSocketInputPipeline::log_error_response(const char* message, int length) {
+  return get_shard(0).log_error_response(message, length);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // SOCKET OUTPUT PIPELINE
 ///////////////////////////////////////////////////////////////////////////////
 
+void SocketOutputPipeline::add_to_batch(ReaderWriter* rw) {
+  c3_assert(sop_batch_size && rw);
+  auto writer = (SocketCommandWriter*) rw;
+  c3_uint_t size = writer->get_command_size();
+  if (size > sop_batch_size) {
+    // commands that are too big for any batch are sent as is, but must not overtake batched ones
+    flush_batch();
+    send_object(rw);
+    return;
+  }
+  if (sop_batch_used + size > sop_batch_size) {
+    flush_batch();
+  }
+  if (sop_batch_count == 0) {
+    // a "batch" of just one command is sent as that command, so we do not serialize it just yet
+    c3_assert(sop_batch_head == nullptr && sop_batch_used == 0);
+    sop_batch_head = rw;
+    sop_batch_sequence = rw->get_sequence();
+    sop_batch_used = size;
+  } else {
+    if (sop_batch_buffer == nullptr) {
+      sop_batch_buffer = (c3_byte_t*) get_memory_object().alloc(sop_batch_size);
+    }
+    if (sop_batch_head != nullptr) {
+      ((SocketCommandWriter*) sop_batch_head)->copy_command(sop_batch_buffer);
+      ReaderWriter::dispose(sop_batch_head);
+      sop_batch_head = nullptr;
+    }
+    writer->copy_command(sop_batch_buffer + sop_batch_used);
+    ReaderWriter::dispose(rw);
+    sop_batch_used += size;
+  }
+  sop_batch_count++;
+}
+
+void SocketOutputPipeline::flush_batch() {
+  if (sop_batch_count == 1) {
+    c3_assert(sop_batch_head);
+    ReaderWriter* rw = sop_batch_head;
+    sop_batch_head = nullptr;
+    sop_batch_used = 0;
+    sop_batch_count = 0;
+    send_object(rw);
+  } else if (sop_batch_count > 1) {
+    c3_assert(sop_batch_buffer && sop_batch_head == nullptr);
+    Memory& memory = get_memory_object();
+    SharedObjectBuffers* sob = SharedObjectBuffers::create_object(memory);
+    auto scw = alloc<SocketCommandWriter>(memory);
+    // passing zero `fd` sets "valid, but not active" object state
+    new (scw) SocketCommandWriter(memory, 0, INVALID_IPV4_ADDRESS, sob);
+    // if the batch is lost, catching up should start with its first command
+    scw->set_sequence(sop_batch_sequence);
+    CommandHeaderChunkBuilder header(*scw, server_net_config, CMD_BATCH, false);
+    c3_uint_t count = sop_batch_count;
+    c3_uint_t used = sop_batch_used;
+    sop_batch_used = 0;
+    sop_batch_count = 0;
+    if (header.estimate_number(count) != 0) {
+      // this compresses the entire batch if it's big enough
+      PayloadChunkBuilder payload(*scw, server_net_config);
+      payload.add(sop_batch_buffer, used);
+      header.configure(&payload);
+      header.add_number(count);
+      header.check();
+      // same as with individual commands being replicated, "user" password is replaced with "bulk"
+      c3_hash_t password;
+      if (scw->get_command_pwd_hash(password) == CPT_USER_PASSWORD) {
+        scw->set_command_pwd_hash(CPT_BULK_PASSWORD, server_net_config.get_bulk_password());
+      }
+      PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Batches);
+      PERF_UPDATE_VAR_DOMAIN_MAXIMUM(get_domain(), Replicator_Max_Batched_Commands, count);
+      send_object(scw);
+    } else {
+      record_lost_sequence(sop_batch_sequence);
+      ReaderWriter::dispose(scw);
+      log(LL_ERROR, "%s: could not create BATCH command (%u commands lost)", sp_name, count);
+    }
+  }
+}
+
+void SocketOutputPipeline::dispose_batch() {
+  if (sop_batch_head != nullptr) {
+    ReaderWriter::dispose(sop_batch_head);
+    sop_batch_head = nullptr;
+  }
+  if (sop_batch_count > 1) {
+    record_lost_sequence(sop_batch_sequence);
+    log(LL_WARNING, "%s: dropped batch of %u commands", sp_name, sop_batch_count);
+  }
+  if (sop_batch_buffer != nullptr) {
+    get_memory_object().free(sop_batch_buffer, sop_batch_size);
+    sop_batch_buffer = nullptr;
+  }
+  sop_batch_used = 0;
+  sop_batch_count = 0;
+}
+
+void SocketOutputPipeline::record_lost_sequence(c3_ulong_t sequence) {
+  // only this thread updates the field, so there is no need for compare-and-swap loops
+  if (sequence != 0) {
+    c3_ulong_t lost = sop_lost_sequence.load(std::memory_order_relaxed);
+    if (lost == 0 || sequence < lost) {
+      sop_lost_sequence.store(sequence, std::memory_order_release);
+    }
+  }
+}
+
+void SocketOutputPipeline::next_catch_up_file() {
+  c3_assert(is_catching_up());
+  c3_close_file(sop_catch_up.cp_fds[sop_catch_up_file]);
+  sop_catch_up_next = 0; // each binlog file starts with its own sequence number mark
+  if (++sop_catch_up_file < sop_catch_up.cp_num_files) {
+    sop_catch_up_remains = sop_catch_up.cp_sizes[sop_catch_up_file];
+  } else {
+    sop_catch_up_remains = 0;
+    log(LL_NORMAL, "%s: catch-up complete, re-sent %llu commands", sp_name, sop_catch_up_count);
+  }
+}
+
+ReaderWriter* SocketOutputPipeline::get_catch_up_object() {
+  Memory& memory = get_memory_object();
+  while (is_catching_up()) {
+    if (sop_catch_up_remains > 0) {
+      auto fcr = alloc<FileCommandReader>(memory);
+      auto sob = SharedObjectBuffers::create_object(memory);
+      new (fcr) FileCommandReader(memory, sop_catch_up.cp_fds[sop_catch_up_file], sob);
+      c3_ulong_t size;
+      if (fcr->read(size) == IO_RESULT_OK && size <= sop_catch_up_remains) {
+        sop_catch_up_remains -= size;
+        if (fcr->get_command_id() == CMD_SEQUENCE) {
+          CommandHeaderIterator iterator(*fcr);
+          NumberChunk high = iterator.get_number();
+          NumberChunk low = iterator.get_number();
+          sop_catch_up_next = high.is_valid_uint() && low.is_valid_uint()?
+            ((c3_ulong_t) high.get_uint() << 32) | low.get_uint(): 0;
+          ReaderWriter::dispose(fcr);
+          continue;
+        }
+        // commands that precede the first mark in a file do not have sequence numbers, and are skipped
+        c3_ulong_t sequence = sop_catch_up_next;
+        if (sequence != 0) {
+          sop_catch_up_next++;
+        }
+        if (sequence >= sop_catch_up.cp_from) {
+          auto scw = alloc<SocketCommandWriter>(memory);
+          // passing zero `fd` sets "valid, but not active" object state
+          new (scw) SocketCommandWriter(memory, *fcr, 0);
+          scw->set_sequence(sequence);
+          ReaderWriter::dispose(fcr);
+          sop_catch_up_count++;
+          PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Catch_Up_Commands);
+          return scw;
+        }
+        ReaderWriter::dispose(fcr);
+        continue;
+      }
+      ReaderWriter::dispose(fcr);
+      log(LL_ERROR, "%s: could not read binlog command during catch-up (file %u of %u)",
+        sp_name, sop_catch_up_file + 1, sop_catch_up.cp_num_files);
+    }
+    next_catch_up_file();
+  }
+  return nullptr;
+}
+
+ReaderWriter* SocketOutputPipeline::get_next_object() {
+  // commands being re-sent from the binlog precede all commands that arrived since catch-up had started
+  if (is_catching_up()) {
+    ReaderWriter* rw = get_catch_up_object();
+    if (rw != nullptr) {
+      return rw;
+    }
+  }
+  ReaderWriterPointer rwp = sop_deferred_objects.get();
+  return rwp.is_valid()? rwp.get(): nullptr;
+}
+
 void SocketOutputPipeline::process_input_queue_object(ReaderWriter* rw) {
   c3_assert(rw && rw->is_valid() && rw->is_set(IO_FLAG_NETWORK) &&
     rw->is_clear(IO_FLAG_IS_READER) && rw->is_clear(IO_FLAG_IS_RESPONSE));
 
-  if (sp_persistent && sp_num_connections > 0) {
+  if (sop_batch_size != 0) {
+    add_to_batch(rw);
+  } else {
+    send_object(rw);
+  }
+}
+
+void SocketOutputPipeline::process_input_queue_end() {
+  flush_batch();
+}
+
+void SocketOutputPipeline::send_object(ReaderWriter* rw) {
+  c3_assert(rw && rw->is_valid() && rw->is_set(IO_FLAG_NETWORK) &&
+    rw->is_clear(IO_FLAG_IS_READER) && rw->is_clear(IO_FLAG_IS_RESPONSE));
+
+  if ((sp_persistent && sp_num_connections > 0) || is_stream_busy() || is_catching_up() ||
+    sop_deferred_objects.get_count() > 0) {
     /*
      * In socket output pipelines, number of active connections has different meaning: not that
      * a connection had been established, but that a command or a response to a command is still
@@ -915,16 +1312,39 @@ void SocketOutputPipeline::process_input_queue_object(ReaderWriter* rw) {
      * If we are in "persistent connections" mode, we cannot start transferring a new command until
      * sending previous command (*and* receiving response to it) is complete -- because connection
      * sockets are re-used. So we queue the command, and wait till transfer is done.
+     *
+     * In pipelined mode, the command can be sent right away if there is room in the window, and if
+     * it would not overtake commands that are already waiting in the queue, or commands that are being
+     * re-sent from the binlog.
      */
+    if (is_pipelining() && sop_stream_writer == nullptr && sop_num_in_flight < sop_window &&
+      get_num_regular_connections() == 0 && sop_deferred_objects.get_count() == 0 && !is_catching_up()) {
+      send_stream_object(rw);
+      return;
+    }
     if (!sop_deferred_objects.put(ReaderWriterPointer(rw))) {
+      record_lost_sequence(rw->get_sequence());
       log_object(LL_ERROR, rw, "could not defer writing [Q]");
     }
     PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Deferred_Commands);
     PERF_UPDATE_VAR_DOMAIN_MAXIMUM(get_domain(), Replicator_Max_Deferred_Commands, sop_deferred_objects.get_count());
     return;
   }
+  transmit_object(rw);
+}
+
+void SocketOutputPipeline::transmit_object(ReaderWriter* rw) {
+  c3_assert(rw && rw->is_valid() && rw->is_set(IO_FLAG_NETWORK) &&
+    rw->is_clear(IO_FLAG_IS_READER) && rw->is_clear(IO_FLAG_IS_RESPONSE));
+
+  if (is_pipelining()) {
+    send_stream_object(rw);
+    return;
+  }
 
   Memory& memory = get_memory_object();
+  const c3_ulong_t sequence = rw->get_sequence();
+  bool delivered = false;
   for (c3_uint_t i = 0; i < sp_event_processor.get_num_sockets(); i++) {
     for (c3_uint_t j = 0; j < 2; j++) {
       c3_ipv4_t ipv4;
@@ -938,9 +1358,12 @@ void SocketOutputPipeline::process_input_queue_object(ReaderWriter* rw) {
             auto new_reader = alloc<SocketResponseReader>(memory);
             auto sob = SharedObjectBuffers::create_object(memory);
             new (new_reader) SocketResponseReader(memory, fd, ipv4, sob);
+            // if response does not arrive, we will know what command may have been lost
+            new_reader->set_sequence(sequence);
             C3_DEBUG(log_object(LL_DEBUG, new_reader, "new connection [Q]"));
             sp_event_processor.watch_object(new_reader);
             sp_num_connections++;
+            delivered = true;
             break;
           }
           case IO_RESULT_RETRY: { // could not complete, must retry later
@@ -956,6 +1379,7 @@ void SocketOutputPipeline::process_input_queue_object(ReaderWriter* rw) {
             sp_event_processor.watch_object(rw);
             sp_num_connections++;
             rw = new_writer;
+            delivered = true;
             break;
           }
           default:
@@ -974,6 +1398,8 @@ void SocketOutputPipeline::process_input_queue_object(ReaderWriter* rw) {
               sp_event_processor.close_connection_socket(i);
             }
         }
+        // the command had been either sent (or started being sent), or given up on
+        break;
       } else {
         // failed call must have set IP address, it's part of its contract
         log(LL_ERROR, "%s: could not connect to %s to send a command",
@@ -982,6 +1408,9 @@ void SocketOutputPipeline::process_input_queue_object(ReaderWriter* rw) {
     }
     break;
   }
+  if (!delivered && sp_event_processor.get_num_sockets() > 0) {
+    record_lost_sequence(sequence);
+  }
   if (rw != nullptr) {
     ReaderWriter::dispose(rw);
   }
@@ -992,15 +1421,246 @@ void SocketOutputPipeline::process_socket_event(const pipeline_event_t& event) {
   c3_assert_failure();
 }
 
+void SocketOutputPipeline::send_stream_object(ReaderWriter* rw) {
+  c3_assert(rw && sop_stream_writer == nullptr && sop_num_in_flight < sop_window);
+  if (sp_event_processor.get_num_sockets() == 0) {
+    // no replication servers configured
+    ReaderWriter::dispose(rw);
+    return;
+  }
+  const bool was_busy = is_stream_busy();
+  for (c3_uint_t j = 0; j < 2; j++) {
+    c3_ipv4_t ipv4;
+    int fd = sp_event_processor.create_connection_socket(0, ipv4, true);
+    if (fd > 0) {
+      rw->io_rewind(fd, ipv4);
+      c3_ulong_t ntotal;
+      switch (rw->write(ntotal)) {
+        case IO_RESULT_OK: // completed writing in one go
+          add_in_flight_sequence(rw->get_sequence());
+          if (sop_num_in_flight++ == 0) {
+            Memory& memory = get_memory_object();
+            sop_stream_reader = alloc<SocketResponseReader>(memory);
+            auto sob = SharedObjectBuffers::create_object(memory);
+            new (sop_stream_reader) SocketResponseReader(memory, fd, ipv4, sob);
+            C3_DEBUG(log_object(LL_DEBUG, sop_stream_reader, "new stream connection [S]"));
+            if (sop_stream_writer == nullptr) {
+              sp_event_processor.watch_object(sop_stream_reader);
+            }
+          }
+          PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Pipelined_Commands);
+          PERF_UPDATE_VAR_DOMAIN_MAXIMUM(get_domain(), Replicator_Max_Commands_In_Flight, sop_num_in_flight);
+          ReaderWriter::dispose(rw);
+          break;
+        case IO_RESULT_RETRY: // could not complete, must retry later
+          sop_stream_writer = rw;
+          if (sop_num_in_flight == 0) {
+            sp_event_processor.watch_object(rw);
+          }
+          break;
+        default:
+          if (j == 0 && !was_busy) {
+            // connection had been idle, and could have been dropped by the peer: silently re-connect
+            sp_event_processor.close_connection_socket(0);
+            PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Reconnections);
+            continue;
+          }
+          log_object(LL_ERROR, rw, "could not send data [S]");
+          record_lost_sequence(rw->get_sequence());
+          ReaderWriter::dispose(rw);
+          if (was_busy) {
+            abort_stream("dropped pipelined commands");
+          } else {
+            sp_event_processor.close_connection_socket(0);
+          }
+          return;
+      }
+      if (!was_busy) {
+        sp_num_connections++;
+      }
+      return;
+    } else {
+      // failed call must have set IP address, it's part of its contract
+      log(LL_ERROR, "%s: could not connect to %s to send a command", sp_name, c3_ip2address(ipv4));
+    }
+  }
+  record_lost_sequence(rw->get_sequence());
+  ReaderWriter::dispose(rw);
+}
+
+void SocketOutputPipeline::fill_stream_window() {
+  while (is_pipelining() && sop_stream_writer == nullptr && sop_num_in_flight < sop_window &&
+    get_num_regular_connections() == 0) {
+    ReaderWriter* rw = get_next_object();
+    if (rw != nullptr) {
+      send_stream_object(rw);
+    } else {
+      break;
+    }
+  }
+}
+
+void SocketOutputPipeline::complete_stream_response() {
+  c3_assert(sop_num_in_flight > 0 && sop_stream_reader);
+  SocketResponseReader* reader = sop_stream_reader;
+  sop_in_flight_head = (sop_in_flight_head + 1) % SOP_MAX_WINDOW;
+  if (--sop_num_in_flight > 0) {
+    // start reading next response on the same connection
+    Memory& memory = get_memory_object();
+    sop_stream_reader = alloc<SocketResponseReader>(memory);
+    auto sob = SharedObjectBuffers::create_object(memory);
+    new (sop_stream_reader) SocketResponseReader(memory, reader->get_fd(), reader->get_ipv4(), sob);
+    sp_event_processor.replace_watched_object(sop_stream_reader);
+  } else {
+    sop_stream_reader = nullptr;
+    if (sop_stream_writer != nullptr) {
+      // the command that could not be sent in one go is now the only thing to wait for
+      sp_event_processor.replace_watched_object(sop_stream_writer);
+    } else {
+      C3_DEBUG(log_object(LL_DEBUG, reader, "stream is idle [S]"));
+      sp_event_processor.unwatch_object(reader);
+      assert(sp_num_connections > 0);
+      sp_num_connections--;
+      if (!sp_persistent) {
+        // must have switched off persistent connections while the stream was busy
+        sp_event_processor.close_connection_socket(0);
+      }
+    }
+  }
+  ReaderWriter::dispose(reader);
+}
+
+void SocketOutputPipeline::abort_stream(const char* msg) {
+  c3_assert(is_stream_busy());
+  ReaderWriter* watched = sop_num_in_flight > 0? sop_stream_reader: sop_stream_writer;
+  log_object(LL_ERROR, watched, msg);
+  // commands that did not get responses may or may not have been executed by the replication server
+  for (c3_uint_t i = 0; i < sop_num_in_flight; i++) {
+    record_lost_sequence(sop_in_flight_sequences[(sop_in_flight_head + i) % SOP_MAX_WINDOW]);
+  }
+  sp_event_processor.unwatch_object(watched);
+  sp_event_processor.close_connection_socket(0);
+  if (sop_stream_reader != nullptr) {
+    ReaderWriter::dispose(sop_stream_reader);
+    sop_stream_reader = nullptr;
+  }
+  if (sop_stream_writer != nullptr) {
+    record_lost_sequence(sop_stream_writer->get_sequence());
+    ReaderWriter::dispose(sop_stream_writer);
+    sop_stream_writer = nullptr;
+  }
+  sop_num_in_flight = 0;
+  assert(sp_num_connections > 0);
+  sp_num_connections--;
+}
+
+void SocketOutputPipeline::process_stream_event(const pipeline_event_t& event) {
+  const c3_byte_t flags = event.pe_flags;
+  c3_ulong_t ntotal;
+  if ((flags & PEF_ERROR) != 0) {
+    abort_stream("connection error [S]");
+  } else if ((flags & PEF_HUP) != 0 && (flags & PEF_READ) == 0) {
+    abort_stream("connection dropped [S]");
+  } else if ((flags & PEF_READ) != 0) { // "connection ready for reading"
+    c3_assert(event.pe_object == sop_stream_reader);
+    /*
+     * Several responses may have arrived at once; since `epoll` works in edge-triggered mode, we have to
+     * keep reading until there is no more data.
+     */
+    while (sop_stream_reader != nullptr) {
+      io_result_t result = sop_stream_reader->read(ntotal);
+      if (result == IO_RESULT_OK) {
+        switch (sop_stream_reader->get_type()) {
+          case RESPONSE_OK:
+            break;
+          case RESPONSE_ERROR:
+            log_object(LL_ERROR, sop_stream_reader, "received ERROR response [S]");
+            break;
+          default: // "can't happen" (we don't replicate commands that would send other responses)
+            c3_assert_failure();
+        }
+        complete_stream_response();
+        if (sop_stream_writer != nullptr && sop_num_in_flight > 0) {
+          // peer had consumed some data, so there may be room in the socket buffer now
+          switch (sop_stream_writer->write(ntotal)) {
+            case IO_RESULT_OK:
+              add_in_flight_sequence(sop_stream_writer->get_sequence());
+              ReaderWriter::dispose(sop_stream_writer);
+              sop_stream_writer = nullptr;
+              sop_num_in_flight++;
+              PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Pipelined_Commands);
+              PERF_UPDATE_VAR_DOMAIN_MAXIMUM(get_domain(), Replicator_Max_Commands_In_Flight, sop_num_in_flight);
+              break;
+            case IO_RESULT_RETRY:
+              break;
+            default:
+              abort_stream("could not send data [S]");
+              continue; // reader is gone, so this ends the loop
+          }
+        }
+        fill_stream_window();
+      } else {
+        if (result != IO_RESULT_RETRY) {
+          abort_stream("could not receive data [S]");
+        }
+        break;
+      }
+    }
+  } else { // "connection ready for writing"
+    c3_assert(event.pe_object == sop_stream_writer && sop_num_in_flight == 0);
+    ReaderWriter* writer = sop_stream_writer;
+    switch (writer->write(ntotal)) {
+      case IO_RESULT_OK: {
+        // completed writing command; start reading responses
+        Memory& memory = get_memory_object();
+        sop_stream_reader = alloc<SocketResponseReader>(memory);
+        auto sob = SharedObjectBuffers::create_object(memory);
+        new (sop_stream_reader) SocketResponseReader(memory, writer->get_fd(), writer->get_ipv4(), sob);
+        sp_event_processor.replace_watched_object(sop_stream_reader);
+        sop_stream_writer = nullptr;
+        sop_in_flight_head = 0;
+        add_in_flight_sequence(writer->get_sequence());
+        sop_num_in_flight = 1;
+        PERF_INCREMENT_VAR_DOMAIN_COUNTER(get_domain(), Replicator_Pipelined_Commands);
+        ReaderWriter::dispose(writer);
+        fill_stream_window();
+        break;
+      }
+      case IO_RESULT_RETRY:
+        // could not write all the data; keep the object on `epoll` watch list
+        break;
+      default:
+        abort_stream("could not send data [S]");
+    }
+  }
+
+  if (!is_stream_busy()) {
+    // stream is idle (or had been aborted); if pipelining had been switched off, use regular connections
+    fill_stream_window();
+    if (!is_pipelining() && (!sp_persistent || sp_num_connections == 0)) {
+      ReaderWriter* rw = get_next_object();
+      if (rw != nullptr) {
+        transmit_object(rw);
+      }
+    }
+  }
+}
+
 void SocketOutputPipeline::process_object_event(const pipeline_event_t& event) {
   const c3_byte_t flags = event.pe_flags;
   ReaderWriter* rw = event.pe_object;
   c3_assert(rw && rw->is_active() && rw->is_set(IO_FLAG_NETWORK));
 
+  if (rw == sop_stream_reader || rw == sop_stream_writer) {
+    process_stream_event(event);
+    return;
+  }
+
   bool close_connection = true;
   if ((flags & PEF_ERROR) != 0) {
     // log the error, and proceed with disposing the object
     log_object(LL_ERROR, rw, "connection error");
+    record_lost_sequence(rw->get_sequence());
   } else if ((flags & PEF_HUP) != 0 && (flags & PEF_READ) == 0) {
     /*
      * log the warning, and proceed with disposing the object; here, we make sure that not only remote peer
@@ -1009,6 +1669,7 @@ void SocketOutputPipeline::process_object_event(const pipeline_event_t& event) {
      * it would be normal for a replication server (peer) to disconnect right after sending the response
      */
     log_object(LL_WARNING, rw, "connection dropped");
+    record_lost_sequence(rw->get_sequence());
   } else {
     c3_ulong_t ntotal;
     if ((flags & PEF_READ) != 0) { // "connection ready for reading"
@@ -1038,6 +1699,7 @@ void SocketOutputPipeline::process_object_event(const pipeline_event_t& event) {
         default:
           // got an error! report it and proceed with disposing the object
           log_object(LL_ERROR, rw, "could not receive data [E]");
+          record_lost_sequence(rw->get_sequence());
       }
     } else { // "connection ready for writing"
       c3_assert(rw->is_clear(IO_FLAG_IS_READER) && rw->is_clear(IO_FLAG_IS_RESPONSE));
@@ -1048,6 +1710,7 @@ void SocketOutputPipeline::process_object_event(const pipeline_event_t& event) {
           auto rr = alloc<SocketResponseReader>(memory);
           auto sob = SharedObjectBuffers::create_object(memory);
           new (rr) SocketResponseReader(memory, rw->get_fd(), rw->get_ipv4(), sob);
+          rr->set_sequence(rw->get_sequence());
           c3_assert(rw->is_active());
           sp_event_processor.replace_watched_object(rr);
           c3_assert(rr->get_fd() == rw->get_fd());
@@ -1060,6 +1723,7 @@ void SocketOutputPipeline::process_object_event(const pipeline_event_t& event) {
         default:
           // got an error! report it and proceed with disposing the object
           log_object(LL_ERROR, rw, "could not send data [E]");
+          record_lost_sequence(rw->get_sequence());
       }
     }
   }
@@ -1079,9 +1743,13 @@ void SocketOutputPipeline::process_object_event(const pipeline_event_t& event) {
    * do not check if connection had just been closed either because if could have been closed because
    * of socket error, or because remote peer is not using persistent connections and just hung up
    */
-  ReaderWriterPointer rwp = sop_deferred_objects.get();
-  if (rwp.is_valid()) {
-    process_input_queue_object(rwp.get());
+  if (is_pipelining()) {
+    fill_stream_window();
+  } else if (!is_stream_busy()) {
+    ReaderWriter* next_rw = get_next_object();
+    if (next_rw != nullptr) {
+      transmit_object(next_rw);
+    }
   }
 }
 
@@ -1112,7 +1780,8 @@ void SocketOutputPipeline::process_port_and_ip_set_change() {
 }
 
 void SocketOutputPipeline::process_persistent_connections_change(bool persistent) {
-  if (!(sp_persistent = persistent)) {
+  // if pipelined stream is still busy, its connection will be closed once it becomes idle
+  if (!(sp_persistent = persistent) && !is_stream_busy()) {
     sp_event_processor.close_connection_sockets();
   }
 }
@@ -1131,8 +1800,70 @@ void SocketOutputPipeline::process_local_max_capacity_change(c3_uint_t max_capac
       sp_name, set_capacity, max_capacity);
 }
 
+void SocketOutputPipeline::process_window_change(c3_uint_t window) {
+  assert(window > 0 && window <= SOP_MAX_WINDOW);
+  sop_window = window;
+  log(LL_VERBOSE, "%s: replication window set to %u", sp_name, window);
+  // in-flight commands above new limit (if any) will just complete; otherwise, there might be room now
+  if (is_stream_busy()) {
+    fill_stream_window();
+  }
+}
+
+void SocketOutputPipeline::process_batch_size_change(c3_uint_t size) {
+  if (size != sop_batch_size) {
+    // buffer of the current batch has old size, so the batch has to be sent before it's re-allocated
+    flush_batch();
+    dispose_batch();
+    sop_batch_size = size;
+    log(LL_VERBOSE, "%s: replication batch size set to %u", sp_name, size);
+  }
+}
+
+void SocketOutputPipeline::process_catch_up(const catch_up_plan_t& plan) {
+  c3_assert(plan.cp_num_files > 0 && plan.cp_num_files <= catch_up_plan_t::MAX_NUM_FILES);
+  if (is_catching_up() || sp_event_processor.get_num_sockets() == 0) {
+    log(LL_WARNING, "%s: ignoring catch-up request (%s)", sp_name,
+      is_catching_up()? "previous catch-up is still in progress": "replication is not active");
+    for (c3_uint_t i = 0; i < plan.cp_num_files; i++) {
+      c3_close_file(plan.cp_fds[i]);
+    }
+    return;
+  }
+  log(LL_NORMAL, "%s: re-sending commands starting from sequence number %llu (%u binlog file%s)",
+    sp_name, plan.cp_from, plan.cp_num_files, plan.cp_num_files == 1? "": "s");
+  std::memcpy(&sop_catch_up, &plan, sizeof plan);
+  sop_catch_up_file = 0;
+  sop_catch_up_remains = plan.cp_sizes[0];
+  sop_catch_up_next = 0;
+  sop_catch_up_count = 0;
+  // all commands that had been lost since sequence number in the plan are going to be re-sent
+  if (get_lost_sequence() >= plan.cp_from) {
+    sop_lost_sequence.store(0, std::memory_order_release);
+  }
+  // commands arriving from now on are deferred until catch-up completes, so we have to start it here
+  if (is_pipelining()) {
+    fill_stream_window();
+  } else if (!is_stream_busy() && sp_num_connections == 0) {
+    ReaderWriter* rw = get_next_object();
+    if (rw != nullptr) {
+      transmit_object(rw);
+    }
+  }
+}
+
 void SocketOutputPipeline::reset_event_processor() {
+  c3_assert(!is_stream_busy());
   sp_event_processor.dispose_connection_sockets();
 }
 
+void SocketOutputPipeline::cleanup() {
+  for (c3_uint_t i = sop_catch_up_file; i < sop_catch_up.cp_num_files; i++) {
+    c3_close_file(sop_catch_up.cp_fds[i]);
+  }
+  sop_catch_up_file = sop_catch_up.cp_num_files;
+  dispose_batch();
+  cleanup_socket_pipeline();
+}
+
 }
@@ -44,6 +44,9 @@ enum socket_input_command_t: c3_uintptr_t {
   SIC_OUTPUT_QUEUE_MAX_CAPACITY_CHANGE, // should change output queue capacity limit
   SIC_LOCAL_QUEUE_CAPACITY_CHANGE,      // should change capacity of the internal queue of deferred objects
   SIC_LOCAL_QUEUE_MAX_CAPACITY_CHANGE,  // should change internal queue of deferred objects limit
+  SIC_WINDOW_CHANGE,                    // should change max number of commands sent ahead of responses
+  SIC_BATCH_SIZE_CHANGE,                // should change max size of batches of commands
+  SIC_CATCH_UP,                         // should re-send commands from binlog files (see `catch_up_plan_t`)
   SIC_PERSISTENT_CONNECTIONS_ON,        // should use persistent connections
   SIC_PERSISTENT_CONNECTIONS_OFF,       // should use per-command connections
   SIC_QUIT,                             // must complete outstanding actions and then quit
@@ -57,6 +60,20 @@ enum socket_output_command_t: c3_uintptr_t {
   SOC_NUMBER_OF_ELEMENTS
 };
 
+/**
+ * Binlog files from which a replicator should re-send commands that it could not deliver; sent to the
+ * replicator by the binlog writer of the same domain. Files are already opened and positioned right past
+ * their headers; the replicator reads them in order, and closes them when done.
+ */
+struct catch_up_plan_t {
+  static constexpr c3_uint_t MAX_NUM_FILES = 16;
+
+  c3_ulong_t cp_from;                 // sequence number of the first command to re-send
+  c3_ulong_t cp_sizes[MAX_NUM_FILES]; // number of bytes to read from each file (past its header)
+  int        cp_fds[MAX_NUM_FILES];   // file handles, oldest file first
+  c3_uint_t  cp_num_files;            // number of files in the plan
+};
+
 /// Message type for socket pipeline's input message queue
 typedef CommandMessage<socket_input_command_t, PipelineCommand, ReaderWriter, SIC_NUMBER_OF_ELEMENTS>
   InputSocketMessage;
@@ -79,6 +96,10 @@ class SocketPipeline: public virtual AbstractLogger {
   virtual void process_persistent_connections_change(bool persistent) = 0;
   virtual void process_local_capacity_change(c3_uint_t capacity) = 0;
   virtual void process_local_max_capacity_change(c3_uint_t max_capacity) = 0;
+  virtual void process_window_change(c3_uint_t window) = 0;
+  virtual void process_batch_size_change(c3_uint_t size) = 0;
+  virtual void process_catch_up(const catch_up_plan_t& plan) = 0;
+  virtual void process_input_queue_end() {}
   virtual void reset_event_processor() = 0;
   virtual void cleanup() C3_FUNC_COLD { cleanup_socket_pipeline(); }
 
@@ -95,6 +116,7 @@ protected:
   c3_ushort_t          sp_port_change;     // port change command is being processed
   bool                 sp_persistent;      // `true` if connections are persistent
   bool                 sp_quitting;        // `true` if "quit" request had been received
+  bool                 sp_shared_output;   // `true` if output queue is owned by another pipeline
 
   SocketPipeline(const char* name, domain_t domain, host_object_t host,
     c3_uint_t input_capacity, c3_uint_t output_capacity, c3_byte_t base_id) C3_FUNC_COLD;
@@ -118,6 +140,7 @@ protected:
 
   bool send_output_command(socket_output_command_t cmd) C3_FUNC_COLD;
   bool send_output_object(ReaderWriter* object);
+  bool try_send_output_object(ReaderWriter* object);
   bool send_input_command(socket_input_command_t cmd) C3_FUNC_COLD;
   bool send_input_command(socket_input_command_t cmd, const void* data, size_t size) C3_FUNC_COLD;
 
@@ -141,6 +164,8 @@ public:
   c3_uint_t get_max_output_queue_capacity() C3LM_OFF(const) C3_FUNC_COLD {
     return sp_output_queue != nullptr? sp_output_queue->get_max_capacity(): 0;
   }
+  void share_output_queue(const SocketPipeline& owner) C3_FUNC_COLD;
+  void shutdown_unused_pipeline() C3_FUNC_COLD;
 
   // to be used by the application
   bool is_using_persistent_connections() const { return sp_persistent; }
@@ -175,12 +200,22 @@ public:
   bool send_max_local_queue_capacity_change_command(c3_uint_t max_capacity) C3_FUNC_COLD {
     return send_input_command(SIC_LOCAL_QUEUE_MAX_CAPACITY_CHANGE, &max_capacity, sizeof max_capacity);
   }
+  bool send_window_change_command(c3_uint_t window) C3_FUNC_COLD {
+    return send_input_command(SIC_WINDOW_CHANGE, &window, sizeof window);
+  }
+  bool send_batch_size_change_command(c3_uint_t size) C3_FUNC_COLD {
+    return send_input_command(SIC_BATCH_SIZE_CHANGE, &size, sizeof size);
+  }
+  bool send_catch_up_command(const catch_up_plan_t& plan) C3_FUNC_COLD {
+    return send_input_command(SIC_CATCH_UP, &plan, sizeof plan);
+  }
   bool send_set_persistent_connections_command(bool enable) C3_FUNC_COLD {
     return send_input_command(enable? SIC_PERSISTENT_CONNECTIONS_ON: SIC_PERSISTENT_CONNECTIONS_OFF);
   }
   bool send_quit_command() C3_FUNC_COLD { return send_input_command(SIC_QUIT); }
 
   OutputSocketMessage get_output_message();
+  OutputSocketMessage get_output_message(c3_uint_t msecs);
 
   // this method must *NOT* be called directly: its name should be passed to Thread::start()
   static void thread_proc(c3_uint_t id, ThreadArgument arg);
@@ -209,6 +244,11 @@ public:
   // low-level command handlers
   virtual bool post_processors_quit_command() = 0;
   virtual bool post_command_reader(CommandReader* cr) = 0;
+  /*
+   * Re-dispatches a command that had been postponed by its processor; never blocks, and returns `false`
+   * if the command could not be queued (in which case the caller should process it itself).
+   */
+  virtual bool post_deferred_command_reader(CommandReader* cr) = 0;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -307,6 +347,9 @@ class SocketInputPipeline: public SocketPipeline,
   public CommandObjectConsumer, public ResponseObjectConsumer {
 
   PipelineCommand* sip_last_ipv4_set; // last used IP set (in case we need to change port)
+  c3_byte_t*       sip_owners;        // shards that accepted connections, by handles (NULL if not sharded)
+  c3_uint_t        sip_num_owners;    // number of elements in the `sip_owners` table
+  c3_byte_t        sip_index;         // index of this pipeline among shards of the server listener
 
   void process_input_queue_object(ReaderWriter* rw) override;
   void process_socket_event(const pipeline_event_t& event) override;
@@ -318,6 +361,9 @@ class SocketInputPipeline: public SocketPipeline,
   void process_persistent_connections_change(bool persistent) override C3_FUNC_COLD;
   void process_local_capacity_change(c3_uint_t capacity) override C3_FUNC_COLD;
   void process_local_max_capacity_change(c3_uint_t max_capacity) override C3_FUNC_COLD;
+  void process_window_change(c3_uint_t window) override C3_FUNC_COLD;
+  void process_batch_size_change(c3_uint_t size) override C3_FUNC_COLD;
+  void process_catch_up(const catch_up_plan_t& plan) override C3_FUNC_COLD;
   void reset_event_processor() override C3_FUNC_COLD;
   void cleanup() override C3_FUNC_COLD;
 
@@ -326,6 +372,7 @@ class SocketInputPipeline: public SocketPipeline,
 public:
   bool post_processors_quit_command() override C3_FUNC_COLD;
   bool post_command_reader(CommandReader* cr) override;
+  bool post_deferred_command_reader(CommandReader* cr) override;
   bool post_response_writer(ResponseWriter* rw) override;
   bool log_error_response(const char* message, int length) override C3_FUNC_COLD;
 
@@ -333,6 +380,9 @@ public:
     c3_uint_t input_capacity, c3_uint_t output_capacity, c3_byte_t base_id):
     SocketPipeline(name, domain, host, input_capacity, output_capacity, base_id) {
     sip_last_ipv4_set = nullptr;
+    sip_owners = nullptr;
+    sip_num_owners = 0;
+    sip_index = 0;
   }
   SocketInputPipeline(const SocketInputPipeline&) = delete;
   SocketInputPipeline(SocketInputPipeline&&) = delete;
@@ -340,22 +390,222 @@ public:
 
   SocketInputPipeline& operator=(const SocketInputPipeline&) = delete;
   SocketInputPipeline& operator=(SocketInputPipeline&&) = delete;
+
+  void configure_shard(c3_byte_t index, c3_byte_t* owners, c3_uint_t num_owners, bool share_port) C3_FUNC_COLD;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SHARDED SOCKET INPUT PIPELINE
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Server entry point served by several threads ("shards"), each running its own socket input pipeline,
+ * with its own `epoll` set and listening sockets.
+ *
+ * If more than one shard is started, listening sockets are created with `SO_REUSEPORT` option, so that
+ * the kernel distributes incoming connections between shards. A connection is served by the shard that
+ * accepted it until the connection is closed: responses sent by connection threads are routed back to
+ * that shard using a table indexed by connection handles. All shards post received commands to the
+ * output queue of the first shard, which is listened to by connection threads.
+ *
+ * Shards themselves are owned by the derived class. Until shards are started, configuration commands are
+ * sent to all of them (number of shards to start may not be known yet); shards that end up not being
+ * started then discard their messages.
+ */
+class ShardedSocketInputPipeline: public CommandObjectConsumer, public ResponseObjectConsumer {
+  /// Maximum number of elements in the table of connection owners
+  static constexpr c3_uint_t MAX_NUM_OWNERS = 1024 * 1024;
+
+  SocketInputPipeline* ssp_shards[MAX_NUM_LISTENER_THREADS]; // all shards, started or not
+  c3_byte_t*           ssp_owners;                           // shards serving connections, by handles
+  c3_uint_t            ssp_num_owners;                       // number of elements in `ssp_owners`
+  c3_uint_t            ssp_num_shards;                       // number of shards to be started
+  bool                 ssp_started;                          // whether shards had been started
+
+  c3_uint_t get_num_messaged_shards() const {
+    return ssp_started? ssp_num_shards: MAX_NUM_LISTENER_THREADS;
+  }
+  SocketInputPipeline& get_owner_shard(int fd) const {
+    c3_assert(fd > 0);
+    if (ssp_owners != nullptr && (c3_uint_t) fd < ssp_num_owners) {
+      return get_shard(ssp_owners[fd]);
+    }
+    return get_shard(0);
+  }
+
+  /**
+   * Sends a message to all shards that are going to be started (or, before startup, to all shards).
+   *
+   * @param proc Function (or functor, or lambda) accepting `SocketPipeline` reference, and returning
+   *   `true` on success
+   * @return `true` if message had been sent to all shards, `false` otherwise
+   */
+  template <class P> bool send_to_shards(P proc) const {
+    bool result = true;
+    for (c3_uint_t i = 0; i < get_num_messaged_shards(); i++) {
+      if (!proc((SocketPipeline&) get_shard(i))) {
+        result = false;
+      }
+    }
+    return result;
+  }
+
+protected:
+  ShardedSocketInputPipeline() noexcept C3_FUNC_COLD;
+  void set_shard(c3_uint_t i, SocketInputPipeline* shard) C3_FUNC_COLD;
+
+public:
+  ShardedSocketInputPipeline(const ShardedSocketInputPipeline&) = delete;
+  ShardedSocketInputPipeline(ShardedSocketInputPipeline&&) = delete;
+  ~ShardedSocketInputPipeline() C3_FUNC_COLD;
+
+  ShardedSocketInputPipeline& operator=(const ShardedSocketInputPipeline&) = delete;
+  ShardedSocketInputPipeline& operator=(ShardedSocketInputPipeline&&) = delete;
+
+  c3_uint_t get_num_shards() const { return ssp_num_shards; }
+  void set_num_shards(c3_uint_t num) C3_FUNC_COLD {
+    c3_assert(num > 0 && num <= MAX_NUM_LISTENER_THREADS && !ssp_started);
+    ssp_num_shards = num;
+  }
+  SocketInputPipeline& get_shard(c3_uint_t i) const {
+    c3_assert(i < MAX_NUM_LISTENER_THREADS && ssp_shards[i]);
+    return *ssp_shards[i];
+  }
+  bool initialize() C3_FUNC_COLD;
+  bool prepare_shards() C3_FUNC_COLD;
+
+  // queue manipulation
+  c3_uint_t get_input_queue_capacity() C3_FUNC_COLD { return get_shard(0).get_input_queue_capacity(); }
+  c3_uint_t get_max_input_queue_capacity() C3_FUNC_COLD { return get_shard(0).get_max_input_queue_capacity(); }
+  c3_uint_t get_output_queue_capacity() C3_FUNC_COLD { return get_shard(0).get_output_queue_capacity(); }
+  c3_uint_t get_max_output_queue_capacity() C3_FUNC_COLD { return get_shard(0).get_max_output_queue_capacity(); }
+
+  // to be used by the application
+  bool is_using_persistent_connections() const { return get_shard(0).is_using_persistent_connections(); }
+  bool is_service_active() const;
+  c3_uint_t get_num_connections() const;
+
+  // messaging
+  bool send_ip_set_change_command(const c3_ipv4_t* ips, c3_uint_t num) C3_FUNC_COLD {
+    return send_to_shards([=](SocketPipeline& shard) {
+      return shard.send_ip_set_change_command(ips, num);
+    });
+  }
+  bool send_port_change_command(c3_ushort_t port) C3_FUNC_COLD {
+    return send_to_shards([=](SocketPipeline& shard) {
+      return shard.send_port_change_command(port);
+    });
+  }
+  bool send_input_queue_capacity_change_command(c3_uint_t capacity) C3_FUNC_COLD {
+    return send_to_shards([=](SocketPipeline& shard) {
+      return shard.send_input_queue_capacity_change_command(capacity);
+    });
+  }
+  bool send_max_input_queue_capacity_change_command(c3_uint_t max_capacity) C3_FUNC_COLD {
+    return send_to_shards([=](SocketPipeline& shard) {
+      return shard.send_max_input_queue_capacity_change_command(max_capacity);
+    });
+  }
+  // output queue is owned by the first shard
+  bool send_output_queue_capacity_change_command(c3_uint_t capacity) C3_FUNC_COLD {
+    return get_shard(0).send_output_queue_capacity_change_command(capacity);
+  }
+  bool send_max_output_queue_capacity_change_command(c3_uint_t max_capacity) C3_FUNC_COLD {
+    return get_shard(0).send_max_output_queue_capacity_change_command(max_capacity);
+  }
+  bool send_set_persistent_connections_command(bool enable) C3_FUNC_COLD {
+    return send_to_shards([=](SocketPipeline& shard) {
+      return shard.send_set_persistent_connections_command(enable);
+    });
+  }
+  bool send_quit_command() C3_FUNC_COLD {
+    return send_to_shards([](SocketPipeline& shard) {
+      return shard.send_quit_command();
+    });
+  }
+
+  OutputSocketMessage get_output_message() { return get_shard(0).get_output_message(); }
+  OutputSocketMessage get_output_message(c3_uint_t msecs) { return get_shard(0).get_output_message(msecs); }
+
+  // object consumer interfaces
+  bool post_processors_quit_command() override C3_FUNC_COLD;
+  bool post_command_reader(CommandReader* cr) override;
+  bool post_deferred_command_reader(CommandReader* cr) override;
+  bool post_response_writer(ResponseWriter* rw) override;
+  bool log_error_response(const char* message, int length) override C3_FUNC_COLD;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // SOCKET OUTPUT PIPELINE
 ///////////////////////////////////////////////////////////////////////////////
 
-/// Server replicator or a client "command sender"
+/**
+ * Server replicator or a client "command sender".
+ *
+ * With persistent connections, the pipeline can work in "pipelined" (streaming) mode: if window size is
+ * bigger than one, up to that many commands are sent over the connection to the first replication server
+ * without waiting for responses, and responses are then matched to commands in order. At any given time,
+ * only one object is watched on the connection socket: response reader if there are commands in flight,
+ * or, otherwise, a command that could not be sent in one go.
+ *
+ * If batch size is not zero, commands taken from the input queue in one go are not sent one by one, but
+ * are serialized into a buffer that is then sent as payload of a single `BATCH` command (and therefore
+ * compressed as a whole); the batch is sent when the input queue gets drained, or when the next command
+ * would not fit into the buffer. A "batch" of just one command is sent as that very command.
+ */
 class SocketOutputPipeline: public SocketPipeline {
 
   static constexpr c3_uint_t SOP_DEFAULT_QUEUE_CAPACITY = 16;
   static constexpr c3_uint_t SOP_MAX_QUEUE_CAPACITY = 1024;
+  static constexpr c3_uint_t SOP_MAX_WINDOW = 1024;
+  static constexpr c3_uint_t SOP_MAX_BATCH_SIZE = 16 * 1024 * 1024;
 
   typedef Pointer<ReaderWriter> ReaderWriterPointer;
   typedef Queue<ReaderWriterPointer> ReaderWriterQueue;
 
-  ReaderWriterQueue sop_deferred_objects; // queue of pointers to deferred `ReaderWriter` objects
+  ReaderWriterQueue     sop_deferred_objects; // queue of pointers to deferred `ReaderWriter` objects
+  SocketResponseReader* sop_stream_reader;    // reader of the next response in pipelined mode
+  ReaderWriter*         sop_stream_writer;    // command that could not be sent in one go in pipelined mode
+  c3_uint_t             sop_num_in_flight;    // number of pipelined commands awaiting responses
+  c3_uint_t             sop_window;           // max number of commands in flight; 1 means "no pipelining"
+  ReaderWriter*         sop_batch_head;       // first command of the current batch, if not serialized yet
+  c3_byte_t*            sop_batch_buffer;     // buffer with serialized commands of the current batch
+  c3_uint_t             sop_batch_size;       // max size of a batch, bytes; zero means "no batching"
+  c3_uint_t             sop_batch_used;       // number of bytes used in the batch buffer
+  c3_uint_t             sop_batch_count;      // number of commands in the current batch
+  c3_ulong_t            sop_batch_sequence;   // sequence number of the first command in the current batch
+  catch_up_plan_t       sop_catch_up;         // binlog files from which commands are being re-sent
+  c3_uint_t             sop_catch_up_file;    // index of the file being read (catch-up is done if past last)
+  c3_ulong_t            sop_catch_up_remains; // number of bytes yet to read from current catch-up file
+  c3_ulong_t            sop_catch_up_next;    // sequence number of the next command in the file (0: unknown)
+  c3_ulong_t            sop_catch_up_count;   // number of commands re-sent during current catch-up
+  c3_uint_t             sop_in_flight_head;   // index of the oldest in-flight command in the ring below
+  c3_ulong_t            sop_in_flight_sequences[SOP_MAX_WINDOW]; // sequence numbers of pipelined commands
+  std::atomic<c3_ulong_t> sop_lost_sequence;  // lowest sequence number of commands not delivered, or 0
+
+  bool is_pipelining() const { return sp_persistent && sop_window > 1; }
+  bool is_catching_up() const { return sop_catch_up_file < sop_catch_up.cp_num_files; }
+  bool is_stream_busy() const { return sop_num_in_flight > 0 || sop_stream_writer != nullptr; }
+  c3_uint_t get_num_regular_connections() const {
+    return is_stream_busy()? sp_num_connections - 1: sp_num_connections;
+  }
+  void send_stream_object(ReaderWriter* rw);
+  void fill_stream_window();
+  void complete_stream_response();
+  void abort_stream(const char* msg) C3_FUNC_COLD;
+  void process_stream_event(const pipeline_event_t& event);
+  void add_to_batch(ReaderWriter* rw);
+  void flush_batch();
+  void dispose_batch() C3_FUNC_COLD;
+  void send_object(ReaderWriter* rw);
+  void transmit_object(ReaderWriter* rw);
+  void add_in_flight_sequence(c3_ulong_t sequence) {
+    sop_in_flight_sequences[(sop_in_flight_head + sop_num_in_flight) % SOP_MAX_WINDOW] = sequence;
+  }
+  void record_lost_sequence(c3_ulong_t sequence);
+  void next_catch_up_file() C3_FUNC_COLD;
+  ReaderWriter* get_catch_up_object();
+  ReaderWriter* get_next_object();
 
   void process_input_queue_object(ReaderWriter* rw) override;
   void process_socket_event(const pipeline_event_t &event) override;
@@ -367,17 +617,44 @@ class SocketOutputPipeline: public SocketPipeline {
   void process_persistent_connections_change(bool persistent) override C3_FUNC_COLD;
   void process_local_capacity_change(c3_uint_t capacity) override C3_FUNC_COLD;
   void process_local_max_capacity_change(c3_uint_t max_capacity) override C3_FUNC_COLD;
+  void process_window_change(c3_uint_t window) override C3_FUNC_COLD;
+  void process_batch_size_change(c3_uint_t size) override C3_FUNC_COLD;
+  void process_catch_up(const catch_up_plan_t& plan) override C3_FUNC_COLD;
+  void process_input_queue_end() override;
   void reset_event_processor() override C3_FUNC_COLD;
+  void cleanup() override C3_FUNC_COLD;
 
 public:
   C3_FUNC_COLD SocketOutputPipeline(const char* name, domain_t domain, host_object_t host,
     c3_uint_t input_capacity, c3_uint_t output_capacity, c3_byte_t base_id) noexcept:
     SocketPipeline(name, domain, host, input_capacity, output_capacity, base_id),
     sop_deferred_objects(domain, SOP_DEFAULT_QUEUE_CAPACITY, SOP_MAX_QUEUE_CAPACITY) {
+    sop_stream_reader = nullptr;
+    sop_stream_writer = nullptr;
+    sop_num_in_flight = 0;
+    sop_window = 1;
+    sop_batch_head = nullptr;
+    sop_batch_buffer = nullptr;
+    sop_batch_size = 0;
+    sop_batch_used = 0;
+    sop_batch_count = 0;
+    sop_batch_sequence = 0;
+    sop_catch_up.cp_num_files = 0;
+    sop_catch_up_file = 0;
+    sop_catch_up_remains = 0;
+    sop_catch_up_next = 0;
+    sop_catch_up_count = 0;
+    sop_in_flight_head = 0;
+    sop_lost_sequence.store(0, std::memory_order_relaxed);
   }
 
   c3_uint_t get_local_queue_capacity() const { return sop_deferred_objects.get_capacity(); }
   c3_uint_t get_local_queue_max_capacity() const { return sop_deferred_objects.get_max_capacity(); }
+  c3_uint_t get_window() const { return sop_window; }
+  static constexpr c3_uint_t get_max_window() { return SOP_MAX_WINDOW; }
+  c3_uint_t get_batch_size() const { return sop_batch_size; }
+  static constexpr c3_uint_t get_max_batch_size() { return SOP_MAX_BATCH_SIZE; }
+  c3_ulong_t get_lost_sequence() const { return sop_lost_sequence.load(std::memory_order_acquire); }
 };
 
 }
@@ -0,0 +1,293 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <vector>
+#include <sys/stat.h>
+
+typedef unsigned char c3_byte_t;
+typedef unsigned int c3_uint_t;
+typedef unsigned long long c3_ulong_t;
+
+/// Signature of the samples file; must match `DICTIONARY_SAMPLES_SIGNATURE` in `c3_compressor.h`
+static const char SAMPLES_SIGNATURE[] = "C3Sample";
+static constexpr c3_uint_t SAMPLES_SIGNATURE_LENGTH = sizeof SAMPLES_SIGNATURE - 1;
+
+/// Maximum code length; must match `CompressorAsciient::MAX_CODE_LENGTH`
+static constexpr c3_uint_t MAX_CODE_LENGTH = 12;
+
+/// Limits of the size of samples that are taken into account
+static constexpr c3_uint_t MIN_SAMPLE_SIZE = 16;
+static constexpr c3_uint_t MAX_SAMPLE_SIZE = 64 * 1024;
+static constexpr c3_uint_t DEFAULT_SAMPLE_SIZE = 1024;
+
+///////////////////////////////////////////////////////////////////////////////
+// ALGORITHM IMPLEMENTATION
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Builder of the code lengths for the `asciient` compressor.
+ *
+ * Every byte value gets a code (frequencies are "smoothed" by adding one to each of them), so that
+ * compressor could handle any input, not just the kind of text it was trained on. If regular Huffman
+ * algorithm yields codes longer than `MAX_CODE_LENGTH`, frequencies are halved (but kept non-zero),
+ * and code lengths are re-calculated; this is repeated until all codes fit. Actual codes are then
+ * derived from the lengths by the compressor itself, using canonical ordering.
+ */
+class Trainer {
+  struct node_t {
+    c3_ulong_t n_weight; // total frequency of all symbols in the subtree
+    int        n_left;   // index of left child, or -1 if this is a leaf
+    int        n_right;  // index of right child, or symbol value if this is a leaf
+  };
+
+  struct node_order_t {
+    const std::vector<node_t>* no_nodes;
+    explicit node_order_t(const std::vector<node_t>* nodes): no_nodes(nodes) {}
+    bool operator()(int a, int b) const {
+      // "greater than" comparison turns priority queue into a min-heap
+      return (*no_nodes)[a].n_weight > (*no_nodes)[b].n_weight;
+    }
+  };
+
+  c3_ulong_t t_frequencies[256]; // counts of all byte values in the samples, plus one
+  c3_ulong_t t_total;            // total number of bytes in the samples
+
+  static void walk(const std::vector<node_t>& nodes, int index, c3_uint_t depth, c3_byte_t* lengths) {
+    const node_t& node = nodes[index];
+    if (node.n_left < 0) {
+      lengths[node.n_right] = (c3_byte_t) depth;
+    } else {
+      walk(nodes, node.n_left, depth + 1, lengths);
+      walk(nodes, node.n_right, depth + 1, lengths);
+    }
+  }
+
+  static c3_uint_t build(const c3_ulong_t* frequencies, c3_byte_t* lengths) {
+    std::vector<node_t> nodes;
+    nodes.reserve(512);
+    node_order_t order(&nodes);
+    std::priority_queue<int, std::vector<int>, node_order_t> queue(order);
+    for (int i = 0; i < 256; i++) {
+      nodes.push_back({frequencies[i], -1, i});
+      queue.push(i);
+    }
+    while (queue.size() > 1) {
+      int left = queue.top();
+      queue.pop();
+      int right = queue.top();
+      queue.pop();
+      nodes.push_back({nodes[left].n_weight + nodes[right].n_weight, left, right});
+      queue.push((int) nodes.size() - 1);
+    }
+    walk(nodes, queue.top(), 0, lengths);
+    c3_uint_t max_length = 0;
+    for (c3_uint_t i = 0; i < 256; i++) {
+      if (lengths[i] > max_length) {
+        max_length = lengths[i];
+      }
+    }
+    return max_length;
+  }
+
+public:
+  Trainer() {
+    for (c3_uint_t i = 0; i < 256; i++) {
+      t_frequencies[i] = 1;
+    }
+    t_total = 0;
+  }
+
+  void add_sample(const c3_byte_t* data, c3_uint_t size) {
+    for (c3_uint_t i = 0; i < size; i++) {
+      t_frequencies[data[i]]++;
+    }
+    t_total += size;
+  }
+
+  c3_ulong_t get_total() const { return t_total; }
+
+  /**
+   * Calculates code lengths; returns estimated size of all samples (in bytes) after compression.
+   */
+  c3_ulong_t train(c3_byte_t* lengths) const {
+    c3_ulong_t frequencies[256];
+    std::memcpy(frequencies, t_frequencies, sizeof frequencies);
+    while (build(frequencies, lengths) > MAX_CODE_LENGTH) {
+      for (c3_uint_t i = 0; i < 256; i++) {
+        frequencies[i] = (frequencies[i] >> 1) | 1;
+      }
+    }
+    c3_ulong_t bits = 0;
+    for (c3_uint_t i = 0; i < 256; i++) {
+      bits += (t_frequencies[i] - 1) * lengths[i];
+    }
+    return (bits + 7) / 8;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// HOUSEKEEPING AND ENTRY POINT
+///////////////////////////////////////////////////////////////////////////////
+
+static void fail(const char* message) {
+  fprintf(stderr, "ERROR: %s\n", message);
+  exit(3);
+}
+
+static c3_uint_t load_samples(const char* path, c3_uint_t max_size, Trainer& trainer) {
+  struct stat stats;
+  if (stat(path, &stats) != 0) {
+    fail("could not get samples file size");
+  }
+  if (stats.st_size <= SAMPLES_SIGNATURE_LENGTH || stats.st_size > 0xFFFFFFFF) {
+    fail("samples file is too small or too big");
+  }
+  auto file_size = (c3_uint_t) stats.st_size;
+  auto buffer = (c3_byte_t*) std::malloc(file_size);
+  if (buffer == nullptr) {
+    fail("could not allocate samples buffer");
+  }
+  FILE* file = std::fopen(path, "r");
+  if (file == nullptr) {
+    fail("could not open samples file");
+  }
+  if (std::fread(buffer, 1, file_size, file) != file_size) {
+    fail("could not read samples file");
+  }
+  std::fclose(file);
+  if (std::memcmp(buffer, SAMPLES_SIGNATURE, SAMPLES_SIGNATURE_LENGTH) != 0) {
+    fail("not a samples file (signature mismatch)");
+  }
+  c3_uint_t num_samples = 0;
+  c3_uint_t pos = SAMPLES_SIGNATURE_LENGTH;
+  while (pos < file_size) {
+    c3_uint_t sample_size;
+    if (file_size - pos < sizeof sample_size) {
+      fail("samples file is corrupt (truncated sample length)");
+    }
+    std::memcpy(&sample_size, buffer + pos, sizeof sample_size);
+    pos += sizeof sample_size;
+    if (file_size - pos < sample_size) {
+      fail("samples file is corrupt (truncated sample data)");
+    }
+    // bigger records are better handled by general-purpose compressors, so they would skew statistics
+    if (sample_size <= max_size) {
+      trainer.add_sample(buffer + pos, sample_size);
+      num_samples++;
+    }
+    pos += sample_size;
+  }
+  std::free(buffer);
+  return num_samples;
+}
+
+static void save_table(const char* path, const c3_byte_t* lengths) {
+  FILE* file = std::fopen(path, "w");
+  if (file == nullptr) {
+    fail("could not create table file");
+  }
+  fprintf(file,
+    "/**\n"
+    " * CyberCache Cluster\n"
+    " * Written by Vadim Sytnikov.\n"
+    " * Copyright (C) 2016-2019 CyberHULL. All rights reserved.\n"
+    " *\n"
+    " * This program is free software: you can redistribute it and/or modify\n"
+    " * it under the terms of the GNU General Public License as published by\n"
+    " * the Free Software Foundation, either version 2 of the License, or\n"
+    " * (at your option) any later version.\n"
+    " * \n"
+    " * This program is distributed in the hope that it will be useful,\n"
+    " * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+    " * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the\n"
+    " * GNU General Public License for more details.\n"
+    " * ----------------------------------------------------------------------------\n"
+    " *\n"
+    " * Code lengths of the `asciient` compressor; generated by the `asciient` utility, do not edit.\n"
+    " */\n"
+    "#ifndef _ENGINE_ASCIIENT_TABLE_H\n"
+    "#define _ENGINE_ASCIIENT_TABLE_H\n"
+    "\n"
+    "namespace CyberCache {\n"
+    "\n"
+    "static const c3_byte_t asciient_code_lengths[256] = {\n");
+  for (c3_uint_t i = 0; i < 256; i += 16) {
+    fprintf(file, " ");
+    for (c3_uint_t j = i; j < i + 16; j++) {
+      fprintf(file, " %2u%s", lengths[j], j < 255? ",": " ");
+    }
+    fprintf(file, " // 0x%02X..0x%02X\n", i, i + 15);
+  }
+  fprintf(file,
+    "};\n"
+    "\n"
+    "} // CyberCache\n"
+    "\n"
+    "#endif // _ENGINE_ASCIIENT_TABLE_H\n");
+  if (std::fclose(file) != 0) {
+    fail("could not write table file");
+  }
+}
+
+static bool get_number(const char* arg, c3_uint_t min, c3_uint_t max, c3_uint_t& num) {
+  char* end;
+  unsigned long value = std::strtoul(arg, &end, 10);
+  if (*arg != '\0' && *end == '\0' && value >= min && value <= max) {
+    num = (c3_uint_t) value;
+    return true;
+  }
+  return false;
+}
+
+static int usage() {
+  puts("Use: asciient [-m <max-sample-size>] <samples-file> <table-file>");
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  c3_uint_t max_size = DEFAULT_SAMPLE_SIZE;
+  int i = 1;
+  while (i + 1 < argc && argv[i][0] == '-') {
+    if (std::strcmp(argv[i], "-m") == 0) {
+      if (!get_number(argv[i + 1], MIN_SAMPLE_SIZE, MAX_SAMPLE_SIZE, max_size)) {
+        return usage();
+      }
+    } else {
+      return usage();
+    }
+    i += 2;
+  }
+  if (argc - i != 2) {
+    return usage();
+  }
+  Trainer trainer;
+  c3_uint_t num_samples = load_samples(argv[i], max_size, trainer);
+  c3_ulong_t total = trainer.get_total();
+  printf("Loaded %u samples (%llu bytes) from '%s'\n", num_samples, total, argv[i]);
+  if (total == 0) {
+    printf("Samples file does not contain records of up to %u bytes\n", max_size);
+    return 2;
+  }
+  c3_byte_t lengths[256];
+  c3_ulong_t estimate = trainer.train(lengths);
+  printf("Estimated compression: %llu => %llu [%llu%%]\n", total, estimate, estimate * 100 / total);
+  save_table(argv[i + 1], lengths);
+  printf("Saved code lengths to '%s'\n", argv[i + 1]);
+  return 0;
+}
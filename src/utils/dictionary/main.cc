@@ -0,0 +1,315 @@
+/**
+ * This file is a part of the implementation of the CyberCache Cluster.
+ * Written by Vadim Sytnikov.
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+typedef unsigned char c3_byte_t;
+typedef unsigned int c3_uint_t;
+typedef unsigned long long c3_ulong_t;
+
+/// Signature of the samples file; must match `DICTIONARY_SAMPLES_SIGNATURE` in `c3_compressor.h`
+static const char SAMPLES_SIGNATURE[] = "C3Sample";
+static constexpr c3_uint_t SAMPLES_SIGNATURE_LENGTH = sizeof SAMPLES_SIGNATURE - 1;
+
+/// Dictionary size limits; must match respective `CompressorLibrary` constants
+static constexpr c3_uint_t MIN_DICTIONARY_SIZE = 256;
+static constexpr c3_uint_t MAX_DICTIONARY_SIZE = 1024 * 1024;
+static constexpr c3_uint_t DEFAULT_DICTIONARY_SIZE = 64 * 1024;
+
+/// Segment length limits
+static constexpr c3_uint_t MIN_SEGMENT_LENGTH = 16;
+static constexpr c3_uint_t MAX_SEGMENT_LENGTH = 1024;
+static constexpr c3_uint_t DEFAULT_SEGMENT_LENGTH = 256;
+
+///////////////////////////////////////////////////////////////////////////////
+// ALGORITHM IMPLEMENTATION
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Dictionary trainer implementing simplified version of the "cover" algorithm (the one used by `zstd`
+ * dictionary builder in its later versions).
+ *
+ * Each 8-byte sequence ("d-mer") found in the samples is given a frequency equal to the number of
+ * samples in which it occurs. All samples are then split into "epochs", one per dictionary segment; in
+ * each epoch, the segment with highest total frequency of its d-mers is selected, and frequencies of
+ * all d-mers in the selected segment are reset to zero, so that subsequent segments would favor data
+ * that is not covered yet. Selected segments are put into the dictionary in the order of increasing
+ * scores, so that most valuable data ends up closest to the data being compressed.
+ */
+class Trainer {
+  static constexpr c3_uint_t DMER_LENGTH = 8;
+
+  /// A segment selected for inclusion into the dictionary
+  struct segment_t {
+    c3_ulong_t s_score;  // total frequency of d-mers in the segment at the time it was selected
+    c3_uint_t  s_offset; // offset of the segment within the samples buffer
+    c3_uint_t  s_length; // length of the segment, bytes
+  };
+
+  struct dmer_info_t {
+    c3_uint_t di_frequency;   // number of samples containing the d-mer
+    c3_uint_t di_last_sample; // index of the last sample in which the d-mer was seen, plus one
+  };
+
+  const c3_byte_t*                             t_data;  // concatenated samples
+  c3_uint_t                                    t_size;  // total size of all samples
+  std::vector<c3_ulong_t>                      t_dmers; // d-mer at each position (0 if crossing sample boundary)
+  std::unordered_map<c3_ulong_t, dmer_info_t>  t_info;  // current frequencies of all d-mers
+
+  static c3_ulong_t get_dmer(const c3_byte_t* p) {
+    c3_ulong_t dmer;
+    std::memcpy(&dmer, p, sizeof dmer);
+    // zero is used as "no d-mer" marker, so all-zero sequences are mapped to something else
+    return dmer != 0? dmer: ~(c3_ulong_t) 0;
+  }
+
+  c3_uint_t get_frequency(c3_uint_t pos) const {
+    c3_ulong_t dmer = t_dmers[pos];
+    if (dmer != 0) {
+      c3_uint_t frequency = t_info.find(dmer)->second.di_frequency;
+      // d-mers that occur in just one sample are of no use in a dictionary
+      return frequency > 1? frequency: 0;
+    }
+    return 0;
+  }
+
+public:
+  Trainer(const c3_byte_t* data, c3_uint_t size, const std::vector<c3_uint_t>& sample_sizes):
+    t_data(data), t_size(size), t_dmers(size, 0) {
+    c3_uint_t offset = 0;
+    for (c3_uint_t i = 0; i < sample_sizes.size(); i++) {
+      c3_uint_t sample_size = sample_sizes[i];
+      if (sample_size >= DMER_LENGTH) {
+        for (c3_uint_t pos = offset; pos <= offset + sample_size - DMER_LENGTH; pos++) {
+          c3_ulong_t dmer = get_dmer(data + pos);
+          t_dmers[pos] = dmer;
+          dmer_info_t& info = t_info[dmer];
+          if (info.di_last_sample != i + 1) {
+            info.di_last_sample = i + 1;
+            info.di_frequency++;
+          }
+        }
+      }
+      offset += sample_size;
+    }
+  }
+
+  /**
+   * Builds dictionary.
+   *
+   * @param dict Buffer for the dictionary
+   * @param dict_size Maximum size of the dictionary
+   * @param segment_length Length of segments comprising the dictionary
+   * @return Actual size of the dictionary, which may be less than `dict_size`
+   */
+  c3_uint_t train(c3_byte_t* dict, c3_uint_t dict_size, c3_uint_t segment_length) {
+    if (segment_length > t_size) {
+      segment_length = t_size;
+    }
+    c3_uint_t num_epochs = dict_size / segment_length;
+    if (num_epochs == 0) {
+      num_epochs = 1;
+    }
+    c3_uint_t epoch_size = t_size / num_epochs;
+    if (epoch_size < segment_length) {
+      epoch_size = segment_length;
+      num_epochs = t_size / epoch_size;
+    }
+    std::vector<segment_t> segments;
+    std::vector<c3_uint_t> frequencies(epoch_size);
+    c3_uint_t total_length = 0;
+    for (c3_uint_t epoch = 0; epoch < num_epochs && total_length < dict_size; epoch++) {
+      c3_uint_t begin = epoch * epoch_size;
+      c3_uint_t end = std::min(begin + epoch_size, t_size);
+      if (end - begin < segment_length) {
+        break;
+      }
+      for (c3_uint_t pos = begin; pos < end; pos++) {
+        frequencies[pos - begin] = get_frequency(pos);
+      }
+      // slide a window over the epoch, keeping track of the best segment
+      c3_ulong_t score = 0;
+      for (c3_uint_t i = 0; i < segment_length; i++) {
+        score += frequencies[i];
+      }
+      c3_ulong_t best_score = score;
+      c3_uint_t best_start = 0;
+      for (c3_uint_t i = segment_length; i < end - begin; i++) {
+        score += frequencies[i];
+        score -= frequencies[i - segment_length];
+        if (score > best_score) {
+          best_score = score;
+          best_start = i - segment_length + 1;
+        }
+      }
+      if (best_score == 0) {
+        continue;
+      }
+      c3_uint_t best_offset = begin + best_start;
+      c3_uint_t length = std::min(segment_length, dict_size - total_length);
+      segments.push_back({best_score, best_offset, length});
+      total_length += length;
+      // d-mers in the selected segment should not count towards scores of subsequent segments
+      for (c3_uint_t pos = best_offset; pos < best_offset + length; pos++) {
+        if (t_dmers[pos] != 0) {
+          t_info[t_dmers[pos]].di_frequency = 0;
+        }
+      }
+    }
+    std::sort(segments.begin(), segments.end(), [](const segment_t& a, const segment_t& b) {
+      return a.s_score < b.s_score;
+    });
+    c3_uint_t dict_pos = 0;
+    for (const segment_t& segment: segments) {
+      std::memcpy(dict + dict_pos, t_data + segment.s_offset, segment.s_length);
+      dict_pos += segment.s_length;
+    }
+    return dict_pos;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// HOUSEKEEPING AND ENTRY POINT
+///////////////////////////////////////////////////////////////////////////////
+
+static void fail(const char* message) {
+  fprintf(stderr, "ERROR: %s\n", message);
+  exit(3);
+}
+
+static c3_byte_t* load_samples(const char* path, c3_uint_t& size, std::vector<c3_uint_t>& sample_sizes) {
+  struct stat stats;
+  if (stat(path, &stats) != 0) {
+    fail("could not get samples file size");
+  }
+  if (stats.st_size <= SAMPLES_SIGNATURE_LENGTH || stats.st_size > 0xFFFFFFFF) {
+    fail("samples file is too small or too big");
+  }
+  auto file_size = (c3_uint_t) stats.st_size;
+  auto buffer = (c3_byte_t*) std::malloc(file_size);
+  if (buffer == nullptr) {
+    fail("could not allocate samples buffer");
+  }
+  FILE* file = std::fopen(path, "r");
+  if (file == nullptr) {
+    fail("could not open samples file");
+  }
+  if (std::fread(buffer, 1, file_size, file) != file_size) {
+    fail("could not read samples file");
+  }
+  std::fclose(file);
+  if (std::memcmp(buffer, SAMPLES_SIGNATURE, SAMPLES_SIGNATURE_LENGTH) != 0) {
+    fail("not a samples file (signature mismatch)");
+  }
+  // samples are moved to the beginning of the buffer, one right after another
+  c3_uint_t src = SAMPLES_SIGNATURE_LENGTH;
+  c3_uint_t dst = 0;
+  while (src < file_size) {
+    c3_uint_t sample_size;
+    if (file_size - src < sizeof sample_size) {
+      fail("samples file is corrupt (truncated sample length)");
+    }
+    std::memcpy(&sample_size, buffer + src, sizeof sample_size);
+    src += sizeof sample_size;
+    if (file_size - src < sample_size) {
+      fail("samples file is corrupt (truncated sample data)");
+    }
+    std::memmove(buffer + dst, buffer + src, sample_size);
+    src += sample_size;
+    dst += sample_size;
+    sample_sizes.push_back(sample_size);
+  }
+  size = dst;
+  return buffer;
+}
+
+static void save_dictionary(const char* path, const c3_byte_t* buffer, c3_uint_t size) {
+  FILE* file = std::fopen(path, "w");
+  if (file != nullptr) {
+    if (std::fwrite(buffer, 1, size, file) == size) {
+      std::fclose(file);
+    } else {
+      fail("could not write dictionary file");
+    }
+  } else {
+    fail("could not create dictionary file");
+  }
+}
+
+static bool get_number(const char* arg, c3_uint_t min, c3_uint_t max, c3_uint_t& num) {
+  char* end;
+  unsigned long value = std::strtoul(arg, &end, 10);
+  if (*arg != '\0' && *end == '\0' && value >= min && value <= max) {
+    num = (c3_uint_t) value;
+    return true;
+  }
+  return false;
+}
+
+static int usage() {
+  puts("Use: c3dict [-s <dictionary-size>] [-k <segment-length>] <samples-file> <dictionary-file>");
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  c3_uint_t dict_size = DEFAULT_DICTIONARY_SIZE;
+  c3_uint_t segment_length = DEFAULT_SEGMENT_LENGTH;
+  int i = 1;
+  while (i + 1 < argc && argv[i][0] == '-') {
+    if (std::strcmp(argv[i], "-s") == 0) {
+      if (!get_number(argv[i + 1], MIN_DICTIONARY_SIZE, MAX_DICTIONARY_SIZE, dict_size)) {
+        return usage();
+      }
+    } else if (std::strcmp(argv[i], "-k") == 0) {
+      if (!get_number(argv[i + 1], MIN_SEGMENT_LENGTH, MAX_SEGMENT_LENGTH, segment_length)) {
+        return usage();
+      }
+    } else {
+      return usage();
+    }
+    i += 2;
+  }
+  if (argc - i != 2) {
+    return usage();
+  }
+  c3_uint_t size;
+  std::vector<c3_uint_t> sample_sizes;
+  // we will rely on C++ runtime to free up resources...
+  const c3_byte_t* samples = load_samples(argv[i], size, sample_sizes);
+  printf("Loaded %u samples (%u bytes) from '%s'\n", (c3_uint_t) sample_sizes.size(), size, argv[i]);
+  if (size < MIN_DICTIONARY_SIZE) {
+    printf("Not enough sample data to build a dictionary\n");
+    return 2;
+  }
+  auto dict = (c3_byte_t*) std::malloc(dict_size);
+  if (dict == nullptr) {
+    fail("could not allocate dictionary buffer");
+  }
+  Trainer trainer(samples, size, sample_sizes);
+  c3_uint_t actual_size = trainer.train(dict, dict_size, segment_length);
+  if (actual_size < MIN_DICTIONARY_SIZE) {
+    printf("Samples have too little common data to build a dictionary (%u bytes)\n", actual_size);
+    return 2;
+  }
+  save_dictionary(argv[i + 1], dict, actual_size);
+  printf("Saved dictionary (%u bytes) to '%s'\n", actual_size, argv[i + 1]);
+  return 0;
+}
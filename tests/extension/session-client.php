@@ -0,0 +1,67 @@
+<?php
+/*
+ * CyberCache Cluster Test Suite
+ * Written by Vadim Sytnikov
+ * Copyright (C) 2016-2019 CyberHULL. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * ----------------------------------------------------------------------------
+ *
+ * Concurrent client for session locking tests; started by functions in
+ * `test-extension.inc`, never run directly. Arguments:
+ *
+ *   read <options-json> <id> <request-id> [ <hold-msecs> <new-data> ]
+ *
+ * Reads session record with session lock; if <hold-msecs> is given, holds the
+ * lock that long and then writes <new-data>, which unlocks the session.
+ *
+ *   write <options-json> <id> <count>
+ *
+ * Writes session record (without locking) <count> times in a row.
+ *
+ * Prints out JSON object with data that was read (if any), and times (as
+ * returned by `microtime(true)`) when reading started, when it completed, and
+ * when last write completed (zero if there were no writes).
+ */
+if (($argc < 5 || $argc > 7) || ($argv[1] == 'write' && $argc != 5)) {
+  fwrite(STDERR, "Invalid arguments\n");
+  exit(1);
+}
+$session = c3_session(json_decode($argv[2], true));
+$id = $argv[3];
+$data = '';
+$started = microtime(true);
+$read = 0;
+$written = 0;
+
+if ($argv[1] == 'read') {
+  $request_id = (int) $argv[4];
+  $data = c3_read($session, $id, $request_id);
+  $read = microtime(true);
+  if ($argc == 7) {
+    usleep((int) $argv[5] * 1000);
+    if (!c3_write($session, $id, -1, $argv[6], $request_id)) {
+      fwrite(STDERR, "Could not write session record '$id'\n");
+      exit(1);
+    }
+    $written = microtime(true);
+  }
+} else {
+  $count = (int) $argv[4];
+  for ($i = 1; $i <= $count; $i++) {
+    if (!c3_write($session, $id, -1, "write $i of $count", 0)) {
+      fwrite(STDERR, "Could not write session record '$id'\n");
+      exit(1);
+    }
+  }
+  $written = microtime(true);
+}
+echo json_encode(['data' => $data, 'started' => $started, 'read' => $read, 'written' => $written]);
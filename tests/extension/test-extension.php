@@ -180,6 +180,14 @@ run_test("save FPC record with zero-length buffer", ERV_TRUE,
   c3_save($c3fpc, 'empty-record', 3600, NULL, ''));
 run_test("load FPC record with zero-length buffer", ERV_EMPTY_STRING,
   c3_load($c3fpc, 'empty-record'));
+run_test("save several FPC records at once", ERV_TRUE,
+  c3_msave($c3fpc, ['fpc-6' => 'first batched record', 'fpc-7' => get_medium_record()], 3600, ['tag-6'])['fpc-7']);
+run_test("load several FPC records at once", ERV_STRING,
+  c3_mload($c3fpc, ['fpc-6', 'fpc-7', 'fpc-record-id-that-does-not-exist'])['fpc-7'], 'Fhtagn');
+run_test("check that batched load of a non-existent FPC record returns false", ERV_FALSE,
+  c3_mload($c3fpc, ['fpc-6', 'fpc-record-id-that-does-not-exist'])['fpc-record-id-that-does-not-exist']);
+run_test("clean FPC records saved in a batch", ERV_TRUE,
+  c3_clean($c3fpc, "matchingAnyTag", ['tag-6']));
 run_test("get FPC store filling percentage", ERV_NUMBER,
   c3_get_filling_percentage($c3fpc));
 run_test("fetch FPC back-end capabilities", ERV_CAPABILITIES,
@@ -193,6 +201,7 @@ $values = c3_get($c3session, "version");
 if (is_array($values)) {
   $c3_instrumented = strpos($values[0], 'i]') !== false;
   echo 'Got server information: running ', ($c3_instrumented? '': 'non-'), "instrumented version\n";
+  $c3_enterprise = strpos($values[0], 'Enterprise edition') !== false;
   if ($c3_instrumented) {
   run_test("request STATS without specifying a domain or mask", ERV_STR_ARRAY,
     c3_stats($c3session), "Connections");
@@ -205,6 +214,352 @@ if (is_array($values)) {
   fail("Could not retrieve server version information");
 }
 
+/*
+ * Test compressors for small text records (Enterprise edition only).
+ * ------------------------------------------------------------------
+ */
+if ($c3_enterprise) {
+  // one-byte threshold makes even the shortest records go through the engines
+  $text_records = [
+    'empty'     => '',
+    'short'     => 'ok',
+    'text'      => 'customer_id|i:42;quote_id|s:5:"12345";',
+    'medium'    => get_medium_record(),
+    'non-ASCII' => "Gr\u{00F6}\u{00DF}e: \u{00BD} \u{20AC}, bytes: \x00\x01\x7F\x80\xFE\xFF"
+  ];
+  foreach (['hesper', 'asciient'] as $engine) {
+    $engine_options = array_merge($c3_options, ['compressor' => $engine, 'threshold' => '1']);
+    run_test("create session resource using '$engine' compressor", ERV_RESOURCE,
+      $c3engine_session = c3_session($engine_options));
+    run_test("create FPC resource using '$engine' compressor", ERV_RESOURCE,
+      $c3engine_fpc = c3_fpc($engine_options));
+    foreach ($text_records as $kind => $record) {
+      /*
+       * Records that an engine cannot pack (or cannot make smaller) must be sent uncompressed, so
+       * they have to survive the round trip just as well as those that were compressed.
+       */
+      run_test("write $kind session record using '$engine' compressor", ERV_TRUE,
+        c3_write($c3engine_session, "$engine-session", -1, $record, 0));
+      run_test("check that $kind session record packed by '$engine' reads back intact", ERV_TRUE,
+        c3_read($c3engine_session, "$engine-session", 0) === $record);
+      run_test("save $kind FPC record using '$engine' compressor", ERV_TRUE,
+        c3_save($c3engine_fpc, "$engine-fpc", 3600, NULL, $record));
+      run_test("check that $kind FPC record packed by '$engine' loads back intact", ERV_TRUE,
+        c3_load($c3engine_fpc, "$engine-fpc") === $record);
+    }
+    run_test("delete session record written using '$engine' compressor", ERV_TRUE,
+      c3_destroy($c3engine_session, "$engine-session"));
+    run_test("remove FPC record saved using '$engine' compressor", ERV_TRUE,
+      c3_remove($c3engine_fpc, "$engine-fpc"));
+  }
+}
+
+/*
+ * Test incremental resizing of hash tables.
+ * -----------------------------------------
+ */
+/*
+ * Smallest fill factor makes session tables (which use "chained" engine) grow several times while
+ * the records are being written. Each write migrates only a few buckets, so records written earlier
+ * are read back while their buckets may still be in the old array; half of the records are then
+ * deleted, which also migrates buckets, and the rest must still be found.
+ */
+const RESIZE_NUM_RECORDS = 4000;
+run_test("set session table fill factor to 0.5", ERV_TRUE,
+  c3_set($c3session, "perf_session_table_fill_factor", "0.5"));
+$resize_failures = 0;
+for ($i = 1; $i <= RESIZE_NUM_RECORDS; $i++) {
+  if (!c3_write($c3session, "resize-$i", -1, "resize record $i", 0)) {
+    $resize_failures++;
+  }
+  $j = $i - ($i % 97);
+  if ($j > 0 && c3_read($c3session, "resize-$j", 0) !== "resize record $j") {
+    $resize_failures++;
+  }
+}
+run_test("write session records while tables are being resized", ERV_TRUE,
+  $resize_failures == 0);
+$resize_failures = 0;
+for ($i = 1; $i <= RESIZE_NUM_RECORDS; $i++) {
+  if (c3_read($c3session, "resize-$i", 0) !== "resize record $i") {
+    $resize_failures++;
+  }
+}
+run_test("read all session records after tables had been resized", ERV_TRUE,
+  $resize_failures == 0);
+$resize_failures = 0;
+for ($i = 2; $i <= RESIZE_NUM_RECORDS; $i += 2) {
+  if (!c3_destroy($c3session, "resize-$i")) {
+    $resize_failures++;
+  }
+}
+for ($i = 1; $i <= RESIZE_NUM_RECORDS; $i++) {
+  $expected = ($i % 2)? "resize record $i": '';
+  if (c3_read($c3session, "resize-$i", 0) !== $expected) {
+    $resize_failures++;
+  }
+}
+run_test("delete every other session record, and read the rest", ERV_TRUE,
+  $resize_failures == 0);
+for ($i = 1; $i <= RESIZE_NUM_RECORDS; $i += 2) {
+  c3_destroy($c3session, "resize-$i");
+}
+// restore setting from `config/cybercached-test.cfg`
+run_test("restore session table fill factor", ERV_TRUE,
+  c3_set($c3session, "perf_session_table_fill_factor", "1.5"));
+
+/*
+ * Test slab allocation of small memory blocks.
+ * --------------------------------------------
+ */
+/*
+ * Session records written here, along with their object headers, are small enough to be served by
+ * slab allocators. Blocks kept in per-thread caches count as allocated, so the checks leave some
+ * slack; slabs that become empty may be kept in the pool, so reserved size is not checked to shrink.
+ */
+const SLAB_NUM_RECORDS = 4000;
+const SLAB_RECORD_SIZE = 256;
+const SLAB_MIN_CHANGE = SLAB_NUM_RECORDS * SLAB_RECORD_SIZE / 2;
+list($slab_allocated_before) = get_info_numbers($c3session, C3_DOMAIN_SESSION, 'Session slabs:');
+$slab_record = str_repeat('s', SLAB_RECORD_SIZE);
+$slab_failures = 0;
+for ($i = 1; $i <= SLAB_NUM_RECORDS; $i++) {
+  if (!c3_write($c3session, "slab-$i", -1, $slab_record, 0)) {
+    $slab_failures++;
+  }
+}
+run_test("write small session records", ERV_TRUE,
+  $slab_failures == 0);
+list($slab_allocated, $slab_reserved) = get_info_numbers($c3session, C3_DOMAIN_SESSION, 'Session slabs:');
+run_test("check that small session records were allocated from slabs", ERV_TRUE,
+  $slab_allocated - $slab_allocated_before >= SLAB_MIN_CHANGE);
+run_test("check that slab memory is reserved in whole slabs, and covers allocated memory", ERV_TRUE,
+  $slab_reserved >= $slab_allocated && $slab_reserved % (64 * 1024) == 0);
+for ($i = 1; $i <= SLAB_NUM_RECORDS; $i++) {
+  c3_destroy($c3session, "slab-$i");
+}
+// deleted records are disposed of as their tables get unlocked, or by the optimizer
+$slab_allocated_peak = $slab_allocated;
+for ($attempt = 0; $attempt < 20; $attempt++) {
+  list($slab_allocated) = get_info_numbers($c3session, C3_DOMAIN_SESSION, 'Session slabs:');
+  if ($slab_allocated_peak - $slab_allocated >= SLAB_MIN_CHANGE) {
+    break;
+  }
+  usleep(500 * 1000);
+}
+run_test("check that blocks of deleted session records were returned to slabs", ERV_TRUE,
+  $slab_allocated_peak - $slab_allocated >= SLAB_MIN_CHANGE);
+
+/*
+ * Test batched accounting of used memory.
+ * ---------------------------------------
+ */
+/*
+ * Threads add changes of used memory sizes to shared counters in batches of up to 64k, so reported
+ * sizes may be off by that much per thread; the checks allow for 2M of such drift, and use records
+ * made of random bytes, so that their sizes would not depend on compression.
+ */
+const QUOTA_NUM_RECORDS = 4000;
+const QUOTA_RECORD_SIZE = 1500;
+const QUOTA_MAX_DRIFT = 2 * 1024 * 1024;
+list($quota_used_before) = get_info_numbers($c3session, C3_DOMAIN_SESSION, 'Session memory:');
+$quota_failures = 0;
+for ($i = 1; $i <= QUOTA_NUM_RECORDS; $i++) {
+  if (!c3_write($c3session, "quota-$i", -1, random_bytes(QUOTA_RECORD_SIZE), 0)) {
+    $quota_failures++;
+  }
+}
+run_test("write session records made of random bytes", ERV_TRUE,
+  $quota_failures == 0);
+list($quota_used) = get_info_numbers($c3session, C3_DOMAIN_SESSION, 'Session memory:');
+run_test("check that used session memory grew by the size of written records", ERV_TRUE,
+  $quota_used - $quota_used_before >= QUOTA_NUM_RECORDS * QUOTA_RECORD_SIZE - QUOTA_MAX_DRIFT);
+for ($i = 1; $i <= QUOTA_NUM_RECORDS; $i++) {
+  c3_destroy($c3session, "quota-$i");
+}
+for ($attempt = 0; $attempt < 20; $attempt++) {
+  list($quota_used) = get_info_numbers($c3session, C3_DOMAIN_SESSION, 'Session memory:');
+  if (abs($quota_used - $quota_used_before) <= QUOTA_MAX_DRIFT) {
+    break;
+  }
+  usleep(500 * 1000);
+}
+run_test("check that used session memory went back after records were deleted", ERV_TRUE,
+  abs($quota_used - $quota_used_before) <= QUOTA_MAX_DRIFT);
+
+// memory quota must still be enforced even though the optimizer sees used size with some delay
+run_test("set FPC memory quota to 8 megabytes", ERV_TRUE,
+  c3_set($c3fpc, "max_fpc_memory", "8m"));
+run_test("set FPC optimization interval to 1 second", ERV_TRUE,
+  c3_set($c3fpc, "fpc_optimization_interval", "1s"));
+for ($i = 1; $i <= QUOTA_NUM_RECORDS * 2; $i++) {
+  c3_save($c3fpc, "quota-$i", 3600, NULL, random_bytes(QUOTA_RECORD_SIZE));
+}
+for ($attempt = 0; $attempt < 20; $attempt++) {
+  list($quota_used, $quota) = get_info_numbers($c3fpc, C3_DOMAIN_FPC, 'FPC memory:');
+  if ($quota_used <= $quota + QUOTA_MAX_DRIFT) {
+    break;
+  }
+  usleep(500 * 1000);
+}
+run_test("check that FPC records were evicted to keep used memory within quota", ERV_TRUE,
+  $quota == 8 * 1024 * 1024 && $quota_used <= $quota + QUOTA_MAX_DRIFT);
+if ($c3_instrumented) {
+  run_test("request per-thread memory call counts", ERV_STR_ARRAY,
+    c3_stats($c3session, C3_DOMAIN_GLOBAL, "Memory_Thread_*"), "Memory_Thread_Alloc_Calls");
+}
+// restore settings from `config/cybercached-test.cfg`
+run_test("restore FPC memory quota and optimization interval", ERV_TRUE,
+  c3_clean($c3fpc, "all") &&
+  c3_set($c3fpc, "max_fpc_memory", "0b") &&
+  c3_set($c3fpc, "fpc_optimization_interval", "10s"));
+
+/*
+ * Test transfer of responses that do not fit into socket buffers.
+ * ---------------------------------------------------------------
+ */
+/*
+ * Header, payload, and marker of a response are sent with one vectored write; a 16M response cannot
+ * be sent in one go even over loopback, so the server has to resume the write several times, from
+ * the middle of the payload. Records are made of random bytes (base64-encoded, so that concurrent
+ * clients could pass them back as JSON) that compression would not shrink much, and the marker
+ * (enabled in `$c3_options`) makes the extension verify the end of response.
+ */
+const RESUME_RECORD_SIZE = 16 * 1024 * 1024;
+$resume_record = base64_encode(random_bytes(RESUME_RECORD_SIZE / 4 * 3));
+run_test("save FPC record that is bigger than socket buffers", ERV_TRUE,
+  c3_save($c3fpc, 'resume-fpc', 3600, NULL, $resume_record));
+run_test("load FPC record that is bigger than socket buffers", ERV_TRUE,
+  c3_load($c3fpc, 'resume-fpc') === $resume_record);
+run_test("write session record that is bigger than socket buffers", ERV_TRUE,
+  c3_write($c3session, 'resume-session', -1, $resume_record, 0));
+run_test("read session record that is bigger than socket buffers", ERV_TRUE,
+  c3_read($c3session, 'resume-session', 0) === $resume_record);
+// several such responses being sent at once have to be resumed independently
+$resume_readers = [];
+for ($i = 1; $i <= 4; $i++) {
+  $resume_readers[] = start_session_reader($c3_options, 'resume-session', 0);
+}
+$resume_failures = 0;
+foreach ($resume_readers as $reader) {
+  $result = finish_session_client($reader);
+  if ($result['data'] !== $resume_record) {
+    $resume_failures++;
+  }
+}
+run_test("read session record that is bigger than socket buffers by concurrent clients", ERV_TRUE,
+  $resume_failures == 0);
+run_test("remove FPC record that is bigger than socket buffers", ERV_TRUE,
+  c3_remove($c3fpc, 'resume-fpc'));
+run_test("delete session record that is bigger than socket buffers", ERV_TRUE,
+  c3_destroy($c3session, 'resume-session'));
+unset($resume_record);
+
+/*
+ * Test session locking with concurrent clients.
+ * ---------------------------------------------
+ */
+// short lock wait time, so that tests of lock breaking would not take long
+run_test("set session lock wait time to 2 seconds", ERV_TRUE,
+  c3_set($c3session, "session_lock_wait_time", "2000"));
+
+run_test("write unlocked session record", ERV_TRUE,
+  c3_write($c3session, 'lock-1', -1, 'initial data', 0));
+run_test("lock session record that was not locked", ERV_STRING,
+  c3_read($c3session, 'lock-1', 101), 'initial data');
+$reader = start_session_reader($c3_options, 'lock-1', 102);
+$result = finish_session_client($reader);
+run_test("read session record locked by another request after lock expiration", ERV_STRING,
+  $result['data'], 'initial data');
+run_test("check that session lock had been acquired and then broken after 2 seconds", ERV_TRUE,
+  $result['read'] - $result['started'] >= 1.9 && $result['read'] - $result['started'] < 4.0);
+
+run_test("write another unlocked session record", ERV_TRUE,
+  c3_write($c3session, 'lock-2', -1, 'initial data', 0));
+run_test("lock session record by the first request", ERV_STRING,
+  c3_read($c3session, 'lock-2', 201), 'initial data');
+$first_waiter = start_session_reader($c3_options, 'lock-2', 202, 300, 'data from second request');
+usleep(300 * 1000);
+$second_waiter = start_session_reader($c3_options, 'lock-2', 203);
+usleep(300 * 1000);
+$unlocking = microtime(true);
+run_test("unlock session record by the first request", ERV_TRUE,
+  c3_write($c3session, 'lock-2', -1, 'data from first request', 201));
+$first_result = finish_session_client($first_waiter);
+$second_result = finish_session_client($second_waiter);
+run_test("check that session lock was handed over to the first waiting request", ERV_STRING,
+  $first_result['data'], 'data from first request');
+run_test("check that first waiting request got the lock before it expired", ERV_TRUE,
+  $first_result['read'] >= $unlocking && $first_result['read'] - $first_result['started'] < 1.9);
+run_test("check that second waiting request got the lock after the first released it", ERV_STRING,
+  $second_result['data'], 'data from second request');
+run_test("check response order of the waiting requests", ERV_TRUE,
+  $second_result['read'] >= $first_result['written'] && $second_result['read'] - $second_result['started'] < 1.9);
+
+run_test("write session record to be destroyed while locked", ERV_TRUE,
+  c3_write($c3session, 'lock-3', -1, 'initial data', 0));
+run_test("lock session record to be destroyed", ERV_STRING,
+  c3_read($c3session, 'lock-3', 301), 'initial data');
+$reader = start_session_reader($c3_options, 'lock-3', 302);
+usleep(300 * 1000);
+run_test("destroy session record with a waiting request", ERV_TRUE,
+  c3_destroy($c3session, 'lock-3'));
+$result = finish_session_client($reader);
+run_test("check that waiting request got a cache miss", ERV_EMPTY_STRING,
+  $result['data']);
+run_test("check that waiting request was released without waiting for lock expiration", ERV_TRUE,
+  $result['read'] - $result['started'] < 1.9);
+
+/*
+ * With a single connection thread and the smallest output queue, a connection
+ * thread that unlocks a session is likely to find the queue full, and to process
+ * the waiting request itself; it is not possible to force that from here, so the
+ * test only checks that responses are correct either way.
+ */
+run_test("set number of connection threads to 1", ERV_TRUE,
+  c3_set($c3session, "num_connection_threads", "1"));
+run_test("set max capacity of listener output queue to 2", ERV_TRUE,
+  c3_set($c3session, "perf_listener_output_queue_max_capacity", "2"));
+run_test("set capacity of listener output queue to 2", ERV_TRUE,
+  c3_set($c3session, "perf_listener_output_queue_capacity", "2"));
+run_test("write session record to be unlocked under load", ERV_TRUE,
+  c3_write($c3session, 'lock-4', -1, 'initial data', 0));
+run_test("lock session record to be unlocked under load", ERV_STRING,
+  c3_read($c3session, 'lock-4', 401), 'initial data');
+$reader = start_session_reader($c3_options, 'lock-4', 402);
+$writers = [];
+for ($i = 1; $i <= 8; $i++) {
+  $writers[] = start_session_writer($c3_options, "load-$i", 500);
+}
+usleep(300 * 1000);
+run_test("unlock session record under load", ERV_TRUE,
+  c3_write($c3session, 'lock-4', -1, 'data written under load', 401));
+$result = finish_session_client($reader);
+foreach ($writers as $writer) {
+  finish_session_client($writer);
+}
+run_test("check that waiting request got the lock under load", ERV_STRING,
+  $result['data'], 'data written under load');
+run_test("check that waiting request under load got the lock before it expired", ERV_TRUE,
+  $result['read'] - $result['started'] < 1.9);
+if ($c3_instrumented) {
+  run_test("request number of waiting requests processed by unlocking threads", ERV_STR_ARRAY,
+    c3_stats($c3session, C3_DOMAIN_SESSION, "Session_Lock_*"), "Session_Lock_Inline_Resumes");
+}
+
+// restore settings from `config/cybercached-test.cfg`
+run_test("restore capacity of listener output queue", ERV_TRUE,
+  c3_set($c3session, "perf_listener_output_queue_max_capacity", "64") &&
+  c3_set($c3session, "perf_listener_output_queue_capacity", "64"));
+run_test("restore number of connection threads", ERV_TRUE,
+  c3_set($c3session, "num_connection_threads", $c3_enterprise? "8": "2"));
+run_test("restore session lock wait time", ERV_TRUE,
+  c3_set($c3session, "session_lock_wait_time", "8000"));
+foreach (['lock-1', 'lock-2', 'lock-4', 'load-1', 'load-2', 'load-3', 'load-4', 'load-5', 'load-6', 'load-7',
+  'load-8'] as $id) {
+  c3_destroy($c3session, $id);
+}
+
 /*
  * Test information functions.
  * ---------------------------
@@ -290,6 +645,119 @@ run_test("force FPC binlog rotation", ERV_TRUE,
   c3_rotate($c3fpc, C3_DOMAIN_FPC));
 // run_test("force rotation of all [bin]logs", ERV_TRUE,
 //  c3_rotate($c3fpc, C3_DOMAIN_ALL));
+
+/*
+ * Test pipelined replication.
+ * ---------------------------
+ */
+/*
+ * This script acts as a replication server, and only responds to commands when told to; the
+ * server cannot be told to stop replicating, so these tests go last, right before shutdown.
+ */
+const REPLICA_PORT = 8121;
+const REPLICA_WINDOW = 4;
+const REPLICA_NUM_RECORDS = REPLICA_WINDOW * 3;
+$replica = start_replica(REPLICA_PORT);
+run_test("configure session replicator to use persistent connections and window of " . REPLICA_WINDOW,
+  ERV_TRUE,
+  c3_set($c3session, "session_replicator_port", (string) REPLICA_PORT) &&
+  c3_set($c3session, "session_replicator_persistent", "true") &&
+  c3_set($c3session, "session_replicator_window", (string) REPLICA_WINDOW) &&
+  c3_set($c3session, "session_replicator_addresses", "localhost"));
+usleep(100 * 1000);
+$replica_failures = 0;
+for ($i = 1; $i <= REPLICA_NUM_RECORDS; $i++) {
+  if (!c3_write($c3session, "replica-$i", -1, "replicated record $i", 0)) {
+    $replica_failures++;
+  }
+}
+run_test("write session records to be replicated", ERV_TRUE,
+  $replica_failures == 0);
+$replica_num_received = 0;
+$replica_window_full = true;
+for ($round = 1; $round <= REPLICA_NUM_RECORDS / REPLICA_WINDOW; $round++) {
+  // replicator must send a full window of commands, and then wait for responses
+  $commands = receive_replicated_commands($replica, REPLICA_NUM_RECORDS, 1.0);
+  foreach ($commands as list($command_id, $count)) {
+    if ($command_id != 0x22) {
+      $replica_failures++;
+    }
+  }
+  if (count($commands) != REPLICA_WINDOW) {
+    $replica_window_full = false;
+  }
+  $replica_num_received += count($commands);
+  acknowledge_replicated_commands($replica);
+}
+run_test("check that replicator kept exactly a window of commands in flight", ERV_TRUE,
+  $replica_window_full && $replica_failures == 0);
+run_test("check that all commands were replicated", ERV_TRUE,
+  $replica_num_received == REPLICA_NUM_RECORDS);
+if ($c3_instrumented) {
+  run_test("request maximum number of replicated commands in flight", ERV_STR_ARRAY,
+    c3_stats($c3session, C3_DOMAIN_SESSION, "Replicator_Max_Commands_In_Flight"),
+    "Replicator_Max_Commands_In_Flight");
+}
+for ($i = 1; $i <= REPLICA_NUM_RECORDS; $i++) {
+  c3_destroy($c3session, "replica-$i");
+}
+receive_replicated_commands($replica, REPLICA_NUM_RECORDS, 1.0, true);
+
+/*
+ * Test batching of replicated session commands.
+ * ---------------------------------------------
+ */
+/*
+ * Replicator packs commands that it finds in its queue at once, so concurrent writers are used to
+ * make sure there are such commands; rounds of writes are repeated (up to a limit) until at least
+ * one batch arrives. Every write has to be replicated exactly once, whether batched or not.
+ */
+const BATCH_NUM_WRITERS = 8;
+const BATCH_NUM_WRITES = 100;
+const BATCH_MAX_ROUNDS = 5;
+run_test("set session replication batch size to 64k, and window to 64", ERV_TRUE,
+  c3_set($c3session, "session_replicator_batch_size", "64k") &&
+  c3_set($c3session, "session_replicator_window", "64"));
+usleep(100 * 1000);
+$batch_num_batches = 0;
+$batch_num_received = 0;
+$batch_num_expected = 0;
+for ($round = 1; $round <= BATCH_MAX_ROUNDS && $batch_num_batches == 0; $round++) {
+  $writers = [];
+  for ($i = 1; $i <= BATCH_NUM_WRITERS; $i++) {
+    $writers[] = start_session_writer($c3_options, "batch-$i", BATCH_NUM_WRITES);
+  }
+  $batch_num_expected += BATCH_NUM_WRITERS * BATCH_NUM_WRITES;
+  while ($batch_num_received < $batch_num_expected) {
+    $commands = receive_replicated_commands($replica, $batch_num_expected - $batch_num_received, 2.0, true);
+    if (count($commands) == 0) {
+      break;
+    }
+    foreach ($commands as list($command_id, $count)) {
+      if ($command_id == 0x25) {
+        $batch_num_batches++;
+      }
+      $batch_num_received += $count;
+    }
+  }
+  foreach ($writers as $writer) {
+    finish_session_client($writer);
+  }
+}
+run_test("check that concurrently written session records were replicated in batches", ERV_TRUE,
+  $batch_num_batches > 0);
+run_test("check that every batched write was replicated exactly once", ERV_TRUE,
+  $batch_num_received == $batch_num_expected);
+if ($c3_instrumented) {
+  run_test("request number of replicated batches", ERV_STR_ARRAY,
+    c3_stats($c3session, C3_DOMAIN_SESSION, "Replicator_*Batch*"), "Replicator_Batches");
+}
+for ($i = 1; $i <= BATCH_NUM_WRITERS; $i++) {
+  c3_destroy($c3session, "batch-$i");
+}
+receive_replicated_commands($replica, BATCH_NUM_WRITERS, 1.0, true);
+stop_replica($replica);
+
 run_test("shut down the server", ERV_TRUE,
   c3_shutdown($c3fpc));
 